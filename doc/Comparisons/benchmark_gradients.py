@@ -0,0 +1,122 @@
+#!/usr/bin/env python
+"""Timings of the gradients of other_gradients.py through the Python wrapping.
+
+The filters compared visually in other_gradients.py, GradientImageFilter,
+DifferenceOfGaussiansGradientImageFilter and
+GradientRecursiveGaussianImageFilter, are timed against
+HigherOrderAccurateGradientImageFilter for several image sizes, orders of
+accuracy and numbers of work units.  The NumPy interface of the module is
+timed as well, to show the cost of the conversions around the filter.
+
+Run with pytest-benchmark::
+
+  pytest benchmark_gradients.py --benchmark-autosave
+
+Every autosaved run is kept in .benchmarks/, so the timings of a change can be
+compared with the earlier runs::
+
+  pytest benchmark_gradients.py --benchmark-compare --benchmark-group-by=param:size
+  pytest-benchmark compare --histogram=gradients
+
+Select a subset with -k, e.g. ``-k 'higher_order and 256'``.
+"""
+
+import multiprocessing
+
+import itk
+import numpy as np
+import pytest
+
+from itk.higherorderaccurategradient import higher_order_accurate_gradient
+
+valt = itk.F
+
+sizes = [(128, 128), (512, 512), (64, 64, 64), (128, 128, 128)]
+accuracies = [1, 2, 3, 4, 5]
+work_units = sorted({1, 2, multiprocessing.cpu_count()})
+
+
+def size_id(size):
+    return 'x'.join(str(s) for s in size)
+
+
+def make_array(size):
+    # A smooth, non-trivial image, the same for every run.
+    grid = np.meshgrid(*[np.linspace(0.0, 4.0 * np.pi, s, dtype=np.float32) for s in size], indexing='ij')
+    return np.sin(grid[0]) * np.cos(0.5 * grid[-1]) + 0.01 * grid[len(size) // 2] ** 2
+
+
+@pytest.fixture(scope='module', params=sizes, ids=size_id)
+def size(request):
+    return request.param
+
+
+@pytest.fixture(scope='module')
+def array(size):
+    return make_array(size).astype(np.float32)
+
+
+@pytest.fixture(scope='module')
+def image(array):
+    return itk.image_from_array(array)
+
+
+def time_filter(benchmark, process_object, number_of_work_units):
+    process_object.SetNumberOfWorkUnits(number_of_work_units)
+
+    def update():
+        # Force the filter to run again on the same input.
+        process_object.Modified()
+        process_object.Update()
+
+    update()
+    benchmark(update)
+
+
+@pytest.mark.parametrize('number_of_work_units', work_units)
+def test_gradient_image_filter(benchmark, image, number_of_work_units):
+    imgt = type(image)
+    gradient_filter = itk.GradientImageFilter[imgt, valt, valt].New(Input=image)
+    time_filter(benchmark, gradient_filter, number_of_work_units)
+
+
+@pytest.mark.parametrize('number_of_work_units', work_units)
+def test_difference_of_gaussians(benchmark, image, number_of_work_units):
+    imgt = type(image)
+    dog_filter = itk.DifferenceOfGaussiansGradientImageFilter[imgt, valt].New(Input=image)
+    dog_filter.SetWidth(1)
+    time_filter(benchmark, dog_filter, number_of_work_units)
+
+
+@pytest.mark.parametrize('number_of_work_units', work_units)
+def test_recursive_gaussian(benchmark, image, number_of_work_units):
+    imgt = type(image)
+    dimension = imgt.GetImageDimension()
+    gradt = itk.Image[itk.CovariantVector[valt, dimension], dimension]
+    recursive_gauss_filter = itk.GradientRecursiveGaussianImageFilter[imgt, gradt].New(Input=image)
+    recursive_gauss_filter.SetSigma(1.0)
+    recursive_gauss_filter.SetNormalizeAcrossScale(True)
+    time_filter(benchmark, recursive_gauss_filter, number_of_work_units)
+
+
+@pytest.mark.parametrize('number_of_work_units', work_units)
+@pytest.mark.parametrize('order_of_accuracy', accuracies)
+def test_higher_order_accurate_gradient(benchmark, image, order_of_accuracy, number_of_work_units):
+    imgt = type(image)
+    gradient_filter = itk.HigherOrderAccurateGradientImageFilter[imgt, valt, valt].New(Input=image)
+    gradient_filter.SetOrderOfAccuracy(order_of_accuracy)
+    time_filter(benchmark, gradient_filter, number_of_work_units)
+
+
+@pytest.mark.parametrize('number_of_work_units', work_units)
+@pytest.mark.parametrize('order_of_accuracy', accuracies)
+def test_higher_order_accurate_gradient_numpy(benchmark, array, order_of_accuracy, number_of_work_units):
+    # Array in, array out: the difference with the filter timing above is
+    # the overhead of the wrapping and of the image views.
+    benchmark(higher_order_accurate_gradient, array, order_of_accuracy=order_of_accuracy,
+              number_of_work_units=number_of_work_units)
+
+
+if __name__ == '__main__':
+    import sys
+    sys.exit(pytest.main([__file__] + sys.argv[1:]))
@@ -0,0 +1,163 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef hoag_h
+#define hoag_h
+
+/* C interface to the higher order accurate gradient kernels.
+ *
+ * The hoag library is built with HigherOrderAccurateGradient_C_API and only
+ * this header is needed to use it; no ITK header or type is exposed.
+ *
+ * Arrays are described in the order of ITK images: dims[0] is the number of
+ * samples along the fastest axis.  spacing holds one value per axis and may
+ * be NULL for unit spacing.  direction holds the direction cosines row by
+ * row and may be NULL for the identity; the gradient is rotated to physical
+ * space as with HigherOrderAccurateGradientImageFilter.  accuracy is the
+ * OrderOfAccuracy of HigherOrderAccurateDerivativeOperator.
+ *
+ * The gradient output holds one component per axis for every sample,
+ * interleaved (channel-last) by default, or as consecutive planes
+ * (channel-first) when requested in the options.  The derivative output has
+ * the layout of a contiguous input.
+ *
+ * On failure, a function returns a status other than HOAG_SUCCESS, and
+ * hoag_last_error() describes the error of the last failed call of the
+ * calling thread. */
+
+#include <stddef.h>
+
+#if defined(_WIN32)
+#  if defined(hoag_EXPORTS)
+#    define HOAG_EXPORT __declspec(dllexport)
+#  else
+#    define HOAG_EXPORT __declspec(dllimport)
+#  endif
+#else
+#  define HOAG_EXPORT __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  typedef enum hoag_status
+  {
+    HOAG_SUCCESS = 0,
+    HOAG_ERROR_INVALID_ARGUMENT = 1,
+    HOAG_ERROR_COMPUTATION = 2
+  } hoag_status;
+
+  typedef struct hoag_options
+  {
+    /* Number of threads the computation is split over, 0 for the default. */
+    unsigned int number_of_work_units;
+    /* Non-zero to write the gradient components as consecutive planes. */
+    int channel_first;
+    /* Distance in bytes between consecutive input samples along each axis,
+     * or NULL for a contiguous input. */
+    const ptrdiff_t * input_strides;
+  } hoag_options;
+
+  /* Set the default options. */
+  HOAG_EXPORT void
+  hoag_options_init(hoag_options * options);
+
+  /* Description of the error of the last failed call on this thread. */
+  HOAG_EXPORT const char *
+  hoag_last_error(void);
+
+  /* Gradient of input into output, which holds 2 or 3 values per sample.
+   * options may be NULL for the defaults. */
+  HOAG_EXPORT hoag_status
+  hoag_gradient_f32_2d(const float *        input,
+                       const size_t         dims[2],
+                       const double         spacing[2],
+                       const double         direction[4],
+                       int                  accuracy,
+                       float *              output,
+                       const hoag_options * options);
+  HOAG_EXPORT hoag_status
+  hoag_gradient_f32_3d(const float *        input,
+                       const size_t         dims[3],
+                       const double         spacing[3],
+                       const double         direction[9],
+                       int                  accuracy,
+                       float *              output,
+                       const hoag_options * options);
+  HOAG_EXPORT hoag_status
+  hoag_gradient_f64_2d(const double *       input,
+                       const size_t         dims[2],
+                       const double         spacing[2],
+                       const double         direction[4],
+                       int                  accuracy,
+                       double *             output,
+                       const hoag_options * options);
+  HOAG_EXPORT hoag_status
+  hoag_gradient_f64_3d(const double *       input,
+                       const size_t         dims[3],
+                       const double         spacing[3],
+                       const double         direction[9],
+                       int                  accuracy,
+                       double *             output,
+                       const hoag_options * options);
+
+  /* Derivative of the given order (1 or 2) along axis of input into output,
+   * which holds one value per sample. */
+  HOAG_EXPORT hoag_status
+  hoag_derivative_f32_2d(const float *        input,
+                         const size_t         dims[2],
+                         const double         spacing[2],
+                         unsigned int         axis,
+                         unsigned int         order,
+                         int                  accuracy,
+                         float *              output,
+                         const hoag_options * options);
+  HOAG_EXPORT hoag_status
+  hoag_derivative_f32_3d(const float *        input,
+                         const size_t         dims[3],
+                         const double         spacing[3],
+                         unsigned int         axis,
+                         unsigned int         order,
+                         int                  accuracy,
+                         float *              output,
+                         const hoag_options * options);
+  HOAG_EXPORT hoag_status
+  hoag_derivative_f64_2d(const double *       input,
+                         const size_t         dims[2],
+                         const double         spacing[2],
+                         unsigned int         axis,
+                         unsigned int         order,
+                         int                  accuracy,
+                         double *             output,
+                         const hoag_options * options);
+  HOAG_EXPORT hoag_status
+  hoag_derivative_f64_3d(const double *       input,
+                         const size_t         dims[3],
+                         const double         spacing[3],
+                         unsigned int         axis,
+                         unsigned int         order,
+                         int                  accuracy,
+                         double *             output,
+                         const hoag_options * options);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,231 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateAnisotropicDiffusionImageFilter_h
+#define itkHigherOrderAccurateAnisotropicDiffusionImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkHigherOrderAccurateDerivativeOperator.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class HigherOrderAccurateAnisotropicDiffusionImageFilter
+ *
+ * \brief Perona-Malik anisotropic diffusion with higher order accurate
+ * gradients and divergence, advanced several time steps per cache tile.
+ *
+ * Every iteration performs the explicit update
+ *
+ * \f[
+ *   u \leftarrow u + \Delta t \, \nabla \cdot \left( c(|\nabla u|) \nabla u \right),
+ *   \qquad c(x) = e^{-(x / K)^2}
+ * \f]
+ *
+ * where the gradient and the divergence are both computed with the
+ * HigherOrderAccurateDerivativeOperator and K is the ConductanceParameter.
+ * The image is extended with zero flux Neumann boundary conditions.
+ *
+ * The image is processed in tiles of TileSize.  With the operator radius r,
+ * one iteration of a pixel depends on the pixels within 2 r, so a tile padded
+ * by a halo of 2 r k is advanced by k = TimeStepsPerBlock iterations in a
+ * thread-local buffer before it is written back.  This trades the redundant
+ * work on the halo for k times fewer sweeps over the whole image.  The result
+ * does not depend on TileSize or TimeStepsPerBlock.  The iterations are
+ * computed in double precision, and the two full-image buffers between the
+ * blocks are allocated once per update.
+ *
+ * The explicit scheme is only stable for small time steps; a warning is
+ * issued when the TimeStep exceeds the stability limit of the linear
+ * operator.  The wide central stencil does not damp the highest frequency,
+ * so checkerboard patterns in the input are preserved.
+ *
+ * \sa GradientAnisotropicDiffusionImageFilter
+ * \sa HigherOrderAccurateDerivativeOperator
+ *
+ * \ingroup HigherOrderAccurateGradient
+ */
+template <typename TInputImage, typename TOperatorValueType = float, typename TOutputValueType = float>
+class HigherOrderAccurateAnisotropicDiffusionImageFilter
+  : public ImageToImageFilter<TInputImage, Image<TOutputValueType, TInputImage::ImageDimension>>
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(HigherOrderAccurateAnisotropicDiffusionImageFilter);
+
+  /** Extract dimension from input image. */
+  static constexpr unsigned int ImageDimension = TInputImage::ImageDimension;
+
+  /** Standard class type alias. */
+  using Self = HigherOrderAccurateAnisotropicDiffusionImageFilter;
+
+  /** Convenient type alias for simplifying declarations. */
+  using InputImageType = TInputImage;
+  using InputImagePointer = typename InputImageType::Pointer;
+  using OutputImageType = Image<TOutputValueType, ImageDimension>;
+  using OutputImagePointer = typename OutputImageType::Pointer;
+
+  /** Standard class type alias. */
+  using Superclass = ImageToImageFilter<InputImageType, OutputImageType>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(HigherOrderAccurateAnisotropicDiffusionImageFilter, ImageToImageFilter);
+
+  /** Image type alias support. */
+  using InputPixelType = typename InputImageType::PixelType;
+  using OperatorValueType = TOperatorValueType;
+  using OutputValueType = TOutputValueType;
+  using OutputImageRegionType = typename OutputImageType::RegionType;
+  using SizeType = typename InputImageType::SizeType;
+
+  /** Set/Get whether or not the filter will use the spacing of the input
+      image in its calculations */
+  itkSetMacro(UseImageSpacing, bool);
+  itkGetConstMacro(UseImageSpacing, bool);
+  itkBooleanMacro(UseImageSpacing);
+
+  /** Set/Get the order of accuracy of the derivative operator.  For more
+   * information, see HigherOrderAccurateDerivativeOperator. */
+  itkSetMacro(OrderOfAccuracy, unsigned int);
+  itkGetConstMacro(OrderOfAccuracy, unsigned int);
+
+  /** Set/Get the number of iterations.  Defaults to 5. */
+  itkSetMacro(NumberOfIterations, unsigned int);
+  itkGetConstMacro(NumberOfIterations, unsigned int);
+
+  /** Set/Get the time step of an iteration.  Defaults to 0.0625. */
+  itkSetMacro(TimeStep, double);
+  itkGetConstMacro(TimeStep, double);
+
+  /** Set/Get the gradient magnitude K at which the conductance falls to
+   * 1 / e.  Defaults to 1. */
+  itkSetMacro(ConductanceParameter, double);
+  itkGetConstMacro(ConductanceParameter, double);
+
+  /** Set/Get the number of iterations applied to a tile before it is written
+   * back.  Defaults to 2. */
+  itkSetClampMacro(TimeStepsPerBlock, unsigned int, 1, NumericTraits<unsigned int>::max());
+  itkGetConstMacro(TimeStepsPerBlock, unsigned int);
+
+  /** Set/Get the size of the tiles, without their halo.  Defaults to 32 along
+   * every axis. */
+  itkSetMacro(TileSize, SizeType);
+  itkGetConstReferenceMacro(TileSize, SizeType);
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  /** Begin concept checking */
+  itkConceptMacro(InputConvertibleToDoubleCheck, (Concept::Convertible<InputPixelType, double>));
+  itkConceptMacro(OutputHasNumericTraitsCheck, (Concept::HasNumericTraits<OutputValueType>));
+  /** End concept checking */
+#endif
+
+protected:
+  HigherOrderAccurateAnisotropicDiffusionImageFilter();
+  ~HigherOrderAccurateAnisotropicDiffusionImageFilter() override = default;
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** The iterations propagate information across the whole image, so the
+   * whole input is requested.
+   *
+   * \sa ImageToImageFilter::GenerateInputRequestedRegion() */
+  void
+  GenerateInputRequestedRegion() override;
+
+  /** The whole output is produced. */
+  void
+  EnlargeOutputRequestedRegion(DataObject * output) override;
+
+  /** Run the blocks of iterations, each of which is multithreaded over the
+   * tiles. */
+  void
+  GenerateData() override;
+
+private:
+  using RealImageType = Image<double, ImageDimension>;
+  using IndexType = typename InputImageType::IndexType;
+  using RegionType = typename InputImageType::RegionType;
+  using OperatorType = HigherOrderAccurateDerivativeOperator<OperatorValueType, ImageDimension>;
+
+  /** Call function with the start index of every scanline of region. */
+  template <typename TFunction>
+  static void
+  ForEachLine(const RegionType & region, TFunction && function);
+
+  /** Offset of index in a buffer laid out over localRegion. */
+  static SizeValueType
+  LocalOffset(const RegionType & localRegion, const IndexType & index);
+
+  /** Advance every tile of the destination by numberOfSteps iterations,
+   * reading the source. */
+  template <typename TSourceImage, typename TDestinationImage>
+  void
+  RunBlock(const TSourceImage * source, TDestinationImage * destination, unsigned int numberOfSteps);
+
+  /** Advance the buffer of a tile, laid out over localRegion, by
+   * numberOfSteps iterations.  On return, the values of the core region are
+   * in values. */
+  void
+  AdvanceTile(const RegionType &    localRegion,
+              const RegionType &    core,
+              unsigned int          numberOfSteps,
+              std::vector<double> & values,
+              std::vector<double> & nextValues,
+              std::vector<double> * flux) const;
+
+  /** Add scale times the derivative along axis of field to accumulator over
+   * region.  Both buffers are laid out over localRegion, at whose border the
+   * taps are clamped. */
+  void
+  AccumulateDerivative(const double *     field,
+                       unsigned int       axis,
+                       const RegionType & localRegion,
+                       const RegionType & region,
+                       double             scale,
+                       double *           accumulator) const;
+
+  bool m_UseImageSpacing{ true };
+
+  unsigned int m_OrderOfAccuracy{ 2 };
+
+  unsigned int m_NumberOfIterations{ 5 };
+
+  double m_TimeStep{ 0.0625 };
+
+  double m_ConductanceParameter{ 1.0 };
+
+  unsigned int m_TimeStepsPerBlock{ 2 };
+
+  SizeType m_TileSize;
+
+  /** Derivative coefficients along each axis, for the offsets -radius..radius. */
+  std::vector<double> m_Coefficients[ImageDimension];
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkHigherOrderAccurateAnisotropicDiffusionImageFilter.hxx"
+#endif
+
+#endif
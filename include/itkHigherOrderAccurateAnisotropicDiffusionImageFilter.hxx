@@ -0,0 +1,419 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateAnisotropicDiffusionImageFilter_hxx
+#define itkHigherOrderAccurateAnisotropicDiffusionImageFilter_hxx
+#include "itkHigherOrderAccurateAnisotropicDiffusionImageFilter.h"
+
+#include "itkHigherOrderAccurateDerivativeOperator.h"
+#include "itkMath.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace itk
+{
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+HigherOrderAccurateAnisotropicDiffusionImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  HigherOrderAccurateAnisotropicDiffusionImageFilter()
+{
+  this->m_TileSize.Fill(32);
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateAnisotropicDiffusionImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  GenerateInputRequestedRegion()
+{
+  // call the superclass' implementation of this method
+  Superclass::GenerateInputRequestedRegion();
+
+  InputImagePointer inputPtr = const_cast<InputImageType *>(this->GetInput());
+  if (inputPtr)
+  {
+    inputPtr->SetRequestedRegionToLargestPossibleRegion();
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateAnisotropicDiffusionImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  EnlargeOutputRequestedRegion(DataObject * output)
+{
+  Superclass::EnlargeOutputRequestedRegion(output);
+  output->SetRequestedRegionToLargestPossibleRegion();
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateAnisotropicDiffusionImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::GenerateData()
+{
+  this->AllocateOutputs();
+
+  const InputImageType * input = this->GetInput();
+  OutputImageType *      output = this->GetOutput();
+
+  if (this->m_ConductanceParameter <= 0.0)
+  {
+    itkExceptionMacro(<< "The ConductanceParameter must be positive.");
+  }
+
+  // The largest eigenvalue of the linear diffusion operator is the sum over
+  // the axes of the squared largest magnitude of the symbol of the
+  // derivative operator.
+  double largestEigenvalue = 0.0;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    this->m_Coefficients[i] = OperatorType::ComputeSpacedCoefficients(
+      1, this->m_OrderOfAccuracy, this->m_UseImageSpacing ? input->GetSpacing()[i] : 1.0);
+
+    const auto radius = static_cast<int>(this->m_Coefficients[i].size() / 2);
+    double     largestSymbol = 0.0;
+    for (unsigned int n = 0; n <= 256; ++n)
+    {
+      const double theta = Math::pi * n / 256.0;
+      double       symbol = 0.0;
+      for (int j = 0; j <= 2 * radius; ++j)
+      {
+        symbol += this->m_Coefficients[i][j] * std::sin((j - radius) * theta);
+      }
+      largestSymbol = std::max(largestSymbol, std::abs(symbol));
+    }
+    largestEigenvalue += largestSymbol * largestSymbol;
+  }
+  if (this->m_NumberOfIterations > 0 && this->m_TimeStep * largestEigenvalue > 2.0)
+  {
+    itkWarningMacro(<< "The TimeStep " << this->m_TimeStep << " exceeds the stability limit "
+                    << 2.0 / largestEigenvalue << " of the explicit scheme.");
+  }
+
+  this->GetMultiThreader()->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+
+  const unsigned int stepsPerBlock = this->m_TimeStepsPerBlock;
+  const unsigned int numberOfBlocks = std::max(1u, (this->m_NumberOfIterations + stepsPerBlock - 1) / stepsPerBlock);
+  if (numberOfBlocks == 1)
+  {
+    this->RunBlock(input, output, this->m_NumberOfIterations);
+    this->UpdateProgress(1.0f);
+    return;
+  }
+
+  // Double buffering between the blocks: the first block reads the input,
+  // the last one writes the output.
+  typename RealImageType::Pointer buffers[2];
+  for (unsigned int b = 0; b < std::min(2u, numberOfBlocks - 1); ++b)
+  {
+    buffers[b] = RealImageType::New();
+    buffers[b]->SetRegions(output->GetBufferedRegion());
+    buffers[b]->Allocate();
+  }
+
+  this->RunBlock(input, buffers[0].GetPointer(), stepsPerBlock);
+  this->UpdateProgress(1.0f / numberOfBlocks);
+  for (unsigned int block = 1; block + 1 < numberOfBlocks; ++block)
+  {
+    const RealImageType * source = buffers[(block - 1) % 2];
+    this->RunBlock(source, buffers[block % 2].GetPointer(), stepsPerBlock);
+    this->UpdateProgress(static_cast<float>(block + 1) / numberOfBlocks);
+  }
+  const RealImageType * source = buffers[(numberOfBlocks - 2) % 2];
+  this->RunBlock(source, output, this->m_NumberOfIterations - (numberOfBlocks - 1) * stepsPerBlock);
+  this->UpdateProgress(1.0f);
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+template <typename TSourceImage, typename TDestinationImage>
+void
+HigherOrderAccurateAnisotropicDiffusionImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::RunBlock(
+  const TSourceImage * source,
+  TDestinationImage *  destination,
+  unsigned int         numberOfSteps)
+{
+  const RegionType    region = destination->GetBufferedRegion();
+  const RegionType    sourceRegion = source->GetBufferedRegion();
+  const SizeValueType radius = this->m_Coefficients[0].size() / 2;
+  const SizeValueType halo = 2 * radius * numberOfSteps;
+
+  SizeType tileSize;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    tileSize[i] = std::max(this->m_TileSize[i], static_cast<SizeValueType>(1));
+  }
+
+  this->GetMultiThreader()->template ParallelizeImageRegion<ImageDimension>(
+    region,
+    [this, source, destination, &sourceRegion, &tileSize, halo, numberOfSteps](const RegionType & piece) {
+      // The buffers of the tiles are reused within the work unit.
+      std::vector<double> values;
+      std::vector<double> nextValues;
+      std::vector<double> flux[ImageDimension];
+
+      SizeValueType tilesPerAxis[ImageDimension];
+      SizeValueType numberOfTiles = 1;
+      for (unsigned int i = 0; i < ImageDimension; ++i)
+      {
+        tilesPerAxis[i] = (piece.GetSize(i) + tileSize[i] - 1) / tileSize[i];
+        numberOfTiles *= tilesPerAxis[i];
+      }
+
+      for (SizeValueType tile = 0; tile < numberOfTiles; ++tile)
+      {
+        RegionType    core;
+        SizeValueType remainder = tile;
+        for (unsigned int i = 0; i < ImageDimension; ++i)
+        {
+          const SizeValueType position = remainder % tilesPerAxis[i];
+          remainder /= tilesPerAxis[i];
+          core.SetIndex(i, piece.GetIndex(i) + static_cast<IndexValueType>(position * tileSize[i]));
+          core.SetSize(i, std::min(tileSize[i], piece.GetSize(i) - position * tileSize[i]));
+        }
+
+        RegionType localRegion = core;
+        localRegion.PadByRadius(static_cast<OffsetValueType>(halo));
+        localRegion.Crop(sourceRegion);
+
+        const SizeValueType numberOfLocalPixels = localRegion.GetNumberOfPixels();
+        values.resize(numberOfLocalPixels);
+        nextValues.resize(numberOfLocalPixels);
+        for (auto & component : flux)
+        {
+          component.resize(numberOfLocalPixels);
+        }
+
+        const auto *        sourceBuffer = source->GetBufferPointer();
+        const SizeValueType localLineLength = localRegion.GetSize(0);
+        ForEachLine(localRegion, [&](const IndexType & lineStart) {
+          const auto * in = sourceBuffer + source->ComputeOffset(lineStart);
+          double *     out = values.data() + LocalOffset(localRegion, lineStart);
+          for (SizeValueType x = 0; x < localLineLength; ++x)
+          {
+            out[x] = static_cast<double>(in[x]);
+          }
+        });
+
+        this->AdvanceTile(localRegion, core, numberOfSteps, values, nextValues, flux);
+
+        auto *              destinationBuffer = destination->GetBufferPointer();
+        const SizeValueType coreLineLength = core.GetSize(0);
+        ForEachLine(core, [&](const IndexType & lineStart) {
+          const double * in = values.data() + LocalOffset(localRegion, lineStart);
+          auto *         out = destinationBuffer + destination->ComputeOffset(lineStart);
+          for (SizeValueType x = 0; x < coreLineLength; ++x)
+          {
+            out[x] = static_cast<typename TDestinationImage::PixelType>(in[x]);
+          }
+        });
+      }
+    },
+    nullptr);
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateAnisotropicDiffusionImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::AdvanceTile(
+  const RegionType &    localRegion,
+  const RegionType &    core,
+  unsigned int          numberOfSteps,
+  std::vector<double> & values,
+  std::vector<double> & nextValues,
+  std::vector<double> * flux) const
+{
+  const SizeValueType radius = this->m_Coefficients[0].size() / 2;
+  const double inverseSquaredConductance = 1.0 / (this->m_ConductanceParameter * this->m_ConductanceParameter);
+
+  for (unsigned int step = 1; step <= numberOfSteps; ++step)
+  {
+    // The values are exact on the core padded by 2 r for every remaining
+    // step; the flux is needed r further out.
+    RegionType outputRegion = core;
+    outputRegion.PadByRadius(static_cast<OffsetValueType>(2 * radius * (numberOfSteps - step)));
+    outputRegion.Crop(localRegion);
+    RegionType fluxRegion = outputRegion;
+    fluxRegion.PadByRadius(static_cast<OffsetValueType>(radius));
+    fluxRegion.Crop(localRegion);
+
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      std::fill(flux[i].begin(), flux[i].end(), 0.0);
+      this->AccumulateDerivative(values.data(), i, localRegion, fluxRegion, 1.0, flux[i].data());
+    }
+
+    const SizeValueType fluxLineLength = fluxRegion.GetSize(0);
+    ForEachLine(fluxRegion, [&](const IndexType & lineStart) {
+      const SizeValueType lineOffset = LocalOffset(localRegion, lineStart);
+      for (SizeValueType x = lineOffset; x < lineOffset + fluxLineLength; ++x)
+      {
+        double squaredMagnitude = 0.0;
+        for (unsigned int i = 0; i < ImageDimension; ++i)
+        {
+          squaredMagnitude += flux[i][x] * flux[i][x];
+        }
+        const double conductance = std::exp(-squaredMagnitude * inverseSquaredConductance);
+        for (unsigned int i = 0; i < ImageDimension; ++i)
+        {
+          flux[i][x] *= conductance;
+        }
+      }
+    });
+
+    const SizeValueType outputLineLength = outputRegion.GetSize(0);
+    ForEachLine(outputRegion, [&](const IndexType & lineStart) {
+      const SizeValueType lineOffset = LocalOffset(localRegion, lineStart);
+      std::copy(
+        values.begin() + lineOffset, values.begin() + lineOffset + outputLineLength, nextValues.begin() + lineOffset);
+    });
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      this->AccumulateDerivative(flux[i].data(), i, localRegion, outputRegion, this->m_TimeStep, nextValues.data());
+    }
+
+    std::swap(values, nextValues);
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateAnisotropicDiffusionImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  AccumulateDerivative(const double *     field,
+                       unsigned int       axis,
+                       const RegionType & localRegion,
+                       const RegionType & region,
+                       double             scale,
+                       double *           accumulator) const
+{
+  const auto            radius = static_cast<OffsetValueType>(this->m_Coefficients[axis].size() / 2);
+  const double *        coefficients = this->m_Coefficients[axis].data();
+  const SizeValueType   lineLength = region.GetSize(0);
+  const OffsetValueType first = localRegion.GetIndex(axis);
+  const OffsetValueType last = first + static_cast<OffsetValueType>(localRegion.GetSize(axis)) - 1;
+
+  OffsetValueType stride = 1;
+  for (unsigned int i = 0; i < axis; ++i)
+  {
+    stride *= static_cast<OffsetValueType>(localRegion.GetSize(i));
+  }
+
+  ForEachLine(region, [&](const IndexType & lineStart) {
+    const SizeValueType   lineOffset = LocalOffset(localRegion, lineStart);
+    const double *        center = field + lineOffset;
+    double *              out = accumulator + lineOffset;
+    const OffsetValueType lineLast = lineStart[axis] + (axis == 0 ? static_cast<OffsetValueType>(lineLength) - 1 : 0);
+
+    if (lineStart[axis] - radius >= first && lineLast + radius <= last)
+    {
+      for (OffsetValueType k = -radius; k <= radius; ++k)
+      {
+        if (coefficients[k + radius] == 0.0)
+        {
+          continue;
+        }
+        const double   weight = scale * coefficients[k + radius];
+        const double * tap = center + k * stride;
+        for (SizeValueType x = 0; x < lineLength; ++x)
+        {
+          out[x] += weight * tap[x];
+        }
+      }
+      return;
+    }
+
+    // Clamp the taps to the local buffer.  At the border of the image this is
+    // the zero flux Neumann boundary condition; elsewhere the halo absorbs
+    // the error.
+    for (SizeValueType x = 0; x < lineLength; ++x)
+    {
+      const OffsetValueType position = lineStart[axis] + (axis == 0 ? static_cast<OffsetValueType>(x) : 0);
+      OperatorType::AccumulateClampedTaps(
+        this->m_Coefficients[axis], position, first, last, [&](double weight, OffsetValueType shift) {
+          out[x] += scale * weight * center[static_cast<OffsetValueType>(x) + shift * stride];
+        });
+    }
+  });
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+template <typename TFunction>
+void
+HigherOrderAccurateAnisotropicDiffusionImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::ForEachLine(
+  const RegionType & region,
+  TFunction &&       function)
+{
+  if (region.GetNumberOfPixels() == 0)
+  {
+    return;
+  }
+
+  const SizeValueType numberOfLines = region.GetNumberOfPixels() / region.GetSize(0);
+  for (SizeValueType line = 0; line < numberOfLines; ++line)
+  {
+    IndexType     lineStart = region.GetIndex();
+    SizeValueType remainder = line;
+    for (unsigned int i = 1; i < ImageDimension; ++i)
+    {
+      lineStart[i] += static_cast<IndexValueType>(remainder % region.GetSize(i));
+      remainder /= region.GetSize(i);
+    }
+    function(lineStart);
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+SizeValueType
+HigherOrderAccurateAnisotropicDiffusionImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::LocalOffset(
+  const RegionType & localRegion,
+  const IndexType &  index)
+{
+  SizeValueType offset = 0;
+  SizeValueType stride = 1;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    offset += stride * static_cast<SizeValueType>(index[i] - localRegion.GetIndex(i));
+    stride *= localRegion.GetSize(i);
+  }
+  return offset;
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateAnisotropicDiffusionImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::PrintSelf(
+  std::ostream & os,
+  Indent         indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "UseImageSpacing: " << (this->m_UseImageSpacing ? "On" : "Off") << std::endl;
+  os << indent << "OrderOfAccuracy: " << this->m_OrderOfAccuracy << std::endl;
+  os << indent << "NumberOfIterations: " << this->m_NumberOfIterations << std::endl;
+  os << indent << "TimeStep: " << this->m_TimeStep << std::endl;
+  os << indent << "ConductanceParameter: " << this->m_ConductanceParameter << std::endl;
+  os << indent << "TimeStepsPerBlock: " << this->m_TimeStepsPerBlock << std::endl;
+  os << indent << "TileSize: " << this->m_TileSize << std::endl;
+}
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,251 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateAutotuner_h
+#define itkHigherOrderAccurateAutotuner_h
+
+#include "itkNumericTraits.h"
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkTimeProbe.h"
+#include "itksys/SystemInformation.hxx"
+#include "itksys/SystemTools.hxx"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+
+namespace itk
+{
+
+/** \class HigherOrderAccurateAutotuner
+ *
+ * \brief Persistent profile of the fastest execution configuration of the
+ * filters, per workload and processor.
+ *
+ * A filter that accepts an Autotuner describes its workload, e.g. the image
+ * dimension, size class, pixel type and order of accuracy, in a key that the
+ * autotuner completes with the processor description.  On the first run for
+ * a key, the filter times its candidate configurations with Time() and
+ * records the fastest; later runs, in this process or another, look it up
+ * and use it directly.
+ *
+ * The profile is a text file with one entry per line, the key and the
+ * configuration separated by a tab.  It is rewritten through a temporary
+ * file that is renamed into place, so concurrent processes never read a
+ * partial profile.  Its default location is
+ * $HOME/.HigherOrderAccurateGradientProfile.txt.
+ *
+ * \sa HigherOrderAccurateGradientImageFilter
+ *
+ * \ingroup HigherOrderAccurateGradient
+ */
+class HigherOrderAccurateAutotuner : public Object
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(HigherOrderAccurateAutotuner);
+
+  /** Standard class type aliases. */
+  using Self = HigherOrderAccurateAutotuner;
+  using Superclass = Object;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(HigherOrderAccurateAutotuner, Object);
+
+  /** Set/Get the file the profile is read from and written to. */
+  itkSetStringMacro(ProfileFileName);
+  itkGetStringMacro(ProfileFileName);
+
+  /** Set/Get the number of times a candidate is run when it is timed; the
+   * shortest time is kept.  Defaults to 3. */
+  itkSetClampMacro(NumberOfTrials, unsigned int, 1, NumericTraits<unsigned int>::max());
+  itkGetConstMacro(NumberOfTrials, unsigned int);
+
+  /** Name, vendor and number of logical cores of the processor, which is
+   * part of every key. */
+  static std::string
+  GetProcessorDescription()
+  {
+    itksys::SystemInformation information;
+    information.RunCPUCheck();
+    std::string name = information.GetExtendedProcessorName();
+    if (name.empty())
+    {
+      name = std::string(information.GetVendorString()) + " " + information.GetModelName();
+    }
+    std::ostringstream description;
+    description << name << " x" << information.GetNumberOfLogicalCPU();
+    return description.str();
+  }
+
+  /** The key of a workload: the processor description followed by the
+   * workload description given by the filter. */
+  std::string
+  ComputeKey(const std::string & workload) const
+  {
+    std::string key = this->m_ProcessorDescription + " | " + workload;
+    std::replace(key.begin(), key.end(), '\t', ' ');
+    std::replace(key.begin(), key.end(), '\n', ' ');
+    return key;
+  }
+
+  /** Look the configuration recorded for key up.  Returns false when there
+   * is none. */
+  bool
+  Lookup(const std::string & key, std::string & configuration) const
+  {
+    const ProfileType profile = this->ReadProfile();
+    const auto        entry = profile.find(key);
+    if (entry == profile.end())
+    {
+      return false;
+    }
+    configuration = entry->second;
+    return true;
+  }
+
+  /** Record configuration as the fastest for key. */
+  void
+  Record(const std::string & key, const std::string & configuration)
+  {
+    ProfileType profile = this->ReadProfile();
+    profile[key] = configuration;
+    this->WriteProfile(profile);
+  }
+
+  /** Remove every entry. */
+  void
+  Clear()
+  {
+    this->WriteProfile(ProfileType());
+  }
+
+  /** The shortest of NumberOfTrials runs of function, in seconds. */
+  template <typename TFunction>
+  double
+  Time(TFunction && function) const
+  {
+    double shortest = NumericTraits<double>::max();
+    for (unsigned int trial = 0; trial < this->m_NumberOfTrials; ++trial)
+    {
+      TimeProbe probe;
+      probe.Start();
+      function();
+      probe.Stop();
+      shortest = std::min(shortest, probe.GetTotal());
+    }
+    return shortest;
+  }
+
+protected:
+  HigherOrderAccurateAutotuner()
+    : m_ProcessorDescription(GetProcessorDescription())
+  {
+    std::string home;
+    if (itksys::SystemTools::GetEnv("HOME", home) || itksys::SystemTools::GetEnv("USERPROFILE", home))
+    {
+      this->m_ProfileFileName = home + "/";
+    }
+    this->m_ProfileFileName += ".HigherOrderAccurateGradientProfile.txt";
+  }
+  ~HigherOrderAccurateAutotuner() override = default;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override
+  {
+    Superclass::PrintSelf(os, indent);
+
+    os << indent << "ProfileFileName: " << this->m_ProfileFileName << std::endl;
+    os << indent << "NumberOfTrials: " << this->m_NumberOfTrials << std::endl;
+    os << indent << "ProcessorDescription: " << this->m_ProcessorDescription << std::endl;
+  }
+
+private:
+  using ProfileType = std::map<std::string, std::string>;
+
+  ProfileType
+  ReadProfile() const
+  {
+    ProfileType   profile;
+    std::ifstream file(this->m_ProfileFileName.c_str());
+    std::string   line;
+    while (std::getline(file, line))
+    {
+      const std::string::size_type separator = line.find('\t');
+      if (separator != std::string::npos)
+      {
+        profile[line.substr(0, separator)] = line.substr(separator + 1);
+      }
+    }
+    return profile;
+  }
+
+  void
+  WriteProfile(const ProfileType & profile)
+  {
+    if (this->m_ProfileFileName.empty())
+    {
+      itkExceptionMacro(<< "ProfileFileName is not set.");
+    }
+    const std::string directory = itksys::SystemTools::GetFilenamePath(this->m_ProfileFileName);
+    if (!directory.empty())
+    {
+      itksys::SystemTools::MakeDirectory(directory);
+    }
+
+    // Write to a file no other process uses, then move it into place.
+    std::random_device randomDevice;
+    const std::string  temporaryFileName = this->m_ProfileFileName + "." + std::to_string(randomDevice()) + ".tmp";
+    {
+      std::ofstream file(temporaryFileName.c_str());
+      for (const auto & entry : profile)
+      {
+        file << entry.first << '\t' << entry.second << '\n';
+      }
+      if (!file)
+      {
+        file.close();
+        itksys::SystemTools::RemoveFile(temporaryFileName);
+        itkWarningMacro(<< "Could not write the profile " << temporaryFileName);
+        return;
+      }
+    }
+    if (!itksys::SystemTools::RenameFile(temporaryFileName, this->m_ProfileFileName))
+    {
+      itksys::SystemTools::RemoveFile(temporaryFileName);
+      itkWarningMacro(<< "Could not move the profile to " << this->m_ProfileFileName);
+    }
+  }
+
+  std::string m_ProfileFileName;
+
+  unsigned int m_NumberOfTrials{ 3 };
+
+  const std::string m_ProcessorDescription;
+};
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,202 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateBinaryGradientImageFilter_h
+#define itkHigherOrderAccurateBinaryGradientImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkCovariantVector.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace itk
+{
+
+/** \class HigherOrderAccurateBinaryGradientImageFilter
+ *
+ * \brief Calculate the higher order accurate gradient, or the surface normal,
+ * of a binary mask without converting the mask to a real valued image.
+ *
+ * Pixels equal to the ForegroundValue are treated as 1 and all other pixels as
+ * 0.  Before the threaded pass, the input mask is packed into 64 bit words,
+ * one bit per pixel, so the working set is 1/32 of that of a float image.
+ *
+ * Because every tap of the stencil is either 0 or 1, the derivative along an
+ * axis only depends on the bit pattern under the stencil.  The derivative is
+ * therefore read from two lookup tables, indexed by the bits of the negative
+ * and of the positive taps, instead of being accumulated tap by tap.
+ *
+ * The gradient is zero unless a pixel lies within the stencil radius of the
+ * mask boundary.  Candidate pixels are found 64 at a time by XOR-ing each
+ * packed word with its shifted neighbors, and words without any candidate are
+ * written as zero directly.
+ *
+ * When NormalizeGradient is enabled, the output is the unit gradient direction,
+ * which points from the background into the foreground, and is zero away from
+ * the boundary.
+ *
+ * The OrderOfAccuracy may be at most 16, which bounds the size of the lookup
+ * tables at 2^16 entries per axis.
+ *
+ * \sa HigherOrderAccurateGradientImageFilter
+ * \sa HigherOrderAccurateDerivativeOperator
+ *
+ * \ingroup GradientFilters
+ * \ingroup HigherOrderAccurateGradient
+ */
+template <typename TInputImage, typename TOperatorValueType = float, typename TOutputValueType = float>
+class HigherOrderAccurateBinaryGradientImageFilter
+  : public ImageToImageFilter<
+      TInputImage,
+      Image<CovariantVector<TOutputValueType, TInputImage::ImageDimension>, TInputImage::ImageDimension>>
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(HigherOrderAccurateBinaryGradientImageFilter);
+
+  /** Extract dimension from input image. */
+  static constexpr unsigned int ImageDimension = TInputImage::ImageDimension;
+
+  /** Standard class type alias. */
+  using Self = HigherOrderAccurateBinaryGradientImageFilter;
+
+  /** Convenient type alias for simplifying declarations. */
+  using InputImageType = TInputImage;
+  using InputImagePointer = typename InputImageType::Pointer;
+  using OutputImageType = Image<CovariantVector<TOutputValueType, ImageDimension>, ImageDimension>;
+  using OutputImagePointer = typename OutputImageType::Pointer;
+
+  /** Standard class type alias. */
+  using Superclass = ImageToImageFilter<InputImageType, OutputImageType>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(HigherOrderAccurateBinaryGradientImageFilter, ImageToImageFilter);
+
+  /** Image type alias support. */
+  using InputPixelType = typename InputImageType::PixelType;
+  using OperatorValueType = TOperatorValueType;
+  using OutputValueType = TOutputValueType;
+  using OutputPixelType = CovariantVector<OutputValueType, ImageDimension>;
+  using OutputImageRegionType = typename OutputImageType::RegionType;
+
+  /** Set/Get the value of the foreground pixels.  Defaults to the maximum
+   * value of the input pixel type. */
+  itkSetMacro(ForegroundValue, InputPixelType);
+  itkGetConstMacro(ForegroundValue, InputPixelType);
+
+  /** Set/Get whether or not the filter will use the spacing of the input
+      image in its calculations */
+  itkSetMacro(UseImageSpacing, bool);
+  itkGetConstMacro(UseImageSpacing, bool);
+  itkBooleanMacro(UseImageSpacing);
+
+  /** Set/Get whether the derivatives are computed with respect to the
+   * physical coordinate system (On) or the image grid (Off).  The default
+   * value of this flag is On. */
+  itkSetMacro(UseImageDirection, bool);
+  itkGetConstMacro(UseImageDirection, bool);
+  itkBooleanMacro(UseImageDirection);
+
+  /** Set/Get whether the gradient is normalized to unit length, which yields
+   * the surface normal.  The default value of this flag is Off. */
+  itkSetMacro(NormalizeGradient, bool);
+  itkGetConstMacro(NormalizeGradient, bool);
+  itkBooleanMacro(NormalizeGradient);
+
+  /** Set/Get the order of accuracy of the derivative operator.  For more
+   * information, see HigherOrderAccurateDerivativeOperator. */
+  itkSetMacro(OrderOfAccuracy, unsigned int);
+  itkGetConstMacro(OrderOfAccuracy, unsigned int);
+
+  /** The largest supported OrderOfAccuracy. */
+  static constexpr unsigned int MaximumOrderOfAccuracy = 16;
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  /** Begin concept checking */
+  itkConceptMacro(InputEqualityComparableCheck, (Concept::EqualityComparable<InputPixelType>));
+  itkConceptMacro(OutputHasNumericTraitsCheck, (Concept::HasNumericTraits<OutputValueType>));
+  /** End concept checking */
+#endif
+
+protected:
+  HigherOrderAccurateBinaryGradientImageFilter();
+  ~HigherOrderAccurateBinaryGradientImageFilter() override = default;
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** The input requested region is padded by the operator radius.
+   *
+   * \sa ImageToImageFilter::GenerateInputRequestedRegion() */
+  void
+  GenerateInputRequestedRegion() override;
+
+  /** Build the tap lookup tables and pack the input mask. */
+  void
+  BeforeThreadedGenerateData() override;
+
+  void
+  DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread) override;
+
+  /** Release the packed mask. */
+  void
+  AfterThreadedGenerateData() override;
+
+private:
+  using IndexType = typename InputImageType::IndexType;
+
+  /** Return the packed scanline that contains the given index. */
+  const std::uint64_t *
+  GetPackedLine(IndexType index) const;
+
+  /** Return count bits, starting at position start, of a packed scanline of
+   * the given length.  Positions outside of the scanline are clamped to it. */
+  static std::uint64_t
+  ReadBits(const std::uint64_t * line, OffsetValueType start, unsigned int count, OffsetValueType length);
+
+  InputPixelType m_ForegroundValue;
+
+  bool m_UseImageSpacing{ true };
+
+  bool m_UseImageDirection{ true };
+
+  bool m_NormalizeGradient{ false };
+
+  unsigned int m_OrderOfAccuracy{ 2 };
+
+  unsigned int m_Radius{ 0 };
+
+  SizeValueType              m_WordsPerLine{ 0 };
+  std::vector<std::uint64_t> m_PackedMask;
+
+  /** Derivative contribution of the taps at offsets -radius..-1 and
+   * 1..radius, indexed by the bits of those taps. */
+  std::vector<OutputValueType> m_NegativeTapTable[ImageDimension];
+  std::vector<OutputValueType> m_PositiveTapTable[ImageDimension];
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkHigherOrderAccurateBinaryGradientImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,381 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateBinaryGradientImageFilter_hxx
+#define itkHigherOrderAccurateBinaryGradientImageFilter_hxx
+#include "itkHigherOrderAccurateBinaryGradientImageFilter.h"
+
+#include "itkImageRegionConstIteratorWithOnlyIndex.h"
+#include "itkHigherOrderAccurateDerivativeOperator.h"
+
+#include <algorithm>
+
+namespace itk
+{
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+HigherOrderAccurateBinaryGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  HigherOrderAccurateBinaryGradientImageFilter()
+  : m_ForegroundValue(NumericTraits<InputPixelType>::max())
+{}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateBinaryGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  GenerateInputRequestedRegion()
+{
+  // call the superclass' implementation of this method
+  Superclass::GenerateInputRequestedRegion();
+
+  // get pointers to the input and output
+  InputImagePointer  inputPtr = const_cast<InputImageType *>(this->GetInput());
+  OutputImagePointer outputPtr = this->GetOutput();
+
+  if (!inputPtr || !outputPtr)
+  {
+    return;
+  }
+
+  // Build an operator so that we can determine the kernel size
+  HigherOrderAccurateDerivativeOperator<OperatorValueType, ImageDimension> oper;
+  oper.SetDirection(0);
+  oper.SetOrder(1);
+  oper.SetOrderOfAccuracy(this->m_OrderOfAccuracy);
+  oper.CreateDirectional();
+  unsigned long radius = oper.GetRadius()[0];
+
+  // get a copy of the input requested region (should equal the output
+  // requested region)
+  typename TInputImage::RegionType inputRequestedRegion;
+  inputRequestedRegion = inputPtr->GetRequestedRegion();
+
+  // pad the input requested region by the operator radius
+  inputRequestedRegion.PadByRadius(radius);
+
+  // crop the input requested region at the input's largest possible region
+  if (inputRequestedRegion.Crop(inputPtr->GetLargestPossibleRegion()))
+  {
+    inputPtr->SetRequestedRegion(inputRequestedRegion);
+    return;
+  }
+  else
+  {
+    // Couldn't crop the region (requested region is outside the largest
+    // possible region).  Throw an exception.
+
+    // store what we tried to request (prior to trying to crop)
+    inputPtr->SetRequestedRegion(inputRequestedRegion);
+
+    // build an exception
+    InvalidRequestedRegionError e(__FILE__, __LINE__);
+    e.SetLocation(ITK_LOCATION);
+    e.SetDescription("Requested region is (at least partially) outside the largest possible region.");
+    e.SetDataObject(inputPtr);
+    throw e;
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateBinaryGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  BeforeThreadedGenerateData()
+{
+  const InputImageType * inputImage = this->GetInput();
+
+  if (this->m_OrderOfAccuracy > MaximumOrderOfAccuracy)
+  {
+    itkExceptionMacro(<< "OrderOfAccuracy " << this->m_OrderOfAccuracy << " exceeds the maximum of "
+                      << MaximumOrderOfAccuracy << " supported by the binary gradient tables.");
+  }
+
+  // Set up operators
+  using OperatorType = HigherOrderAccurateDerivativeOperator<OperatorValueType, ImageDimension>;
+  std::vector<double> coefficients[ImageDimension];
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    coefficients[i] = OperatorType::ComputeSpacedCoefficients(
+      1, this->m_OrderOfAccuracy, this->m_UseImageSpacing ? inputImage->GetSpacing()[i] : 1.0);
+  }
+
+  this->m_Radius = static_cast<unsigned int>(coefficients[0].size() / 2);
+
+  // Bit k of a table index is the value of the tap at offset k - radius for
+  // the negative table and at offset k + 1 for the positive table.
+  const SizeValueType tableSize = SizeValueType{ 1 } << this->m_Radius;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    this->m_NegativeTapTable[i].resize(tableSize);
+    this->m_PositiveTapTable[i].resize(tableSize);
+    for (SizeValueType bits = 0; bits < tableSize; ++bits)
+    {
+      double negative = 0.0;
+      double positive = 0.0;
+      for (unsigned int k = 0; k < this->m_Radius; ++k)
+      {
+        if ((bits >> k) & 1)
+        {
+          negative += coefficients[i][k];
+          positive += coefficients[i][this->m_Radius + 1 + k];
+        }
+      }
+      this->m_NegativeTapTable[i][bits] = static_cast<OutputValueType>(negative);
+      this->m_PositiveTapTable[i][bits] = static_cast<OutputValueType>(positive);
+    }
+  }
+
+  // Pack every scanline of the buffered region into whole 64 bit words.
+  const typename InputImageType::RegionType & bufferedRegion = inputImage->GetBufferedRegion();
+  const SizeValueType                         lineLength = bufferedRegion.GetSize(0);
+  if (lineLength == 0)
+  {
+    return;
+  }
+  const SizeValueType numberOfLines = bufferedRegion.GetNumberOfPixels() / lineLength;
+  this->m_WordsPerLine = (lineLength + 63) / 64;
+  this->m_PackedMask.assign(numberOfLines * this->m_WordsPerLine, 0);
+
+  const InputPixelType * inputBuffer = inputImage->GetBufferPointer();
+  this->GetMultiThreader()->ParallelizeArray(
+    0,
+    numberOfLines,
+    [this, inputBuffer, lineLength](SizeValueType line) {
+      const InputPixelType * pixel = inputBuffer + line * lineLength;
+      std::uint64_t *        words = this->m_PackedMask.data() + line * this->m_WordsPerLine;
+      for (SizeValueType x = 0; x < lineLength; ++x)
+      {
+        if (pixel[x] == this->m_ForegroundValue)
+        {
+          words[x >> 6] |= std::uint64_t{ 1 } << (x & 63);
+        }
+      }
+    },
+    nullptr);
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateBinaryGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread)
+{
+  const InputImageType * inputImage = this->GetInput();
+  OutputImageType *      outputImage = this->GetOutput();
+
+  if (outputRegionForThread.GetNumberOfPixels() == 0)
+  {
+    return;
+  }
+
+  const typename InputImageType::RegionType & bufferedRegion = inputImage->GetBufferedRegion();
+  OutputPixelType *                           outputBuffer = outputImage->GetBufferPointer();
+
+  const auto            radius = static_cast<OffsetValueType>(this->m_Radius);
+  const auto            lineLength = static_cast<OffsetValueType>(bufferedRegion.GetSize(0));
+  const unsigned int    tapsPerAxis = 2 * this->m_Radius;
+  const OffsetValueType firstX = outputRegionForThread.GetIndex(0) - bufferedRegion.GetIndex(0);
+  const OffsetValueType lastX = firstX + static_cast<OffsetValueType>(outputRegionForThread.GetSize(0)) - 1;
+
+  // The packed scanlines under the taps along each axis but the scanline axis,
+  // ordered from offset -radius to -1 and then from 1 to radius.
+  std::vector<const std::uint64_t *> neighborLines(ImageDimension * tapsPerAxis);
+
+  OutputImageRegionType lineStartRegion = outputRegionForThread;
+  lineStartRegion.SetSize(0, 1);
+
+  for (ImageRegionConstIteratorWithOnlyIndex<OutputImageType> lineIt(outputImage, lineStartRegion);
+       !lineIt.IsAtEnd();
+       ++lineIt)
+  {
+    const IndexType       lineIndex = lineIt.GetIndex();
+    const std::uint64_t * line = this->GetPackedLine(lineIndex);
+
+    for (unsigned int i = 1; i < ImageDimension; ++i)
+    {
+      const OffsetValueType first = bufferedRegion.GetIndex(i);
+      const OffsetValueType last = first + static_cast<OffsetValueType>(bufferedRegion.GetSize(i)) - 1;
+      IndexType             neighborIndex = lineIndex;
+      for (unsigned int t = 0; t < tapsPerAxis; ++t)
+      {
+        const OffsetValueType k = t < this->m_Radius ? static_cast<OffsetValueType>(t) - radius
+                                                     : static_cast<OffsetValueType>(t) - radius + 1;
+        neighborIndex[i] = std::min(std::max(lineIndex[i] + k, first), last);
+        neighborLines[i * tapsPerAxis + t] = this->GetPackedLine(neighborIndex);
+      }
+    }
+
+    OutputPixelType * outputLine = outputBuffer + outputImage->ComputeOffset(lineIndex);
+
+    for (OffsetValueType word = firstX >> 6; word <= lastX >> 6; ++word)
+    {
+      const OffsetValueType wordStart = word * 64;
+      const OffsetValueType low = std::max(firstX, wordStart);
+      const OffsetValueType high = std::min(lastX, wordStart + 63);
+
+      for (OffsetValueType x = low; x <= high; ++x)
+      {
+        outputLine[x - firstX].Fill(NumericTraits<OutputValueType>::ZeroValue());
+      }
+
+      // A pixel has a non-zero gradient only if a tap along some axis differs
+      // from it.
+      const std::uint64_t center = line[word];
+      std::uint64_t       candidates = 0;
+      for (OffsetValueType s = 1; s <= radius; ++s)
+      {
+        candidates |= center ^ ReadBits(line, wordStart - s, 64, lineLength);
+        candidates |= center ^ ReadBits(line, wordStart + s, 64, lineLength);
+      }
+      for (unsigned int i = 1; i < ImageDimension; ++i)
+      {
+        for (unsigned int t = 0; t < tapsPerAxis; ++t)
+        {
+          candidates |= center ^ neighborLines[i * tapsPerAxis + t][word];
+        }
+      }
+      candidates &= (~std::uint64_t{ 0 } >> (63 - (high - wordStart))) & (~std::uint64_t{ 0 } << (low - wordStart));
+      if (candidates == 0)
+      {
+        continue;
+      }
+
+      for (unsigned int j = 0; j < 64; ++j)
+      {
+        if (!((candidates >> j) & 1))
+        {
+          continue;
+        }
+        const OffsetValueType x = wordStart + j;
+
+        OutputPixelType gradient;
+        gradient[0] = this->m_NegativeTapTable[0][ReadBits(line, x - radius, this->m_Radius, lineLength)] +
+                      this->m_PositiveTapTable[0][ReadBits(line, x + 1, this->m_Radius, lineLength)];
+        for (unsigned int i = 1; i < ImageDimension; ++i)
+        {
+          const std::uint64_t * const * taps = neighborLines.data() + i * tapsPerAxis;
+          std::uint64_t                 negativeBits = 0;
+          std::uint64_t                 positiveBits = 0;
+          for (unsigned int k = 0; k < this->m_Radius; ++k)
+          {
+            negativeBits |= ((taps[k][word] >> j) & 1) << k;
+            positiveBits |= ((taps[this->m_Radius + k][word] >> j) & 1) << k;
+          }
+          gradient[i] = this->m_NegativeTapTable[i][negativeBits] + this->m_PositiveTapTable[i][positiveBits];
+        }
+
+        OutputPixelType & output = outputLine[x - firstX];
+        if (this->m_UseImageDirection)
+        {
+          inputImage->TransformLocalVectorToPhysicalVector(gradient, output);
+        }
+        else
+        {
+          output = gradient;
+        }
+
+        if (this->m_NormalizeGradient)
+        {
+          const auto norm = output.GetNorm();
+          if (norm > 0.0)
+          {
+            output /= norm;
+          }
+        }
+      }
+    }
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateBinaryGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  AfterThreadedGenerateData()
+{
+  this->m_PackedMask.clear();
+  this->m_PackedMask.shrink_to_fit();
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+const std::uint64_t *
+HigherOrderAccurateBinaryGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::GetPackedLine(
+  IndexType index) const
+{
+  const InputImageType *                      inputImage = this->GetInput();
+  const typename InputImageType::RegionType & bufferedRegion = inputImage->GetBufferedRegion();
+
+  index[0] = bufferedRegion.GetIndex(0);
+  const SizeValueType line = inputImage->ComputeOffset(index) / bufferedRegion.GetSize(0);
+  return this->m_PackedMask.data() + line * this->m_WordsPerLine;
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+std::uint64_t
+HigherOrderAccurateBinaryGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::ReadBits(
+  const std::uint64_t * line,
+  OffsetValueType       start,
+  unsigned int          count,
+  OffsetValueType       length)
+{
+  const std::uint64_t mask = count < 64 ? (std::uint64_t{ 1 } << count) - 1 : ~std::uint64_t{ 0 };
+
+  if (start >= 0 && start + static_cast<OffsetValueType>(count) <= length)
+  {
+    const OffsetValueType word = start >> 6;
+    const unsigned int    shift = static_cast<unsigned int>(start & 63);
+    std::uint64_t         bits = line[word] >> shift;
+    if (shift != 0 && shift + count > 64)
+    {
+      bits |= line[word + 1] << (64 - shift);
+    }
+    return bits & mask;
+  }
+
+  // Zero flux Neumann boundary condition: clamp to the ends of the scanline.
+  std::uint64_t bits = 0;
+  for (unsigned int i = 0; i < count; ++i)
+  {
+    const OffsetValueType position = std::min(std::max(start + static_cast<OffsetValueType>(i), OffsetValueType{ 0 }),
+                                              length - 1);
+    bits |= ((line[position >> 6] >> (position & 63)) & 1) << i;
+  }
+  return bits;
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateBinaryGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::PrintSelf(
+  std::ostream & os,
+  Indent         indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "ForegroundValue: "
+     << static_cast<typename NumericTraits<InputPixelType>::PrintType>(this->m_ForegroundValue) << std::endl;
+  os << indent << "UseImageSpacing: " << (this->m_UseImageSpacing ? "On" : "Off") << std::endl;
+  os << indent << "UseImageDirection = " << (this->m_UseImageDirection ? "On" : "Off") << std::endl;
+  os << indent << "NormalizeGradient: " << (this->m_NormalizeGradient ? "On" : "Off") << std::endl;
+  os << indent << "OrderOfAccuracy: " << this->m_OrderOfAccuracy << std::endl;
+}
+
+} // end namespace itk
+
+#endif
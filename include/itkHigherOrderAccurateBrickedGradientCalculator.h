@@ -0,0 +1,184 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateBrickedGradientCalculator_h
+#define itkHigherOrderAccurateBrickedGradientCalculator_h
+
+// The configuration header is generated by CMake; without it, as when the
+// headers are used on their own, the filters are header-only.
+#if defined(__has_include)
+#  if __has_include("itkHigherOrderAccurateGradientConfigure.h")
+#    include "itkHigherOrderAccurateGradientConfigure.h"
+#  endif
+#else
+#  include "itkHigherOrderAccurateGradientConfigure.h"
+#endif
+#include "itkCovariantVector.h"
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkMatrix.h"
+#include "itkMultiThreaderBase.h"
+#include "itkVector.h"
+#include "itkHigherOrderAccurateBrickedLayout.h"
+#include "itkHigherOrderAccurateDerivativeOperator.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class HigherOrderAccurateBrickedGradientCalculator
+ *
+ * \brief Compute higher order accurate gradients of volumes stored as
+ * bricks.
+ *
+ * The input and the output are buffers in the HigherOrderAccurateBrickedLayout
+ * they share, so bricked data is processed without being converted to raster
+ * order and back.  Each work unit processes a range of consecutive bricks:
+ * every brick and a halo of the operator radius are gathered into a small
+ * raster tile, allocated once per work unit, where the taps along every axis
+ * stay in cache, and the gradient of the voxels of the brick is written back
+ * in the layout.  The positions in the layout are walked row by row from
+ * per-axis tables rather than computed for every voxel.
+ *
+ * The Spacing and Direction of the sampling grid are set on the calculator
+ * and default to unit spacing and the identity.  The gradient equals that of
+ * HigherOrderAccurateGradientImageFilter on an image holding the same values,
+ * with the same zero flux Neumann boundary condition.  The padding voxels of
+ * the output are set to zero.
+ *
+ * \sa HigherOrderAccurateBrickedLayout
+ * \sa HigherOrderAccurateGradientImageFilter
+ *
+ * \ingroup HigherOrderAccurateGradient
+ */
+template <typename TInputValueType, unsigned int VDimension, typename TOutputValueType = TInputValueType>
+class ITK_TEMPLATE_EXPORT HigherOrderAccurateBrickedGradientCalculator : public Object
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(HigherOrderAccurateBrickedGradientCalculator);
+
+  static constexpr unsigned int ImageDimension = VDimension;
+
+  /** Standard class type aliases. */
+  using Self = HigherOrderAccurateBrickedGradientCalculator;
+  using Superclass = Object;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(HigherOrderAccurateBrickedGradientCalculator, Object);
+
+  using InputValueType = TInputValueType;
+  using OutputValueType = TOutputValueType;
+  using OutputPixelType = CovariantVector<OutputValueType, ImageDimension>;
+  using LayoutType = HigherOrderAccurateBrickedLayout<ImageDimension>;
+  using SizeType = typename LayoutType::SizeType;
+  using IndexType = typename LayoutType::IndexType;
+  using SpacingType = Vector<SpacePrecisionType, ImageDimension>;
+  using DirectionType = Matrix<SpacePrecisionType, ImageDimension, ImageDimension>;
+
+  /** Set/Get the spacing of the sampling grid along each axis. */
+  itkSetMacro(Spacing, SpacingType);
+  itkGetConstReferenceMacro(Spacing, SpacingType);
+
+  /** Set/Get the direction cosines of the sampling grid.  The gradient is
+   * rotated to physical space as with UseImageDirection. */
+  itkSetMacro(Direction, DirectionType);
+  itkGetConstReferenceMacro(Direction, DirectionType);
+
+  /** Set/Get the order of accuracy of the derivative operator.  For more
+   * information, see HigherOrderAccurateDerivativeOperator. */
+  itkSetMacro(OrderOfAccuracy, unsigned int);
+  itkGetConstMacro(OrderOfAccuracy, unsigned int);
+
+  /** Set/Get the number of work units the bricks are distributed over. */
+  void
+  SetNumberOfWorkUnits(ThreadIdType numberOfWorkUnits);
+  ThreadIdType
+  GetNumberOfWorkUnits() const;
+
+  /** Write the gradient of input to output, both buffers of
+   * layout.GetBufferSize() values in layout. */
+  void
+  ComputeGradient(const LayoutType & layout, const InputValueType * input, OutputPixelType * output) const;
+
+protected:
+  HigherOrderAccurateBrickedGradientCalculator();
+  ~HigherOrderAccurateBrickedGradientCalculator() override = default;
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  using OperatorType = HigherOrderAccurateDerivativeOperator<double, ImageDimension>;
+
+  SpacingType m_Spacing;
+
+  DirectionType m_Direction;
+
+  unsigned int m_OrderOfAccuracy{ 2 };
+
+  MultiThreaderBase::Pointer m_MultiThreader;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkHigherOrderAccurateBrickedGradientCalculator.hxx"
+#endif
+
+#endif
+
+/** Explicit instantiations */
+#if defined(HigherOrderAccurateGradient_EXPLICIT_INSTANTIATION)
+#  ifndef ITK_TEMPLATE_EXPLICIT_HigherOrderAccurateBrickedGradientCalculator
+// The common instantiations are compiled once in the HigherOrderAccurateGradient
+// library.
+//
+// IMPORTANT: Since within the same compilation unit,
+//            ITK_TEMPLATE_EXPLICIT_<classname> defined and undefined states
+//            need to be considered. This code *MUST* be *OUTSIDE* the header
+//            guards.
+//
+#    include "HigherOrderAccurateGradientExport.h"
+#    if defined(HigherOrderAccurateGradient_EXPORTS)
+//   We are building this library
+#      define HigherOrderAccurateGradient_EXPORT_EXPLICIT ITK_FORWARD_EXPORT
+#    else
+//   We are using this library
+#      define HigherOrderAccurateGradient_EXPORT_EXPLICIT HigherOrderAccurateGradient_EXPORT
+#    endif
+namespace itk
+{
+
+ITK_GCC_PRAGMA_DIAG_PUSH()
+ITK_GCC_PRAGMA_DIAG(ignored "-Wattributes")
+
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateBrickedGradientCalculator<float, 3, float>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateBrickedGradientCalculator<double, 3, double>;
+
+ITK_GCC_PRAGMA_DIAG_POP()
+
+} // end namespace itk
+#    undef HigherOrderAccurateGradient_EXPORT_EXPLICIT
+#  endif
+#endif
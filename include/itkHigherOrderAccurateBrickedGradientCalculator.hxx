@@ -0,0 +1,252 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateBrickedGradientCalculator_hxx
+#define itkHigherOrderAccurateBrickedGradientCalculator_hxx
+#include "itkHigherOrderAccurateBrickedGradientCalculator.h"
+
+#include "itkHigherOrderAccurateDerivativeOperator.h"
+
+#include <algorithm>
+
+namespace itk
+{
+
+template <typename TInputValueType, unsigned int VDimension, typename TOutputValueType>
+HigherOrderAccurateBrickedGradientCalculator<TInputValueType, VDimension, TOutputValueType>::
+  HigherOrderAccurateBrickedGradientCalculator()
+  : m_MultiThreader(MultiThreaderBase::New())
+{
+  m_Spacing.Fill(1.0);
+  m_Direction.SetIdentity();
+}
+
+
+template <typename TInputValueType, unsigned int VDimension, typename TOutputValueType>
+void
+HigherOrderAccurateBrickedGradientCalculator<TInputValueType, VDimension, TOutputValueType>::SetNumberOfWorkUnits(
+  ThreadIdType numberOfWorkUnits)
+{
+  if (numberOfWorkUnits != this->m_MultiThreader->GetNumberOfWorkUnits())
+  {
+    this->m_MultiThreader->SetNumberOfWorkUnits(numberOfWorkUnits);
+    this->Modified();
+  }
+}
+
+
+template <typename TInputValueType, unsigned int VDimension, typename TOutputValueType>
+ThreadIdType
+HigherOrderAccurateBrickedGradientCalculator<TInputValueType, VDimension, TOutputValueType>::GetNumberOfWorkUnits()
+  const
+{
+  return this->m_MultiThreader->GetNumberOfWorkUnits();
+}
+
+
+template <typename TInputValueType, unsigned int VDimension, typename TOutputValueType>
+void
+HigherOrderAccurateBrickedGradientCalculator<TInputValueType, VDimension, TOutputValueType>::ComputeGradient(
+  const LayoutType &     layout,
+  const InputValueType * input,
+  OutputPixelType *      output) const
+{
+  if (input == nullptr || output == nullptr)
+  {
+    itkExceptionMacro(<< "The input and output buffers must not be null.");
+  }
+
+  std::vector<double> coefficients[ImageDimension];
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    coefficients[i] = OperatorType::ComputeSpacedCoefficients(1, this->m_OrderOfAccuracy, this->m_Spacing[i]);
+  }
+  const auto radius = static_cast<IndexValueType>(coefficients[0].size() / 2);
+
+  bool identityDirection = true;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    for (unsigned int j = 0; j < ImageDimension; ++j)
+    {
+      identityDirection = identityDirection && this->m_Direction[i][j] == (i == j ? 1.0 : 0.0);
+    }
+  }
+  const DirectionType & direction = this->m_Direction;
+
+  const SizeType &     size = layout.GetSize();
+  const SizeType &     numberOfBricks = layout.GetNumberOfBricks();
+  const auto           brickSize = static_cast<IndexValueType>(layout.GetBrickSize());
+  const IndexValueType tileEdge = brickSize + 2 * radius;
+  OffsetValueType      tileStrides[ImageDimension];
+  OffsetValueType      tileSize = 1;
+  SizeValueType        totalNumberOfBricks = 1;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    tileStrides[i] = tileSize;
+    tileSize *= tileEdge;
+    totalNumberOfBricks *= numberOfBricks[i];
+  }
+
+  // Step through the rows along the fastest axis of a box of the given edge
+  // length; returns false past the last one.
+  const auto nextRow = [](IndexType & position, IndexValueType edge) {
+    for (unsigned int i = 1; i < ImageDimension; ++i)
+    {
+      if (++position[i] < edge)
+      {
+        return true;
+      }
+      position[i] = 0;
+    }
+    return false;
+  };
+
+  // One range of consecutive bricks per work unit, which reuses its tile and
+  // offset tables for all its bricks.
+  const SizeValueType numberOfRanges =
+    std::min(static_cast<SizeValueType>(this->GetNumberOfWorkUnits()), totalNumberOfBricks);
+  this->m_MultiThreader->ParallelizeArray(
+    0,
+    numberOfRanges,
+    [&](SizeValueType range) {
+      std::vector<double>        tile(tileSize);
+      std::vector<SizeValueType> tileAxisOffsets[ImageDimension];
+      std::vector<SizeValueType> brickAxisOffsets[ImageDimension];
+      for (unsigned int i = 0; i < ImageDimension; ++i)
+      {
+        tileAxisOffsets[i].resize(tileEdge);
+        brickAxisOffsets[i].resize(brickSize);
+      }
+
+      const SizeValueType firstBrick = range * totalNumberOfBricks / numberOfRanges;
+      const SizeValueType endBrick = (range + 1) * totalNumberOfBricks / numberOfRanges;
+      for (SizeValueType brick = firstBrick; brick < endBrick; ++brick)
+      {
+        IndexType     origin;
+        SizeValueType remainder = brick;
+        for (unsigned int i = 0; i < ImageDimension; ++i)
+        {
+          origin[i] = static_cast<IndexValueType>(remainder % numberOfBricks[i]) * brickSize;
+          remainder /= numberOfBricks[i];
+        }
+
+        // The position of a voxel in the layout is a sum of one term per
+        // axis, tabulated for the tile, clamped to the volume, and for the
+        // brick.
+        for (unsigned int i = 0; i < ImageDimension; ++i)
+        {
+          const auto last = static_cast<IndexValueType>(size[i]) - 1;
+          for (IndexValueType x = 0; x < tileEdge; ++x)
+          {
+            tileAxisOffsets[i][x] =
+              layout.ComputeAxisOffset(i, std::min(std::max(origin[i] + x - radius, IndexValueType{ 0 }), last));
+          }
+          for (IndexValueType x = 0; x < brickSize; ++x)
+          {
+            brickAxisOffsets[i][x] = layout.ComputeAxisOffset(i, origin[i] + x);
+          }
+        }
+
+        // Gather the brick and its halo, row by row.
+        IndexType       position{};
+        OffsetValueType tileOffset = 0;
+        do
+        {
+          SizeValueType rowOffset = 0;
+          for (unsigned int i = 1; i < ImageDimension; ++i)
+          {
+            rowOffset += tileAxisOffsets[i][position[i]];
+          }
+          for (IndexValueType x = 0; x < tileEdge; ++x)
+          {
+            tile[tileOffset++] = static_cast<double>(input[rowOffset + tileAxisOffsets[0][x]]);
+          }
+        } while (nextRow(position, tileEdge));
+
+        // All the taps of the voxels of the brick lie in the tile.
+        position.Fill(0);
+        do
+        {
+          SizeValueType   rowOffset = 0;
+          OffsetValueType rowCenter = radius;
+          bool            rowInside = true;
+          for (unsigned int i = 1; i < ImageDimension; ++i)
+          {
+            rowOffset += brickAxisOffsets[i][position[i]];
+            rowCenter += (position[i] + radius) * tileStrides[i];
+            rowInside = rowInside && origin[i] + position[i] < static_cast<IndexValueType>(size[i]);
+          }
+          for (IndexValueType x = 0; x < brickSize; ++x)
+          {
+            OutputPixelType & value = output[rowOffset + brickAxisOffsets[0][x]];
+            if (!rowInside || origin[0] + x >= static_cast<IndexValueType>(size[0]))
+            {
+              // A padding voxel holds no gradient.
+              value.Fill(NumericTraits<OutputValueType>::ZeroValue());
+              continue;
+            }
+
+            const OffsetValueType center = rowCenter + x;
+            double                gradient[ImageDimension];
+            for (unsigned int i = 0; i < ImageDimension; ++i)
+            {
+              gradient[i] = 0.0;
+              const double * taps = tile.data() + center - radius * tileStrides[i];
+              for (IndexValueType j = 0; j <= 2 * radius; ++j)
+              {
+                gradient[i] += coefficients[i][j] * taps[j * tileStrides[i]];
+              }
+            }
+
+            for (unsigned int i = 0; i < ImageDimension; ++i)
+            {
+              double component = gradient[i];
+              if (!identityDirection)
+              {
+                component = 0.0;
+                for (unsigned int k = 0; k < ImageDimension; ++k)
+                {
+                  component += direction[i][k] * gradient[k];
+                }
+              }
+              value[i] = static_cast<OutputValueType>(component);
+            }
+          }
+        } while (nextRow(position, brickSize));
+      }
+    },
+    nullptr);
+}
+
+
+template <typename TInputValueType, unsigned int VDimension, typename TOutputValueType>
+void
+HigherOrderAccurateBrickedGradientCalculator<TInputValueType, VDimension, TOutputValueType>::PrintSelf(
+  std::ostream & os,
+  Indent         indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Spacing: " << this->m_Spacing << std::endl;
+  os << indent << "Direction: " << this->m_Direction << std::endl;
+  os << indent << "OrderOfAccuracy: " << this->m_OrderOfAccuracy << std::endl;
+  os << indent << "NumberOfWorkUnits: " << this->GetNumberOfWorkUnits() << std::endl;
+}
+
+} // end namespace itk
+
+#endif
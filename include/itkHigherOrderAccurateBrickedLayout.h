@@ -0,0 +1,300 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateBrickedLayout_h
+#define itkHigherOrderAccurateBrickedLayout_h
+
+#include "itkIndex.h"
+#include "itkMacro.h"
+#include "itkSize.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace itk
+{
+
+/** \class HigherOrderAccurateBrickedLayoutEnums
+ *
+ * \brief Contains the enums used by HigherOrderAccurateBrickedLayout.
+ *
+ * \ingroup HigherOrderAccurateGradient
+ */
+class HigherOrderAccurateBrickedLayoutEnums
+{
+public:
+  /** \class VoxelOrder
+   * \ingroup HigherOrderAccurateGradient
+   * Order of the voxels within a brick. */
+  enum class VoxelOrder : uint8_t
+  {
+    Raster,
+    Morton
+  };
+};
+
+/** Define how to print enumerations */
+inline std::ostream &
+operator<<(std::ostream & out, const HigherOrderAccurateBrickedLayoutEnums::VoxelOrder value)
+{
+  return out << [value] {
+    switch (value)
+    {
+      case HigherOrderAccurateBrickedLayoutEnums::VoxelOrder::Raster:
+        return "itk::HigherOrderAccurateBrickedLayoutEnums::VoxelOrder::Raster";
+      case HigherOrderAccurateBrickedLayoutEnums::VoxelOrder::Morton:
+        return "itk::HigherOrderAccurateBrickedLayoutEnums::VoxelOrder::Morton";
+      default:
+        return "INVALID VALUE FOR itk::HigherOrderAccurateBrickedLayoutEnums::VoxelOrder";
+    }
+  }();
+}
+
+/** \class HigherOrderAccurateBrickedLayout
+ *
+ * \brief Description of a volume stored as cubic bricks.
+ *
+ * The volume is divided into bricks of BrickSize voxels along every axis,
+ * BrickSize being a power of two.  The bricks are stored one after the
+ * other, in raster order of the grid of bricks, and the voxels of a brick
+ * either in raster order or in Morton (Z) order, which interleaves the bits
+ * of the voxel coordinates within the brick.  A volume whose size is not a
+ * multiple of BrickSize is padded to whole bricks; the padding voxels are
+ * never read.  A volume in plain Z order is one Morton brick of the next
+ * power of two of its largest size.
+ *
+ * Neighbors along every axis, not only along the fastest one, are at most a
+ * brick apart in memory, so stencils along the slow axes keep their
+ * locality.  CopyFromImage() and CopyToImage() convert between this layout
+ * and the raster order of an Image buffer.
+ *
+ * \sa HigherOrderAccurateBrickedGradientCalculator
+ *
+ * \ingroup HigherOrderAccurateGradient
+ */
+template <unsigned int VDimension>
+class HigherOrderAccurateBrickedLayout
+{
+public:
+  static constexpr unsigned int Dimension = VDimension;
+
+  using SizeType = Size<VDimension>;
+  using IndexType = Index<VDimension>;
+  using VoxelOrderEnum = HigherOrderAccurateBrickedLayoutEnums::VoxelOrder;
+
+  HigherOrderAccurateBrickedLayout(const SizeType &     size,
+                                   SizeValueType        brickSize = 8,
+                                   const VoxelOrderEnum voxelOrder = VoxelOrderEnum::Raster)
+    : m_Size(size)
+    , m_BrickSize(brickSize)
+    , m_VoxelOrder(voxelOrder)
+  {
+    if (brickSize == 0 || (brickSize & (brickSize - 1)) != 0)
+    {
+      itkGenericExceptionMacro(<< "The brick size " << brickSize << " is not a power of two.");
+    }
+    while ((SizeValueType{ 1 } << m_BrickShift) < brickSize)
+    {
+      ++m_BrickShift;
+    }
+
+    SizeValueType voxelsPerBrick = 1;
+    for (unsigned int i = 0; i < VDimension; ++i)
+    {
+      voxelsPerBrick *= brickSize;
+    }
+    SizeValueType brickStride = voxelsPerBrick;
+    for (unsigned int i = 0; i < VDimension; ++i)
+    {
+      m_NumberOfBricks[i] = (size[i] + brickSize - 1) >> m_BrickShift;
+      m_BrickStrides[i] = brickStride;
+      brickStride *= m_NumberOfBricks[i];
+    }
+    m_BufferSize = brickStride;
+
+    // The offset of a voxel within its brick is the sum of one term per
+    // axis, tabulated for the coordinates within a brick.
+    SizeValueType rasterStride = 1;
+    for (unsigned int i = 0; i < VDimension; ++i)
+    {
+      m_VoxelOffsets[i].resize(brickSize);
+      for (SizeValueType x = 0; x < brickSize; ++x)
+      {
+        SizeValueType offset = 0;
+        if (voxelOrder == VoxelOrderEnum::Morton)
+        {
+          for (unsigned int bit = 0; bit < m_BrickShift; ++bit)
+          {
+            offset |= ((x >> bit) & 1) << (bit * VDimension + i);
+          }
+        }
+        else
+        {
+          offset = x * rasterStride;
+        }
+        m_VoxelOffsets[i][x] = offset;
+      }
+      rasterStride *= brickSize;
+    }
+  }
+
+  const SizeType &
+  GetSize() const
+  {
+    return m_Size;
+  }
+
+  SizeValueType
+  GetBrickSize() const
+  {
+    return m_BrickSize;
+  }
+
+  VoxelOrderEnum
+  GetVoxelOrder() const
+  {
+    return m_VoxelOrder;
+  }
+
+  /** Number of bricks along each axis. */
+  const SizeType &
+  GetNumberOfBricks() const
+  {
+    return m_NumberOfBricks;
+  }
+
+  /** Number of values in the buffer, padding included. */
+  SizeValueType
+  GetBufferSize() const
+  {
+    return m_BufferSize;
+  }
+
+  /** Position in the buffer of the voxel at index, which must lie in the
+   * volume padded to whole bricks. */
+  SizeValueType
+  ComputeOffset(const IndexType & index) const
+  {
+    SizeValueType offset = 0;
+    for (unsigned int i = 0; i < VDimension; ++i)
+    {
+      offset += this->ComputeAxisOffset(i, index[i]);
+    }
+    return offset;
+  }
+
+  /** Term of the coordinate x along axis in the position of a voxel: the
+   * position is the sum of the terms of its coordinates, so a walk can
+   * tabulate them per axis. */
+  SizeValueType
+  ComputeAxisOffset(unsigned int axis, IndexValueType x) const
+  {
+    const auto coordinate = static_cast<SizeValueType>(x);
+    return (coordinate >> m_BrickShift) * m_BrickStrides[axis] + m_VoxelOffsets[axis][coordinate & (m_BrickSize - 1)];
+  }
+
+  /** Copy the buffer of image, which must have the size of the volume, to
+   * bricked.  The padding voxels are set to zero. */
+  template <typename TImage>
+  void
+  CopyFromImage(const TImage * image, typename TImage::PixelType * bricked) const
+  {
+    this->VerifyImageSize(image);
+    if (m_BufferSize != image->GetBufferedRegion().GetNumberOfPixels())
+    {
+      std::fill(bricked, bricked + m_BufferSize, typename TImage::PixelType{});
+    }
+    const typename TImage::PixelType * raster = image->GetBufferPointer();
+    this->ForEachVoxel([&](const IndexType & index, SizeValueType rasterOffset) {
+      bricked[this->ComputeOffset(index)] = raster[rasterOffset];
+    });
+  }
+
+  /** Copy bricked to the buffer of image, which must have the size of the
+   * volume. */
+  template <typename TImage>
+  void
+  CopyToImage(const typename TImage::PixelType * bricked, TImage * image) const
+  {
+    this->VerifyImageSize(image);
+    typename TImage::PixelType * raster = image->GetBufferPointer();
+    this->ForEachVoxel([&](const IndexType & index, SizeValueType rasterOffset) {
+      raster[rasterOffset] = bricked[this->ComputeOffset(index)];
+    });
+  }
+
+private:
+  template <typename TImage>
+  void
+  VerifyImageSize(const TImage * image) const
+  {
+    if (image->GetBufferedRegion().GetSize() != m_Size)
+    {
+      itkGenericExceptionMacro(<< "The buffered size " << image->GetBufferedRegion().GetSize()
+                               << " of the image differs from the size " << m_Size << " of the layout.");
+    }
+  }
+
+  /** Call function with the index and raster offset of every voxel, in
+   * raster order. */
+  template <typename TFunction>
+  void
+  ForEachVoxel(const TFunction & function) const
+  {
+    for (unsigned int i = 0; i < VDimension; ++i)
+    {
+      if (m_Size[i] == 0)
+      {
+        return;
+      }
+    }
+    IndexType     index{};
+    SizeValueType rasterOffset = 0;
+    while (true)
+    {
+      function(index, rasterOffset++);
+
+      unsigned int i = 0;
+      for (; i < VDimension; ++i)
+      {
+        if (static_cast<SizeValueType>(++index[i]) < m_Size[i])
+        {
+          break;
+        }
+        index[i] = 0;
+      }
+      if (i == VDimension)
+      {
+        return;
+      }
+    }
+  }
+
+  SizeType       m_Size;
+  SizeValueType  m_BrickSize;
+  VoxelOrderEnum m_VoxelOrder;
+  unsigned int   m_BrickShift{ 0 };
+  SizeType       m_NumberOfBricks;
+  SizeValueType  m_BrickStrides[VDimension];
+  SizeValueType  m_BufferSize;
+
+  std::vector<SizeValueType> m_VoxelOffsets[VDimension];
+};
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,200 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateCurvatureImageFilter_h
+#define itkHigherOrderAccurateCurvatureImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkHigherOrderAccurateDerivativeOperator.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class HigherOrderAccurateCurvatureImageFilter
+ *
+ * \brief Compute the mean and Gaussian curvature of the iso-surfaces of an
+ * image from higher order accurate first and second derivatives.
+ *
+ * The gradient g and the Hessian H are evaluated at every pixel in one pass
+ * with the first and second order HigherOrderAccurateDerivativeOperator, and
+ * combined without storing any intermediate image into
+ *
+ * \f[
+ *   \kappa_M = \nabla \cdot \frac{\nabla \phi}{|\nabla \phi|}
+ *            = \frac{|g|^2 \mathrm{tr}(H) - g^T H g}{|g|^3}
+ * \f]
+ *
+ * which is the sum of the principal curvatures, as used by the level set
+ * curvature terms, and
+ *
+ * \f[
+ *   \kappa_G = -\frac{1}{|g|^{N+1}}
+ *              \det \begin{pmatrix} H & g \\ g^T & 0 \end{pmatrix}
+ * \f]
+ *
+ * which is the product of the principal curvatures.  The mean curvature is
+ * the first output and the Gaussian curvature the second one; only the
+ * enabled outputs are computed and allocated.  Where the gradient magnitude is
+ * below the GradientMagnitudeThreshold, both curvatures are zero.
+ *
+ * The curvatures do not depend on the orientation of the image, so the image
+ * direction is not used.
+ *
+ * \sa HigherOrderAccurateGradientImageFilter
+ * \sa HigherOrderAccurateDerivativeOperator
+ *
+ * \ingroup HigherOrderAccurateGradient
+ */
+template <typename TInputImage, typename TOperatorValueType = float, typename TOutputValueType = float>
+class HigherOrderAccurateCurvatureImageFilter
+  : public ImageToImageFilter<TInputImage, Image<TOutputValueType, TInputImage::ImageDimension>>
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(HigherOrderAccurateCurvatureImageFilter);
+
+  /** Extract dimension from input image. */
+  static constexpr unsigned int ImageDimension = TInputImage::ImageDimension;
+
+  /** Standard class type alias. */
+  using Self = HigherOrderAccurateCurvatureImageFilter;
+
+  /** Convenient type alias for simplifying declarations. */
+  using InputImageType = TInputImage;
+  using InputImagePointer = typename InputImageType::Pointer;
+  using OutputImageType = Image<TOutputValueType, ImageDimension>;
+  using OutputImagePointer = typename OutputImageType::Pointer;
+
+  /** Standard class type alias. */
+  using Superclass = ImageToImageFilter<InputImageType, OutputImageType>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(HigherOrderAccurateCurvatureImageFilter, ImageToImageFilter);
+
+  /** Image type alias support. */
+  using InputPixelType = typename InputImageType::PixelType;
+  using OperatorValueType = TOperatorValueType;
+  using OutputValueType = TOutputValueType;
+  using OutputImageRegionType = typename OutputImageType::RegionType;
+
+  /** Set/Get whether or not the filter will use the spacing of the input
+      image in its calculations */
+  itkSetMacro(UseImageSpacing, bool);
+  itkGetConstMacro(UseImageSpacing, bool);
+  itkBooleanMacro(UseImageSpacing);
+
+  /** Set/Get the order of accuracy of the derivative operators.  For more
+   * information, see HigherOrderAccurateDerivativeOperator. */
+  itkSetMacro(OrderOfAccuracy, unsigned int);
+  itkGetConstMacro(OrderOfAccuracy, unsigned int);
+
+  /** Set/Get whether the mean curvature is computed.  The default value of
+   * this flag is On. */
+  itkSetMacro(ComputeMeanCurvature, bool);
+  itkGetConstMacro(ComputeMeanCurvature, bool);
+  itkBooleanMacro(ComputeMeanCurvature);
+
+  /** Set/Get whether the Gaussian curvature is computed.  The default value
+   * of this flag is Off. */
+  itkSetMacro(ComputeGaussianCurvature, bool);
+  itkGetConstMacro(ComputeGaussianCurvature, bool);
+  itkBooleanMacro(ComputeGaussianCurvature);
+
+  /** Set/Get the gradient magnitude below which the curvatures are zero.
+   * Defaults to 1e-9. */
+  itkSetMacro(GradientMagnitudeThreshold, double);
+  itkGetConstMacro(GradientMagnitudeThreshold, double);
+
+  /** Get the mean curvature.  Only valid when ComputeMeanCurvature is
+   * enabled. */
+  OutputImageType *
+  GetMeanCurvatureOutput();
+  const OutputImageType *
+  GetMeanCurvatureOutput() const;
+
+  /** Get the Gaussian curvature.  Only valid when ComputeGaussianCurvature is
+   * enabled. */
+  OutputImageType *
+  GetGaussianCurvatureOutput();
+  const OutputImageType *
+  GetGaussianCurvatureOutput() const;
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  /** Begin concept checking */
+  itkConceptMacro(InputConvertibleToDoubleCheck, (Concept::Convertible<InputPixelType, double>));
+  itkConceptMacro(OutputHasNumericTraitsCheck, (Concept::HasNumericTraits<OutputValueType>));
+  /** End concept checking */
+#endif
+
+protected:
+  HigherOrderAccurateCurvatureImageFilter();
+  ~HigherOrderAccurateCurvatureImageFilter() override = default;
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** The input requested region is padded by the operator radius.
+   *
+   * \sa ImageToImageFilter::GenerateInputRequestedRegion() */
+  void
+  GenerateInputRequestedRegion() override;
+
+  /** Only the enabled outputs are allocated. */
+  void
+  AllocateOutputs() override;
+
+  /** Build the scaled first and second derivative coefficients. */
+  void
+  BeforeThreadedGenerateData() override;
+
+  void
+  DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread) override;
+
+private:
+  using OperatorType = HigherOrderAccurateDerivativeOperator<OperatorValueType, ImageDimension>;
+
+  /** Number of distinct entries of the symmetric Hessian. */
+  static constexpr unsigned int NumberOfHessianComponents = ImageDimension * (ImageDimension + 1) / 2;
+
+  bool m_UseImageSpacing{ true };
+
+  unsigned int m_OrderOfAccuracy{ 2 };
+
+  bool m_ComputeMeanCurvature{ true };
+
+  bool m_ComputeGaussianCurvature{ false };
+
+  double m_GradientMagnitudeThreshold{ 1e-9 };
+
+  /** First and second derivative coefficients along each axis, for the
+   * offsets -radius..radius. */
+  std::vector<double> m_FirstOrderCoefficients[ImageDimension];
+  std::vector<double> m_SecondOrderCoefficients[ImageDimension];
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkHigherOrderAccurateCurvatureImageFilter.hxx"
+#endif
+
+#endif
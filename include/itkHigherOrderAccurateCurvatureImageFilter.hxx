@@ -0,0 +1,428 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateCurvatureImageFilter_hxx
+#define itkHigherOrderAccurateCurvatureImageFilter_hxx
+#include "itkHigherOrderAccurateCurvatureImageFilter.h"
+
+#include "itkImageRegionConstIteratorWithOnlyIndex.h"
+#include "itkHigherOrderAccurateDerivativeOperator.h"
+#include "itkMatrix.h"
+#include "vnl/algo/vnl_determinant.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace itk
+{
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+HigherOrderAccurateCurvatureImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  HigherOrderAccurateCurvatureImageFilter()
+{
+  this->SetNumberOfRequiredOutputs(2);
+  this->SetNthOutput(1, this->MakeOutput(1));
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+auto
+HigherOrderAccurateCurvatureImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::GetMeanCurvatureOutput()
+  -> OutputImageType *
+{
+  return this->GetOutput();
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+auto
+HigherOrderAccurateCurvatureImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::GetMeanCurvatureOutput()
+  const -> const OutputImageType *
+{
+  return this->GetOutput();
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+auto
+HigherOrderAccurateCurvatureImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  GetGaussianCurvatureOutput() -> OutputImageType *
+{
+  return itkDynamicCastInDebugMode<OutputImageType *>(this->ProcessObject::GetOutput(1));
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+auto
+HigherOrderAccurateCurvatureImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  GetGaussianCurvatureOutput() const -> const OutputImageType *
+{
+  return itkDynamicCastInDebugMode<const OutputImageType *>(this->ProcessObject::GetOutput(1));
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateCurvatureImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  GenerateInputRequestedRegion()
+{
+  // call the superclass' implementation of this method
+  Superclass::GenerateInputRequestedRegion();
+
+  // get pointers to the input and output
+  InputImagePointer  inputPtr = const_cast<InputImageType *>(this->GetInput());
+  OutputImagePointer outputPtr = this->GetOutput();
+
+  if (!inputPtr || !outputPtr)
+  {
+    return;
+  }
+
+  // Build an operator so that we can determine the kernel size.  The first
+  // and second order operators have the same radius.
+  HigherOrderAccurateDerivativeOperator<OperatorValueType, ImageDimension> oper;
+  oper.SetDirection(0);
+  oper.SetOrder(1);
+  oper.SetOrderOfAccuracy(this->m_OrderOfAccuracy);
+  oper.CreateDirectional();
+  unsigned long radius = oper.GetRadius()[0];
+
+  // get a copy of the input requested region (should equal the output
+  // requested region)
+  typename TInputImage::RegionType inputRequestedRegion;
+  inputRequestedRegion = inputPtr->GetRequestedRegion();
+
+  // pad the input requested region by the operator radius
+  inputRequestedRegion.PadByRadius(radius);
+
+  // crop the input requested region at the input's largest possible region
+  if (inputRequestedRegion.Crop(inputPtr->GetLargestPossibleRegion()))
+  {
+    inputPtr->SetRequestedRegion(inputRequestedRegion);
+    return;
+  }
+  else
+  {
+    // Couldn't crop the region (requested region is outside the largest
+    // possible region).  Throw an exception.
+
+    // store what we tried to request (prior to trying to crop)
+    inputPtr->SetRequestedRegion(inputRequestedRegion);
+
+    // build an exception
+    InvalidRequestedRegionError e(__FILE__, __LINE__);
+    e.SetLocation(ITK_LOCATION);
+    e.SetDescription("Requested region is (at least partially) outside the largest possible region.");
+    e.SetDataObject(inputPtr);
+    throw e;
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateCurvatureImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::AllocateOutputs()
+{
+  if (this->m_ComputeMeanCurvature)
+  {
+    OutputImageType * meanOutputPtr = this->GetMeanCurvatureOutput();
+    meanOutputPtr->SetBufferedRegion(meanOutputPtr->GetRequestedRegion());
+    meanOutputPtr->Allocate();
+  }
+
+  if (this->m_ComputeGaussianCurvature)
+  {
+    OutputImageType * gaussianOutputPtr = this->GetGaussianCurvatureOutput();
+    gaussianOutputPtr->SetBufferedRegion(gaussianOutputPtr->GetRequestedRegion());
+    gaussianOutputPtr->Allocate();
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateCurvatureImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  BeforeThreadedGenerateData()
+{
+  if (!this->m_ComputeMeanCurvature && !this->m_ComputeGaussianCurvature)
+  {
+    itkExceptionMacro(<< "At least one of ComputeMeanCurvature and ComputeGaussianCurvature must be enabled.");
+  }
+
+  const InputImageType * inputImage = this->GetInput();
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    const double spacing = this->m_UseImageSpacing ? inputImage->GetSpacing()[i] : 1.0;
+    this->m_FirstOrderCoefficients[i] = OperatorType::ComputeSpacedCoefficients(1, this->m_OrderOfAccuracy, spacing);
+    this->m_SecondOrderCoefficients[i] = OperatorType::ComputeSpacedCoefficients(2, this->m_OrderOfAccuracy, spacing);
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateCurvatureImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread)
+{
+  using IndexType = typename InputImageType::IndexType;
+
+  const InputImageType *  inputImage = this->GetInput();
+  const InputPixelType *  inputBuffer = inputImage->GetBufferPointer();
+  const OffsetValueType * offsetTable = inputImage->GetOffsetTable();
+  const auto &            bufferedRegion = inputImage->GetBufferedRegion();
+  const auto              radius = static_cast<OffsetValueType>(this->m_FirstOrderCoefficients[0].size() / 2);
+
+  OutputImageType *       meanOutput = nullptr;
+  OutputImageType *       gaussianOutput = nullptr;
+  const OutputImageType * referenceOutput = nullptr;
+  if (this->m_ComputeMeanCurvature)
+  {
+    meanOutput = this->GetMeanCurvatureOutput();
+    referenceOutput = meanOutput;
+  }
+  if (this->m_ComputeGaussianCurvature)
+  {
+    gaussianOutput = this->GetGaussianCurvatureOutput();
+    referenceOutput = gaussianOutput;
+  }
+
+  // Line buffers for the gradient and the upper triangle of the Hessian, in
+  // row-major order.
+  const SizeValueType lineLength = outputRegionForThread.GetSize(0);
+  std::vector<double> lines((ImageDimension + NumberOfHessianComponents) * lineLength);
+  double *            gradient[ImageDimension];
+  double *            hessian[NumberOfHessianComponents];
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    gradient[i] = lines.data() + i * lineLength;
+  }
+  for (unsigned int m = 0; m < NumberOfHessianComponents; ++m)
+  {
+    hessian[m] = lines.data() + (ImageDimension + m) * lineLength;
+  }
+
+  const double threshold = this->m_GradientMagnitudeThreshold;
+
+  OutputImageRegionType lineStartRegion = outputRegionForThread;
+  lineStartRegion.SetSize(0, 1);
+  for (ImageRegionConstIteratorWithOnlyIndex<OutputImageType> lineIt(referenceOutput, lineStartRegion);
+       !lineIt.IsAtEnd();
+       ++lineIt)
+  {
+    const IndexType        lineStart = lineIt.GetIndex();
+    const InputPixelType * center = inputBuffer + inputImage->ComputeOffset(lineStart);
+    std::fill(lines.begin(), lines.end(), 0.0);
+
+    // Inside the buffer, the pixels under each tap form one contiguous run.
+    bool interior = true;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      const OffsetValueType first = bufferedRegion.GetIndex(i);
+      const OffsetValueType last = first + static_cast<OffsetValueType>(bufferedRegion.GetSize(i)) - 1;
+      const OffsetValueType lineLast = lineStart[i] + (i == 0 ? static_cast<OffsetValueType>(lineLength) - 1 : 0);
+      if (lineStart[i] - radius < first || lineLast + radius > last)
+      {
+        interior = false;
+      }
+    }
+
+    if (interior)
+    {
+      unsigned int m = 0;
+      for (unsigned int i = 0; i < ImageDimension; ++i)
+      {
+        for (OffsetValueType k = -radius; k <= radius; ++k)
+        {
+          const double           firstWeight = this->m_FirstOrderCoefficients[i][k + radius];
+          const double           secondWeight = this->m_SecondOrderCoefficients[i][k + radius];
+          const InputPixelType * tap = center + k * offsetTable[i];
+          for (SizeValueType x = 0; x < lineLength; ++x)
+          {
+            const auto value = static_cast<double>(tap[x]);
+            gradient[i][x] += firstWeight * value;
+            hessian[m][x] += secondWeight * value;
+          }
+        }
+        ++m;
+
+        // The mixed derivatives are the tensor products of the first order
+        // operators.
+        for (unsigned int j = i + 1; j < ImageDimension; ++j, ++m)
+        {
+          for (OffsetValueType a = -radius; a <= radius; ++a)
+          {
+            if (a == 0)
+            {
+              continue;
+            }
+            for (OffsetValueType b = -radius; b <= radius; ++b)
+            {
+              if (b == 0)
+              {
+                continue;
+              }
+              const double           weight =
+                this->m_FirstOrderCoefficients[i][a + radius] * this->m_FirstOrderCoefficients[j][b + radius];
+              const InputPixelType * tap = center + a * offsetTable[i] + b * offsetTable[j];
+              for (SizeValueType x = 0; x < lineLength; ++x)
+              {
+                hessian[m][x] += weight * static_cast<double>(tap[x]);
+              }
+            }
+          }
+        }
+      }
+    }
+    else
+    {
+      // Zero flux Neumann boundary condition: clamp the taps to the buffer.
+      const auto valueAt = [&](const IndexType & index) -> double {
+        IndexType clampedIndex;
+        for (unsigned int d = 0; d < ImageDimension; ++d)
+        {
+          const OffsetValueType first = bufferedRegion.GetIndex(d);
+          const OffsetValueType last = first + static_cast<OffsetValueType>(bufferedRegion.GetSize(d)) - 1;
+          clampedIndex[d] = std::min(std::max(index[d], first), last);
+        }
+        return static_cast<double>(inputBuffer[inputImage->ComputeOffset(clampedIndex)]);
+      };
+
+      IndexType index = lineStart;
+      for (SizeValueType x = 0; x < lineLength; ++x, ++index[0])
+      {
+        unsigned int m = 0;
+        for (unsigned int i = 0; i < ImageDimension; ++i)
+        {
+          IndexType tapIndex = index;
+          for (OffsetValueType k = -radius; k <= radius; ++k)
+          {
+            tapIndex[i] = index[i] + k;
+            const double value = valueAt(tapIndex);
+            gradient[i][x] += this->m_FirstOrderCoefficients[i][k + radius] * value;
+            hessian[m][x] += this->m_SecondOrderCoefficients[i][k + radius] * value;
+          }
+          ++m;
+
+          for (unsigned int j = i + 1; j < ImageDimension; ++j, ++m)
+          {
+            tapIndex = index;
+            for (OffsetValueType a = -radius; a <= radius; ++a)
+            {
+              tapIndex[i] = index[i] + a;
+              for (OffsetValueType b = -radius; b <= radius; ++b)
+              {
+                tapIndex[j] = index[j] + b;
+                hessian[m][x] += this->m_FirstOrderCoefficients[i][a + radius] *
+                                 this->m_FirstOrderCoefficients[j][b + radius] * valueAt(tapIndex);
+              }
+            }
+          }
+        }
+      }
+    }
+
+    // Combine the derivatives of every pixel of the line into the curvatures.
+    OutputValueType * meanLine =
+      meanOutput ? meanOutput->GetBufferPointer() + meanOutput->ComputeOffset(lineStart) : nullptr;
+    OutputValueType * gaussianLine =
+      gaussianOutput ? gaussianOutput->GetBufferPointer() + gaussianOutput->ComputeOffset(lineStart) : nullptr;
+    for (SizeValueType x = 0; x < lineLength; ++x)
+    {
+      double       g[ImageDimension];
+      double       h[ImageDimension][ImageDimension];
+      double       squaredMagnitude = 0.0;
+      unsigned int m = 0;
+      for (unsigned int i = 0; i < ImageDimension; ++i)
+      {
+        g[i] = gradient[i][x];
+        squaredMagnitude += g[i] * g[i];
+        for (unsigned int j = i; j < ImageDimension; ++j, ++m)
+        {
+          h[i][j] = hessian[m][x];
+          h[j][i] = hessian[m][x];
+        }
+      }
+
+      const double magnitude = std::sqrt(squaredMagnitude);
+      if (magnitude < threshold)
+      {
+        if (meanLine)
+        {
+          meanLine[x] = NumericTraits<OutputValueType>::ZeroValue();
+        }
+        if (gaussianLine)
+        {
+          gaussianLine[x] = NumericTraits<OutputValueType>::ZeroValue();
+        }
+        continue;
+      }
+
+      if (meanLine)
+      {
+        double trace = 0.0;
+        double gHg = 0.0;
+        for (unsigned int i = 0; i < ImageDimension; ++i)
+        {
+          trace += h[i][i];
+          for (unsigned int j = 0; j < ImageDimension; ++j)
+          {
+            gHg += g[i] * h[i][j] * g[j];
+          }
+        }
+        meanLine[x] =
+          static_cast<OutputValueType>((squaredMagnitude * trace - gHg) / (squaredMagnitude * magnitude));
+      }
+
+      if (gaussianLine)
+      {
+        Matrix<double, ImageDimension + 1, ImageDimension + 1> bordered;
+        for (unsigned int i = 0; i < ImageDimension; ++i)
+        {
+          for (unsigned int j = 0; j < ImageDimension; ++j)
+          {
+            bordered(i, j) = h[i][j];
+          }
+          bordered(i, ImageDimension) = g[i];
+          bordered(ImageDimension, i) = g[i];
+        }
+        bordered(ImageDimension, ImageDimension) = 0.0;
+        gaussianLine[x] = static_cast<OutputValueType>(-vnl_determinant(bordered.GetVnlMatrix()) /
+                                                       std::pow(magnitude, static_cast<double>(ImageDimension + 1)));
+      }
+    }
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateCurvatureImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::PrintSelf(
+  std::ostream & os,
+  Indent         indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "UseImageSpacing: " << (this->m_UseImageSpacing ? "On" : "Off") << std::endl;
+  os << indent << "OrderOfAccuracy: " << this->m_OrderOfAccuracy << std::endl;
+  os << indent << "ComputeMeanCurvature: " << (this->m_ComputeMeanCurvature ? "On" : "Off") << std::endl;
+  os << indent << "ComputeGaussianCurvature: " << (this->m_ComputeGaussianCurvature ? "On" : "Off") << std::endl;
+  os << indent << "GradientMagnitudeThreshold: " << this->m_GradientMagnitudeThreshold << std::endl;
+}
+
+} // end namespace itk
+
+#endif
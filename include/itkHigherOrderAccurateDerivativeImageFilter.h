@@ -18,7 +18,17 @@
 #ifndef itkHigherOrderAccurateDerivativeImageFilter_h
 #define itkHigherOrderAccurateDerivativeImageFilter_h
 
+// The configuration header is generated by CMake; without it, as when the
+// headers are used on their own, the filters are header-only.
+#if defined(__has_include)
+#  if __has_include("itkHigherOrderAccurateGradientConfigure.h")
+#    include "itkHigherOrderAccurateGradientConfigure.h"
+#  endif
+#else
+#  include "itkHigherOrderAccurateGradientConfigure.h"
+#endif
 #include "itkImageToImageFilter.h"
+#include "itkHigherOrderAccurateResultCache.h"
 
 namespace itk
 {
@@ -46,7 +56,8 @@ namespace itk
  * \ingroup HigherOrderAccurateGradient
  */
 template <typename TInputImage, typename TOutputImage>
-class HigherOrderAccurateDerivativeImageFilter : public ImageToImageFilter<TInputImage, TOutputImage>
+class ITK_TEMPLATE_EXPORT HigherOrderAccurateDerivativeImageFilter
+  : public ImageToImageFilter<TInputImage, TOutputImage>
 {
 public:
   ITK_DISALLOW_COPY_AND_MOVE(HigherOrderAccurateDerivativeImageFilter);
@@ -114,6 +125,12 @@ public:
   itkSetMacro(UseImageSpacing, bool);
   itkGetConstMacro(UseImageSpacing, bool);
 
+  /** Set/Get the optional persistent cache of the output.  When it is set,
+   * the output is read from the cache if the same input was processed with
+   * the same parameters before, and stored in it otherwise. */
+  itkSetObjectMacro(ResultCache, HigherOrderAccurateResultCache);
+  itkGetModifiableObjectMacro(ResultCache, HigherOrderAccurateResultCache);
+
 protected:
   HigherOrderAccurateDerivativeImageFilter()
 
@@ -142,6 +159,10 @@ protected:
   GenerateData() override;
 
 private:
+  /** Digest of the input and of every parameter that changes the output. */
+  std::string
+  ComputeResultCacheKey() const;
+
   /** The order of the derivative. */
   unsigned int m_Order{ 1 };
 
@@ -152,6 +173,8 @@ private:
   unsigned int m_Direction{ 0 };
 
   bool m_UseImageSpacing{ true };
+
+  HigherOrderAccurateResultCache::Pointer m_ResultCache;
 };
 
 } // end namespace itk
@@ -161,3 +184,60 @@ private:
 #endif
 
 #endif
+
+/** Explicit instantiations */
+#if defined(HigherOrderAccurateGradient_EXPLICIT_INSTANTIATION)
+#  ifndef ITK_TEMPLATE_EXPLICIT_HigherOrderAccurateDerivativeImageFilter
+// The common instantiations are compiled once in the HigherOrderAccurateGradient
+// library.
+//
+// IMPORTANT: Since within the same compilation unit,
+//            ITK_TEMPLATE_EXPLICIT_<classname> defined and undefined states
+//            need to be considered. This code *MUST* be *OUTSIDE* the header
+//            guards.
+//
+#    include "HigherOrderAccurateGradientExport.h"
+#    if defined(HigherOrderAccurateGradient_EXPORTS)
+//   We are building this library
+#      define HigherOrderAccurateGradient_EXPORT_EXPLICIT ITK_FORWARD_EXPORT
+#    else
+//   We are using this library
+#      define HigherOrderAccurateGradient_EXPORT_EXPLICIT HigherOrderAccurateGradient_EXPORT
+#    endif
+namespace itk
+{
+
+ITK_GCC_PRAGMA_DIAG_PUSH()
+ITK_GCC_PRAGMA_DIAG(ignored "-Wattributes")
+
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateDerivativeImageFilter<Image<unsigned char, 2>, Image<float, 2>>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateDerivativeImageFilter<Image<short, 2>, Image<float, 2>>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateDerivativeImageFilter<Image<float, 2>, Image<float, 2>>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateDerivativeImageFilter<Image<double, 2>, Image<double, 2>>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateDerivativeImageFilter<Image<unsigned char, 3>, Image<float, 3>>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateDerivativeImageFilter<Image<short, 3>, Image<float, 3>>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateDerivativeImageFilter<Image<float, 3>, Image<float, 3>>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateDerivativeImageFilter<Image<double, 3>, Image<double, 3>>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateDerivativeImageFilter<Image<unsigned char, 4>, Image<float, 4>>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateDerivativeImageFilter<Image<short, 4>, Image<float, 4>>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateDerivativeImageFilter<Image<float, 4>, Image<float, 4>>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateDerivativeImageFilter<Image<double, 4>, Image<double, 4>>;
+
+ITK_GCC_PRAGMA_DIAG_POP()
+
+} // end namespace itk
+#    undef HigherOrderAccurateGradient_EXPORT_EXPLICIT
+#  endif
+#endif
@@ -24,6 +24,8 @@
 #include "itkHigherOrderAccurateDerivativeOperator.h"
 #include "itkProgressAccumulator.h"
 
+#include <typeinfo>
+
 namespace itk
 {
 
@@ -82,10 +84,45 @@ HigherOrderAccurateDerivativeImageFilter<TInputImage, TOutputImage>::GenerateInp
 }
 
 
+template <typename TInputImage, typename TOutputImage>
+std::string
+HigherOrderAccurateDerivativeImageFilter<TInputImage, TOutputImage>::ComputeResultCacheKey() const
+{
+  HigherOrderAccurateResultCacheKey key;
+  key.Append(this->GetNameOfClass());
+  key.Append(typeid(OutputPixelType).name());
+  key.AppendValue(m_Order);
+  key.AppendValue(m_OrderOfAccuracy);
+  key.AppendValue(m_Direction);
+  key.AppendValue(m_UseImageSpacing);
+  key.Append(m_ResultCache->ComputeImageDigest(this->GetInput()));
+
+  const typename OutputImageType::RegionType & requestedRegion = this->GetOutput()->GetRequestedRegion();
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    key.AppendValue(requestedRegion.GetIndex(i));
+    key.AppendValue(requestedRegion.GetSize(i));
+  }
+  return key.GetHexDigest();
+}
+
+
 template <typename TInputImage, typename TOutputImage>
 void
 HigherOrderAccurateDerivativeImageFilter<TInputImage, TOutputImage>::GenerateData()
 {
+  std::string resultCacheKey;
+  if (m_ResultCache)
+  {
+    resultCacheKey = this->ComputeResultCacheKey();
+    this->AllocateOutputs();
+    if (m_ResultCache->Load(resultCacheKey, this->GetOutput()))
+    {
+      this->UpdateProgress(1.0f);
+      return;
+    }
+  }
+
   ZeroFluxNeumannBoundaryCondition<TInputImage> nbc;
 
   // Define the operator value type so that we can filter integral
@@ -142,6 +179,11 @@ HigherOrderAccurateDerivativeImageFilter<TInputImage, TOutputImage>::GenerateDat
   // Graft the output of the mini-pipeline back onto the filter's output,
   // this copies back the region ivars and meta-data.
   this->GraftOutput(filter->GetOutput());
+
+  if (m_ResultCache)
+  {
+    m_ResultCache->Store(resultCacheKey, this->GetOutput());
+  }
 }
 
 
@@ -155,6 +197,7 @@ HigherOrderAccurateDerivativeImageFilter<TInputImage, TOutputImage>::PrintSelf(s
   os << indent << "OrderOfAccuracy: " << m_OrderOfAccuracy << std::endl;
   os << indent << "Direction: " << m_Direction << std::endl;
   os << indent << "UseImageSpacing: " << m_UseImageSpacing << std::endl;
+  itkPrintSelfObjectMacro(ResultCache);
 }
 
 } // end namespace itk
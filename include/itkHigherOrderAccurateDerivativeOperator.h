@@ -20,6 +20,9 @@
 
 #include "itkNeighborhoodOperator.h"
 
+#include <algorithm>
+#include <vector>
+
 namespace itk
 {
 
@@ -46,7 +49,9 @@ namespace itk
  * approximation will be accurate to two times the OrderOfAccuracy in terms of
  * Taylor series terms.
  *
- * @todo: implement support for higher order derivatives.
+ * First and second order derivatives are supported.
+ *
+ * @todo: implement support for derivatives of order higher than two.
  *
  * \sa DerivativeOperator
  * \sa NeighborhoodOperator
@@ -121,6 +126,37 @@ public:
     return m_OrderOfAccuracy;
   }
 
+  /** Compute the coefficients of the derivative of the given order and order
+   * of accuracy along an axis of the given spacing, where coefficient j
+   * weights the pixel at offset j - radius.  Pass a spacing of one to work in
+   * pixel units. */
+  static std::vector<double>
+  ComputeSpacedCoefficients(unsigned int order, unsigned int orderOfAccuracy, double spacing);
+
+  /** Pass each tap of coefficients around position to accumulate(weight,
+   * shift), where the tap position is clamped to [first, last], the zero flux
+   * Neumann boundary condition, and shift is the clamped position minus
+   * position.  Taps of zero weight, such as the center of a first derivative,
+   * are skipped. */
+  template <typename TAccumulate>
+  static void
+  AccumulateClampedTaps(const std::vector<double> & coefficients,
+                        OffsetValueType             position,
+                        OffsetValueType             first,
+                        OffsetValueType             last,
+                        TAccumulate &&              accumulate)
+  {
+    const auto radius = static_cast<OffsetValueType>(coefficients.size() / 2);
+    for (OffsetValueType k = -radius; k <= radius; ++k)
+    {
+      const double weight = coefficients[k + radius];
+      if (weight != 0.0)
+      {
+        accumulate(weight, std::min(std::max(position + k, first), last) - position);
+      }
+    }
+  }
+
   /** Prints some debugging information */
   void
   PrintSelf(std::ostream & os, Indent i) const override
@@ -150,6 +186,9 @@ private:
   CoefficientVector
   GenerateFirstOrderCoefficients();
 
+  CoefficientVector
+  GenerateSecondOrderCoefficients();
+
   /** Order of the derivative. */
   unsigned int m_Order{ 1 };
 
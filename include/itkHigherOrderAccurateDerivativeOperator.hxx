@@ -24,6 +24,44 @@
 namespace itk
 {
 
+template <typename TPixel, unsigned int VDimension, typename TAllocator>
+std::vector<double>
+HigherOrderAccurateDerivativeOperator<TPixel, VDimension, TAllocator>::ComputeSpacedCoefficients(
+  unsigned int order,
+  unsigned int orderOfAccuracy,
+  double       spacing)
+{
+  if (spacing == 0.0)
+  {
+    itkGenericExceptionMacro(<< "Image spacing cannot be zero.");
+  }
+
+  Self op;
+  op.SetDirection(0);
+  op.SetOrder(order);
+  op.SetOrderOfAccuracy(orderOfAccuracy);
+  op.CreateDirectional();
+
+  // Reverse order of coefficients so that coefficient j weights the pixel
+  // at offset j - radius.
+  op.FlipAxes();
+
+  // Each order of the derivative divides by the spacing once.
+  double scale = 1.0;
+  for (unsigned int i = 0; i < order; ++i)
+  {
+    scale *= 1.0 / spacing;
+  }
+
+  std::vector<double> coefficients(op.Size());
+  for (unsigned int j = 0; j < op.Size(); ++j)
+  {
+    coefficients[j] = scale * op[j];
+  }
+  return coefficients;
+}
+
+
 template <typename TPixel, unsigned int VDimension, typename TAllocator>
 typename HigherOrderAccurateDerivativeOperator<TPixel, VDimension, TAllocator>::CoefficientVector
 HigherOrderAccurateDerivativeOperator<TPixel, VDimension, TAllocator>::GenerateCoefficients()
@@ -32,6 +70,8 @@ HigherOrderAccurateDerivativeOperator<TPixel, VDimension, TAllocator>::GenerateC
   {
     case 1:
       return this->GenerateFirstOrderCoefficients();
+    case 2:
+      return this->GenerateSecondOrderCoefficients();
     default:
       itkExceptionMacro(<< "The specified derivative order/degree is not yet supported.");
   }
@@ -71,6 +111,39 @@ HigherOrderAccurateDerivativeOperator<TPixel, VDimension, TAllocator>::GenerateF
   return coeff;
 }
 
+
+template <typename TPixel, unsigned int VDimension, typename TAllocator>
+typename HigherOrderAccurateDerivativeOperator<TPixel, VDimension, TAllocator>::CoefficientVector
+HigherOrderAccurateDerivativeOperator<TPixel, VDimension, TAllocator>::GenerateSecondOrderCoefficients()
+{
+  unsigned int      order = this->m_OrderOfAccuracy;
+  unsigned int      length = 2 * order + 1;
+  CoefficientVector coeff(length);
+
+  // c_i = 2 (-1)^(i+1) (order!)^2 / (i^2 (order - i)! (order + i)!), which is
+  // symmetric, so no flip is needed.
+  coeff[order + 1] = 2.0 * order / (order + 1);
+  coeff[order - 1] = coeff[order + 1];
+
+  unsigned int i;
+  for (i = 2; i <= order; ++i)
+  {
+    coeff[order + i] = -1 * (static_cast<double>(i - 1) * (i - 1) * (order - i + 1)) /
+                       (static_cast<double>(i) * i * (order + i)) * coeff[order + i - 1];
+    coeff[order - i] = coeff[order + i];
+  }
+
+  // Center point: the coefficients sum to zero.
+  double center = 0.0;
+  for (i = 1; i <= order; ++i)
+  {
+    center -= 2.0 * coeff[order + i];
+  }
+  coeff[order] = center;
+
+  return coeff;
+}
+
 } // namespace itk
 
 #endif
@@ -0,0 +1,262 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateFeatureBankImageFilter_h
+#define itkHigherOrderAccurateFeatureBankImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkHigherOrderAccurateDerivativeOperator.h"
+#include "itkVectorImage.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class HigherOrderAccurateFeatureBankImageFilterEnums
+ *
+ * \brief Contains the enums used by HigherOrderAccurateFeatureBankImageFilter.
+ *
+ * \ingroup HigherOrderAccurateGradient
+ */
+class HigherOrderAccurateFeatureBankImageFilterEnums
+{
+public:
+  /** \class Feature
+   * \ingroup HigherOrderAccurateGradient
+   * Derivative feature written to the output channels. */
+  enum class Feature : uint8_t
+  {
+    /** The ImageDimension first derivatives. */
+    Gradient,
+    /** The Euclidean norm of the gradient. */
+    GradientMagnitude,
+    /** The upper triangle of the Hessian, in row-major order. */
+    Hessian,
+    /** The trace of the Hessian. */
+    Laplacian,
+    /** The eigenvalues of the Hessian, in ascending order. */
+    HessianEigenvalues
+  };
+};
+
+/** Define how to print enumerations */
+inline std::ostream &
+operator<<(std::ostream & out, const HigherOrderAccurateFeatureBankImageFilterEnums::Feature value)
+{
+  return out << [value] {
+    switch (value)
+    {
+      case HigherOrderAccurateFeatureBankImageFilterEnums::Feature::Gradient:
+        return "itk::HigherOrderAccurateFeatureBankImageFilterEnums::Feature::Gradient";
+      case HigherOrderAccurateFeatureBankImageFilterEnums::Feature::GradientMagnitude:
+        return "itk::HigherOrderAccurateFeatureBankImageFilterEnums::Feature::GradientMagnitude";
+      case HigherOrderAccurateFeatureBankImageFilterEnums::Feature::Hessian:
+        return "itk::HigherOrderAccurateFeatureBankImageFilterEnums::Feature::Hessian";
+      case HigherOrderAccurateFeatureBankImageFilterEnums::Feature::Laplacian:
+        return "itk::HigherOrderAccurateFeatureBankImageFilterEnums::Feature::Laplacian";
+      case HigherOrderAccurateFeatureBankImageFilterEnums::Feature::HessianEigenvalues:
+        return "itk::HigherOrderAccurateFeatureBankImageFilterEnums::Feature::HessianEigenvalues";
+      default:
+        return "INVALID VALUE FOR itk::HigherOrderAccurateFeatureBankImageFilterEnums::Feature";
+    }
+  }();
+}
+
+/** \class HigherOrderAccurateFeatureBankImageFilter
+ *
+ * \brief Compute a bank of first and second order derivative features at
+ * several scales in a single pass.
+ *
+ * The features are added with AddFeature(), each with a dilation d: the taps
+ * of the HigherOrderAccurateDerivativeOperator are spaced d pixels apart,
+ * which estimates the derivative at a coarser scale without smoothing the
+ * image.  The channels of the output VectorImage follow the order in which
+ * the features were added, so the buffer can be handed to machine learning
+ * code as a channel-last array.
+ *
+ * Every scanline of the input is read once per dilation: the first
+ * derivatives, the pure second derivatives and the mixed derivatives that
+ * the features of a dilation need are accumulated together from the same
+ * taps, and every feature is then assembled from these shared line buffers.
+ * Compared to one filter per feature, the input is traversed once and the
+ * derivatives common to several features are computed once.
+ *
+ * The derivatives are taken along the axes of the image grid.  The
+ * magnitude, Laplacian and eigenvalue features do not depend on the image
+ * direction.  The image is extended with zero flux Neumann boundary
+ * conditions.
+ *
+ * \sa HigherOrderAccurateDerivativeOperator
+ * \sa HigherOrderAccurateCurvatureImageFilter
+ *
+ * \ingroup HigherOrderAccurateGradient
+ */
+template <typename TInputImage, typename TOperatorValueType = float, typename TOutputValueType = float>
+class HigherOrderAccurateFeatureBankImageFilter
+  : public ImageToImageFilter<TInputImage, VectorImage<TOutputValueType, TInputImage::ImageDimension>>
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(HigherOrderAccurateFeatureBankImageFilter);
+
+  /** Extract dimension from input image. */
+  static constexpr unsigned int ImageDimension = TInputImage::ImageDimension;
+
+  /** Standard class type alias. */
+  using Self = HigherOrderAccurateFeatureBankImageFilter;
+
+  /** Convenient type alias for simplifying declarations. */
+  using InputImageType = TInputImage;
+  using InputImagePointer = typename InputImageType::Pointer;
+  using OutputImageType = VectorImage<TOutputValueType, ImageDimension>;
+  using OutputImagePointer = typename OutputImageType::Pointer;
+
+  /** Standard class type alias. */
+  using Superclass = ImageToImageFilter<InputImageType, OutputImageType>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(HigherOrderAccurateFeatureBankImageFilter, ImageToImageFilter);
+
+  /** Image type alias support. */
+  using InputPixelType = typename InputImageType::PixelType;
+  using OperatorValueType = TOperatorValueType;
+  using OutputValueType = TOutputValueType;
+  using OutputImageRegionType = typename OutputImageType::RegionType;
+
+  using FeatureEnum = HigherOrderAccurateFeatureBankImageFilterEnums::Feature;
+
+  /** Set/Get whether or not the filter will use the spacing of the input
+      image in its calculations */
+  itkSetMacro(UseImageSpacing, bool);
+  itkGetConstMacro(UseImageSpacing, bool);
+  itkBooleanMacro(UseImageSpacing);
+
+  /** Set/Get the order of accuracy of the derivative operators.  For more
+   * information, see HigherOrderAccurateDerivativeOperator. */
+  itkSetMacro(OrderOfAccuracy, unsigned int);
+  itkGetConstMacro(OrderOfAccuracy, unsigned int);
+
+  /** Append a feature computed with the taps spaced dilation pixels apart. */
+  void
+  AddFeature(FeatureEnum feature, unsigned int dilation = 1);
+
+  /** Remove all the features. */
+  void
+  ClearFeatures();
+
+  /** Get the number of features added. */
+  unsigned int
+  GetNumberOfFeatures() const
+  {
+    return static_cast<unsigned int>(this->m_Features.size());
+  }
+
+  /** Get the number of output channels of a feature. */
+  static unsigned int
+  GetNumberOfFeatureComponents(FeatureEnum feature);
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  /** Begin concept checking */
+  itkConceptMacro(InputConvertibleToDoubleCheck, (Concept::Convertible<InputPixelType, double>));
+  itkConceptMacro(OutputHasNumericTraitsCheck, (Concept::HasNumericTraits<OutputValueType>));
+  /** End concept checking */
+#endif
+
+protected:
+  HigherOrderAccurateFeatureBankImageFilter() = default;
+  ~HigherOrderAccurateFeatureBankImageFilter() override = default;
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** The number of output channels is the sum of the channels of the
+   * features. */
+  void
+  GenerateOutputInformation() override;
+
+  /** The input requested region is padded by the operator radius times the
+   * largest dilation.
+   *
+   * \sa ImageToImageFilter::GenerateInputRequestedRegion() */
+  void
+  GenerateInputRequestedRegion() override;
+
+  /** Build the derivative coefficients and group the features by dilation. */
+  void
+  BeforeThreadedGenerateData() override;
+
+  void
+  DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread) override;
+
+private:
+  using IndexType = typename InputImageType::IndexType;
+  using OperatorType = HigherOrderAccurateDerivativeOperator<OperatorValueType, ImageDimension>;
+
+  /** Number of distinct entries of the symmetric Hessian. */
+  static constexpr unsigned int NumberOfHessianComponents = ImageDimension * (ImageDimension + 1) / 2;
+
+  struct FeatureDescription
+  {
+    FeatureEnum  Feature;
+    unsigned int Dilation;
+    unsigned int ScaleIndex;
+  };
+
+  /** Derivatives needed at one dilation. */
+  struct ScaleDescription
+  {
+    unsigned int Dilation;
+    bool         NeedsGradient;
+    bool         NeedsPureSecondDerivatives;
+    bool         NeedsMixedDerivatives;
+  };
+
+  /** Accumulate the derivatives needed by scale along the scanline starting
+   * at lineStart. */
+  void
+  ComputeDerivatives(const ScaleDescription & scale,
+                     const IndexType &        lineStart,
+                     SizeValueType            lineLength,
+                     double * const *         gradient,
+                     double * const *         hessian) const;
+
+  bool m_UseImageSpacing{ true };
+
+  unsigned int m_OrderOfAccuracy{ 2 };
+
+  std::vector<FeatureDescription> m_Features;
+
+  /** Distinct dilations of the features, in increasing order. */
+  std::vector<ScaleDescription> m_Scales;
+
+  /** First and second derivative coefficients along each axis, for the
+   * offsets -radius..radius, at a dilation of 1. */
+  std::vector<double> m_FirstOrderCoefficients[ImageDimension];
+  std::vector<double> m_SecondOrderCoefficients[ImageDimension];
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkHigherOrderAccurateFeatureBankImageFilter.hxx"
+#endif
+
+#endif
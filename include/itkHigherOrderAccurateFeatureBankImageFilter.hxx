@@ -0,0 +1,521 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateFeatureBankImageFilter_hxx
+#define itkHigherOrderAccurateFeatureBankImageFilter_hxx
+#include "itkHigherOrderAccurateFeatureBankImageFilter.h"
+
+#include "itkImageRegionConstIteratorWithOnlyIndex.h"
+#include "itkHigherOrderAccurateDerivativeOperator.h"
+#include "itkSymmetricSecondRankTensor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace itk
+{
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateFeatureBankImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::AddFeature(
+  FeatureEnum  feature,
+  unsigned int dilation)
+{
+  if (dilation == 0)
+  {
+    itkExceptionMacro(<< "The dilation of a feature must be positive.");
+  }
+  this->m_Features.push_back(FeatureDescription{ feature, dilation, 0 });
+  this->Modified();
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateFeatureBankImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::ClearFeatures()
+{
+  if (!this->m_Features.empty())
+  {
+    this->m_Features.clear();
+    this->Modified();
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+unsigned int
+HigherOrderAccurateFeatureBankImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  GetNumberOfFeatureComponents(FeatureEnum feature)
+{
+  switch (feature)
+  {
+    case FeatureEnum::Gradient:
+    case FeatureEnum::HessianEigenvalues:
+      return ImageDimension;
+    case FeatureEnum::Hessian:
+      return NumberOfHessianComponents;
+    case FeatureEnum::GradientMagnitude:
+    case FeatureEnum::Laplacian:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateFeatureBankImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  GenerateOutputInformation()
+{
+  Superclass::GenerateOutputInformation();
+
+  OutputImageType * outputPtr = this->GetOutput();
+  if (!outputPtr)
+  {
+    return;
+  }
+
+  if (this->m_Features.empty())
+  {
+    itkExceptionMacro(<< "At least one feature must be added.");
+  }
+
+  unsigned int numberOfComponents = 0;
+  for (const FeatureDescription & feature : this->m_Features)
+  {
+    numberOfComponents += GetNumberOfFeatureComponents(feature.Feature);
+  }
+  outputPtr->SetNumberOfComponentsPerPixel(numberOfComponents);
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateFeatureBankImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  GenerateInputRequestedRegion()
+{
+  // call the superclass' implementation of this method
+  Superclass::GenerateInputRequestedRegion();
+
+  // get pointers to the input and output
+  InputImagePointer  inputPtr = const_cast<InputImageType *>(this->GetInput());
+  OutputImagePointer outputPtr = this->GetOutput();
+
+  if (!inputPtr || !outputPtr)
+  {
+    return;
+  }
+
+  // Build an operator so that we can determine the kernel size.  The first
+  // and second order operators have the same radius.
+  HigherOrderAccurateDerivativeOperator<OperatorValueType, ImageDimension> oper;
+  oper.SetDirection(0);
+  oper.SetOrder(1);
+  oper.SetOrderOfAccuracy(this->m_OrderOfAccuracy);
+  oper.CreateDirectional();
+  unsigned int largestDilation = 1;
+  for (const FeatureDescription & feature : this->m_Features)
+  {
+    largestDilation = std::max(largestDilation, feature.Dilation);
+  }
+  unsigned long radius = oper.GetRadius()[0] * largestDilation;
+
+  // get a copy of the input requested region (should equal the output
+  // requested region)
+  typename TInputImage::RegionType inputRequestedRegion;
+  inputRequestedRegion = inputPtr->GetRequestedRegion();
+
+  // pad the input requested region by the dilated operator radius
+  inputRequestedRegion.PadByRadius(radius);
+
+  // crop the input requested region at the input's largest possible region
+  if (inputRequestedRegion.Crop(inputPtr->GetLargestPossibleRegion()))
+  {
+    inputPtr->SetRequestedRegion(inputRequestedRegion);
+    return;
+  }
+  else
+  {
+    // Couldn't crop the region (requested region is outside the largest
+    // possible region).  Throw an exception.
+
+    // store what we tried to request (prior to trying to crop)
+    inputPtr->SetRequestedRegion(inputRequestedRegion);
+
+    // build an exception
+    InvalidRequestedRegionError e(__FILE__, __LINE__);
+    e.SetLocation(ITK_LOCATION);
+    e.SetDescription("Requested region is (at least partially) outside the largest possible region.");
+    e.SetDataObject(inputPtr);
+    throw e;
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateFeatureBankImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  BeforeThreadedGenerateData()
+{
+  const InputImageType * inputImage = this->GetInput();
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    const double spacing = this->m_UseImageSpacing ? inputImage->GetSpacing()[i] : 1.0;
+    this->m_FirstOrderCoefficients[i] = OperatorType::ComputeSpacedCoefficients(1, this->m_OrderOfAccuracy, spacing);
+    this->m_SecondOrderCoefficients[i] = OperatorType::ComputeSpacedCoefficients(2, this->m_OrderOfAccuracy, spacing);
+  }
+
+  // Group the features by dilation, so that the derivatives shared by
+  // several features are computed once.
+  this->m_Scales.clear();
+  for (const FeatureDescription & feature : this->m_Features)
+  {
+    auto scaleIt = std::find_if(this->m_Scales.begin(), this->m_Scales.end(), [&feature](const ScaleDescription & s) {
+      return s.Dilation == feature.Dilation;
+    });
+    if (scaleIt == this->m_Scales.end())
+    {
+      this->m_Scales.push_back(ScaleDescription{ feature.Dilation, false, false, false });
+    }
+  }
+  std::sort(this->m_Scales.begin(), this->m_Scales.end(), [](const ScaleDescription & a, const ScaleDescription & b) {
+    return a.Dilation < b.Dilation;
+  });
+
+  for (FeatureDescription & feature : this->m_Features)
+  {
+    for (unsigned int s = 0; s < this->m_Scales.size(); ++s)
+    {
+      ScaleDescription & scale = this->m_Scales[s];
+      if (scale.Dilation != feature.Dilation)
+      {
+        continue;
+      }
+      feature.ScaleIndex = s;
+      switch (feature.Feature)
+      {
+        case FeatureEnum::Gradient:
+        case FeatureEnum::GradientMagnitude:
+          scale.NeedsGradient = true;
+          break;
+        case FeatureEnum::Laplacian:
+          scale.NeedsPureSecondDerivatives = true;
+          break;
+        case FeatureEnum::Hessian:
+        case FeatureEnum::HessianEigenvalues:
+          scale.NeedsPureSecondDerivatives = true;
+          scale.NeedsMixedDerivatives = true;
+          break;
+        default:
+          itkExceptionMacro(<< "Unknown feature " << feature.Feature);
+      }
+    }
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateFeatureBankImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread)
+{
+  using TensorType = SymmetricSecondRankTensor<double, ImageDimension>;
+
+  OutputImageType *  outputImage = this->GetOutput();
+  OutputValueType *  outputBuffer = outputImage->GetBufferPointer();
+  const unsigned int numberOfComponents = outputImage->GetNumberOfComponentsPerPixel();
+
+  // Line buffers for the gradient and the upper triangle of the Hessian, in
+  // row-major order, at every dilation.
+  const SizeValueType   lineLength = outputRegionForThread.GetSize(0);
+  const auto            numberOfScales = static_cast<unsigned int>(this->m_Scales.size());
+  std::vector<double>   lines(numberOfScales * (ImageDimension + NumberOfHessianComponents) * lineLength);
+  std::vector<double *> gradients(numberOfScales * ImageDimension);
+  std::vector<double *> hessians(numberOfScales * NumberOfHessianComponents);
+  double *              line = lines.data();
+  for (auto & gradient : gradients)
+  {
+    gradient = line;
+    line += lineLength;
+  }
+  for (auto & hessian : hessians)
+  {
+    hessian = line;
+    line += lineLength;
+  }
+
+  typename TensorType::EigenValuesArrayType eigenValues;
+
+  OutputImageRegionType lineStartRegion = outputRegionForThread;
+  lineStartRegion.SetSize(0, 1);
+  for (ImageRegionConstIteratorWithOnlyIndex<OutputImageType> lineIt(outputImage, lineStartRegion); !lineIt.IsAtEnd();
+       ++lineIt)
+  {
+    const IndexType lineStart = lineIt.GetIndex();
+    std::fill(lines.begin(), lines.end(), 0.0);
+    for (unsigned int s = 0; s < numberOfScales; ++s)
+    {
+      this->ComputeDerivatives(this->m_Scales[s],
+                               lineStart,
+                               lineLength,
+                               gradients.data() + s * ImageDimension,
+                               hessians.data() + s * NumberOfHessianComponents);
+    }
+
+    // Assemble the features of every pixel of the line from the shared
+    // derivatives.
+    OutputValueType * outputLine = outputBuffer + outputImage->ComputeOffset(lineStart) * numberOfComponents;
+    for (SizeValueType x = 0; x < lineLength; ++x)
+    {
+      OutputValueType * pixel = outputLine + x * numberOfComponents;
+      for (const FeatureDescription & feature : this->m_Features)
+      {
+        double * const * gradient = gradients.data() + feature.ScaleIndex * ImageDimension;
+        double * const * hessian = hessians.data() + feature.ScaleIndex * NumberOfHessianComponents;
+        switch (feature.Feature)
+        {
+          case FeatureEnum::Gradient:
+            for (unsigned int i = 0; i < ImageDimension; ++i)
+            {
+              *pixel++ = static_cast<OutputValueType>(gradient[i][x]);
+            }
+            break;
+          case FeatureEnum::GradientMagnitude:
+          {
+            double squaredMagnitude = 0.0;
+            for (unsigned int i = 0; i < ImageDimension; ++i)
+            {
+              squaredMagnitude += gradient[i][x] * gradient[i][x];
+            }
+            *pixel++ = static_cast<OutputValueType>(std::sqrt(squaredMagnitude));
+            break;
+          }
+          case FeatureEnum::Hessian:
+            for (unsigned int m = 0; m < NumberOfHessianComponents; ++m)
+            {
+              *pixel++ = static_cast<OutputValueType>(hessian[m][x]);
+            }
+            break;
+          case FeatureEnum::Laplacian:
+          {
+            double       trace = 0.0;
+            unsigned int m = 0;
+            for (unsigned int i = 0; i < ImageDimension; m += ImageDimension - i, ++i)
+            {
+              trace += hessian[m][x];
+            }
+            *pixel++ = static_cast<OutputValueType>(trace);
+            break;
+          }
+          case FeatureEnum::HessianEigenvalues:
+          {
+            TensorType   tensor;
+            unsigned int m = 0;
+            for (unsigned int i = 0; i < ImageDimension; ++i)
+            {
+              for (unsigned int j = i; j < ImageDimension; ++j, ++m)
+              {
+                tensor(i, j) = hessian[m][x];
+              }
+            }
+
+            // The eigenvalues are sorted in ascending order.
+            tensor.ComputeEigenValues(eigenValues);
+            for (unsigned int i = 0; i < ImageDimension; ++i)
+            {
+              *pixel++ = static_cast<OutputValueType>(eigenValues[i]);
+            }
+            break;
+          }
+          default:
+            break;
+        }
+      }
+    }
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateFeatureBankImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::ComputeDerivatives(
+  const ScaleDescription & scale,
+  const IndexType &        lineStart,
+  SizeValueType            lineLength,
+  double * const *         gradient,
+  double * const *         hessian) const
+{
+  const InputImageType *  inputImage = this->GetInput();
+  const InputPixelType *  inputBuffer = inputImage->GetBufferPointer();
+  const OffsetValueType * offsetTable = inputImage->GetOffsetTable();
+  const auto &            bufferedRegion = inputImage->GetBufferedRegion();
+  const auto              radius = static_cast<OffsetValueType>(this->m_FirstOrderCoefficients[0].size() / 2);
+  const auto              dilation = static_cast<OffsetValueType>(scale.Dilation);
+  const InputPixelType *  center = inputBuffer + inputImage->ComputeOffset(lineStart);
+
+  // The dilated operators estimate the derivatives with a spacing of
+  // dilation pixels.
+  const double firstScale = 1.0 / static_cast<double>(scale.Dilation);
+  const double secondScale = firstScale * firstScale;
+  const bool   needsAxisTaps = scale.NeedsGradient || scale.NeedsPureSecondDerivatives;
+
+  // Inside the buffer, the pixels under each tap form one contiguous run.
+  bool interior = true;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    const OffsetValueType first = bufferedRegion.GetIndex(i);
+    const OffsetValueType last = first + static_cast<OffsetValueType>(bufferedRegion.GetSize(i)) - 1;
+    const OffsetValueType lineLast = lineStart[i] + (i == 0 ? static_cast<OffsetValueType>(lineLength) - 1 : 0);
+    if (lineStart[i] - radius * dilation < first || lineLast + radius * dilation > last)
+    {
+      interior = false;
+    }
+  }
+
+  if (interior)
+  {
+    unsigned int m = 0;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      // The first and the pure second derivatives along an axis share their
+      // taps.
+      if (needsAxisTaps)
+      {
+        for (OffsetValueType k = -radius; k <= radius; ++k)
+        {
+          const double           firstWeight = firstScale * this->m_FirstOrderCoefficients[i][k + radius];
+          const double           secondWeight = secondScale * this->m_SecondOrderCoefficients[i][k + radius];
+          const InputPixelType * tap = center + k * dilation * offsetTable[i];
+          for (SizeValueType x = 0; x < lineLength; ++x)
+          {
+            const auto value = static_cast<double>(tap[x]);
+            gradient[i][x] += firstWeight * value;
+            hessian[m][x] += secondWeight * value;
+          }
+        }
+      }
+      ++m;
+
+      // The mixed derivatives are the tensor products of the first order
+      // operators.
+      for (unsigned int j = i + 1; j < ImageDimension; ++j, ++m)
+      {
+        if (!scale.NeedsMixedDerivatives)
+        {
+          continue;
+        }
+        for (OffsetValueType a = -radius; a <= radius; ++a)
+        {
+          if (a == 0)
+          {
+            continue;
+          }
+          for (OffsetValueType b = -radius; b <= radius; ++b)
+          {
+            if (b == 0)
+            {
+              continue;
+            }
+            const double           weight = secondScale * this->m_FirstOrderCoefficients[i][a + radius] *
+                                            this->m_FirstOrderCoefficients[j][b + radius];
+            const InputPixelType * tap = center + dilation * (a * offsetTable[i] + b * offsetTable[j]);
+            for (SizeValueType x = 0; x < lineLength; ++x)
+            {
+              hessian[m][x] += weight * static_cast<double>(tap[x]);
+            }
+          }
+        }
+      }
+    }
+    return;
+  }
+
+  // Zero flux Neumann boundary condition: clamp the taps to the buffer.
+  const auto valueAt = [&](const IndexType & index) -> double {
+    IndexType clampedIndex;
+    for (unsigned int d = 0; d < ImageDimension; ++d)
+    {
+      const OffsetValueType first = bufferedRegion.GetIndex(d);
+      const OffsetValueType last = first + static_cast<OffsetValueType>(bufferedRegion.GetSize(d)) - 1;
+      clampedIndex[d] = std::min(std::max(index[d], first), last);
+    }
+    return static_cast<double>(inputBuffer[inputImage->ComputeOffset(clampedIndex)]);
+  };
+
+  IndexType index = lineStart;
+  for (SizeValueType x = 0; x < lineLength; ++x, ++index[0])
+  {
+    unsigned int m = 0;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      IndexType tapIndex = index;
+      if (needsAxisTaps)
+      {
+        for (OffsetValueType k = -radius; k <= radius; ++k)
+        {
+          tapIndex[i] = index[i] + k * dilation;
+          const double value = valueAt(tapIndex);
+          gradient[i][x] += firstScale * this->m_FirstOrderCoefficients[i][k + radius] * value;
+          hessian[m][x] += secondScale * this->m_SecondOrderCoefficients[i][k + radius] * value;
+        }
+      }
+      ++m;
+
+      for (unsigned int j = i + 1; j < ImageDimension; ++j, ++m)
+      {
+        if (!scale.NeedsMixedDerivatives)
+        {
+          continue;
+        }
+        tapIndex = index;
+        for (OffsetValueType a = -radius; a <= radius; ++a)
+        {
+          tapIndex[i] = index[i] + a * dilation;
+          for (OffsetValueType b = -radius; b <= radius; ++b)
+          {
+            tapIndex[j] = index[j] + b * dilation;
+            hessian[m][x] += secondScale * this->m_FirstOrderCoefficients[i][a + radius] *
+                             this->m_FirstOrderCoefficients[j][b + radius] * valueAt(tapIndex);
+          }
+        }
+      }
+    }
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateFeatureBankImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::PrintSelf(
+  std::ostream & os,
+  Indent         indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "UseImageSpacing: " << (this->m_UseImageSpacing ? "On" : "Off") << std::endl;
+  os << indent << "OrderOfAccuracy: " << this->m_OrderOfAccuracy << std::endl;
+  os << indent << "Features: " << this->m_Features.size() << std::endl;
+  for (const FeatureDescription & feature : this->m_Features)
+  {
+    os << indent.GetNextIndent() << feature.Feature << ", Dilation: " << feature.Dilation << std::endl;
+  }
+}
+
+} // end namespace itk
+
+#endif
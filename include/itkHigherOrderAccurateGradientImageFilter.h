@@ -18,12 +18,86 @@
 #ifndef itkHigherOrderAccurateGradientImageFilter_h
 #define itkHigherOrderAccurateGradientImageFilter_h
 
+// The configuration header is generated by CMake; without it, as when the
+// headers are used on their own, the filters are header-only.
+#if defined(__has_include)
+#  if __has_include("itkHigherOrderAccurateGradientConfigure.h")
+#    include "itkHigherOrderAccurateGradientConfigure.h"
+#  endif
+#else
+#  include "itkHigherOrderAccurateGradientConfigure.h"
+#endif
 #include "itkImageToImageFilter.h"
 #include "itkCovariantVector.h"
+#include "itkHigherOrderAccurateAutotuner.h"
+#include "itkHigherOrderAccurateResultCache.h"
+
+#include <valarray>
 
 namespace itk
 {
 
+/** \class HigherOrderAccurateGradientImageFilterEnums
+ *
+ * \brief Contains the enums used by HigherOrderAccurateGradientImageFilter.
+ *
+ * \ingroup HigherOrderAccurateGradient
+ */
+class HigherOrderAccurateGradientImageFilterEnums
+{
+public:
+  /** \class KernelVariant
+   * \ingroup HigherOrderAccurateGradient
+   * How the derivative kernels are applied. */
+  enum class KernelVariant : uint8_t
+  {
+    Neighborhood,
+    Scanline
+  };
+
+  /** \class Tiling
+   * \ingroup HigherOrderAccurateGradient
+   * Shape of the pieces the output is split into for the threads. */
+  enum class Tiling : uint8_t
+  {
+    Slabs,
+    Blocks
+  };
+};
+
+/** Define how to print enumerations */
+inline std::ostream &
+operator<<(std::ostream & out, const HigherOrderAccurateGradientImageFilterEnums::KernelVariant value)
+{
+  return out << [value] {
+    switch (value)
+    {
+      case HigherOrderAccurateGradientImageFilterEnums::KernelVariant::Neighborhood:
+        return "itk::HigherOrderAccurateGradientImageFilterEnums::KernelVariant::Neighborhood";
+      case HigherOrderAccurateGradientImageFilterEnums::KernelVariant::Scanline:
+        return "itk::HigherOrderAccurateGradientImageFilterEnums::KernelVariant::Scanline";
+      default:
+        return "INVALID VALUE FOR itk::HigherOrderAccurateGradientImageFilterEnums::KernelVariant";
+    }
+  }();
+}
+
+inline std::ostream &
+operator<<(std::ostream & out, const HigherOrderAccurateGradientImageFilterEnums::Tiling value)
+{
+  return out << [value] {
+    switch (value)
+    {
+      case HigherOrderAccurateGradientImageFilterEnums::Tiling::Slabs:
+        return "itk::HigherOrderAccurateGradientImageFilterEnums::Tiling::Slabs";
+      case HigherOrderAccurateGradientImageFilterEnums::Tiling::Blocks:
+        return "itk::HigherOrderAccurateGradientImageFilterEnums::Tiling::Blocks";
+      default:
+        return "INVALID VALUE FOR itk::HigherOrderAccurateGradientImageFilterEnums::Tiling";
+    }
+  }();
+}
+
 /** \class HigherOrderAccurateGradientImageFilter
  *
  * \brief Calculate the image gradient from a higher order accurate
@@ -44,14 +118,79 @@ namespace itk
  * approximation will be accurate to two times the OrderOfAccuracy in terms of
  * Taylor series terms.
  *
+ * When ComputeGradientVariance is enabled, the filter also propagates the
+ * noise of the input to the gradient in the same pass.  The per-pixel noise
+ * variance is taken from the optional VarianceImage input or, when it is not
+ * set, from the constant NoiseSigma.  Assuming the noise of different pixels is
+ * uncorrelated, the variance of each gradient component is the sum of the
+ * squared kernel coefficients times the variance under the stencil.  Taps that
+ * are replicated by the boundary condition are merged before squaring, and
+ * the variance is rotated with the squared direction cosines when
+ * UseImageDirection is enabled.  The result is available from
+ * GetGradientVarianceOutput().
+ *
+ * When the filter is streamed, every piece needs the input padded by the
+ * operator radius, so the 2 * radius slabs shared by consecutive pieces are
+ * normally requested, and produced upstream, twice.  With ReuseStreamingHalo
+ * enabled, the filter keeps the trailing slabs of the input of a piece along
+ * the slowest axis and, when the next piece follows it along that axis, only
+ * requests the slabs it does not hold yet.  The pieces must be split along
+ * the slowest axis and processed in increasing order, as StreamingImageFilter
+ * and the image writers do by default; any other piece is processed
+ * normally.  Nothing is kept after a piece that reaches the end of the
+ * slowest axis, such as the whole output of an unstreamed update.
+ *
+ * The KernelVariant selects how the kernels are applied: with a neighborhood
+ * iterator around every pixel, or, for the Scanline variant, along rows of
+ * the fastest axis, where the taps along the other axes are whole shifted
+ * rows that vectorize well.  The Scanline variant is not used when
+ * ComputeGradientVariance is enabled.  The Tiling selects whether the output
+ * is split into slabs along the slowest axis, as by default in ITK, or into
+ * blocks along all the axes, and NumberOfWorkUnits the number of pieces.
+ *
+ * When an Autotuner is set, these three settings are ignored.  On the first
+ * run of a workload, described by the processor, the image dimension, the
+ * size class of the requested region, the pixel types, the order of accuracy,
+ * whether the variance is computed and the number of threads of the
+ * multithreader, the filter times the candidate
+ * configurations and records the fastest in the profile of the Autotuner.
+ * The candidates use fewer, as many and more work units than the threads of
+ * the multithreader of the filter, and its NumberOfWorkUnits, and are timed
+ * on a central block of at most 2^20 pixels of the requested region, so the
+ * first run costs a bounded amount on top of the filter itself.  Later runs
+ * of the same workload use the recorded configuration directly.
+ *
+ * The kernel variants agree to rounding: the Neighborhood variant sums
+ * through OutputValueType, and the compiler may fuse a multiplication and an
+ * addition into one instruction where the processor has it, and differently
+ * in each variant, so the last bit of the outputs can change with the
+ * variant and the processor.  With Reproducible
+ * enabled, every sum of products, including the rotation by the image
+ * direction and the variance, is accumulated in double precision tap after
+ * tap in a fixed order, each product and each sum rounded.  The functions
+ * doing so are compiled without floating-point contraction, with
+ * `#pragma STDC FP_CONTRACT OFF` for Clang and the fp-contract=off
+ * optimization for GCC; MSVC does not contract with /fp:precise, its default.
+ * The outputs are then bitwise identical whatever the kernel variant, tiling
+ * and number of work units, and on every processor, so the Autotuner remains
+ * usable.
+ *
+ * The cost of Reproducible is the loss of the fused multiply-adds where the
+ * processor has them; the sums along rows still vectorize.  GCC does not
+ * inline a function compiled without contraction into one compiled with it,
+ * its default, so a few sums near the border and in the variance are calls
+ * unless the code using the filter is also compiled with -ffp-contract=off,
+ * as the module compiles its own library and tests.
+ *
  * \sa HigherOrderAccurateDerivativeOperator
  * \sa HigherOrderAccurateDerivativeImageFilter
+ * \sa HigherOrderAccurateAutotuner
  *
  * \ingroup GradientFilters
  * \ingroup HigherOrderAccurateGradient
  */
 template <typename TInputImage, typename TOperatorValueType = float, class TOutputValueType = float>
-class HigherOrderAccurateGradientImageFilter
+class ITK_TEMPLATE_EXPORT HigherOrderAccurateGradientImageFilter
   : public ImageToImageFilter<
       TInputImage,
       Image<CovariantVector<TOutputValueType, TInputImage::ImageDimension>, TInputImage::ImageDimension>>
@@ -90,6 +229,12 @@ public:
   using OutputPixelType = CovariantVector<OutputValueType, itkGetStaticConstMacro(OutputImageDimension)>;
   using OutputImageRegionType = typename OutputImageType::RegionType;
 
+  /** Type of the per-pixel noise variance image. */
+  using VarianceImageType = Image<OutputValueType, ImageDimension>;
+
+  using KernelVariantEnum = HigherOrderAccurateGradientImageFilterEnums::KernelVariant;
+  using TilingEnum = HigherOrderAccurateGradientImageFilterEnums::Tiling;
+
   /** Set/Get whether or not the filter will use the spacing of the input
       image in its calculations */
   itkSetMacro(UseImageSpacing, bool);
@@ -122,6 +267,66 @@ public:
   itkSetMacro(OrderOfAccuracy, unsigned int);
   itkGetConstMacro(OrderOfAccuracy, unsigned int);
 
+  /** Set/Get whether the variance of the gradient components is computed
+   * alongside the gradient.  The default value of this flag is Off. */
+  itkSetMacro(ComputeGradientVariance, bool);
+  itkGetConstMacro(ComputeGradientVariance, bool);
+  itkBooleanMacro(ComputeGradientVariance);
+
+  /** Set/Get the optional image holding the noise variance of every input
+   * pixel.  It must cover the same grid as the input image. */
+  itkSetInputMacro(VarianceImage, VarianceImageType);
+  itkGetInputMacro(VarianceImage, VarianceImageType);
+
+  /** Set/Get the standard deviation of the input noise, used when no
+   * VarianceImage is given.  Defaults to 1. */
+  itkSetMacro(NoiseSigma, double);
+  itkGetConstMacro(NoiseSigma, double);
+
+  /** Get the variance of each gradient component.  Only valid when
+   * ComputeGradientVariance is enabled. */
+  OutputImageType *
+  GetGradientVarianceOutput();
+  const OutputImageType *
+  GetGradientVarianceOutput() const;
+
+  /** Set/Get whether the input slabs shared by consecutive streamed pieces
+   * are kept, so that they are requested once.  The default value of this
+   * flag is Off. */
+  itkSetMacro(ReuseStreamingHalo, bool);
+  itkGetConstMacro(ReuseStreamingHalo, bool);
+  itkBooleanMacro(ReuseStreamingHalo);
+
+  /** Set/Get the optional persistent cache of the outputs.  When it is set,
+   * the outputs are read from the cache if the same input was processed with
+   * the same parameters before, and stored in it otherwise. */
+  itkSetObjectMacro(ResultCache, HigherOrderAccurateResultCache);
+  itkGetModifiableObjectMacro(ResultCache, HigherOrderAccurateResultCache);
+
+  /** Set/Get how the derivative kernels are applied.  Defaults to
+   * Neighborhood. */
+  itkSetEnumMacro(KernelVariant, KernelVariantEnum);
+  itkGetEnumMacro(KernelVariant, KernelVariantEnum);
+
+  /** Set/Get the shape of the pieces processed by the threads.  Defaults to
+   * Slabs. */
+  itkSetEnumMacro(Tiling, TilingEnum);
+  itkGetEnumMacro(Tiling, TilingEnum);
+
+  /** Set/Get the optional autotuner.  When it is set, the kernel variant,
+   * tiling and number of work units are the fastest recorded for the
+   * workload, and are measured on the first run. */
+  itkSetObjectMacro(Autotuner, HigherOrderAccurateAutotuner);
+  itkGetModifiableObjectMacro(Autotuner, HigherOrderAccurateAutotuner);
+
+  /** Set/Get whether the outputs are computed with rounded products and sums
+   * in a fixed order, without contraction, so that they do not depend on the
+   * execution configuration or the processor.  The default value of this
+   * flag is Off. */
+  itkSetMacro(Reproducible, bool);
+  itkGetConstMacro(Reproducible, bool);
+  itkBooleanMacro(Reproducible);
+
 protected:
   HigherOrderAccurateGradientImageFilter();
   ~HigherOrderAccurateGradientImageFilter() override = default;
@@ -137,6 +342,18 @@ protected:
   void
   GenerateInputRequestedRegion() override;
 
+  /** The gradient variance output is only allocated when it is computed. */
+  void
+  AllocateOutputs() override;
+
+  /** Read the outputs from the ResultCache when possible, compute and store
+   * them otherwise. */
+  void
+  GenerateData() override;
+
+  void
+  BeforeThreadedGenerateData() override;
+
   /** GradientImageFilter can be implemented as a multithreaded filter.
    * Therefore, this implementation provides a ThreadedGenerateData()
    * routine which is called for each processing thread. The output
@@ -151,6 +368,101 @@ protected:
   DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread) override;
 
 private:
+  using InputImageRegionType = typename InputImageType::RegionType;
+
+  /** The settings a computation of the outputs runs with. */
+  struct ExecutionConfiguration
+  {
+    KernelVariantEnum KernelVariant;
+    TilingEnum        Tiling;
+    unsigned int      NumberOfWorkUnits;
+  };
+
+  /** Compute the outputs with the configuration chosen by the Autotuner, or
+   * with the settings of the filter. */
+  void
+  ComputeOutputs();
+
+  /** Time the candidate configurations, or look the fastest up, and set it
+   * as the execution configuration. */
+  void
+  Autotune();
+
+  /** Compute the outputs with the execution configuration. */
+  void
+  ExecuteConfiguration();
+
+  /** Compute region of the allocated outputs with the execution
+   * configuration, in parallel. */
+  void
+  ThreadedExecuteConfiguration(const OutputImageRegionType & region);
+
+  /** Compute the gradient of outputRegionForThread with the Scanline
+   * variant. */
+  void
+  ScanlineThreadedGenerateData(const OutputImageRegionType & outputRegionForThread);
+
+  /** Rotate the local vector to physical space with the direction of the
+   * input, as TransformLocalVectorToPhysicalVector, but in a fixed order
+   * without contraction. */
+  static void
+  ReproducibleTransformLocalVectorToPhysicalVector(const typename InputImageType::DirectionType & direction,
+                                                   const OutputPixelType &                        localVector,
+                                                   OutputPixelType &                              physicalVector);
+
+  /** sum + a * b, the product and the sum each rounded. */
+  template <typename TSum>
+  static TSum
+  ReproducibleMultiplyAdd(TSum a, TSum b, TSum sum);
+
+  /** Inner product of the coefficients with the values of the neighborhood
+   * along slice, in the order of the taps and without contraction. */
+  template <typename TSum, typename TNeighborhoodIterator, typename TCoefficients>
+  static TSum
+  ReproducibleInnerProduct(const std::slice &           slice,
+                           const TNeighborhoodIterator & it,
+                           const TCoefficients &         coefficients);
+
+  /** Inner product of numberOfTaps coefficients with consecutive values, in
+   * the order of the taps and without contraction. */
+  template <typename TSum, typename TValue>
+  static TSum
+  ReproducibleInnerProduct(const TSum * coefficients, const TValue * values, unsigned int numberOfTaps);
+
+  /** Add coefficient times each of length values to sums, without
+   * contraction. */
+  template <typename TSum, typename TValue>
+  static void
+  ReproducibleAccumulateRow(TSum coefficient, const TValue * values, TSum * sums, IndexValueType length);
+
+  /** Radius of the derivative operator. */
+  SizeValueType
+  GetOperatorRadius() const;
+
+  /** Whether the kept slabs hold the start of region along the slowest axis,
+   * and region extends past them. */
+  bool
+  CanReuseStreamingHalo(const InputImageRegionType & region) const;
+
+  /** Set the image the gradient is computed from: the input, or the kept
+   * slabs completed with the input when they are reused. */
+  void
+  PrepareStreamingInput();
+
+  /** Keep the trailing slabs of the processed input for the next piece. */
+  void
+  UpdateStreamingHalo();
+
+  const InputImageType *
+  GetStreamingInput() const
+  {
+    return this->m_StreamingInput ? this->m_StreamingInput.GetPointer() : this->GetInput();
+  }
+
+  /** Digest of the inputs and of every parameter that changes the outputs. */
+  std::string
+  ComputeResultCacheKey() const;
+
   bool m_UseImageSpacing{ true };
 
   // flag to take or not the image direction into account
@@ -158,6 +470,32 @@ private:
   bool m_UseImageDirection{ true };
 
   unsigned int m_OrderOfAccuracy{ 2 };
+
+  bool m_ComputeGradientVariance{ false };
+
+  double m_NoiseSigma{ 1.0 };
+
+  HigherOrderAccurateResultCache::Pointer m_ResultCache;
+
+  bool m_ReuseStreamingHalo{ false };
+
+  typename InputImageType::ConstPointer m_StreamingInput;
+
+  /** Trailing input slabs of the last piece, and the times they are valid
+   * for. */
+  typename InputImageType::Pointer m_StreamingHalo;
+  ModifiedTimeType                 m_StreamingHaloMTime{ 0 };
+  ModifiedTimeType                 m_StreamingHaloPipelineMTime{ 0 };
+
+  KernelVariantEnum m_KernelVariant{ KernelVariantEnum::Neighborhood };
+
+  TilingEnum m_Tiling{ TilingEnum::Slabs };
+
+  HigherOrderAccurateAutotuner::Pointer m_Autotuner;
+
+  bool m_Reproducible{ false };
+
+  ExecutionConfiguration m_ExecutionConfiguration{ KernelVariantEnum::Neighborhood, TilingEnum::Slabs, 1 };
 };
 
 } // end namespace itk
@@ -167,3 +505,66 @@ private:
 #endif
 
 #endif
+
+/** Explicit instantiations */
+#if defined(HigherOrderAccurateGradient_EXPLICIT_INSTANTIATION)
+#  ifndef ITK_TEMPLATE_EXPLICIT_HigherOrderAccurateGradientImageFilter
+// The common instantiations are compiled once in the HigherOrderAccurateGradient
+// library.
+//
+// IMPORTANT: Since within the same compilation unit,
+//            ITK_TEMPLATE_EXPLICIT_<classname> defined and undefined states
+//            need to be considered. This code *MUST* be *OUTSIDE* the header
+//            guards.
+//
+#    include "HigherOrderAccurateGradientExport.h"
+#    if defined(HigherOrderAccurateGradient_EXPORTS)
+//   We are building this library
+#      define HigherOrderAccurateGradient_EXPORT_EXPLICIT ITK_FORWARD_EXPORT
+#    else
+//   We are using this library
+#      define HigherOrderAccurateGradient_EXPORT_EXPLICIT HigherOrderAccurateGradient_EXPORT
+#    endif
+namespace itk
+{
+
+ITK_GCC_PRAGMA_DIAG_PUSH()
+ITK_GCC_PRAGMA_DIAG(ignored "-Wattributes")
+
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateGradientImageFilter<Image<unsigned char, 2>, float, float>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateGradientImageFilter<Image<short, 2>, float, float>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateGradientImageFilter<Image<float, 2>, float, float>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateGradientImageFilter<Image<double, 2>, float, float>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateGradientImageFilter<Image<double, 2>, double, double>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateGradientImageFilter<Image<unsigned char, 3>, float, float>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateGradientImageFilter<Image<short, 3>, float, float>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateGradientImageFilter<Image<float, 3>, float, float>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateGradientImageFilter<Image<double, 3>, float, float>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateGradientImageFilter<Image<double, 3>, double, double>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateGradientImageFilter<Image<unsigned char, 4>, float, float>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateGradientImageFilter<Image<short, 4>, float, float>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateGradientImageFilter<Image<float, 4>, float, float>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateGradientImageFilter<Image<double, 4>, float, float>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateGradientImageFilter<Image<double, 4>, double, double>;
+
+ITK_GCC_PRAGMA_DIAG_POP()
+
+} // end namespace itk
+#    undef HigherOrderAccurateGradient_EXPORT_EXPLICIT
+#  endif
+#endif
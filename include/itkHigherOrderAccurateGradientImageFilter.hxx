@@ -25,6 +25,16 @@
 #include "itkHigherOrderAccurateDerivativeOperator.h"
 #include "itkNeighborhoodAlgorithm.h"
 #include "itkOffset.h"
+#include "itkImageAlgorithm.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionSplitterMultidimensional.h"
+#include "itkImageRegionSplitterSlowDimension.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <typeinfo>
+#include <vector>
 
 namespace itk
 {
@@ -32,8 +42,30 @@ namespace itk
 template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
 HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
   HigherOrderAccurateGradientImageFilter()
+{
+  this->AddOptionalInputName("VarianceImage", 1);
+
+  this->SetNumberOfRequiredOutputs(2);
+  this->SetNthOutput(1, this->MakeOutput(1));
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+auto
+HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::GetGradientVarianceOutput()
+  -> OutputImageType *
+{
+  return itkDynamicCastInDebugMode<OutputImageType *>(this->ProcessObject::GetOutput(1));
+}
+
 
-  = default;
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+auto
+HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::GetGradientVarianceOutput()
+  const -> const OutputImageType *
+{
+  return itkDynamicCastInDebugMode<const OutputImageType *>(this->ProcessObject::GetOutput(1));
+}
 
 
 template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
@@ -53,13 +85,19 @@ HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputV
     return;
   }
 
-  // Build an operator so that we can determine the kernel size
-  HigherOrderAccurateDerivativeOperator<OperatorValueType, ImageDimension> oper;
-  oper.SetDirection(0);
-  oper.SetOrder(1);
-  oper.SetOrderOfAccuracy(this->m_OrderOfAccuracy);
-  oper.CreateDirectional();
-  unsigned long radius = oper.GetRadius()[0];
+  const SizeValueType radius = this->GetOperatorRadius();
+
+  // the variance image is read under the same stencil as the input
+  auto * varianceImage = const_cast<VarianceImageType *>(this->GetVarianceImage());
+  if (this->m_ComputeGradientVariance && varianceImage)
+  {
+    typename VarianceImageType::RegionType varianceRequestedRegion = varianceImage->GetRequestedRegion();
+    varianceRequestedRegion.PadByRadius(radius);
+    if (varianceRequestedRegion.Crop(varianceImage->GetLargestPossibleRegion()))
+    {
+      varianceImage->SetRequestedRegion(varianceRequestedRegion);
+    }
+  }
 
   // get a copy of the input requested region (should equal the output
   // requested region)
@@ -72,6 +110,16 @@ HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputV
   // crop the input requested region at the input's largest possible region
   if (inputRequestedRegion.Crop(inputPtr->GetLargestPossibleRegion()))
   {
+    // only request the slabs that were not kept from the previous piece
+    if (this->CanReuseStreamingHalo(inputRequestedRegion))
+    {
+      constexpr unsigned int slowest = ImageDimension - 1;
+      const IndexValueType   haloEnd = this->m_StreamingHalo->GetBufferedRegion().GetUpperIndex()[slowest] + 1;
+      inputRequestedRegion.SetSize(slowest,
+                                   inputRequestedRegion.GetSize(slowest) -
+                                     static_cast<SizeValueType>(haloEnd - inputRequestedRegion.GetIndex(slowest)));
+      inputRequestedRegion.SetIndex(slowest, haloEnd);
+    }
     inputPtr->SetRequestedRegion(inputRequestedRegion);
     return;
   }
@@ -93,11 +141,407 @@ HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputV
 }
 
 
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::AllocateOutputs()
+{
+  OutputImageType * outputPtr = this->GetOutput();
+  outputPtr->SetBufferedRegion(outputPtr->GetRequestedRegion());
+  outputPtr->Allocate();
+
+  if (this->m_ComputeGradientVariance)
+  {
+    OutputImageType * varianceOutputPtr = this->GetGradientVarianceOutput();
+    varianceOutputPtr->SetBufferedRegion(varianceOutputPtr->GetRequestedRegion());
+    varianceOutputPtr->Allocate();
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+SizeValueType
+HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::GetOperatorRadius() const
+{
+  // Build an operator so that we can determine the kernel size
+  HigherOrderAccurateDerivativeOperator<OperatorValueType, ImageDimension> oper;
+  oper.SetDirection(0);
+  oper.SetOrder(1);
+  oper.SetOrderOfAccuracy(this->m_OrderOfAccuracy);
+  oper.CreateDirectional();
+  return oper.GetRadius()[0];
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+bool
+HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::CanReuseStreamingHalo(
+  const InputImageRegionType & region) const
+{
+  const InputImageType * input = this->GetInput();
+  if (!this->m_ReuseStreamingHalo || !this->m_StreamingHalo || !input ||
+      this->m_StreamingHaloMTime != this->GetMTime() ||
+      this->m_StreamingHaloPipelineMTime != input->GetPipelineMTime() ||
+      this->m_StreamingHalo->GetLargestPossibleRegion() != input->GetLargestPossibleRegion())
+  {
+    return false;
+  }
+
+  // The kept slabs must span the region across the other axes, and hold its
+  // first slabs along the slowest axis.
+  constexpr unsigned int       slowest = ImageDimension - 1;
+  const InputImageRegionType & halo = this->m_StreamingHalo->GetBufferedRegion();
+  for (unsigned int i = 0; i < slowest; ++i)
+  {
+    if (halo.GetIndex(i) != region.GetIndex(i) || halo.GetSize(i) != region.GetSize(i))
+    {
+      return false;
+    }
+  }
+  const IndexValueType haloEnd = halo.GetIndex(slowest) + static_cast<IndexValueType>(halo.GetSize(slowest));
+  const IndexValueType regionEnd = region.GetIndex(slowest) + static_cast<IndexValueType>(region.GetSize(slowest));
+  return halo.GetIndex(slowest) <= region.GetIndex(slowest) && region.GetIndex(slowest) < haloEnd &&
+         haloEnd < regionEnd;
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::PrepareStreamingInput()
+{
+  this->m_StreamingInput = nullptr;
+
+  const InputImageType * input = this->GetInput();
+  InputImageRegionType   requiredRegion = this->GetOutput()->GetRequestedRegion();
+  requiredRegion.PadByRadius(this->GetOperatorRadius());
+  requiredRegion.Crop(input->GetLargestPossibleRegion());
+  if (input->GetBufferedRegion().IsInside(requiredRegion) || !this->CanReuseStreamingHalo(requiredRegion))
+  {
+    return;
+  }
+
+  // Complete the kept slabs with the slabs produced for this piece.
+  constexpr unsigned int slowest = ImageDimension - 1;
+  const IndexValueType   haloEnd = this->m_StreamingHalo->GetBufferedRegion().GetUpperIndex()[slowest] + 1;
+  const IndexValueType   requiredEnd = requiredRegion.GetUpperIndex()[slowest] + 1;
+
+  InputImageRegionType keptRegion = requiredRegion;
+  keptRegion.SetSize(slowest, static_cast<SizeValueType>(haloEnd - requiredRegion.GetIndex(slowest)));
+  InputImageRegionType newRegion = requiredRegion;
+  newRegion.SetIndex(slowest, haloEnd);
+  newRegion.SetSize(slowest, static_cast<SizeValueType>(requiredEnd - haloEnd));
+  if (!input->GetBufferedRegion().IsInside(newRegion))
+  {
+    return;
+  }
+
+  typename InputImageType::Pointer streamingInput = InputImageType::New();
+  streamingInput->CopyInformation(input);
+  streamingInput->SetBufferedRegion(requiredRegion);
+  streamingInput->SetRequestedRegion(requiredRegion);
+  streamingInput->Allocate();
+  ImageAlgorithm::Copy(this->m_StreamingHalo.GetPointer(), streamingInput.GetPointer(), keptRegion, keptRegion);
+  ImageAlgorithm::Copy(input, streamingInput.GetPointer(), newRegion, newRegion);
+  this->m_StreamingInput = streamingInput;
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::UpdateStreamingHalo()
+{
+  // No piece follows one that reaches the end of the slowest axis, as the
+  // whole unstreamed output does, so there is nothing to keep.
+  constexpr unsigned int        slowest = ImageDimension - 1;
+  const OutputImageRegionType & outputRegion = this->GetOutput()->GetRequestedRegion();
+  if (!this->m_ReuseStreamingHalo ||
+      outputRegion.GetUpperIndex()[slowest] == this->GetOutput()->GetLargestPossibleRegion().GetUpperIndex()[slowest])
+  {
+    this->m_StreamingHalo = nullptr;
+    return;
+  }
+
+  // The next piece starts radius slabs before the end of this output, and
+  // needs radius slabs before its start.
+  const InputImageType * input = this->GetStreamingInput();
+  InputImageRegionType   haloRegion = input->GetBufferedRegion();
+  const SizeValueType    haloSize = std::min(2 * this->GetOperatorRadius(), haloRegion.GetSize(slowest));
+  haloRegion.SetIndex(slowest, haloRegion.GetUpperIndex()[slowest] + 1 - static_cast<IndexValueType>(haloSize));
+  haloRegion.SetSize(slowest, haloSize);
+
+  typename InputImageType::Pointer halo = InputImageType::New();
+  halo->CopyInformation(input);
+  halo->SetBufferedRegion(haloRegion);
+  halo->SetRequestedRegion(haloRegion);
+  halo->Allocate();
+  ImageAlgorithm::Copy(input, halo.GetPointer(), haloRegion, haloRegion);
+
+  this->m_StreamingHalo = halo;
+  this->m_StreamingHaloMTime = this->GetMTime();
+  this->m_StreamingHaloPipelineMTime = this->GetInput()->GetPipelineMTime();
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+std::string
+HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::ComputeResultCacheKey()
+  const
+{
+  HigherOrderAccurateResultCacheKey key;
+  key.Append(this->GetNameOfClass());
+  key.Append(typeid(OperatorValueType).name());
+  key.Append(typeid(OutputPixelType).name());
+  key.AppendValue(this->m_UseImageSpacing);
+  key.AppendValue(this->m_UseImageDirection);
+  key.AppendValue(this->m_OrderOfAccuracy);
+  key.AppendValue(this->m_ComputeGradientVariance);
+  key.AppendValue(this->m_Reproducible);
+  key.Append(this->m_ResultCache->ComputeImageDigest(this->GetStreamingInput()));
+  if (this->m_ComputeGradientVariance)
+  {
+    key.AppendValue(this->m_NoiseSigma);
+    const VarianceImageType * varianceImage = this->GetVarianceImage();
+    key.AppendValue(varianceImage != nullptr);
+    if (varianceImage)
+    {
+      key.Append(this->m_ResultCache->ComputeImageDigest(varianceImage));
+    }
+  }
+
+  const OutputImageRegionType & requestedRegion = this->GetOutput()->GetRequestedRegion();
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    key.AppendValue(requestedRegion.GetIndex(i));
+    key.AppendValue(requestedRegion.GetSize(i));
+  }
+  return key.GetHexDigest();
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::GenerateData()
+{
+  this->PrepareStreamingInput();
+
+  if (!this->m_ResultCache)
+  {
+    this->ComputeOutputs();
+  }
+  else
+  {
+    // The gradient and its variance are cached as two entries, and only used
+    // when all the outputs are present.
+    const std::string key = this->ComputeResultCacheKey();
+    const std::string varianceKey = key + "-variance";
+    this->AllocateOutputs();
+    if (this->m_ResultCache->Load(key, this->GetOutput()) &&
+        (!this->m_ComputeGradientVariance || this->m_ResultCache->Load(varianceKey, this->GetGradientVarianceOutput())))
+    {
+      this->UpdateProgress(1.0f);
+    }
+    else
+    {
+      this->ComputeOutputs();
+
+      this->m_ResultCache->Store(key, this->GetOutput());
+      if (this->m_ComputeGradientVariance)
+      {
+        this->m_ResultCache->Store(varianceKey, this->GetGradientVarianceOutput());
+      }
+    }
+  }
+
+  this->UpdateStreamingHalo();
+  this->m_StreamingInput = nullptr;
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::ComputeOutputs()
+{
+  if (this->m_Autotuner)
+  {
+    this->Autotune();
+  }
+  else
+  {
+    this->m_ExecutionConfiguration =
+      ExecutionConfiguration{ this->m_KernelVariant, this->m_Tiling, this->GetNumberOfWorkUnits() };
+  }
+  this->ExecuteConfiguration();
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::Autotune()
+{
+  // Everything the relative speed of the candidates depends on, besides the
+  // processor.
+  const OutputImageRegionType & region = this->GetOutput()->GetRequestedRegion();
+  std::ostringstream            workload;
+  workload << this->GetNameOfClass() << ' ' << ImageDimension << "D " << typeid(InputPixelType).name() << ' '
+           << typeid(OperatorValueType).name() << ' ' << typeid(OutputValueType).name() << " size 2^"
+           << static_cast<unsigned int>(std::log2(std::max(static_cast<double>(region.GetNumberOfPixels()), 1.0)))
+           << " accuracy " << this->m_OrderOfAccuracy << " variance " << this->m_ComputeGradientVariance
+           << " reproducible " << this->m_Reproducible << " threads "
+           << this->GetMultiThreader()->GetMaximumNumberOfThreads();
+  const std::string key = this->m_Autotuner->ComputeKey(workload.str());
+
+  std::string recorded;
+  if (this->m_Autotuner->Lookup(key, recorded))
+  {
+    std::istringstream configuration(recorded);
+    std::string        kernelVariant;
+    std::string        tiling;
+    unsigned int       numberOfWorkUnits = 0;
+    if (configuration >> kernelVariant >> tiling >> numberOfWorkUnits && numberOfWorkUnits > 0)
+    {
+      this->m_ExecutionConfiguration.KernelVariant =
+        kernelVariant == "Scanline" ? KernelVariantEnum::Scanline : KernelVariantEnum::Neighborhood;
+      this->m_ExecutionConfiguration.Tiling = tiling == "Blocks" ? TilingEnum::Blocks : TilingEnum::Slabs;
+      this->m_ExecutionConfiguration.NumberOfWorkUnits = numberOfWorkUnits;
+      return;
+    }
+  }
+
+  // Fewer, as many and more pieces than the threads of the multithreader of
+  // the filter, and its own NumberOfWorkUnits, with both kernel variants and
+  // tilings.
+  const unsigned int        numberOfThreads = this->GetMultiThreader()->GetMaximumNumberOfThreads();
+  std::vector<unsigned int> numberOfWorkUnits{
+    std::max(numberOfThreads / 2, 1u), numberOfThreads, 4 * numberOfThreads, this->GetNumberOfWorkUnits()
+  };
+  std::sort(numberOfWorkUnits.begin(), numberOfWorkUnits.end());
+  numberOfWorkUnits.erase(std::unique(numberOfWorkUnits.begin(), numberOfWorkUnits.end()), numberOfWorkUnits.end());
+  std::vector<KernelVariantEnum> kernelVariants{ KernelVariantEnum::Neighborhood };
+  if (!this->m_ComputeGradientVariance)
+  {
+    kernelVariants.push_back(KernelVariantEnum::Scanline);
+  }
+
+  // The candidates are timed on a central block of at most 2^20 pixels of
+  // the requested region, cropped along the slowest axes first, so the first
+  // run of a workload costs a bounded amount on top of the filter itself.
+  constexpr SizeValueType maximumNumberOfTuningPixels = SizeValueType{ 1 } << 20;
+  OutputImageRegionType   tuningRegion = region;
+  for (unsigned int i = ImageDimension; i-- > 0 && tuningRegion.GetNumberOfPixels() > maximumNumberOfTuningPixels;)
+  {
+    const SizeValueType sliceSize = tuningRegion.GetNumberOfPixels() / tuningRegion.GetSize(i);
+    const SizeValueType length = std::max(maximumNumberOfTuningPixels / sliceSize, SizeValueType{ 1 });
+    const auto          margin = static_cast<IndexValueType>((tuningRegion.GetSize(i) - length) / 2);
+    tuningRegion.SetIndex(i, tuningRegion.GetIndex(i) + margin);
+    tuningRegion.SetSize(i, length);
+  }
+
+  this->AllocateOutputs();
+  this->BeforeThreadedGenerateData();
+
+  ExecutionConfiguration fastest = this->m_ExecutionConfiguration;
+  double                 fastestTime = NumericTraits<double>::max();
+  for (const KernelVariantEnum kernelVariant : kernelVariants)
+  {
+    for (const TilingEnum tiling : { TilingEnum::Slabs, TilingEnum::Blocks })
+    {
+      for (const unsigned int candidateNumberOfWorkUnits : numberOfWorkUnits)
+      {
+        this->m_ExecutionConfiguration = ExecutionConfiguration{ kernelVariant, tiling, candidateNumberOfWorkUnits };
+        const double time =
+          this->m_Autotuner->Time([this, &tuningRegion] { this->ThreadedExecuteConfiguration(tuningRegion); });
+        if (time < fastestTime)
+        {
+          fastestTime = time;
+          fastest = this->m_ExecutionConfiguration;
+        }
+      }
+    }
+  }
+
+  std::ostringstream configuration;
+  configuration << (fastest.KernelVariant == KernelVariantEnum::Scanline ? "Scanline" : "Neighborhood") << ' '
+                << (fastest.Tiling == TilingEnum::Blocks ? "Blocks" : "Slabs") << ' ' << fastest.NumberOfWorkUnits;
+  this->m_Autotuner->Record(key, configuration.str());
+  this->m_ExecutionConfiguration = fastest;
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::ExecuteConfiguration()
+{
+  const ExecutionConfiguration configuration = this->m_ExecutionConfiguration;
+  if (configuration.Tiling == TilingEnum::Slabs && configuration.NumberOfWorkUnits == this->GetNumberOfWorkUnits())
+  {
+    Superclass::GenerateData();
+    return;
+  }
+
+  this->AllocateOutputs();
+  this->BeforeThreadedGenerateData();
+  this->ThreadedExecuteConfiguration(this->GetOutput()->GetRequestedRegion());
+  this->AfterThreadedGenerateData();
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  ThreadedExecuteConfiguration(const OutputImageRegionType & region)
+{
+  const ExecutionConfiguration configuration = this->m_ExecutionConfiguration;
+
+  // One piece of the configured shape per work unit.
+  ImageRegionSplitterBase::Pointer splitter;
+  if (configuration.Tiling == TilingEnum::Blocks)
+  {
+    splitter = ImageRegionSplitterMultidimensional::New();
+  }
+  else
+  {
+    splitter = ImageRegionSplitterSlowDimension::New();
+  }
+  const unsigned int numberOfPieces = splitter->GetNumberOfSplits(region, configuration.NumberOfWorkUnits);
+
+  this->GetMultiThreader()->SetNumberOfWorkUnits(configuration.NumberOfWorkUnits);
+  this->GetMultiThreader()->ParallelizeArray(
+    0,
+    numberOfPieces,
+    [this, &splitter, &region, numberOfPieces](SizeValueType piece) {
+      OutputImageRegionType pieceRegion = region;
+      splitter->GetSplit(static_cast<unsigned int>(piece), numberOfPieces, pieceRegion);
+      this->DynamicThreadedGenerateData(pieceRegion);
+    },
+    this);
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::BeforeThreadedGenerateData()
+{
+  const VarianceImageType * varianceImage = this->GetVarianceImage();
+  if (this->m_ComputeGradientVariance && varianceImage &&
+      !varianceImage->GetBufferedRegion().IsInside(this->GetStreamingInput()->GetBufferedRegion()))
+  {
+    itkExceptionMacro(<< "The VarianceImage does not cover the buffered region of the input image.");
+  }
+}
+
+
 template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
 void
 HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::DynamicThreadedGenerateData(
   const OutputImageRegionType & outputRegionForThread)
 {
+  if (this->m_ExecutionConfiguration.KernelVariant == KernelVariantEnum::Scanline && !this->m_ComputeGradientVariance)
+  {
+    this->ScanlineThreadedGenerateData(outputRegionForThread);
+    return;
+  }
+
+  using AccumulateType = typename NumericTraits<typename NumericTraits<InputPixelType>::RealType>::AccumulateType;
+
   unsigned int    i;
   OutputPixelType gradient;
 
@@ -110,7 +554,7 @@ HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputV
 
   // Get the input and output
   OutputImageType *      outputImage = this->GetOutput();
-  const InputImageType * inputImage = this->GetInput();
+  const InputImageType * inputImage = this->GetStreamingInput();
 
   // Set up operators
   HigherOrderAccurateDerivativeOperator<OperatorValueType, ImageDimension> op[ImageDimension];
@@ -147,6 +591,48 @@ HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputV
     radius[i] = op[0].GetRadius()[0];
   }
 
+  // With Reproducible enabled, every sum of products is accumulated tap
+  // after tap, each product and sum rounded, whatever the compiler contracts.
+  const bool reproducible = this->m_Reproducible;
+  const auto multiplyAdd = [reproducible](double a, double b, double sum) {
+    return reproducible ? ReproducibleMultiplyAdd(a, b, sum) : sum + a * b;
+  };
+
+  // The variance of a gradient component is the sum of the squared kernel
+  // coefficients times the variance under the stencil.  The coefficients are
+  // squared and accumulated in double on every face, so the variance stays
+  // continuous across the face boundaries whatever the OperatorValueType.
+  const bool                computeVariance = this->m_ComputeGradientVariance;
+  const VarianceImageType * varianceImage = this->GetVarianceImage();
+  OutputImageType *         varianceOutput = computeVariance ? this->GetGradientVarianceOutput() : nullptr;
+  const double              noiseVariance = this->m_NoiseSigma * this->m_NoiseSigma;
+
+  std::vector<double> squaredCoefficients[ImageDimension];
+  double              constantVariance[ImageDimension];
+  for (i = 0; i < ImageDimension; ++i)
+  {
+    squaredCoefficients[i].resize(op[i].Size());
+    constantVariance[i] = 0.0;
+    for (unsigned int j = 0; j < op[i].Size(); ++j)
+    {
+      const auto coefficient = static_cast<double>(op[i][j]);
+      squaredCoefficients[i][j] = coefficient * coefficient;
+      constantVariance[i] = multiplyAdd(noiseVariance, squaredCoefficients[i][j], constantVariance[i]);
+    }
+  }
+
+  ConstNeighborhoodIterator<VarianceImageType> vnit;
+  ImageRegionIterator<OutputImageType>         vit;
+  OutputPixelType                              variance;
+
+  // Merged coefficient of the pixel itself in each component, and variance
+  // of the pixel, for the covariance of the components.
+  double centerCoefficient[ImageDimension];
+  double centerVariance = 0.0;
+
+  const typename InputImageType::RegionType bufferedRegion = inputImage->GetBufferedRegion();
+  const typename InputImageType::DirectionType & direction = inputImage->GetDirection();
+
   // Find the data-set boundary "faces"
   typename NeighborhoodAlgorithm::ImageBoundaryFacesCalculator<InputImageType>::FaceListType faceList;
   NeighborhoodAlgorithm::ImageBoundaryFacesCalculator<InputImageType>                        bC;
@@ -174,14 +660,41 @@ HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputV
     nit.OverrideBoundaryCondition(&nbc);
     nit.GoToBegin();
 
+    // Inside the buffer, the variance stencil is applied with an inner
+    // product.  Near the border, taps replicated by the boundary condition
+    // are merged before their coefficient is squared.
+    typename InputImageType::RegionType paddedFace = *fit;
+    paddedFace.PadByRadius(radius);
+    const bool interior = bufferedRegion.IsInside(paddedFace);
+    if (computeVariance)
+    {
+      vit = ImageRegionIterator<OutputImageType>(varianceOutput, *fit);
+      if (varianceImage && interior)
+      {
+        vnit = ConstNeighborhoodIterator<VarianceImageType>(radius, varianceImage, *fit);
+        vnit.GoToBegin();
+      }
+    }
+
     while (!nit.IsAtEnd())
     {
       for (i = 0; i < ImageDimension; ++i)
       {
-        gradient[i] = SIP(x_slice[i], nit, op[i]);
+        if (reproducible)
+        {
+          gradient[i] = static_cast<OutputValueType>(ReproducibleInnerProduct<AccumulateType>(x_slice[i], nit, op[i]));
+        }
+        else
+        {
+          gradient[i] = SIP(x_slice[i], nit, op[i]);
+        }
       }
 
-      if (this->m_UseImageDirection)
+      if (this->m_UseImageDirection && reproducible)
+      {
+        ReproducibleTransformLocalVectorToPhysicalVector(direction, gradient, it.Value());
+      }
+      else if (this->m_UseImageDirection)
       {
         inputImage->TransformLocalVectorToPhysicalVector(gradient, it.Value());
       }
@@ -189,6 +702,119 @@ HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputV
       {
         it.Value() = gradient;
       }
+
+      if (computeVariance)
+      {
+        if (interior)
+        {
+          for (i = 0; i < ImageDimension; ++i)
+          {
+            centerCoefficient[i] = 0.0;
+            if (varianceImage && reproducible)
+            {
+              const double sum = ReproducibleInnerProduct<double>(x_slice[i], vnit, squaredCoefficients[i]);
+              variance[i] = static_cast<OutputValueType>(sum);
+            }
+            else if (varianceImage)
+            {
+              double sum = 0.0;
+              for (unsigned int j = 0; j < squaredCoefficients[i].size(); ++j)
+              {
+                sum += squaredCoefficients[i][j] *
+                       static_cast<double>(vnit.GetPixel(x_slice[i].start() + j * x_slice[i].stride()));
+              }
+              variance[i] = static_cast<OutputValueType>(sum);
+            }
+            else
+            {
+              variance[i] = static_cast<OutputValueType>(constantVariance[i]);
+            }
+          }
+          if (varianceImage)
+          {
+            ++vnit;
+          }
+        }
+        else
+        {
+          const typename InputImageType::IndexType index = nit.GetIndex();
+          centerVariance = varianceImage ? static_cast<double>(varianceImage->GetPixel(index)) : noiseVariance;
+          for (i = 0; i < ImageDimension; ++i)
+          {
+            centerCoefficient[i] = 0.0;
+            const IndexValueType first = bufferedRegion.GetIndex(i);
+            const IndexValueType last = first + static_cast<IndexValueType>(bufferedRegion.GetSize(i)) - 1;
+
+            typename InputImageType::IndexType tapIndex = index;
+            double                             sum = 0.0;
+            double                             mergedCoefficient = 0.0;
+            for (unsigned int j = 0; j < op[i].Size(); ++j)
+            {
+              const IndexValueType position = std::min(
+                std::max(index[i] + static_cast<IndexValueType>(j) - static_cast<IndexValueType>(radius[i]), first),
+                last);
+              if (j > 0 && position != tapIndex[i])
+              {
+                const double tapVariance =
+                  varianceImage ? static_cast<double>(varianceImage->GetPixel(tapIndex)) : noiseVariance;
+                sum = multiplyAdd(mergedCoefficient * mergedCoefficient, tapVariance, sum);
+                if (tapIndex[i] == index[i])
+                {
+                  centerCoefficient[i] = mergedCoefficient;
+                }
+                mergedCoefficient = 0.0;
+              }
+              tapIndex[i] = position;
+              mergedCoefficient += static_cast<double>(op[i][j]);
+            }
+            const double tapVariance =
+              varianceImage ? static_cast<double>(varianceImage->GetPixel(tapIndex)) : noiseVariance;
+            sum = multiplyAdd(mergedCoefficient * mergedCoefficient, tapVariance, sum);
+            if (tapIndex[i] == index[i])
+            {
+              centerCoefficient[i] = mergedCoefficient;
+            }
+            variance[i] = static_cast<OutputValueType>(sum);
+          }
+        }
+
+        // The stencils of two components only share the pixel itself.  Its
+        // coefficient is zero in the interior, so the components along the
+        // grid axes are uncorrelated there and their variances rotate with
+        // the squared direction cosines.  On an edge or a corner, the taps
+        // clamped onto the pixel along several axes correlate the
+        // components, and their covariance is added.
+        if (this->m_UseImageDirection)
+        {
+          OutputPixelType physicalVariance;
+          for (unsigned int row = 0; row < ImageDimension; ++row)
+          {
+            double sum = 0.0;
+            for (unsigned int col = 0; col < ImageDimension; ++col)
+            {
+              sum = multiplyAdd(direction[row][col] * direction[row][col], variance[col], sum);
+            }
+            if (!interior)
+            {
+              for (unsigned int col = 0; col < ImageDimension; ++col)
+              {
+                for (unsigned int otherCol = col + 1; otherCol < ImageDimension; ++otherCol)
+                {
+                  const double covariance = centerCoefficient[col] * centerCoefficient[otherCol] * centerVariance;
+                  sum = multiplyAdd(2.0 * direction[row][col] * direction[row][otherCol], covariance, sum);
+                }
+              }
+            }
+            physicalVariance[row] = static_cast<OutputValueType>(sum);
+          }
+          vit.Set(physicalVariance);
+        }
+        else
+        {
+          vit.Set(variance);
+        }
+        ++vit;
+      }
       ++nit;
       ++it;
     }
@@ -196,6 +822,250 @@ HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputV
 }
 
 
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::ScanlineThreadedGenerateData(
+  const OutputImageRegionType & outputRegionForThread)
+{
+  // Sums are accumulated in the type and tap order of the neighborhood
+  // variant.
+  using AccumulateType = typename NumericTraits<typename NumericTraits<InputPixelType>::RealType>::AccumulateType;
+
+  OutputImageType *      outputImage = this->GetOutput();
+  const InputImageType * inputImage = this->GetStreamingInput();
+
+  const bool reproducible = this->m_Reproducible;
+  const auto multiplyAdd = [reproducible](AccumulateType a, AccumulateType b, AccumulateType sum) -> AccumulateType {
+    return reproducible ? ReproducibleMultiplyAdd(a, b, sum) : sum + a * b;
+  };
+
+  std::vector<AccumulateType> coefficients[ImageDimension];
+  IndexValueType              radius = 0;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    HigherOrderAccurateDerivativeOperator<OperatorValueType, ImageDimension> op;
+    op.SetDirection(0);
+    op.SetOrder(1);
+    op.SetOrderOfAccuracy(this->m_OrderOfAccuracy);
+    op.CreateDirectional();
+    op.FlipAxes();
+    if (this->m_UseImageSpacing)
+    {
+      if (this->GetInput()->GetSpacing()[i] == 0.0)
+      {
+        itkExceptionMacro(<< "Image spacing cannot be zero.");
+      }
+      op.ScaleCoefficients(1.0 / this->GetInput()->GetSpacing()[i]);
+    }
+    radius = static_cast<IndexValueType>(op.GetRadius()[0]);
+    for (unsigned int j = 0; j < op.Size(); ++j)
+    {
+      coefficients[i].push_back(static_cast<AccumulateType>(op[j]));
+    }
+  }
+  const unsigned int numberOfTaps = static_cast<unsigned int>(coefficients[0].size());
+
+  const InputImageRegionType  bufferedRegion = inputImage->GetBufferedRegion();
+  const InputPixelType *      inputBuffer = inputImage->GetBufferPointer();
+  const OffsetValueType *     inputOffsets = inputImage->GetOffsetTable();
+  const IndexValueType        length = static_cast<IndexValueType>(outputRegionForThread.GetSize(0));
+  std::vector<AccumulateType> sums(length);
+
+  // One row along the fastest axis at a time.
+  OutputImageRegionType rowStarts = outputRegionForThread;
+  rowStarts.SetSize(0, 1);
+  for (ImageRegionConstIteratorWithIndex<OutputImageType> rit(outputImage, rowStarts); !rit.IsAtEnd(); ++rit)
+  {
+    const typename OutputImageType::IndexType index = rit.GetIndex();
+    const InputPixelType *                    inputRow = inputBuffer + inputImage->ComputeOffset(index);
+    OutputPixelType * const                   outputRow =
+      outputImage->GetBufferPointer() + outputImage->ComputeOffset(index);
+
+    // Along the fastest axis, the taps are only clamped to the buffered
+    // region near its ends.
+    const IndexValueType first = bufferedRegion.GetIndex(0);
+    const IndexValueType last = first + static_cast<IndexValueType>(bufferedRegion.GetSize(0)) - 1;
+    for (IndexValueType k = 0; k < length; ++k)
+    {
+      const IndexValueType x = index[0] + k;
+      AccumulateType       sum = NumericTraits<AccumulateType>::ZeroValue();
+      if (x - radius >= first && x + radius <= last && reproducible)
+      {
+        sum = ReproducibleInnerProduct(coefficients[0].data(), inputRow + k - radius, numberOfTaps);
+      }
+      else if (x - radius >= first && x + radius <= last)
+      {
+        const InputPixelType * taps = inputRow + k - radius;
+        for (unsigned int j = 0; j < numberOfTaps; ++j)
+        {
+          sum += coefficients[0][j] * static_cast<AccumulateType>(taps[j]);
+        }
+      }
+      else
+      {
+        for (unsigned int j = 0; j < numberOfTaps; ++j)
+        {
+          const IndexValueType position = std::min(std::max(x + static_cast<IndexValueType>(j) - radius, first), last);
+          sum = multiplyAdd(coefficients[0][j], static_cast<AccumulateType>(inputRow[position - index[0]]), sum);
+        }
+      }
+      outputRow[k][0] = static_cast<OutputValueType>(sum);
+    }
+
+    // Along the other axes, every tap is a whole row, clamped as a whole.
+    for (unsigned int i = 1; i < ImageDimension; ++i)
+    {
+      const IndexValueType axisFirst = bufferedRegion.GetIndex(i);
+      const IndexValueType axisLast = axisFirst + static_cast<IndexValueType>(bufferedRegion.GetSize(i)) - 1;
+      std::fill(sums.begin(), sums.end(), NumericTraits<AccumulateType>::ZeroValue());
+      for (unsigned int j = 0; j < numberOfTaps; ++j)
+      {
+        const IndexValueType position =
+          std::min(std::max(index[i] + static_cast<IndexValueType>(j) - radius, axisFirst), axisLast);
+        const InputPixelType * tapRow = inputRow + (position - index[i]) * inputOffsets[i];
+        const AccumulateType   coefficient = coefficients[i][j];
+        if (reproducible)
+        {
+          ReproducibleAccumulateRow(coefficient, tapRow, sums.data(), length);
+        }
+        else
+        {
+          for (IndexValueType k = 0; k < length; ++k)
+          {
+            sums[k] += coefficient * static_cast<AccumulateType>(tapRow[k]);
+          }
+        }
+      }
+      for (IndexValueType k = 0; k < length; ++k)
+      {
+        outputRow[k][i] = static_cast<OutputValueType>(sums[k]);
+      }
+    }
+
+    if (this->m_UseImageDirection)
+    {
+      for (IndexValueType k = 0; k < length; ++k)
+      {
+        const OutputPixelType gradient = outputRow[k];
+        if (reproducible)
+        {
+          ReproducibleTransformLocalVectorToPhysicalVector(inputImage->GetDirection(), gradient, outputRow[k]);
+        }
+        else
+        {
+          inputImage->TransformLocalVectorToPhysicalVector(gradient, outputRow[k]);
+        }
+      }
+    }
+  }
+}
+
+
+// The reproducible sums must not be contracted into fused multiply-adds,
+// which only some processors have.  Clang honors the standard pragma within a
+// function body; GCC compiles the functions below with fp-contract=off, and
+// does not inline them into functions compiled with contraction.
+#if defined(__clang__)
+#  define itkHigherOrderAccurateNoContractMacro _Pragma("STDC FP_CONTRACT OFF")
+#else
+#  define itkHigherOrderAccurateNoContractMacro
+#endif
+#if defined(__GNUC__) && !defined(__clang__)
+#  pragma GCC push_options
+#  pragma GCC optimize("fp-contract=off")
+#endif
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  ReproducibleTransformLocalVectorToPhysicalVector(const typename InputImageType::DirectionType & direction,
+                                                   const OutputPixelType &                        localVector,
+                                                   OutputPixelType &                              physicalVector)
+{
+  itkHigherOrderAccurateNoContractMacro;
+  for (unsigned int row = 0; row < ImageDimension; ++row)
+  {
+    double sum = 0.0;
+    for (unsigned int col = 0; col < ImageDimension; ++col)
+    {
+      sum = sum + static_cast<double>(direction[row][col]) * static_cast<double>(localVector[col]);
+    }
+    physicalVector[row] = static_cast<OutputValueType>(sum);
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+template <typename TSum>
+TSum
+HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::ReproducibleMultiplyAdd(
+  TSum a,
+  TSum b,
+  TSum sum)
+{
+  itkHigherOrderAccurateNoContractMacro;
+  return sum + a * b;
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+template <typename TSum, typename TNeighborhoodIterator, typename TCoefficients>
+TSum
+HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::ReproducibleInnerProduct(
+  const std::slice &           slice,
+  const TNeighborhoodIterator & it,
+  const TCoefficients &         coefficients)
+{
+  itkHigherOrderAccurateNoContractMacro;
+  TSum sum = NumericTraits<TSum>::ZeroValue();
+  for (size_t j = 0; j < slice.size(); ++j)
+  {
+    sum = sum + static_cast<TSum>(coefficients[j]) * static_cast<TSum>(it.GetPixel(slice.start() + j * slice.stride()));
+  }
+  return sum;
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+template <typename TSum, typename TValue>
+TSum
+HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::ReproducibleInnerProduct(
+  const TSum *   coefficients,
+  const TValue * values,
+  unsigned int   numberOfTaps)
+{
+  itkHigherOrderAccurateNoContractMacro;
+  TSum sum = NumericTraits<TSum>::ZeroValue();
+  for (unsigned int j = 0; j < numberOfTaps; ++j)
+  {
+    sum = sum + coefficients[j] * static_cast<TSum>(values[j]);
+  }
+  return sum;
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+template <typename TSum, typename TValue>
+void
+HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::ReproducibleAccumulateRow(
+  TSum           coefficient,
+  const TValue * values,
+  TSum *         sums,
+  IndexValueType length)
+{
+  itkHigherOrderAccurateNoContractMacro;
+  for (IndexValueType k = 0; k < length; ++k)
+  {
+    sums[k] = sums[k] + coefficient * static_cast<TSum>(values[k]);
+  }
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#  pragma GCC pop_options
+#endif
+#undef itkHigherOrderAccurateNoContractMacro
+
+
 template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
 void
 HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::PrintSelf(
@@ -207,6 +1077,14 @@ HigherOrderAccurateGradientImageFilter<TInputImage, TOperatorValueType, TOutputV
   os << indent << "UseImageSpacing: " << (this->m_UseImageSpacing ? "On" : "Off") << std::endl;
   os << indent << "UseImageDirection = " << (this->m_UseImageDirection ? "On" : "Off") << std::endl;
   os << indent << "OrderOfAccuracy: " << this->m_OrderOfAccuracy << std::endl;
+  os << indent << "ComputeGradientVariance: " << (this->m_ComputeGradientVariance ? "On" : "Off") << std::endl;
+  os << indent << "NoiseSigma: " << this->m_NoiseSigma << std::endl;
+  itkPrintSelfObjectMacro(ResultCache);
+  os << indent << "ReuseStreamingHalo: " << (this->m_ReuseStreamingHalo ? "On" : "Off") << std::endl;
+  os << indent << "KernelVariant: " << this->m_KernelVariant << std::endl;
+  os << indent << "Tiling: " << this->m_Tiling << std::endl;
+  itkPrintSelfObjectMacro(Autotuner);
+  os << indent << "Reproducible: " << (this->m_Reproducible ? "On" : "Off") << std::endl;
 }
 
 } // end namespace itk
@@ -0,0 +1,163 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateGradientImageFunction_h
+#define itkHigherOrderAccurateGradientImageFunction_h
+
+#include "itkImageFunction.h"
+#include "itkCovariantVector.h"
+#include "itkHigherOrderAccurateDerivativeOperator.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class HigherOrderAccurateGradientImageFunction
+ *
+ * \brief Evaluate the higher order accurate gradient of an image at a point,
+ * without computing a gradient image.
+ *
+ * The gradient on the grid is computed with the
+ * HigherOrderAccurateDerivativeOperator, with taps outside of the buffer
+ * clamped to it.  At a continuous index, the grid gradients of the
+ * neighboring pixels are linearly interpolated, so the result matches a
+ * LinearInterpolateImageFunction applied to the output of
+ * HigherOrderAccurateGradientImageFilter.
+ *
+ * This function can be used as the gradient calculator of the
+ * ImageToImageMetricv4 metrics.
+ *
+ * \sa HigherOrderAccurateGradientImageFilter
+ * \sa CentralDifferenceImageFunction
+ *
+ * \ingroup ImageFunctions
+ * \ingroup HigherOrderAccurateGradient
+ */
+template <typename TInputImage,
+          typename TCoordRep = float,
+          typename TOutputType = CovariantVector<double, TInputImage::ImageDimension>>
+class HigherOrderAccurateGradientImageFunction : public ImageFunction<TInputImage, TOutputType, TCoordRep>
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(HigherOrderAccurateGradientImageFunction);
+
+  /** Dimension underlying input image. */
+  static constexpr unsigned int ImageDimension = TInputImage::ImageDimension;
+
+  /** Standard class type aliases. */
+  using Self = HigherOrderAccurateGradientImageFunction;
+  using Superclass = ImageFunction<TInputImage, TOutputType, TCoordRep>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(HigherOrderAccurateGradientImageFunction, ImageFunction);
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** InputImageType type alias support */
+  using InputImageType = TInputImage;
+
+  /** OutputType type alias support */
+  using OutputType = TOutputType;
+
+  /** Index type alias support */
+  using IndexType = typename Superclass::IndexType;
+
+  /** ContinuousIndex type alias support */
+  using ContinuousIndexType = typename Superclass::ContinuousIndexType;
+
+  /** Point type alias support */
+  using PointType = typename Superclass::PointType;
+
+  /** Set the input image.  The derivative coefficients are computed from its
+   * spacing. */
+  void
+  SetInputImage(const InputImageType * inputData) override;
+
+  /** Evaluate the image gradient at the specified index. */
+  OutputType
+  EvaluateAtIndex(const IndexType & index) const override;
+
+  /** Evaluate the image gradient at the specified physical point. */
+  OutputType
+  Evaluate(const PointType & point) const override;
+
+  /** Evaluate the image gradient at the specified continuous index. */
+  OutputType
+  EvaluateAtContinuousIndex(const ContinuousIndexType & cindex) const override;
+
+  /** Set/Get whether or not the function will use the spacing of the input
+      image in its calculations */
+  void
+  SetUseImageSpacing(bool useImageSpacing);
+  itkGetConstMacro(UseImageSpacing, bool);
+  itkBooleanMacro(UseImageSpacing);
+
+  /** The UseImageDirection flag determines whether image derivatives are
+   * computed with respect to the image grid or with respect to the physical
+   * space.  The default value of this flag is On. */
+  itkSetMacro(UseImageDirection, bool);
+  itkGetConstMacro(UseImageDirection, bool);
+  itkBooleanMacro(UseImageDirection);
+
+  /** Set/Get the order of accuracy of the derivative operator.  For more
+   * information, see HigherOrderAccurateDerivativeOperator. */
+  void
+  SetOrderOfAccuracy(unsigned int orderOfAccuracy);
+  itkGetConstMacro(OrderOfAccuracy, unsigned int);
+
+protected:
+  HigherOrderAccurateGradientImageFunction() = default;
+  ~HigherOrderAccurateGradientImageFunction() override = default;
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  using OperatorType = HigherOrderAccurateDerivativeOperator<double, ImageDimension>;
+
+  /** Build the scaled derivative coefficients for the current input. */
+  void
+  ComputeCoefficients();
+
+  /** Gradient with respect to the grid at a pixel of the buffer. */
+  void
+  ComputeGridGradient(const IndexType & index, double gradient[]) const;
+
+  /** Convert a grid gradient to the output type. */
+  OutputType
+  MakeOutput(const double gridGradient[]) const;
+
+  bool m_UseImageSpacing{ true };
+
+  bool m_UseImageDirection{ true };
+
+  unsigned int m_OrderOfAccuracy{ 2 };
+
+  /** Derivative coefficients along each axis, for the offsets -radius..radius. */
+  std::vector<double> m_Coefficients[ImageDimension];
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkHigherOrderAccurateGradientImageFunction.hxx"
+#endif
+
+#endif
@@ -0,0 +1,241 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateGradientImageFunction_hxx
+#define itkHigherOrderAccurateGradientImageFunction_hxx
+#include "itkHigherOrderAccurateGradientImageFunction.h"
+
+#include "itkHigherOrderAccurateDerivativeOperator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace itk
+{
+
+template <typename TInputImage, typename TCoordRep, typename TOutputType>
+void
+HigherOrderAccurateGradientImageFunction<TInputImage, TCoordRep, TOutputType>::SetInputImage(
+  const InputImageType * inputData)
+{
+  Superclass::SetInputImage(inputData);
+  this->ComputeCoefficients();
+}
+
+
+template <typename TInputImage, typename TCoordRep, typename TOutputType>
+void
+HigherOrderAccurateGradientImageFunction<TInputImage, TCoordRep, TOutputType>::SetUseImageSpacing(
+  bool useImageSpacing)
+{
+  if (useImageSpacing != this->m_UseImageSpacing)
+  {
+    this->m_UseImageSpacing = useImageSpacing;
+    this->ComputeCoefficients();
+    this->Modified();
+  }
+}
+
+
+template <typename TInputImage, typename TCoordRep, typename TOutputType>
+void
+HigherOrderAccurateGradientImageFunction<TInputImage, TCoordRep, TOutputType>::SetOrderOfAccuracy(
+  unsigned int orderOfAccuracy)
+{
+  if (orderOfAccuracy != this->m_OrderOfAccuracy)
+  {
+    this->m_OrderOfAccuracy = orderOfAccuracy;
+    this->ComputeCoefficients();
+    this->Modified();
+  }
+}
+
+
+template <typename TInputImage, typename TCoordRep, typename TOutputType>
+void
+HigherOrderAccurateGradientImageFunction<TInputImage, TCoordRep, TOutputType>::ComputeCoefficients()
+{
+  const InputImageType * inputImage = this->GetInputImage();
+  if (!inputImage)
+  {
+    return;
+  }
+
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    this->m_Coefficients[i] = OperatorType::ComputeSpacedCoefficients(
+      1, this->m_OrderOfAccuracy, this->m_UseImageSpacing ? inputImage->GetSpacing()[i] : 1.0);
+  }
+}
+
+
+template <typename TInputImage, typename TCoordRep, typename TOutputType>
+void
+HigherOrderAccurateGradientImageFunction<TInputImage, TCoordRep, TOutputType>::ComputeGridGradient(
+  const IndexType & index,
+  double            gradient[]) const
+{
+  const InputImageType *                      inputImage = this->GetInputImage();
+  const typename InputImageType::RegionType & bufferedRegion = inputImage->GetBufferedRegion();
+  const typename InputImageType::PixelType *  buffer = inputImage->GetBufferPointer();
+  const OffsetValueType *                     offsetTable = inputImage->GetOffsetTable();
+
+  const OffsetValueType pixelOffset = inputImage->ComputeOffset(index);
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    // Taps outside of the buffer are clamped to it, as with the
+    // ZeroFluxNeumannBoundaryCondition.
+    const IndexValueType first = bufferedRegion.GetIndex(i);
+    const IndexValueType last = first + static_cast<IndexValueType>(bufferedRegion.GetSize(i)) - 1;
+    double               sum = 0.0;
+    OperatorType::AccumulateClampedTaps(
+      this->m_Coefficients[i], index[i], first, last, [&](double weight, OffsetValueType shift) {
+        sum += weight * static_cast<double>(buffer[pixelOffset + shift * offsetTable[i]]);
+      });
+    gradient[i] = sum;
+  }
+}
+
+
+template <typename TInputImage, typename TCoordRep, typename TOutputType>
+auto
+HigherOrderAccurateGradientImageFunction<TInputImage, TCoordRep, TOutputType>::MakeOutput(
+  const double gridGradient[]) const -> OutputType
+{
+  CovariantVector<double, ImageDimension> gradient;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    gradient[i] = gridGradient[i];
+  }
+  if (this->m_UseImageDirection)
+  {
+    const CovariantVector<double, ImageDimension> localGradient = gradient;
+    this->GetInputImage()->TransformLocalVectorToPhysicalVector(localGradient, gradient);
+  }
+
+  OutputType output;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    output[i] = static_cast<typename OutputType::ValueType>(gradient[i]);
+  }
+  return output;
+}
+
+
+template <typename TInputImage, typename TCoordRep, typename TOutputType>
+auto
+HigherOrderAccurateGradientImageFunction<TInputImage, TCoordRep, TOutputType>::EvaluateAtIndex(
+  const IndexType & index) const -> OutputType
+{
+  // Indices outside of the buffer take the gradient of the closest pixel.
+  const typename InputImageType::RegionType & bufferedRegion = this->GetInputImage()->GetBufferedRegion();
+  IndexType                                   clampedIndex;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    const IndexValueType first = bufferedRegion.GetIndex(i);
+    const IndexValueType last = first + static_cast<IndexValueType>(bufferedRegion.GetSize(i)) - 1;
+    clampedIndex[i] = std::min(std::max(index[i], first), last);
+  }
+
+  double gridGradient[ImageDimension];
+  this->ComputeGridGradient(clampedIndex, gridGradient);
+  return this->MakeOutput(gridGradient);
+}
+
+
+template <typename TInputImage, typename TCoordRep, typename TOutputType>
+auto
+HigherOrderAccurateGradientImageFunction<TInputImage, TCoordRep, TOutputType>::Evaluate(const PointType & point) const
+  -> OutputType
+{
+  ContinuousIndexType cindex;
+  this->GetInputImage()->TransformPhysicalPointToContinuousIndex(point, cindex);
+  return this->EvaluateAtContinuousIndex(cindex);
+}
+
+
+template <typename TInputImage, typename TCoordRep, typename TOutputType>
+auto
+HigherOrderAccurateGradientImageFunction<TInputImage, TCoordRep, TOutputType>::EvaluateAtContinuousIndex(
+  const ContinuousIndexType & cindex) const -> OutputType
+{
+  const typename InputImageType::RegionType & bufferedRegion = this->GetInputImage()->GetBufferedRegion();
+
+  IndexType baseIndex;
+  IndexType lastIndex;
+  double    fraction[ImageDimension];
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    const IndexValueType first = bufferedRegion.GetIndex(i);
+    const IndexValueType last = first + static_cast<IndexValueType>(bufferedRegion.GetSize(i)) - 1;
+    const double         clamped = std::min(std::max(static_cast<double>(cindex[i]), static_cast<double>(first)),
+                                            static_cast<double>(last));
+    baseIndex[i] = static_cast<IndexValueType>(std::floor(clamped));
+    lastIndex[i] = std::min(baseIndex[i] + 1, last);
+    fraction[i] = clamped - static_cast<double>(baseIndex[i]);
+  }
+
+  // Linear interpolation of the grid gradients of the neighboring pixels.
+  double gradient[ImageDimension] = {};
+  double cornerGradient[ImageDimension];
+  for (unsigned int corner = 0; corner < (1u << ImageDimension); ++corner)
+  {
+    double    weight = 1.0;
+    IndexType cornerIndex;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      if (corner & (1u << i))
+      {
+        cornerIndex[i] = lastIndex[i];
+        weight *= fraction[i];
+      }
+      else
+      {
+        cornerIndex[i] = baseIndex[i];
+        weight *= 1.0 - fraction[i];
+      }
+    }
+    if (weight == 0.0)
+    {
+      continue;
+    }
+    this->ComputeGridGradient(cornerIndex, cornerGradient);
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      gradient[i] += weight * cornerGradient[i];
+    }
+  }
+
+  return this->MakeOutput(gradient);
+}
+
+
+template <typename TInputImage, typename TCoordRep, typename TOutputType>
+void
+HigherOrderAccurateGradientImageFunction<TInputImage, TCoordRep, TOutputType>::PrintSelf(std::ostream & os,
+                                                                                         Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "UseImageSpacing: " << (this->m_UseImageSpacing ? "On" : "Off") << std::endl;
+  os << indent << "UseImageDirection = " << (this->m_UseImageDirection ? "On" : "Off") << std::endl;
+  os << indent << "OrderOfAccuracy: " << this->m_OrderOfAccuracy << std::endl;
+}
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,255 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateGradientIntegrationImageFilter_h
+#define itkHigherOrderAccurateGradientIntegrationImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkHigherOrderAccurateDerivativeOperator.h"
+#include "itkHigherOrderAccurateLineDerivative.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class HigherOrderAccurateGradientIntegrationImageFilterEnums
+ *
+ * \brief Contains the enums used by HigherOrderAccurateGradientIntegrationImageFilter.
+ *
+ * \ingroup HigherOrderAccurateGradient
+ */
+class HigherOrderAccurateGradientIntegrationImageFilterEnums
+{
+public:
+  /** \class Solver
+   * \ingroup HigherOrderAccurateGradient
+   * Method used to solve the least squares problem. */
+  enum class Solver : uint8_t
+  {
+    Spectral,
+    ConjugateGradient
+  };
+};
+
+/** Define how to print enumerations */
+inline std::ostream &
+operator<<(std::ostream & out, const HigherOrderAccurateGradientIntegrationImageFilterEnums::Solver value)
+{
+  return out << [value] {
+    switch (value)
+    {
+      case HigherOrderAccurateGradientIntegrationImageFilterEnums::Solver::Spectral:
+        return "itk::HigherOrderAccurateGradientIntegrationImageFilterEnums::Solver::Spectral";
+      case HigherOrderAccurateGradientIntegrationImageFilterEnums::Solver::ConjugateGradient:
+        return "itk::HigherOrderAccurateGradientIntegrationImageFilterEnums::Solver::ConjugateGradient";
+      default:
+        return "INVALID VALUE FOR itk::HigherOrderAccurateGradientIntegrationImageFilterEnums::Solver";
+    }
+  }();
+}
+
+/** \class HigherOrderAccurateGradientIntegrationImageFilter
+ *
+ * \brief Recover the image whose higher order accurate gradient best matches
+ * a gradient field in the least squares sense.
+ *
+ * This is the inverse of HigherOrderAccurateGradientImageFilter.  The input is
+ * a field of CovariantVector, possibly edited, and the output is the image u
+ * minimizing \f$ \| G u - v \|^2 \f$, where G is the gradient computed with
+ * the HigherOrderAccurateDerivativeOperator of the same OrderOfAccuracy,
+ * UseImageSpacing and UseImageDirection.  The solution is defined up to a
+ * constant; the output has zero mean.
+ *
+ * Two solvers are available:
+ *
+ * - Spectral, the default, extends the field by mirror symmetry and solves
+ *   the normal equations with the fast Fourier transform.  The eigenvalues
+ *   are the squared symbols of the derivative operator, so the solution is
+ *   exact for the stencil.  The image is extended by half-sample symmetry,
+ *   which matches the zero flux Neumann boundary condition of the gradient
+ *   filter for an OrderOfAccuracy of 1.  For higher orders the mirrored taps
+ *   differ from the clamped ones within the operator radius of the border,
+ *   so the spectral solution is refined by conjugate gradients with the
+ *   clamped boundary condition; starting from it, few iterations are needed
+ *   and both solvers return the same image.  When the doubled image size is
+ *   not supported by the FFT implementation, the conjugate gradient solver is
+ *   used from zero instead.
+ * - ConjugateGradient solves the normal equations of the gradient with the
+ *   zero flux Neumann boundary condition of the gradient filter, by
+ *   conjugate gradients with multithreaded applications of the stencil and
+ *   of its exact adjoint.
+ *
+ * Multigrid is not used: the wide central stencil does not couple the odd
+ * and even pixels, so the usual smoothers do not reduce the high frequency
+ * error.
+ *
+ * \sa HigherOrderAccurateGradientImageFilter
+ *
+ * \ingroup HigherOrderAccurateGradient
+ */
+template <typename TInputImage, typename TOperatorValueType = float, typename TOutputValueType = float>
+class HigherOrderAccurateGradientIntegrationImageFilter
+  : public ImageToImageFilter<TInputImage, Image<TOutputValueType, TInputImage::ImageDimension>>
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(HigherOrderAccurateGradientIntegrationImageFilter);
+
+  /** Extract dimension from input image. */
+  static constexpr unsigned int ImageDimension = TInputImage::ImageDimension;
+
+  /** Standard class type alias. */
+  using Self = HigherOrderAccurateGradientIntegrationImageFilter;
+
+  /** Convenient type alias for simplifying declarations. */
+  using InputImageType = TInputImage;
+  using InputImagePointer = typename InputImageType::Pointer;
+  using OutputImageType = Image<TOutputValueType, ImageDimension>;
+  using OutputImagePointer = typename OutputImageType::Pointer;
+
+  /** Standard class type alias. */
+  using Superclass = ImageToImageFilter<InputImageType, OutputImageType>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(HigherOrderAccurateGradientIntegrationImageFilter, ImageToImageFilter);
+
+  /** Image type alias support. */
+  using InputPixelType = typename InputImageType::PixelType;
+  using OperatorValueType = TOperatorValueType;
+  using OutputValueType = TOutputValueType;
+  using OutputImageRegionType = typename OutputImageType::RegionType;
+
+  using SolverEnum = HigherOrderAccurateGradientIntegrationImageFilterEnums::Solver;
+
+  /** Set/Get whether or not the gradient was computed with the spacing of the
+   * image. */
+  itkSetMacro(UseImageSpacing, bool);
+  itkGetConstMacro(UseImageSpacing, bool);
+  itkBooleanMacro(UseImageSpacing);
+
+  /** Set/Get whether the gradient is with respect to the physical coordinate
+   * system (On) or the image grid (Off).  The default value of this flag is
+   * On, as for HigherOrderAccurateGradientImageFilter. */
+  itkSetMacro(UseImageDirection, bool);
+  itkGetConstMacro(UseImageDirection, bool);
+  itkBooleanMacro(UseImageDirection);
+
+  /** Set/Get the order of accuracy of the derivative operator.  For more
+   * information, see HigherOrderAccurateDerivativeOperator. */
+  itkSetMacro(OrderOfAccuracy, unsigned int);
+  itkGetConstMacro(OrderOfAccuracy, unsigned int);
+
+  /** Set/Get the solver.  Defaults to Spectral. */
+  itkSetEnumMacro(Solver, SolverEnum);
+  itkGetEnumMacro(Solver, SolverEnum);
+
+  /** Set/Get the maximum number of conjugate gradient iterations.  Defaults
+   * to 1000. */
+  itkSetMacro(MaximumNumberOfIterations, unsigned int);
+  itkGetConstMacro(MaximumNumberOfIterations, unsigned int);
+
+  /** Set/Get the relative residual at which the conjugate gradient iterations
+   * stop.  Defaults to 1e-8. */
+  itkSetMacro(Tolerance, double);
+  itkGetConstMacro(Tolerance, double);
+
+  /** Get the number of conjugate gradient iterations of the last update,
+   * zero when the spectral solver was used. */
+  itkGetConstMacro(ElapsedIterations, unsigned int);
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  /** Begin concept checking */
+  itkConceptMacro(InputConvertibleToDoubleCheck,
+                  (Concept::Convertible<typename InputPixelType::ValueType, double>));
+  itkConceptMacro(OutputHasNumericTraitsCheck, (Concept::HasNumericTraits<OutputValueType>));
+  /** End concept checking */
+#endif
+
+protected:
+  HigherOrderAccurateGradientIntegrationImageFilter() = default;
+  ~HigherOrderAccurateGradientIntegrationImageFilter() override = default;
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** Every pixel of the output depends on the whole input, so the whole
+   * input is requested.
+   *
+   * \sa ImageToImageFilter::GenerateInputRequestedRegion() */
+  void
+  GenerateInputRequestedRegion() override;
+
+  /** The whole output is produced. */
+  void
+  EnlargeOutputRequestedRegion(DataObject * output) override;
+
+  void
+  GenerateData() override;
+
+private:
+  using IndexType = typename InputImageType::IndexType;
+  using RegionType = typename InputImageType::RegionType;
+  using OperatorType = HigherOrderAccurateDerivativeOperator<OperatorValueType, ImageDimension>;
+  using RealImageType = Image<double, ImageDimension>;
+
+  /** Solve with the fast Fourier transform of the mirrored field.  Returns
+   * false when the size is not supported by the FFT implementation. */
+  bool
+  SolveSpectral(const std::vector<double> * gridGradient, std::vector<double> & solution);
+
+  /** Solve the normal equations with conjugate gradients, starting from
+   * solution when it has the size of the image and from zero otherwise. */
+  void
+  SolveConjugateGradient(const std::vector<double> * gridGradient, std::vector<double> & solution);
+
+  /** Compute the gradient of field, laid out as the input buffer. */
+  void
+  ApplyGradient(const double * field, std::vector<double> * gradient);
+
+  /** Compute the adjoint of the gradient applied to the components. */
+  void
+  ApplyAdjoint(const std::vector<double> * components, double * result);
+
+  bool m_UseImageSpacing{ true };
+
+  bool m_UseImageDirection{ true };
+
+  unsigned int m_OrderOfAccuracy{ 2 };
+
+  SolverEnum m_Solver{ SolverEnum::Spectral };
+
+  unsigned int m_MaximumNumberOfIterations{ 1000 };
+
+  double m_Tolerance{ 1e-8 };
+
+  unsigned int m_ElapsedIterations{ 0 };
+
+  /** Derivative along each axis, and its adjoint, on the input buffer. */
+  HigherOrderAccurateLineDerivative<ImageDimension> m_LineDerivative;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkHigherOrderAccurateGradientIntegrationImageFilter.hxx"
+#endif
+
+#endif
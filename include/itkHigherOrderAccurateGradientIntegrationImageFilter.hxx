@@ -0,0 +1,461 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateGradientIntegrationImageFilter_hxx
+#define itkHigherOrderAccurateGradientIntegrationImageFilter_hxx
+#include "itkHigherOrderAccurateGradientIntegrationImageFilter.h"
+
+#include "itkForwardFFTImageFilter.h"
+#include "itkInverseFFTImageFilter.h"
+#include "itkImageRegionConstIteratorWithOnlyIndex.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkHigherOrderAccurateDerivativeOperator.h"
+#include "itkMath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <numeric>
+
+namespace itk
+{
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateGradientIntegrationImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  GenerateInputRequestedRegion()
+{
+  // call the superclass' implementation of this method
+  Superclass::GenerateInputRequestedRegion();
+
+  InputImagePointer inputPtr = const_cast<InputImageType *>(this->GetInput());
+  if (inputPtr)
+  {
+    inputPtr->SetRequestedRegionToLargestPossibleRegion();
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateGradientIntegrationImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  EnlargeOutputRequestedRegion(DataObject * output)
+{
+  Superclass::EnlargeOutputRequestedRegion(output);
+  output->SetRequestedRegionToLargestPossibleRegion();
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateGradientIntegrationImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::GenerateData()
+{
+  this->AllocateOutputs();
+
+  const InputImageType * input = this->GetInput();
+  OutputImageType *      output = this->GetOutput();
+  const RegionType       region = input->GetBufferedRegion();
+
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    this->m_LineDerivative.SetCoefficients(
+      i,
+      OperatorType::ComputeSpacedCoefficients(
+        1, this->m_OrderOfAccuracy, this->m_UseImageSpacing ? input->GetSpacing()[i] : 1.0));
+  }
+  this->m_LineDerivative.SetBufferedRegion(region);
+
+  // Bring the vectors back to the image grid, one array per component laid
+  // out as the input buffer.
+  const typename InputImageType::InverseDirectionType & inverseDirection = input->GetInverseDirection();
+
+  const SizeValueType    numberOfPixels = region.GetNumberOfPixels();
+  const InputPixelType * inputBuffer = input->GetBufferPointer();
+  std::vector<double>    gridGradient[ImageDimension];
+  for (auto & component : gridGradient)
+  {
+    component.resize(numberOfPixels);
+  }
+  for (SizeValueType n = 0; n < numberOfPixels; ++n)
+  {
+    const InputPixelType & pixel = inputBuffer[n];
+    for (unsigned int k = 0; k < ImageDimension; ++k)
+    {
+      if (this->m_UseImageDirection)
+      {
+        double local = 0.0;
+        for (unsigned int i = 0; i < ImageDimension; ++i)
+        {
+          local += inverseDirection[k][i] * static_cast<double>(pixel[i]);
+        }
+        gridGradient[k][n] = local;
+      }
+      else
+      {
+        gridGradient[k][n] = static_cast<double>(pixel[k]);
+      }
+    }
+  }
+
+  this->GetMultiThreader()->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+
+  this->m_ElapsedIterations = 0;
+  std::vector<double> solution;
+  const bool solvedSpectrally = this->m_Solver == SolverEnum::Spectral && this->SolveSpectral(gridGradient, solution);
+  if (!solvedSpectrally || this->m_OrderOfAccuracy > 1)
+  {
+    // The mirror extension only matches the clamped stencil for an
+    // OrderOfAccuracy of 1; otherwise the spectral solution is the starting
+    // point of the conjugate gradients.
+    this->SolveConjugateGradient(gridGradient, solution);
+  }
+
+  OutputValueType * outputBuffer = output->GetBufferPointer();
+  for (SizeValueType n = 0; n < numberOfPixels; ++n)
+  {
+    outputBuffer[n] = static_cast<OutputValueType>(solution[n]);
+  }
+  this->UpdateProgress(1.0f);
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+bool
+HigherOrderAccurateGradientIntegrationImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::SolveSpectral(
+  const std::vector<double> * gridGradient,
+  std::vector<double> &       solution)
+{
+  using ComplexImageType = Image<std::complex<double>, ImageDimension>;
+  using ForwardFFTType = ForwardFFTImageFilter<RealImageType, ComplexImageType>;
+  using InverseFFTType = InverseFFTImageFilter<ComplexImageType, RealImageType>;
+
+  const InputImageType * input = this->GetInput();
+  const RegionType       region = input->GetBufferedRegion();
+
+  typename ForwardFFTType::Pointer forward = ForwardFFTType::New();
+  forward->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+
+  // The mirrored field has twice the size of the image along every axis.
+  typename RealImageType::SizeType extendedSize;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    extendedSize[i] = 2 * region.GetSize(i);
+
+    SizeValueType remainder = extendedSize[i];
+    SizeValueType greatestFactor = 1;
+    for (SizeValueType factor = 2; factor * factor <= remainder; ++factor)
+    {
+      while (remainder % factor == 0)
+      {
+        greatestFactor = factor;
+        remainder /= factor;
+      }
+    }
+    greatestFactor = std::max(greatestFactor, remainder);
+    if (greatestFactor > forward->GetSizeGreatestPrimeFactor())
+    {
+      itkDebugMacro(<< "Size " << extendedSize[i] << " is not supported by the FFT, using conjugate gradients.");
+      return false;
+    }
+  }
+
+  // Symbol of the derivative operator along each axis: the Fourier transform
+  // of the antisymmetric stencil is i times the sum of its coefficients
+  // weighted by the sines of the frequency times their offsets.
+  std::vector<double> symbols[ImageDimension];
+  double              largestDenominator = 0.0;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    const auto     radius = static_cast<OffsetValueType>(this->m_LineDerivative.GetCoefficients(i).size() / 2);
+    const double * coefficients = this->m_LineDerivative.GetCoefficients(i).data();
+    symbols[i].resize(extendedSize[i]);
+    for (SizeValueType k = 0; k < extendedSize[i]; ++k)
+    {
+      const double theta = 2.0 * Math::pi * static_cast<double>(k) / static_cast<double>(extendedSize[i]);
+      double       symbol = 0.0;
+      for (OffsetValueType j = -radius; j <= radius; ++j)
+      {
+        symbol += coefficients[j + radius] * std::sin(static_cast<double>(j) * theta);
+      }
+      symbols[i][k] = symbol;
+    }
+    double largestSquare = 0.0;
+    for (const double symbol : symbols[i])
+    {
+      largestSquare = std::max(largestSquare, symbol * symbol);
+    }
+    largestDenominator += largestSquare;
+  }
+
+  // Extend each component with half-sample symmetry, odd along its own axis
+  // and even along the others, so that the extension is the gradient of the
+  // even extension of the image.  Accumulate the transforms weighted by the
+  // symbols.
+  typename RealImageType::Pointer extended = RealImageType::New();
+  extended->SetRegions(extendedSize);
+  extended->Allocate();
+
+  typename ComplexImageType::Pointer accumulated;
+  for (unsigned int d = 0; d < ImageDimension; ++d)
+  {
+    for (ImageRegionIteratorWithIndex<RealImageType> it(extended, extended->GetLargestPossibleRegion()); !it.IsAtEnd();
+         ++it)
+    {
+      IndexType index = region.GetIndex();
+      double    sign = 1.0;
+      for (unsigned int i = 0; i < ImageDimension; ++i)
+      {
+        const auto length = static_cast<OffsetValueType>(region.GetSize(i));
+        auto       position = it.GetIndex()[i];
+        if (position >= length)
+        {
+          position = 2 * length - 1 - position;
+          if (i == d)
+          {
+            sign = -sign;
+          }
+        }
+        index[i] += position;
+      }
+      it.Set(sign * gridGradient[d][input->ComputeOffset(index)]);
+    }
+    extended->Modified();
+
+    forward->SetInput(extended);
+    forward->Update();
+    typename ComplexImageType::Pointer transformed = forward->GetOutput();
+    transformed->DisconnectPipeline();
+
+    if (d == 0)
+    {
+      accumulated = transformed;
+    }
+    ImageRegionIteratorWithIndex<ComplexImageType> accumulatedIt(accumulated, accumulated->GetLargestPossibleRegion());
+    ImageRegionIteratorWithIndex<ComplexImageType> transformedIt(transformed, transformed->GetLargestPossibleRegion());
+    for (; !accumulatedIt.IsAtEnd(); ++accumulatedIt, ++transformedIt)
+    {
+      const std::complex<double> term = symbols[d][accumulatedIt.GetIndex()[d]] * transformedIt.Get();
+      accumulatedIt.Set(d == 0 ? term : accumulatedIt.Get() + term);
+    }
+  }
+
+  // Divide by the eigenvalues of the normal equations.  The constant mode,
+  // and the modes the operator does not see, are set to zero.
+  const double threshold = 1e-12 * largestDenominator;
+  for (ImageRegionIteratorWithIndex<ComplexImageType> it(accumulated, accumulated->GetLargestPossibleRegion());
+       !it.IsAtEnd(); ++it)
+  {
+    double denominator = 0.0;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      const double symbol = symbols[i][it.GetIndex()[i]];
+      denominator += symbol * symbol;
+    }
+    if (denominator <= threshold)
+    {
+      it.Set(std::complex<double>(0.0, 0.0));
+    }
+    else
+    {
+      it.Set(std::complex<double>(0.0, -1.0) * it.Get() / denominator);
+    }
+  }
+
+  typename InverseFFTType::Pointer inverse = InverseFFTType::New();
+  inverse->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+  inverse->SetInput(accumulated);
+  inverse->Update();
+  const RealImageType * reconstructed = inverse->GetOutput();
+
+  solution.resize(region.GetNumberOfPixels());
+  RegionType cropRegion = region;
+  cropRegion.SetIndex(IndexType{ { 0 } });
+  for (ImageRegionConstIteratorWithOnlyIndex<RealImageType> it(reconstructed, cropRegion); !it.IsAtEnd(); ++it)
+  {
+    IndexType index = region.GetIndex();
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      index[i] += it.GetIndex()[i];
+    }
+    solution[input->ComputeOffset(index)] = reconstructed->GetPixel(it.GetIndex());
+  }
+  return true;
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateGradientIntegrationImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  SolveConjugateGradient(const std::vector<double> * gridGradient, std::vector<double> & solution)
+{
+  const SizeValueType numberOfPixels = this->GetInput()->GetBufferedRegion().GetNumberOfPixels();
+  const auto          dot = [](const std::vector<double> & a, const std::vector<double> & b) {
+    return std::inner_product(a.begin(), a.end(), b.begin(), 0.0);
+  };
+
+  // The right hand side of the normal equations sums to zero, since the
+  // gradient of a constant is zero, so the iterates keep a zero mean.
+  std::vector<double> residual(numberOfPixels);
+  this->ApplyAdjoint(gridGradient, residual.data());
+  const double stoppingNorm = this->m_Tolerance * this->m_Tolerance * dot(residual, residual);
+
+  std::vector<double> product(numberOfPixels);
+  std::vector<double> gradient[ImageDimension];
+  for (auto & component : gradient)
+  {
+    component.resize(numberOfPixels);
+  }
+
+  if (solution.size() == numberOfPixels)
+  {
+    // Start from the given solution, the tolerance stays relative to the
+    // right hand side.
+    this->ApplyGradient(solution.data(), gradient);
+    this->ApplyAdjoint(gradient, product.data());
+    for (SizeValueType n = 0; n < numberOfPixels; ++n)
+    {
+      residual[n] -= product[n];
+    }
+  }
+  else
+  {
+    solution.assign(numberOfPixels, 0.0);
+  }
+
+  std::vector<double> searchDirection = residual;
+  double              residualNorm = dot(residual, residual);
+  while (this->m_ElapsedIterations < this->m_MaximumNumberOfIterations && residualNorm > stoppingNorm)
+  {
+    this->ApplyGradient(searchDirection.data(), gradient);
+    this->ApplyAdjoint(gradient, product.data());
+    const double curvature = dot(searchDirection, product);
+    if (curvature <= 0.0)
+    {
+      break;
+    }
+
+    const double stepLength = residualNorm / curvature;
+    for (SizeValueType n = 0; n < numberOfPixels; ++n)
+    {
+      solution[n] += stepLength * searchDirection[n];
+      residual[n] -= stepLength * product[n];
+    }
+
+    const double nextResidualNorm = dot(residual, residual);
+    const double beta = nextResidualNorm / residualNorm;
+    for (SizeValueType n = 0; n < numberOfPixels; ++n)
+    {
+      searchDirection[n] = residual[n] + beta * searchDirection[n];
+    }
+    residualNorm = nextResidualNorm;
+
+    ++this->m_ElapsedIterations;
+    this->UpdateProgress(static_cast<float>(this->m_ElapsedIterations) / this->m_MaximumNumberOfIterations);
+  }
+
+  // Remove the round-off drift of the mean.
+  const double mean = std::accumulate(solution.begin(), solution.end(), 0.0) / static_cast<double>(numberOfPixels);
+  for (double & value : solution)
+  {
+    value -= mean;
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateGradientIntegrationImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::ApplyGradient(
+  const double *        field,
+  std::vector<double> * gradient)
+{
+  const InputImageType * input = this->GetInput();
+
+  this->GetMultiThreader()->template ParallelizeImageRegion<ImageDimension>(
+    input->GetBufferedRegion(),
+    [this, input, field, gradient](const RegionType & piece) {
+      const SizeValueType lineLength = piece.GetSize(0);
+
+      RegionType lineStartRegion = piece;
+      lineStartRegion.SetSize(0, 1);
+      for (ImageRegionConstIteratorWithOnlyIndex<InputImageType> lineIt(input, lineStartRegion); !lineIt.IsAtEnd();
+           ++lineIt)
+      {
+        const IndexType lineStart = lineIt.GetIndex();
+        const auto      lineOffset = static_cast<SizeValueType>(input->ComputeOffset(lineStart));
+        for (unsigned int i = 0; i < ImageDimension; ++i)
+        {
+          double * line = gradient[i].data() + lineOffset;
+          std::fill(line, line + lineLength, 0.0);
+          this->m_LineDerivative.AccumulateDerivative(field, i, lineStart, lineLength, line);
+        }
+      }
+    },
+    nullptr);
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateGradientIntegrationImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::ApplyAdjoint(
+  const std::vector<double> * components,
+  double *                    result)
+{
+  const InputImageType * input = this->GetInput();
+
+  this->GetMultiThreader()->template ParallelizeImageRegion<ImageDimension>(
+    input->GetBufferedRegion(),
+    [this, input, components, result](const RegionType & piece) {
+      const SizeValueType lineLength = piece.GetSize(0);
+
+      RegionType lineStartRegion = piece;
+      lineStartRegion.SetSize(0, 1);
+      for (ImageRegionConstIteratorWithOnlyIndex<InputImageType> lineIt(input, lineStartRegion); !lineIt.IsAtEnd();
+           ++lineIt)
+      {
+        const IndexType lineStart = lineIt.GetIndex();
+        double *        line = result + input->ComputeOffset(lineStart);
+        std::fill(line, line + lineLength, 0.0);
+        for (unsigned int i = 0; i < ImageDimension; ++i)
+        {
+          this->m_LineDerivative.AccumulateAdjoint(components[i].data(), i, lineStart, lineLength, line);
+        }
+      }
+    },
+    nullptr);
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateGradientIntegrationImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::PrintSelf(
+  std::ostream & os,
+  Indent         indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "UseImageSpacing: " << (this->m_UseImageSpacing ? "On" : "Off") << std::endl;
+  os << indent << "UseImageDirection: " << (this->m_UseImageDirection ? "On" : "Off") << std::endl;
+  os << indent << "OrderOfAccuracy: " << this->m_OrderOfAccuracy << std::endl;
+  os << indent << "Solver: " << this->m_Solver << std::endl;
+  os << indent << "MaximumNumberOfIterations: " << this->m_MaximumNumberOfIterations << std::endl;
+  os << indent << "Tolerance: " << this->m_Tolerance << std::endl;
+  os << indent << "ElapsedIterations: " << this->m_ElapsedIterations << std::endl;
+}
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,206 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateLineDerivative_h
+#define itkHigherOrderAccurateLineDerivative_h
+
+#include "itkImageRegion.h"
+#include "itkHigherOrderAccurateDerivativeOperator.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace itk
+{
+
+/** \class HigherOrderAccurateLineDerivative
+ *
+ * \brief Derivatives along an axis, and their adjoints, of fields laid out as
+ * an image buffer, one scanline at a time.
+ *
+ * The coefficients of each axis weight the pixels at the offsets
+ * -radius..radius.  Taps that fall outside of the buffered region are clamped
+ * to it, the zero flux Neumann boundary condition, and the adjoint is the
+ * exact transpose of the clamped operator, border included.  Both accumulate
+ * into a scanline of doubles, so the derivatives along several axes, or the
+ * adjoints of several components, can be summed in place.
+ *
+ * \sa HigherOrderAccurateDerivativeOperator
+ *
+ * \ingroup HigherOrderAccurateGradient
+ */
+template <unsigned int VDimension>
+class HigherOrderAccurateLineDerivative
+{
+public:
+  static constexpr unsigned int Dimension = VDimension;
+
+  using IndexType = Index<VDimension>;
+  using RegionType = ImageRegion<VDimension>;
+  using CoefficientsType = std::vector<double>;
+  using OperatorType = HigherOrderAccurateDerivativeOperator<double, VDimension>;
+
+  /** Set the region the fields are buffered over, contiguously, axis 0
+   * fastest. */
+  void
+  SetBufferedRegion(const RegionType & region)
+  {
+    m_BufferedRegion = region;
+    OffsetValueType stride = 1;
+    for (unsigned int i = 0; i < VDimension; ++i)
+    {
+      m_Strides[i] = stride;
+      stride *= static_cast<OffsetValueType>(region.GetSize(i));
+    }
+  }
+
+  const RegionType &
+  GetBufferedRegion() const
+  {
+    return m_BufferedRegion;
+  }
+
+  /** Set the coefficients along axis, for the offsets -radius..radius. */
+  void
+  SetCoefficients(unsigned int axis, const CoefficientsType & coefficients)
+  {
+    m_Coefficients[axis] = coefficients;
+  }
+
+  const CoefficientsType &
+  GetCoefficients(unsigned int axis) const
+  {
+    return m_Coefficients[axis];
+  }
+
+  /** Add the derivative along axis of field to the scanline of lineLength
+   * pixels starting at lineStart. */
+  template <typename TValue>
+  void
+  AccumulateDerivative(const TValue *    field,
+                       unsigned int      axis,
+                       const IndexType & lineStart,
+                       SizeValueType     lineLength,
+                       double *          accumulator) const
+  {
+    const OffsetValueType stride = m_Strides[axis];
+    const auto            radius = static_cast<OffsetValueType>(m_Coefficients[axis].size() / 2);
+    const double *        coefficients = m_Coefficients[axis].data();
+    const OffsetValueType first = m_BufferedRegion.GetIndex(axis);
+    const OffsetValueType last = first + static_cast<OffsetValueType>(m_BufferedRegion.GetSize(axis)) - 1;
+    const OffsetValueType lineLast = lineStart[axis] + (axis == 0 ? static_cast<OffsetValueType>(lineLength) - 1 : 0);
+    const TValue *        center = field + this->ComputeOffset(lineStart);
+
+    if (lineStart[axis] - radius >= first && lineLast + radius <= last)
+    {
+      for (OffsetValueType k = -radius; k <= radius; ++k)
+      {
+        const double   weight = coefficients[k + radius];
+        const TValue * tap = center + k * stride;
+        for (SizeValueType x = 0; x < lineLength; ++x)
+        {
+          accumulator[x] += weight * static_cast<double>(tap[x]);
+        }
+      }
+      return;
+    }
+
+    for (SizeValueType x = 0; x < lineLength; ++x)
+    {
+      const OffsetValueType position = lineStart[axis] + (axis == 0 ? static_cast<OffsetValueType>(x) : 0);
+      OperatorType::AccumulateClampedTaps(
+        m_Coefficients[axis], position, first, last, [&](double weight, OffsetValueType shift) {
+          accumulator[x] += weight * static_cast<double>(center[static_cast<OffsetValueType>(x) + shift * stride]);
+        });
+    }
+  }
+
+  /** Add the adjoint of the derivative along axis of field to the scanline
+   * of lineLength pixels starting at lineStart. */
+  template <typename TValue>
+  void
+  AccumulateAdjoint(const TValue *    field,
+                    unsigned int      axis,
+                    const IndexType & lineStart,
+                    SizeValueType     lineLength,
+                    double *          accumulator) const
+  {
+    const OffsetValueType stride = m_Strides[axis];
+    const auto            radius = static_cast<OffsetValueType>(m_Coefficients[axis].size() / 2);
+    const double *        coefficients = m_Coefficients[axis].data();
+    const OffsetValueType first = m_BufferedRegion.GetIndex(axis);
+    const OffsetValueType last = first + static_cast<OffsetValueType>(m_BufferedRegion.GetSize(axis)) - 1;
+    const OffsetValueType lineLast = lineStart[axis] + (axis == 0 ? static_cast<OffsetValueType>(lineLength) - 1 : 0);
+    const TValue *        center = field + this->ComputeOffset(lineStart);
+
+    // Away from the border, the pixel at offset -k is the only one whose tap k
+    // lands on the current pixel.
+    if (lineStart[axis] - radius >= first && lineLast + radius <= last)
+    {
+      for (OffsetValueType k = -radius; k <= radius; ++k)
+      {
+        const double   weight = coefficients[k + radius];
+        const TValue * tap = center - k * stride;
+        for (SizeValueType x = 0; x < lineLength; ++x)
+        {
+          accumulator[x] += weight * static_cast<double>(tap[x]);
+        }
+      }
+      return;
+    }
+
+    // Near the border, gather the clamped taps of every pixel within the
+    // radius that land on the current pixel.
+    for (SizeValueType x = 0; x < lineLength; ++x)
+    {
+      const OffsetValueType position = lineStart[axis] + (axis == 0 ? static_cast<OffsetValueType>(x) : 0);
+      const OffsetValueType lowest = std::max(position - radius, first);
+      const OffsetValueType highest = std::min(position + radius, last);
+      for (OffsetValueType source = lowest; source <= highest; ++source)
+      {
+        const auto value = static_cast<double>(center[static_cast<OffsetValueType>(x) + (source - position) * stride]);
+        for (OffsetValueType k = -radius; k <= radius; ++k)
+        {
+          if (std::min(std::max(source + k, first), last) == position)
+          {
+            accumulator[x] += coefficients[k + radius] * value;
+          }
+        }
+      }
+    }
+  }
+
+private:
+  OffsetValueType
+  ComputeOffset(const IndexType & index) const
+  {
+    OffsetValueType offset = 0;
+    for (unsigned int i = 0; i < VDimension; ++i)
+    {
+      offset += (index[i] - m_BufferedRegion.GetIndex(i)) * m_Strides[i];
+    }
+    return offset;
+  }
+
+  RegionType       m_BufferedRegion;
+  OffsetValueType  m_Strides[VDimension]{};
+  CoefficientsType m_Coefficients[VDimension];
+};
+
+} // end namespace itk
+
+#endif
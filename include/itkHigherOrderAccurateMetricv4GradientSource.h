@@ -0,0 +1,140 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateMetricv4GradientSource_h
+#define itkHigherOrderAccurateMetricv4GradientSource_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkHigherOrderAccurateGradientImageFilter.h"
+#include "itkHigherOrderAccurateGradientImageFunction.h"
+
+namespace itk
+{
+
+/** \class HigherOrderAccurateMetricv4GradientSource
+ *
+ * \brief Make an ImageToImageMetricv4 use higher order accurate image
+ * gradients.
+ *
+ * ConfigureMetric() replaces both the gradient filter and the gradient
+ * calculator of the metric for the fixed and the moving image:
+ *
+ * - HigherOrderAccurateGradientImageFilter precomputes a gradient image that
+ *   the metric interpolates.
+ * - HigherOrderAccurateGradientImageFunction evaluates the gradient on the
+ *   fly at every sample, without storing a gradient image.
+ *
+ * Both give the same gradients.  The metric precomputes a gradient image when
+ * it fits in what remains of the MemoryBudget, in bytes, and evaluates on the
+ * fly otherwise.  The moving image, which every gradient-based metric uses,
+ * is considered before the fixed image.  Images that are not part of the
+ * metric GradientSource do not consume any budget.
+ *
+ * The fixed and moving images must be set on the metric before it is
+ * configured.  For multi-resolution registration, configure the metric
+ * with the images of the finest level, or again before every level.
+ *
+ * \sa ImageToImageMetricv4
+ *
+ * \ingroup HigherOrderAccurateGradient
+ */
+template <typename TMetric>
+class HigherOrderAccurateMetricv4GradientSource : public Object
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(HigherOrderAccurateMetricv4GradientSource);
+
+  /** Standard class type aliases. */
+  using Self = HigherOrderAccurateMetricv4GradientSource;
+  using Superclass = Object;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(HigherOrderAccurateMetricv4GradientSource, Object);
+
+  /** Metric type alias support. */
+  using MetricType = TMetric;
+  using FixedImageType = typename MetricType::FixedImageType;
+  using MovingImageType = typename MetricType::MovingImageType;
+  using FixedImageGradientType = typename MetricType::FixedImageGradientType;
+  using MovingImageGradientType = typename MetricType::MovingImageGradientType;
+
+  /** Gradient sources installed in the metric. */
+  using FixedImageGradientFilterType = HigherOrderAccurateGradientImageFilter<FixedImageType,
+                                                                              typename FixedImageGradientType::ValueType,
+                                                                              typename FixedImageGradientType::ValueType>;
+  using MovingImageGradientFilterType =
+    HigherOrderAccurateGradientImageFilter<MovingImageType,
+                                           typename MovingImageGradientType::ValueType,
+                                           typename MovingImageGradientType::ValueType>;
+  using FixedImageGradientCalculatorType =
+    HigherOrderAccurateGradientImageFunction<FixedImageType,
+                                             typename MetricType::FixedImageGradientCalculatorType::CoordRepType,
+                                             FixedImageGradientType>;
+  using MovingImageGradientCalculatorType =
+    HigherOrderAccurateGradientImageFunction<MovingImageType,
+                                             typename MetricType::MovingImageGradientCalculatorType::CoordRepType,
+                                             MovingImageGradientType>;
+
+  /** Set/Get the order of accuracy of the derivative operator.  For more
+   * information, see HigherOrderAccurateDerivativeOperator. */
+  itkSetMacro(OrderOfAccuracy, unsigned int);
+  itkGetConstMacro(OrderOfAccuracy, unsigned int);
+
+  /** Set/Get the number of bytes that precomputed gradient images may use.
+   * Defaults to no limit. */
+  itkSetMacro(MemoryBudget, SizeValueType);
+  itkGetConstMacro(MemoryBudget, SizeValueType);
+
+  /** Install the higher order accurate gradient sources in the metric and
+   * select precomputed or on the fly gradients. */
+  void
+  ConfigureMetric(MetricType * metric);
+
+  /** Whether the last configured metric precomputes the fixed and the
+   * moving image gradient. */
+  itkGetConstMacro(PrecomputeFixedImageGradient, bool);
+  itkGetConstMacro(PrecomputeMovingImageGradient, bool);
+
+protected:
+  HigherOrderAccurateMetricv4GradientSource() = default;
+  ~HigherOrderAccurateMetricv4GradientSource() override = default;
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  unsigned int m_OrderOfAccuracy{ 2 };
+
+  SizeValueType m_MemoryBudget{ NumericTraits<SizeValueType>::max() };
+
+  bool m_PrecomputeFixedImageGradient{ false };
+
+  bool m_PrecomputeMovingImageGradient{ false };
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkHigherOrderAccurateMetricv4GradientSource.hxx"
+#endif
+
+#endif
@@ -0,0 +1,92 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateMetricv4GradientSource_hxx
+#define itkHigherOrderAccurateMetricv4GradientSource_hxx
+#include "itkHigherOrderAccurateMetricv4GradientSource.h"
+
+namespace itk
+{
+
+template <typename TMetric>
+void
+HigherOrderAccurateMetricv4GradientSource<TMetric>::ConfigureMetric(MetricType * metric)
+{
+  if (!metric)
+  {
+    itkExceptionMacro(<< "The metric is not set.");
+  }
+
+  const FixedImageType *  fixedImage = metric->GetFixedImage();
+  const MovingImageType * movingImage = metric->GetMovingImage();
+  if (!fixedImage || !movingImage)
+  {
+    itkExceptionMacro(<< "The fixed and moving images must be set on the metric before it is configured.");
+  }
+
+  SizeValueType remainingBudget = this->m_MemoryBudget;
+  const auto    fitsInBudget = [&remainingBudget](SizeValueType bytes) -> bool {
+    if (bytes > remainingBudget)
+    {
+      return false;
+    }
+    remainingBudget -= bytes;
+    return true;
+  };
+
+  this->m_PrecomputeMovingImageGradient =
+    metric->GetGradientSourceIncludesMoving() &&
+    fitsInBudget(movingImage->GetLargestPossibleRegion().GetNumberOfPixels() * sizeof(MovingImageGradientType));
+  this->m_PrecomputeFixedImageGradient =
+    metric->GetGradientSourceIncludesFixed() &&
+    fitsInBudget(fixedImage->GetLargestPossibleRegion().GetNumberOfPixels() * sizeof(FixedImageGradientType));
+
+  auto movingFilter = MovingImageGradientFilterType::New();
+  movingFilter->SetOrderOfAccuracy(this->m_OrderOfAccuracy);
+  metric->SetMovingImageGradientFilter(movingFilter);
+  auto movingCalculator = MovingImageGradientCalculatorType::New();
+  movingCalculator->SetOrderOfAccuracy(this->m_OrderOfAccuracy);
+  metric->SetMovingImageGradientCalculator(movingCalculator);
+  metric->SetUseMovingImageGradientFilter(this->m_PrecomputeMovingImageGradient);
+
+  auto fixedFilter = FixedImageGradientFilterType::New();
+  fixedFilter->SetOrderOfAccuracy(this->m_OrderOfAccuracy);
+  metric->SetFixedImageGradientFilter(fixedFilter);
+  auto fixedCalculator = FixedImageGradientCalculatorType::New();
+  fixedCalculator->SetOrderOfAccuracy(this->m_OrderOfAccuracy);
+  metric->SetFixedImageGradientCalculator(fixedCalculator);
+  metric->SetUseFixedImageGradientFilter(this->m_PrecomputeFixedImageGradient);
+}
+
+
+template <typename TMetric>
+void
+HigherOrderAccurateMetricv4GradientSource<TMetric>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "OrderOfAccuracy: " << this->m_OrderOfAccuracy << std::endl;
+  os << indent << "MemoryBudget: " << this->m_MemoryBudget << std::endl;
+  os << indent << "PrecomputeFixedImageGradient: " << (this->m_PrecomputeFixedImageGradient ? "On" : "Off")
+     << std::endl;
+  os << indent << "PrecomputeMovingImageGradient: " << (this->m_PrecomputeMovingImageGradient ? "On" : "Off")
+     << std::endl;
+}
+
+} // end namespace itk
+
+#endif
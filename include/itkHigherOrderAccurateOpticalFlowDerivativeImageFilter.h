@@ -0,0 +1,204 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateOpticalFlowDerivativeImageFilter_h
+#define itkHigherOrderAccurateOpticalFlowDerivativeImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkHigherOrderAccurateDerivativeOperator.h"
+#include "itkVectorImage.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class HigherOrderAccurateOpticalFlowDerivativeImageFilter
+ *
+ * \brief Compute the spatial and temporal derivatives used by optical flow
+ * from two or more consecutive frames in a single pass.
+ *
+ * The frames are the indexed inputs, in temporal order, and must share the
+ * same grid.  For every pixel the output holds:
+ *
+ * - the higher order accurate spatial gradient of the mean of the frames,
+ *   computed with the HigherOrderAccurateDerivativeOperator,
+ * - the temporal derivative, which is the least squares slope of the pixel
+ *   value over the frames, i.e. the frame difference for two frames.
+ *
+ * When ComputeLucasKanadeMoments is enabled, the output additionally holds
+ * the sums over a box window of WindowRadius of the products of the
+ * derivatives used by Lucas-Kanade: the entries I_i I_j, i <= j, of the
+ * structure tensor in row-major order, followed by I_i I_t.  The window is
+ * clipped at the image boundary.  The derivatives of the window around the
+ * region of a work unit are kept in a per-thread buffer and summed with
+ * separable running sums, so no intermediate image is produced.  The region
+ * is processed in tiles small enough for that buffer to stay in cache.
+ *
+ * With D the image dimension, the output has D + 1 components, or
+ * D + 1 + D (D + 1) / 2 + D components with the Lucas-Kanade moments.
+ *
+ * \sa HigherOrderAccurateGradientImageFilter
+ *
+ * \ingroup HigherOrderAccurateGradient
+ */
+template <typename TInputImage, typename TOperatorValueType = float, typename TOutputValueType = float>
+class HigherOrderAccurateOpticalFlowDerivativeImageFilter
+  : public ImageToImageFilter<TInputImage, VectorImage<TOutputValueType, TInputImage::ImageDimension>>
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(HigherOrderAccurateOpticalFlowDerivativeImageFilter);
+
+  /** Extract dimension from input image. */
+  static constexpr unsigned int ImageDimension = TInputImage::ImageDimension;
+
+  /** Standard class type alias. */
+  using Self = HigherOrderAccurateOpticalFlowDerivativeImageFilter;
+
+  /** Convenient type alias for simplifying declarations. */
+  using InputImageType = TInputImage;
+  using InputImagePointer = typename InputImageType::Pointer;
+  using OutputImageType = VectorImage<TOutputValueType, ImageDimension>;
+  using OutputImagePointer = typename OutputImageType::Pointer;
+
+  /** Standard class type alias. */
+  using Superclass = ImageToImageFilter<InputImageType, OutputImageType>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(HigherOrderAccurateOpticalFlowDerivativeImageFilter, ImageToImageFilter);
+
+  /** Image type alias support. */
+  using InputPixelType = typename InputImageType::PixelType;
+  using OperatorValueType = TOperatorValueType;
+  using OutputValueType = TOutputValueType;
+  using OutputImageRegionType = typename OutputImageType::RegionType;
+  using SizeType = typename InputImageType::SizeType;
+
+  /** Set/Get whether or not the filter will use the spacing of the input
+      image in its calculations */
+  itkSetMacro(UseImageSpacing, bool);
+  itkGetConstMacro(UseImageSpacing, bool);
+  itkBooleanMacro(UseImageSpacing);
+
+  /** Set/Get whether the spatial derivatives are computed with respect to the
+   * physical coordinate system (On) or the image grid (Off).  The default
+   * value of this flag is On. */
+  itkSetMacro(UseImageDirection, bool);
+  itkGetConstMacro(UseImageDirection, bool);
+  itkBooleanMacro(UseImageDirection);
+
+  /** Set/Get the order of accuracy of the derivative operator.  For more
+   * information, see HigherOrderAccurateDerivativeOperator. */
+  itkSetMacro(OrderOfAccuracy, unsigned int);
+  itkGetConstMacro(OrderOfAccuracy, unsigned int);
+
+  /** Set/Get whether the windowed Lucas-Kanade moments are computed.  The
+   * default value of this flag is Off. */
+  itkSetMacro(ComputeLucasKanadeMoments, bool);
+  itkGetConstMacro(ComputeLucasKanadeMoments, bool);
+  itkBooleanMacro(ComputeLucasKanadeMoments);
+
+  /** Set/Get the radius of the Lucas-Kanade window.  Defaults to 2. */
+  itkSetMacro(WindowRadius, SizeType);
+  itkGetConstReferenceMacro(WindowRadius, SizeType);
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  /** Begin concept checking */
+  itkConceptMacro(InputConvertibleToDoubleCheck, (Concept::Convertible<InputPixelType, double>));
+  itkConceptMacro(OutputHasNumericTraitsCheck, (Concept::HasNumericTraits<OutputValueType>));
+  /** End concept checking */
+#endif
+
+protected:
+  HigherOrderAccurateOpticalFlowDerivativeImageFilter();
+  ~HigherOrderAccurateOpticalFlowDerivativeImageFilter() override = default;
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** The number of output components depends on ComputeLucasKanadeMoments. */
+  void
+  GenerateOutputInformation() override;
+
+  /** The input requested regions are padded by the operator radius, and by
+   * the window radius when the Lucas-Kanade moments are computed.
+   *
+   * \sa ImageToImageFilter::GenerateInputRequestedRegion() */
+  void
+  GenerateInputRequestedRegion() override;
+
+  /** Build the derivative coefficients and the temporal weights. */
+  void
+  BeforeThreadedGenerateData() override;
+
+  void
+  DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread) override;
+
+private:
+  using IndexType = typename InputImageType::IndexType;
+  using RegionType = typename InputImageType::RegionType;
+  using OperatorType = HigherOrderAccurateDerivativeOperator<OperatorValueType, ImageDimension>;
+
+  /** Number of products summed for the Lucas-Kanade moments. */
+  static constexpr unsigned int NumberOfMoments = ImageDimension * (ImageDimension + 1) / 2 + ImageDimension;
+
+  /** Compute the spatial derivatives of the mean frame and the temporal
+   * derivative along a scanline. */
+  void
+  ComputeLine(const IndexType & lineStart,
+              SizeValueType     lineLength,
+              double * const    spatialDerivatives[],
+              double *          temporalDerivative) const;
+
+  /** Size of the tiles region is processed in, so that the fields of a
+   * padded tile fit in cache. */
+  SizeType
+  ComputeLucasKanadeTileSize(const OutputImageRegionType & region) const;
+
+  /** Compute the derivatives and the Lucas-Kanade moments of tile, using
+   * fields as the buffer of the padded tile. */
+  void
+  ComputeLucasKanadeTile(const OutputImageRegionType & tile, std::vector<double> & fields);
+
+  bool m_UseImageSpacing{ true };
+
+  bool m_UseImageDirection{ true };
+
+  unsigned int m_OrderOfAccuracy{ 2 };
+
+  bool m_ComputeLucasKanadeMoments{ false };
+
+  SizeType m_WindowRadius;
+
+  /** Derivative coefficients along each axis, for the offsets -radius..radius. */
+  std::vector<double> m_Coefficients[ImageDimension];
+
+  /** Weight of every frame in the least squares temporal slope. */
+  std::vector<double> m_TemporalWeights;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkHigherOrderAccurateOpticalFlowDerivativeImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,528 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateOpticalFlowDerivativeImageFilter_hxx
+#define itkHigherOrderAccurateOpticalFlowDerivativeImageFilter_hxx
+#include "itkHigherOrderAccurateOpticalFlowDerivativeImageFilter.h"
+
+#include "itkImageRegionConstIteratorWithOnlyIndex.h"
+#include "itkHigherOrderAccurateDerivativeOperator.h"
+
+#include <algorithm>
+
+namespace itk
+{
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+HigherOrderAccurateOpticalFlowDerivativeImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  HigherOrderAccurateOpticalFlowDerivativeImageFilter()
+{
+  this->SetNumberOfRequiredInputs(2);
+  this->m_WindowRadius.Fill(2);
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateOpticalFlowDerivativeImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  GenerateOutputInformation()
+{
+  Superclass::GenerateOutputInformation();
+
+  OutputImageType * outputPtr = this->GetOutput();
+  if (!outputPtr)
+  {
+    return;
+  }
+
+  unsigned int numberOfComponents = ImageDimension + 1;
+  if (this->m_ComputeLucasKanadeMoments)
+  {
+    numberOfComponents += NumberOfMoments;
+  }
+  outputPtr->SetNumberOfComponentsPerPixel(numberOfComponents);
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateOpticalFlowDerivativeImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  GenerateInputRequestedRegion()
+{
+  // call the superclass' implementation of this method
+  Superclass::GenerateInputRequestedRegion();
+
+  // Build an operator so that we can determine the kernel size
+  HigherOrderAccurateDerivativeOperator<OperatorValueType, ImageDimension> oper;
+  oper.SetDirection(0);
+  oper.SetOrder(1);
+  oper.SetOrderOfAccuracy(this->m_OrderOfAccuracy);
+  oper.CreateDirectional();
+
+  // The products summed over the window need the derivatives of the whole
+  // window.
+  SizeType radius;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    radius[i] = oper.GetRadius()[0];
+    if (this->m_ComputeLucasKanadeMoments)
+    {
+      radius[i] += this->m_WindowRadius[i];
+    }
+  }
+
+  for (unsigned int frame = 0; frame < this->GetNumberOfIndexedInputs(); ++frame)
+  {
+    InputImagePointer inputPtr = const_cast<InputImageType *>(this->GetInput(frame));
+    if (!inputPtr)
+    {
+      continue;
+    }
+
+    // pad the input requested region by the radius
+    RegionType inputRequestedRegion = inputPtr->GetRequestedRegion();
+    inputRequestedRegion.PadByRadius(radius);
+
+    // crop the input requested region at the input's largest possible region
+    if (inputRequestedRegion.Crop(inputPtr->GetLargestPossibleRegion()))
+    {
+      inputPtr->SetRequestedRegion(inputRequestedRegion);
+    }
+    else
+    {
+      // Couldn't crop the region (requested region is outside the largest
+      // possible region).  Throw an exception.
+
+      // store what we tried to request (prior to trying to crop)
+      inputPtr->SetRequestedRegion(inputRequestedRegion);
+
+      // build an exception
+      InvalidRequestedRegionError e(__FILE__, __LINE__);
+      e.SetLocation(ITK_LOCATION);
+      e.SetDescription("Requested region is (at least partially) outside the largest possible region.");
+      e.SetDataObject(inputPtr);
+      throw e;
+    }
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateOpticalFlowDerivativeImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  BeforeThreadedGenerateData()
+{
+  const unsigned int     numberOfFrames = this->GetNumberOfIndexedInputs();
+  const InputImageType * firstFrame = this->GetInput(0);
+  for (unsigned int frame = 1; frame < numberOfFrames; ++frame)
+  {
+    if (!this->GetInput(frame) || this->GetInput(frame)->GetBufferedRegion() != firstFrame->GetBufferedRegion())
+    {
+      itkExceptionMacro(<< "All frames must be set and share the same grid.");
+    }
+  }
+
+  // Least squares slope over the frame times 0, 1, ..., numberOfFrames - 1.
+  const double meanTime = 0.5 * static_cast<double>(numberOfFrames - 1);
+  double       sumOfSquares = 0.0;
+  this->m_TemporalWeights.resize(numberOfFrames);
+  for (unsigned int frame = 0; frame < numberOfFrames; ++frame)
+  {
+    this->m_TemporalWeights[frame] = static_cast<double>(frame) - meanTime;
+    sumOfSquares += this->m_TemporalWeights[frame] * this->m_TemporalWeights[frame];
+  }
+  for (auto & weight : this->m_TemporalWeights)
+  {
+    weight /= sumOfSquares;
+  }
+
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    this->m_Coefficients[i] = OperatorType::ComputeSpacedCoefficients(
+      1, this->m_OrderOfAccuracy, this->m_UseImageSpacing ? firstFrame->GetSpacing()[i] : 1.0);
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateOpticalFlowDerivativeImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::ComputeLine(
+  const IndexType & lineStart,
+  SizeValueType     lineLength,
+  double * const    spatialDerivatives[],
+  double *          temporalDerivative) const
+{
+  const unsigned int      numberOfFrames = this->GetNumberOfIndexedInputs();
+  const InputImageType *  firstFrame = this->GetInput(0);
+  const RegionType &      bufferedRegion = firstFrame->GetBufferedRegion();
+  const OffsetValueType * offsetTable = firstFrame->GetOffsetTable();
+  const OffsetValueType   lineOffset = firstFrame->ComputeOffset(lineStart);
+  const auto              radius = static_cast<OffsetValueType>(this->m_Coefficients[0].size() / 2);
+
+  // Inside the buffer, the pixels under each tap form one contiguous run.
+  bool interior = true;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    const OffsetValueType first = bufferedRegion.GetIndex(i);
+    const OffsetValueType last = first + static_cast<OffsetValueType>(bufferedRegion.GetSize(i)) - 1;
+    const OffsetValueType lineLast = lineStart[i] + (i == 0 ? static_cast<OffsetValueType>(lineLength) - 1 : 0);
+    if (lineStart[i] - radius < first || lineLast + radius > last)
+    {
+      interior = false;
+    }
+  }
+
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    std::fill(spatialDerivatives[i], spatialDerivatives[i] + lineLength, 0.0);
+  }
+  std::fill(temporalDerivative, temporalDerivative + lineLength, 0.0);
+
+  // The derivative of the mean frame is the mean of the frame derivatives.
+  const double frameWeight = 1.0 / static_cast<double>(numberOfFrames);
+  for (unsigned int frame = 0; frame < numberOfFrames; ++frame)
+  {
+    const InputPixelType * buffer = this->GetInput(frame)->GetBufferPointer();
+    const InputPixelType * center = buffer + lineOffset;
+
+    const double temporalWeight = this->m_TemporalWeights[frame];
+    for (SizeValueType x = 0; x < lineLength; ++x)
+    {
+      temporalDerivative[x] += temporalWeight * static_cast<double>(center[x]);
+    }
+
+    if (interior)
+    {
+      for (unsigned int i = 0; i < ImageDimension; ++i)
+      {
+        for (OffsetValueType k = -radius; k <= radius; ++k)
+        {
+          if (k == 0)
+          {
+            continue;
+          }
+          const double           weight = frameWeight * this->m_Coefficients[i][k + radius];
+          const InputPixelType * tap = center + k * offsetTable[i];
+          for (SizeValueType x = 0; x < lineLength; ++x)
+          {
+            spatialDerivatives[i][x] += weight * static_cast<double>(tap[x]);
+          }
+        }
+      }
+      continue;
+    }
+
+    // Zero flux Neumann boundary condition: clamp the taps to the buffer.
+    IndexType index = lineStart;
+    for (SizeValueType x = 0; x < lineLength; ++x, ++index[0])
+    {
+      for (unsigned int i = 0; i < ImageDimension; ++i)
+      {
+        const OffsetValueType first = bufferedRegion.GetIndex(i);
+        const OffsetValueType last = first + static_cast<OffsetValueType>(bufferedRegion.GetSize(i)) - 1;
+        IndexType             tapIndex = index;
+        OperatorType::AccumulateClampedTaps(
+          this->m_Coefficients[i], index[i], first, last, [&](double weight, OffsetValueType shift) {
+            tapIndex[i] = index[i] + shift;
+            spatialDerivatives[i][x] +=
+              frameWeight * weight * static_cast<double>(buffer[firstFrame->ComputeOffset(tapIndex)]);
+          });
+      }
+    }
+  }
+
+  if (this->m_UseImageDirection)
+  {
+    const typename InputImageType::DirectionType & direction = firstFrame->GetDirection();
+    for (SizeValueType x = 0; x < lineLength; ++x)
+    {
+      double gridGradient[ImageDimension];
+      for (unsigned int i = 0; i < ImageDimension; ++i)
+      {
+        gridGradient[i] = spatialDerivatives[i][x];
+      }
+      for (unsigned int i = 0; i < ImageDimension; ++i)
+      {
+        double sum = 0.0;
+        for (unsigned int k = 0; k < ImageDimension; ++k)
+        {
+          sum += direction[i][k] * gridGradient[k];
+        }
+        spatialDerivatives[i][x] = sum;
+      }
+    }
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateOpticalFlowDerivativeImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread)
+{
+  OutputImageType *  outputImage = this->GetOutput();
+  OutputValueType *  outputBuffer = outputImage->GetBufferPointer();
+  const unsigned int numberOfComponents = outputImage->GetNumberOfComponentsPerPixel();
+
+  if (!this->m_ComputeLucasKanadeMoments)
+  {
+    const SizeValueType lineLength = outputRegionForThread.GetSize(0);
+    std::vector<double> lines((ImageDimension + 1) * lineLength);
+    double *            spatialDerivatives[ImageDimension];
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      spatialDerivatives[i] = lines.data() + i * lineLength;
+    }
+    double * temporalDerivative = lines.data() + ImageDimension * lineLength;
+
+    OutputImageRegionType lineStartRegion = outputRegionForThread;
+    lineStartRegion.SetSize(0, 1);
+    for (ImageRegionConstIteratorWithOnlyIndex<OutputImageType> lineIt(outputImage, lineStartRegion);
+         !lineIt.IsAtEnd();
+         ++lineIt)
+    {
+      const IndexType lineStart = lineIt.GetIndex();
+      this->ComputeLine(lineStart, lineLength, spatialDerivatives, temporalDerivative);
+
+      OutputValueType * outputLine = outputBuffer + outputImage->ComputeOffset(lineStart) * numberOfComponents;
+      for (SizeValueType x = 0; x < lineLength; ++x)
+      {
+        for (unsigned int i = 0; i < ImageDimension; ++i)
+        {
+          outputLine[x * numberOfComponents + i] = static_cast<OutputValueType>(spatialDerivatives[i][x]);
+        }
+        outputLine[x * numberOfComponents + ImageDimension] = static_cast<OutputValueType>(temporalDerivative[x]);
+      }
+    }
+    return;
+  }
+
+  // The region of the work unit is processed in tiles whose fields, over
+  // the tile padded by the window, fit in cache.
+  const SizeType      tileSize = this->ComputeLucasKanadeTileSize(outputRegionForThread);
+  const IndexType     regionStart = outputRegionForThread.GetIndex();
+  const IndexType     regionEnd = outputRegionForThread.GetUpperIndex();
+  IndexType           tileStart = regionStart;
+  std::vector<double> fields;
+  while (true)
+  {
+    OutputImageRegionType tile;
+    tile.SetIndex(tileStart);
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      tile.SetSize(i, std::min(tileSize[i], static_cast<SizeValueType>(regionEnd[i] - tileStart[i] + 1)));
+    }
+    this->ComputeLucasKanadeTile(tile, fields);
+
+    unsigned int i = 0;
+    for (; i < ImageDimension; ++i)
+    {
+      tileStart[i] += static_cast<IndexValueType>(tileSize[i]);
+      if (tileStart[i] <= regionEnd[i])
+      {
+        break;
+      }
+      tileStart[i] = regionStart[i];
+    }
+    if (i == ImageDimension)
+    {
+      return;
+    }
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+auto
+HigherOrderAccurateOpticalFlowDerivativeImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  ComputeLucasKanadeTileSize(const OutputImageRegionType & region) const -> SizeType
+{
+  // About the size of a second level cache.
+  constexpr SizeValueType maximumTileBytes = SizeValueType{ 1 } << 20;
+  constexpr unsigned int  numberOfFields = ImageDimension + 1 + NumberOfMoments;
+
+  const auto paddedBytes = [this](const SizeType & size) {
+    SizeValueType numberOfPixels = 1;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      numberOfPixels *= size[i] + 2 * this->m_WindowRadius[i];
+    }
+    return numberOfFields * numberOfPixels * sizeof(double);
+  };
+
+  // Shrink the slowest axes first, so that scanlines stay long, but not
+  // below the window, where the padding would be computed more than twice.
+  SizeType tileSize = region.GetSize();
+  for (unsigned int i = ImageDimension; i-- > 0;)
+  {
+    const SizeValueType minimumSize = std::max(SizeValueType{ 1 }, 2 * this->m_WindowRadius[i]);
+    while (paddedBytes(tileSize) > maximumTileBytes && tileSize[i] > minimumSize)
+    {
+      tileSize[i] = std::max(minimumSize, (tileSize[i] + 1) / 2);
+    }
+  }
+  return tileSize;
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateOpticalFlowDerivativeImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  ComputeLucasKanadeTile(const OutputImageRegionType & tile, std::vector<double> & fields)
+{
+  OutputImageType *  outputImage = this->GetOutput();
+  OutputValueType *  outputBuffer = outputImage->GetBufferPointer();
+  const unsigned int numberOfComponents = outputImage->GetNumberOfComponentsPerPixel();
+
+  // The derivatives and their products are computed over the tile padded by
+  // the window.
+  RegionType workRegion = tile;
+  workRegion.PadByRadius(this->m_WindowRadius);
+  workRegion.Crop(this->GetInput(0)->GetLargestPossibleRegion());
+
+  const SizeValueType    numberOfWorkPixels = workRegion.GetNumberOfPixels();
+  const SizeValueType    workLineLength = workRegion.GetSize(0);
+  constexpr unsigned int numberOfFields = ImageDimension + 1 + NumberOfMoments;
+  fields.resize(numberOfFields * numberOfWorkPixels);
+
+  SizeValueType workStride[ImageDimension];
+  workStride[0] = 1;
+  for (unsigned int i = 1; i < ImageDimension; ++i)
+  {
+    workStride[i] = workStride[i - 1] * workRegion.GetSize(i - 1);
+  }
+  const auto workOffset = [&](const IndexType & index) -> SizeValueType {
+    SizeValueType offset = 0;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      offset += workStride[i] * static_cast<SizeValueType>(index[i] - workRegion.GetIndex(i));
+    }
+    return offset;
+  };
+
+  RegionType workLineStartRegion = workRegion;
+  workLineStartRegion.SetSize(0, 1);
+  for (ImageRegionConstIteratorWithOnlyIndex<InputImageType> lineIt(this->GetInput(0), workLineStartRegion);
+       !lineIt.IsAtEnd();
+       ++lineIt)
+  {
+    const IndexType     lineStart = lineIt.GetIndex();
+    const SizeValueType lineOffset = workOffset(lineStart);
+
+    double * field[numberOfFields];
+    for (unsigned int f = 0; f < numberOfFields; ++f)
+    {
+      field[f] = fields.data() + f * numberOfWorkPixels + lineOffset;
+    }
+    this->ComputeLine(lineStart, workLineLength, field, field[ImageDimension]);
+
+    unsigned int moment = ImageDimension + 1;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      for (unsigned int j = i; j < ImageDimension; ++j, ++moment)
+      {
+        for (SizeValueType x = 0; x < workLineLength; ++x)
+        {
+          field[moment][x] = field[i][x] * field[j][x];
+        }
+      }
+    }
+    for (unsigned int i = 0; i < ImageDimension; ++i, ++moment)
+    {
+      for (SizeValueType x = 0; x < workLineLength; ++x)
+      {
+        field[moment][x] = field[i][x] * field[ImageDimension][x];
+      }
+    }
+  }
+
+  // Separable box sums of the products, clipped at the work region, which is
+  // itself clipped at the image.
+  std::vector<double> prefixSum;
+  for (unsigned int axis = 0; axis < ImageDimension; ++axis)
+  {
+    const SizeValueType length = workRegion.GetSize(axis);
+    const SizeValueType stride = workStride[axis];
+    const auto          windowRadius = static_cast<OffsetValueType>(this->m_WindowRadius[axis]);
+    prefixSum.resize(length + 1);
+
+    for (SizeValueType lineOffset = 0; lineOffset < numberOfWorkPixels; ++lineOffset)
+    {
+      if ((lineOffset / stride) % length != 0)
+      {
+        continue;
+      }
+      for (unsigned int f = ImageDimension + 1; f < numberOfFields; ++f)
+      {
+        double * line = fields.data() + f * numberOfWorkPixels + lineOffset;
+        prefixSum[0] = 0.0;
+        for (SizeValueType x = 0; x < length; ++x)
+        {
+          prefixSum[x + 1] = prefixSum[x] + line[x * stride];
+        }
+        for (SizeValueType x = 0; x < length; ++x)
+        {
+          const auto low = static_cast<SizeValueType>(std::max(static_cast<OffsetValueType>(x) - windowRadius,
+                                                               static_cast<OffsetValueType>(0)));
+          const auto high = static_cast<SizeValueType>(std::min(static_cast<OffsetValueType>(x) + windowRadius,
+                                                                static_cast<OffsetValueType>(length) - 1));
+          line[x * stride] = prefixSum[high + 1] - prefixSum[low];
+        }
+      }
+    }
+  }
+
+  const SizeValueType   lineLength = tile.GetSize(0);
+  OutputImageRegionType lineStartRegion = tile;
+  lineStartRegion.SetSize(0, 1);
+  for (ImageRegionConstIteratorWithOnlyIndex<OutputImageType> lineIt(outputImage, lineStartRegion);
+       !lineIt.IsAtEnd();
+       ++lineIt)
+  {
+    const IndexType     lineStart = lineIt.GetIndex();
+    const SizeValueType lineOffset = workOffset(lineStart);
+    OutputValueType *   outputLine = outputBuffer + outputImage->ComputeOffset(lineStart) * numberOfComponents;
+    for (SizeValueType x = 0; x < lineLength; ++x)
+    {
+      for (unsigned int f = 0; f < numberOfFields; ++f)
+      {
+        outputLine[x * numberOfComponents + f] =
+          static_cast<OutputValueType>(fields[f * numberOfWorkPixels + lineOffset + x]);
+      }
+    }
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateOpticalFlowDerivativeImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::PrintSelf(
+  std::ostream & os,
+  Indent         indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "UseImageSpacing: " << (this->m_UseImageSpacing ? "On" : "Off") << std::endl;
+  os << indent << "UseImageDirection = " << (this->m_UseImageDirection ? "On" : "Off") << std::endl;
+  os << indent << "OrderOfAccuracy: " << this->m_OrderOfAccuracy << std::endl;
+  os << indent << "ComputeLucasKanadeMoments: " << (this->m_ComputeLucasKanadeMoments ? "On" : "Off") << std::endl;
+  os << indent << "WindowRadius: " << this->m_WindowRadius << std::endl;
+}
+
+} // end namespace itk
+
+#endif
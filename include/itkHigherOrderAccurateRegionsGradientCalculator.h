@@ -0,0 +1,197 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateRegionsGradientCalculator_h
+#define itkHigherOrderAccurateRegionsGradientCalculator_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkImage.h"
+#include "itkMultiThreaderBase.h"
+#include "itkHigherOrderAccurateDerivativeOperator.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class HigherOrderAccurateRegionsGradientCalculator
+ *
+ * \brief Compute the higher order accurate gradient over many small regions
+ * of an image at once.
+ *
+ * Compute() takes a list of regions of the image and writes the gradient of
+ * every pixel of every region to a single packed buffer.  The gradient of
+ * region k starts at element GetRegionOffsets()[k] of GetPackedGradients(),
+ * with ImageDimension components per pixel, the pixels in the order of the
+ * region.  The gradients equal those of HigherOrderAccurateGradientImageFilter
+ * with the same parameters.
+ *
+ * Every region is padded by the operator radius into a halo.  Regions whose
+ * halos overlap are grouped, and each group is described by the bounding box
+ * of its halos, returned by GetHaloRegions().  The union of the halo regions
+ * is the only part of the image that is read, so a pipeline only needs to
+ * produce these regions.  The regions are distributed over the work units in
+ * group order, so the regions sharing input data are computed together while
+ * that data is in cache.  The image must be buffered over the halo regions.
+ *
+ * Compared to running HigherOrderAccurateGradientImageFilter through a
+ * RegionOfInterestImageFilter for every region, the pipeline is not
+ * executed once per region and the overlapping input is not copied.
+ *
+ * \sa HigherOrderAccurateGradientImageFilter
+ *
+ * \ingroup HigherOrderAccurateGradient
+ */
+template <typename TInputImage, typename TOutputValueType = float>
+class HigherOrderAccurateRegionsGradientCalculator : public Object
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(HigherOrderAccurateRegionsGradientCalculator);
+
+  /** Extract dimension from input image. */
+  static constexpr unsigned int ImageDimension = TInputImage::ImageDimension;
+
+  /** Standard class type aliases. */
+  using Self = HigherOrderAccurateRegionsGradientCalculator;
+  using Superclass = Object;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(HigherOrderAccurateRegionsGradientCalculator, Object);
+
+  /** Image type alias support. */
+  using InputImageType = TInputImage;
+  using InputPixelType = typename InputImageType::PixelType;
+  using OutputValueType = TOutputValueType;
+  using IndexType = typename InputImageType::IndexType;
+  using RegionType = typename InputImageType::RegionType;
+  using RegionListType = std::vector<RegionType>;
+
+  /** Set/Get the image whose gradient is computed. */
+  itkSetConstObjectMacro(Image, InputImageType);
+  itkGetConstObjectMacro(Image, InputImageType);
+
+  /** Set/Get whether or not the calculator will use the spacing of the
+      image in its calculations */
+  itkSetMacro(UseImageSpacing, bool);
+  itkGetConstMacro(UseImageSpacing, bool);
+  itkBooleanMacro(UseImageSpacing);
+
+  /** The UseImageDirection flag determines whether image derivatives are
+   * computed with respect to the image grid or with respect to the physical
+   * space.  The default value of this flag is On. */
+  itkSetMacro(UseImageDirection, bool);
+  itkGetConstMacro(UseImageDirection, bool);
+  itkBooleanMacro(UseImageDirection);
+
+  /** Set/Get the order of accuracy of the derivative operator.  For more
+   * information, see HigherOrderAccurateDerivativeOperator. */
+  itkSetMacro(OrderOfAccuracy, unsigned int);
+  itkGetConstMacro(OrderOfAccuracy, unsigned int);
+
+  /** Set/Get the number of work units the regions are distributed over. */
+  void
+  SetNumberOfWorkUnits(ThreadIdType numberOfWorkUnits);
+  ThreadIdType
+  GetNumberOfWorkUnits() const;
+
+  /** Return the halos of the groups of regions, without computing the
+   * gradients.  Use it to request the input before calling Compute(). */
+  RegionListType
+  ComputeHaloRegions(const RegionListType & regions) const;
+
+  /** Compute the gradient over every region.  The regions must lie in the
+   * largest possible region of the image. */
+  void
+  Compute(const RegionListType & regions);
+
+  /** Get the gradients of all the regions, one after the other. */
+  const std::vector<OutputValueType> &
+  GetPackedGradients() const
+  {
+    return this->m_PackedGradients;
+  }
+
+  /** Get the position of the gradient of each region in the packed buffer.
+   * The last entry is the size of the buffer. */
+  const std::vector<SizeValueType> &
+  GetRegionOffsets() const
+  {
+    return this->m_RegionOffsets;
+  }
+
+  /** Get the halo regions of the last call to Compute(). */
+  const RegionListType &
+  GetHaloRegions() const
+  {
+    return this->m_HaloRegions;
+  }
+
+protected:
+  HigherOrderAccurateRegionsGradientCalculator();
+  ~HigherOrderAccurateRegionsGradientCalculator() override = default;
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  using OperatorType = HigherOrderAccurateDerivativeOperator<double, ImageDimension>;
+
+  /** Group the regions whose halos overlap.  Returns the halo of each group
+   * and sets the group of each region. */
+  RegionListType
+  GroupRegions(const RegionListType & regions, std::vector<SizeValueType> & groups) const;
+
+  /** Build the scaled derivative coefficients for the current image. */
+  void
+  ComputeCoefficients();
+
+  /** Write the gradient of region to output. */
+  void
+  ComputeRegion(const RegionType & region, OutputValueType * output) const;
+
+  typename InputImageType::ConstPointer m_Image;
+
+  bool m_UseImageSpacing{ true };
+
+  bool m_UseImageDirection{ true };
+
+  unsigned int m_OrderOfAccuracy{ 2 };
+
+  MultiThreaderBase::Pointer m_MultiThreader;
+
+  std::vector<OutputValueType> m_PackedGradients;
+
+  std::vector<SizeValueType> m_RegionOffsets;
+
+  RegionListType m_HaloRegions;
+
+  /** Derivative coefficients along each axis, for the offsets -radius..radius. */
+  std::vector<double> m_Coefficients[ImageDimension];
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkHigherOrderAccurateRegionsGradientCalculator.hxx"
+#endif
+
+#endif
@@ -0,0 +1,334 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateRegionsGradientCalculator_hxx
+#define itkHigherOrderAccurateRegionsGradientCalculator_hxx
+#include "itkHigherOrderAccurateRegionsGradientCalculator.h"
+
+#include "itkImageRegionConstIteratorWithOnlyIndex.h"
+#include "itkHigherOrderAccurateDerivativeOperator.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace itk
+{
+
+template <typename TInputImage, typename TOutputValueType>
+HigherOrderAccurateRegionsGradientCalculator<TInputImage, TOutputValueType>::
+  HigherOrderAccurateRegionsGradientCalculator()
+  : m_MultiThreader(MultiThreaderBase::New())
+{}
+
+
+template <typename TInputImage, typename TOutputValueType>
+void
+HigherOrderAccurateRegionsGradientCalculator<TInputImage, TOutputValueType>::SetNumberOfWorkUnits(
+  ThreadIdType numberOfWorkUnits)
+{
+  if (numberOfWorkUnits != this->m_MultiThreader->GetNumberOfWorkUnits())
+  {
+    this->m_MultiThreader->SetNumberOfWorkUnits(numberOfWorkUnits);
+    this->Modified();
+  }
+}
+
+
+template <typename TInputImage, typename TOutputValueType>
+ThreadIdType
+HigherOrderAccurateRegionsGradientCalculator<TInputImage, TOutputValueType>::GetNumberOfWorkUnits() const
+{
+  return this->m_MultiThreader->GetNumberOfWorkUnits();
+}
+
+
+template <typename TInputImage, typename TOutputValueType>
+auto
+HigherOrderAccurateRegionsGradientCalculator<TInputImage, TOutputValueType>::ComputeHaloRegions(
+  const RegionListType & regions) const -> RegionListType
+{
+  std::vector<SizeValueType> groups;
+  return this->GroupRegions(regions, groups);
+}
+
+
+template <typename TInputImage, typename TOutputValueType>
+auto
+HigherOrderAccurateRegionsGradientCalculator<TInputImage, TOutputValueType>::GroupRegions(
+  const RegionListType &       regions,
+  std::vector<SizeValueType> & groups) const -> RegionListType
+{
+  if (!this->m_Image)
+  {
+    itkExceptionMacro(<< "Image is not set.");
+  }
+
+  HigherOrderAccurateDerivativeOperator<double, ImageDimension> oper;
+  oper.SetDirection(0);
+  oper.SetOrder(1);
+  oper.SetOrderOfAccuracy(this->m_OrderOfAccuracy);
+  oper.CreateDirectional();
+  const SizeValueType radius = oper.GetRadius()[0];
+
+  const RegionType &  largestRegion = this->m_Image->GetLargestPossibleRegion();
+  const SizeValueType numberOfRegions = regions.size();
+  RegionListType      halos(numberOfRegions);
+  for (SizeValueType k = 0; k < numberOfRegions; ++k)
+  {
+    if (!largestRegion.IsInside(regions[k]))
+    {
+      itkExceptionMacro(<< "Region " << k << " is outside the largest possible region of the image.");
+    }
+    halos[k] = regions[k];
+    halos[k].PadByRadius(radius);
+    halos[k].Crop(largestRegion);
+  }
+
+  // Union-find over the overlapping halos.
+  std::vector<SizeValueType> parents(numberOfRegions);
+  std::iota(parents.begin(), parents.end(), SizeValueType{ 0 });
+  const auto findRoot = [&parents](SizeValueType k) {
+    while (parents[k] != k)
+    {
+      parents[k] = parents[parents[k]];
+      k = parents[k];
+    }
+    return k;
+  };
+
+  // Sweep the halos in the order of their start along the longest axis of
+  // the image.  Only the halos that have not ended along that axis can
+  // overlap the next one, so regions spread over the image are not all
+  // compared with each other.
+  unsigned int sweepAxis = 0;
+  for (unsigned int i = 1; i < ImageDimension; ++i)
+  {
+    if (largestRegion.GetSize(i) > largestRegion.GetSize(sweepAxis))
+    {
+      sweepAxis = i;
+    }
+  }
+  std::vector<SizeValueType> sweepOrder(numberOfRegions);
+  std::iota(sweepOrder.begin(), sweepOrder.end(), SizeValueType{ 0 });
+  std::sort(sweepOrder.begin(), sweepOrder.end(), [&halos, sweepAxis](SizeValueType k, SizeValueType l) {
+    return halos[k].GetIndex(sweepAxis) < halos[l].GetIndex(sweepAxis);
+  });
+  std::vector<SizeValueType> openHalos;
+  for (const SizeValueType k : sweepOrder)
+  {
+    const IndexValueType start = halos[k].GetIndex(sweepAxis);
+    openHalos.erase(std::remove_if(openHalos.begin(),
+                                   openHalos.end(),
+                                   [&halos, sweepAxis, start](SizeValueType l) {
+                                     return halos[l].GetUpperIndex()[sweepAxis] < start;
+                                   }),
+                    openHalos.end());
+    for (const SizeValueType l : openHalos)
+    {
+      RegionType overlap = halos[k];
+      if (overlap.Crop(halos[l]))
+      {
+        parents[findRoot(l)] = findRoot(k);
+      }
+    }
+    openHalos.push_back(k);
+  }
+
+  // Number the groups in the order of their first region, and take the
+  // bounding box of their halos.
+  RegionListType             groupHalos;
+  std::vector<SizeValueType> groupOfRoot(numberOfRegions, numberOfRegions);
+  groups.resize(numberOfRegions);
+  for (SizeValueType k = 0; k < numberOfRegions; ++k)
+  {
+    const SizeValueType root = findRoot(k);
+    if (groupOfRoot[root] == numberOfRegions)
+    {
+      groupOfRoot[root] = groupHalos.size();
+      groupHalos.push_back(halos[k]);
+    }
+    groups[k] = groupOfRoot[root];
+
+    RegionType & groupHalo = groupHalos[groups[k]];
+    IndexType    lower = groupHalo.GetIndex();
+    IndexType    upper = groupHalo.GetUpperIndex();
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      lower[i] = std::min(lower[i], halos[k].GetIndex(i));
+      upper[i] = std::max(upper[i], halos[k].GetUpperIndex()[i]);
+    }
+    groupHalo.SetIndex(lower);
+    groupHalo.SetUpperIndex(upper);
+  }
+  return groupHalos;
+}
+
+
+template <typename TInputImage, typename TOutputValueType>
+void
+HigherOrderAccurateRegionsGradientCalculator<TInputImage, TOutputValueType>::ComputeCoefficients()
+{
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    this->m_Coefficients[i] = OperatorType::ComputeSpacedCoefficients(
+      1, this->m_OrderOfAccuracy, this->m_UseImageSpacing ? this->m_Image->GetSpacing()[i] : 1.0);
+  }
+}
+
+
+template <typename TInputImage, typename TOutputValueType>
+void
+HigherOrderAccurateRegionsGradientCalculator<TInputImage, TOutputValueType>::Compute(const RegionListType & regions)
+{
+  std::vector<SizeValueType> groups;
+  this->m_HaloRegions = this->GroupRegions(regions, groups);
+  for (const RegionType & halo : this->m_HaloRegions)
+  {
+    if (!this->m_Image->GetBufferedRegion().IsInside(halo))
+    {
+      itkExceptionMacro(<< "The image is not buffered over the halo region " << halo);
+    }
+  }
+  this->ComputeCoefficients();
+
+  const SizeValueType numberOfRegions = regions.size();
+  this->m_RegionOffsets.resize(numberOfRegions + 1);
+  this->m_RegionOffsets[0] = 0;
+  for (SizeValueType k = 0; k < numberOfRegions; ++k)
+  {
+    this->m_RegionOffsets[k + 1] = this->m_RegionOffsets[k] + regions[k].GetNumberOfPixels() * ImageDimension;
+  }
+  this->m_PackedGradients.resize(this->m_RegionOffsets[numberOfRegions]);
+
+  // Consecutive regions of the same group go to the same work unit.
+  std::vector<SizeValueType> order(numberOfRegions);
+  std::iota(order.begin(), order.end(), SizeValueType{ 0 });
+  std::stable_sort(
+    order.begin(), order.end(), [&groups](SizeValueType a, SizeValueType b) { return groups[a] < groups[b]; });
+
+  this->m_MultiThreader->ParallelizeArray(
+    0,
+    numberOfRegions,
+    [this, &regions, &order](SizeValueType position) {
+      const SizeValueType k = order[position];
+      this->ComputeRegion(regions[k], this->m_PackedGradients.data() + this->m_RegionOffsets[k]);
+    },
+    nullptr);
+}
+
+
+template <typename TInputImage, typename TOutputValueType>
+void
+HigherOrderAccurateRegionsGradientCalculator<TInputImage, TOutputValueType>::ComputeRegion(
+  const RegionType & region,
+  OutputValueType *  output) const
+{
+  const InputImageType *  image = this->m_Image;
+  const InputPixelType *  buffer = image->GetBufferPointer();
+  const OffsetValueType * offsetTable = image->GetOffsetTable();
+  const RegionType &      bufferedRegion = image->GetBufferedRegion();
+  const auto &            direction = image->GetDirection();
+  const auto              radius = static_cast<OffsetValueType>(this->m_Coefficients[0].size() / 2);
+
+  const SizeValueType lineLength = region.GetSize(0);
+  std::vector<double> gradient(ImageDimension * lineLength);
+
+  RegionType lineStartRegion = region;
+  lineStartRegion.SetSize(0, 1);
+  for (ImageRegionConstIteratorWithOnlyIndex<InputImageType> lineIt(image, lineStartRegion); !lineIt.IsAtEnd();
+       ++lineIt)
+  {
+    const IndexType        lineStart = lineIt.GetIndex();
+    const InputPixelType * center = buffer + image->ComputeOffset(lineStart);
+    std::fill(gradient.begin(), gradient.end(), 0.0);
+
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      double *              line = gradient.data() + i * lineLength;
+      const double *        coefficients = this->m_Coefficients[i].data();
+      const OffsetValueType first = bufferedRegion.GetIndex(i);
+      const OffsetValueType last = first + static_cast<OffsetValueType>(bufferedRegion.GetSize(i)) - 1;
+      const OffsetValueType lineLast = lineStart[i] + (i == 0 ? static_cast<OffsetValueType>(lineLength) - 1 : 0);
+
+      if (lineStart[i] - radius >= first && lineLast + radius <= last)
+      {
+        for (OffsetValueType k = -radius; k <= radius; ++k)
+        {
+          const double           weight = coefficients[k + radius];
+          const InputPixelType * tap = center + k * offsetTable[i];
+          for (SizeValueType x = 0; x < lineLength; ++x)
+          {
+            line[x] += weight * static_cast<double>(tap[x]);
+          }
+        }
+        continue;
+      }
+
+      // Zero flux Neumann boundary condition: clamp the taps to the buffer.
+      for (SizeValueType x = 0; x < lineLength; ++x)
+      {
+        const OffsetValueType position = lineStart[i] + (i == 0 ? static_cast<OffsetValueType>(x) : 0);
+        OperatorType::AccumulateClampedTaps(
+          this->m_Coefficients[i], position, first, last, [&](double weight, OffsetValueType shift) {
+            line[x] += weight * static_cast<double>(center[static_cast<OffsetValueType>(x) + shift * offsetTable[i]]);
+          });
+      }
+    }
+
+    for (SizeValueType x = 0; x < lineLength; ++x, output += ImageDimension)
+    {
+      for (unsigned int i = 0; i < ImageDimension; ++i)
+      {
+        if (this->m_UseImageDirection)
+        {
+          double sum = 0.0;
+          for (unsigned int k = 0; k < ImageDimension; ++k)
+          {
+            sum += direction[i][k] * gradient[k * lineLength + x];
+          }
+          output[i] = static_cast<OutputValueType>(sum);
+        }
+        else
+        {
+          output[i] = static_cast<OutputValueType>(gradient[i * lineLength + x]);
+        }
+      }
+    }
+  }
+}
+
+
+template <typename TInputImage, typename TOutputValueType>
+void
+HigherOrderAccurateRegionsGradientCalculator<TInputImage, TOutputValueType>::PrintSelf(std::ostream & os,
+                                                                                       Indent         indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Image: " << this->m_Image.GetPointer() << std::endl;
+  os << indent << "UseImageSpacing: " << (this->m_UseImageSpacing ? "On" : "Off") << std::endl;
+  os << indent << "UseImageDirection: " << (this->m_UseImageDirection ? "On" : "Off") << std::endl;
+  os << indent << "OrderOfAccuracy: " << this->m_OrderOfAccuracy << std::endl;
+  os << indent << "NumberOfWorkUnits: " << this->GetNumberOfWorkUnits() << std::endl;
+  os << indent << "NumberOfRegions: " << (this->m_RegionOffsets.empty() ? 0 : this->m_RegionOffsets.size() - 1)
+     << std::endl;
+  os << indent << "NumberOfHaloRegions: " << this->m_HaloRegions.size() << std::endl;
+}
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,516 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateResultCache_h
+#define itkHigherOrderAccurateResultCache_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itksys/Directory.hxx"
+#include "itksys/MD5.h"
+#include "itksys/SystemTools.hxx"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+namespace itk
+{
+
+/** \class HigherOrderAccurateResultCacheKey
+ *
+ * \brief Incremental MD5 digest of the data and parameters a filter result
+ * depends on.
+ *
+ * \sa HigherOrderAccurateResultCache
+ *
+ * \ingroup HigherOrderAccurateGradient
+ */
+class HigherOrderAccurateResultCacheKey
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(HigherOrderAccurateResultCacheKey);
+
+  HigherOrderAccurateResultCacheKey()
+    : m_MD5(itksysMD5_New())
+  {
+    itksysMD5_Initialize(this->m_MD5);
+  }
+
+  ~HigherOrderAccurateResultCacheKey() { itksysMD5_Delete(this->m_MD5); }
+
+  /** Append raw bytes. */
+  void
+  Append(const void * data, size_t numberOfBytes)
+  {
+    const auto * bytes = static_cast<const unsigned char *>(data);
+    while (numberOfBytes > 0)
+    {
+      const size_t chunk = std::min(numberOfBytes, static_cast<size_t>(std::numeric_limits<int>::max()));
+      itksysMD5_Append(this->m_MD5, bytes, static_cast<int>(chunk));
+      bytes += chunk;
+      numberOfBytes -= chunk;
+    }
+  }
+
+  /** Append a string, terminator included, so that consecutive strings
+   * cannot be confused. */
+  void
+  Append(const std::string & value)
+  {
+    this->Append(value.c_str(), value.size() + 1);
+  }
+
+  /** Append the bytes of a trivially copyable value. */
+  template <typename TValue>
+  void
+  AppendValue(const TValue & value)
+  {
+    this->Append(&value, sizeof(TValue));
+  }
+
+  /** Append the buffer of an image, its buffered region, spacing and
+   * direction, and the name of its pixel type. */
+  template <typename TImage>
+  void
+  AppendImage(const TImage * image)
+  {
+    using ElementType = typename TImage::PixelContainer::Element;
+    this->Append(typeid(ElementType).name());
+    this->AppendValue(image->GetNumberOfComponentsPerPixel());
+    for (unsigned int i = 0; i < TImage::ImageDimension; ++i)
+    {
+      this->AppendValue(image->GetBufferedRegion().GetIndex(i));
+      this->AppendValue(image->GetBufferedRegion().GetSize(i));
+      this->AppendValue(image->GetSpacing()[i]);
+      for (unsigned int j = 0; j < TImage::ImageDimension; ++j)
+      {
+        this->AppendValue(image->GetDirection()[i][j]);
+      }
+    }
+    this->Append(image->GetBufferPointer(), image->GetPixelContainer()->Size() * sizeof(ElementType));
+  }
+
+  /** The 32 hexadecimal digits of the digest.  No data may be appended
+   * afterwards. */
+  std::string
+  GetHexDigest()
+  {
+    char digest[32];
+    itksysMD5_FinalizeHex(this->m_MD5, digest);
+    return std::string(digest, 32);
+  }
+
+private:
+  itksysMD5 * m_MD5;
+};
+
+
+/** \class HigherOrderAccurateResultCache
+ *
+ * \brief Persistent cache of filter results, addressed by the digest of
+ * their inputs and parameters.
+ *
+ * The filters that accept a ResultCache hash their input buffers and all
+ * the parameters that change the output into a key.  When an entry exists
+ * for the key, the output buffer is read from the cache instead of being
+ * computed; otherwise the computed output is stored.  An entry is one file
+ * named after the key in the cache Directory, holding the raw output buffer.
+ *
+ * The digest of an input image is remembered with the image, its MTime and
+ * its buffer, and only recomputed when the image was modified since, so an
+ * unchanged input is hashed once.  A buffer edited in place must be marked
+ * with Modified(), as anywhere in the pipeline.
+ *
+ * Entries are written to a temporary file that is renamed into place, so
+ * concurrent processes sharing the directory never read a partial entry.
+ * Every load and store increments an access counter, recorded per entry in
+ * the index.txt file of the Directory, and after every store the entries
+ * with the lowest counters are removed until the directory holds at most
+ * MaximumSize bytes.  Concurrent processes may lose an update of the index,
+ * which only changes the order of eviction.
+ *
+ * \sa HigherOrderAccurateGradientImageFilter
+ * \sa HigherOrderAccurateDerivativeImageFilter
+ *
+ * \ingroup HigherOrderAccurateGradient
+ */
+class HigherOrderAccurateResultCache : public Object
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(HigherOrderAccurateResultCache);
+
+  /** Standard class type aliases. */
+  using Self = HigherOrderAccurateResultCache;
+  using Superclass = Object;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(HigherOrderAccurateResultCache, Object);
+
+  /** Set/Get the directory holding the entries.  It is created on the first
+   * store. */
+  itkSetStringMacro(Directory);
+  itkGetStringMacro(Directory);
+
+  /** Set/Get the number of bytes the entries may occupy.  Defaults to
+   * 1 GiB. */
+  itkSetMacro(MaximumSize, SizeValueType);
+  itkGetConstMacro(MaximumSize, SizeValueType);
+
+  /** Read the entry of key into the buffer of image, which must be
+   * allocated.  Returns false, leaving the buffer unchanged, when there is no
+   * entry of the size of the buffer. */
+  template <typename TImage>
+  bool
+  Load(const std::string & key, TImage * image) const
+  {
+    using ElementType = typename TImage::PixelContainer::Element;
+    return this->LoadBuffer(key, image->GetBufferPointer(), image->GetPixelContainer()->Size() * sizeof(ElementType));
+  }
+
+  /** Store the buffer of image as the entry of key. */
+  template <typename TImage>
+  void
+  Store(const std::string & key, const TImage * image)
+  {
+    using ElementType = typename TImage::PixelContainer::Element;
+    this->StoreBuffer(key, image->GetBufferPointer(), image->GetPixelContainer()->Size() * sizeof(ElementType));
+  }
+
+  /** The digest of the buffer, buffered region, spacing, direction and
+   * pixel type of image, recomputed only when the MTime or the buffer of
+   * image changed since the last call. */
+  template <typename TImage>
+  std::string
+  ComputeImageDigest(const TImage * image) const
+  {
+    const ImageDigest current{ image, image->GetMTime(), image->GetBufferPointer(), std::string() };
+
+    std::lock_guard<std::mutex> lock(this->m_ImageDigestsMutex);
+    for (const ImageDigest & digest : this->m_ImageDigests)
+    {
+      if (digest.Image == current.Image && digest.MTime == current.MTime && digest.Buffer == current.Buffer)
+      {
+        return digest.Digest;
+      }
+    }
+
+    HigherOrderAccurateResultCacheKey key;
+    key.AppendImage(image);
+    this->m_ImageDigests.erase(std::remove_if(this->m_ImageDigests.begin(),
+                                              this->m_ImageDigests.end(),
+                                              [&current](const ImageDigest & digest) {
+                                                return digest.Image == current.Image;
+                                              }),
+                               this->m_ImageDigests.end());
+    if (this->m_ImageDigests.size() >= MaximumNumberOfImageDigests)
+    {
+      this->m_ImageDigests.erase(this->m_ImageDigests.begin());
+    }
+    this->m_ImageDigests.push_back(current);
+    this->m_ImageDigests.back().Digest = key.GetHexDigest();
+    return this->m_ImageDigests.back().Digest;
+  }
+
+  /** Whether an entry exists for key. */
+  bool
+  Contains(const std::string & key) const
+  {
+    return itksys::SystemTools::FileExists(this->GetEntryPath(key), true);
+  }
+
+  /** Remove every entry. */
+  void
+  Clear()
+  {
+    this->Evict(0);
+  }
+
+  /** Get the number of bytes occupied by the entries. */
+  SizeValueType
+  GetSize() const
+  {
+    SizeValueType size = 0;
+    for (const EntryDescription & entry : this->ListEntries())
+    {
+      size += entry.Size;
+    }
+    return size;
+  }
+
+protected:
+  HigherOrderAccurateResultCache() = default;
+  ~HigherOrderAccurateResultCache() override = default;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override
+  {
+    Superclass::PrintSelf(os, indent);
+
+    os << indent << "Directory: " << this->m_Directory << std::endl;
+    os << indent << "MaximumSize: " << this->m_MaximumSize << std::endl;
+  }
+
+private:
+  struct EntryDescription
+  {
+    std::string   Key;
+    std::string   Path;
+    SizeValueType Size;
+    uint64_t      LastAccess;
+  };
+
+  /** The last access counter of every entry, by key. */
+  using AccessIndexType = std::map<std::string, uint64_t>;
+
+  /** An image digest and what it was computed from.  The addresses are only
+   * compared. */
+  struct ImageDigest
+  {
+    const void *     Image;
+    ModifiedTimeType MTime;
+    const void *     Buffer;
+    std::string      Digest;
+  };
+
+  static constexpr size_t MaximumNumberOfImageDigests = 16;
+
+  std::string
+  GetEntryPath(const std::string & key) const
+  {
+    return this->m_Directory + "/" + key + ".bin";
+  }
+
+  bool
+  LoadBuffer(const std::string & key, void * buffer, SizeValueType numberOfBytes) const
+  {
+    const std::string path = this->GetEntryPath(key);
+    if (!itksys::SystemTools::FileExists(path, true) || itksys::SystemTools::FileLength(path) != numberOfBytes)
+    {
+      return false;
+    }
+
+    std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+    if (!file.read(static_cast<char *>(buffer), static_cast<std::streamsize>(numberOfBytes)))
+    {
+      return false;
+    }
+    file.close();
+
+    this->RecordAccess(key);
+    return true;
+  }
+
+  void
+  StoreBuffer(const std::string & key, const void * buffer, SizeValueType numberOfBytes)
+  {
+    if (this->m_Directory.empty())
+    {
+      itkExceptionMacro(<< "Directory is not set.");
+    }
+    itksys::SystemTools::MakeDirectory(this->m_Directory);
+
+    // Write to a file no other process uses, then move it into place.
+    std::random_device randomDevice;
+    const std::string  path = this->GetEntryPath(key);
+    const std::string  temporaryPath = path + "." + std::to_string(randomDevice()) + ".tmp";
+    {
+      std::ofstream file(temporaryPath.c_str(), std::ios::out | std::ios::binary);
+      if (!file.write(static_cast<const char *>(buffer), static_cast<std::streamsize>(numberOfBytes)))
+      {
+        file.close();
+        itksys::SystemTools::RemoveFile(temporaryPath);
+        itkWarningMacro(<< "Could not write the cache entry " << temporaryPath);
+        return;
+      }
+    }
+    if (!itksys::SystemTools::RenameFile(temporaryPath, path))
+    {
+      itksys::SystemTools::RemoveFile(temporaryPath);
+      itkWarningMacro(<< "Could not move the cache entry to " << path);
+      return;
+    }
+
+    this->RecordAccess(key);
+    this->Evict(this->m_MaximumSize, path);
+  }
+
+  std::string
+  GetAccessIndexPath() const
+  {
+    return this->m_Directory + "/index.txt";
+  }
+
+  AccessIndexType
+  ReadAccessIndex() const
+  {
+    AccessIndexType index;
+    std::ifstream   file(this->GetAccessIndexPath().c_str());
+    std::string     line;
+    while (std::getline(file, line))
+    {
+      std::istringstream entry(line);
+      std::string        key;
+      uint64_t           lastAccess = 0;
+      if (std::getline(entry, key, '\t') && entry >> lastAccess)
+      {
+        index[key] = lastAccess;
+      }
+    }
+    return index;
+  }
+
+  /** Write the index through a temporary file that is renamed into place.
+   * Failures are ignored: they only change the order of eviction. */
+  void
+  WriteAccessIndex(const AccessIndexType & index) const
+  {
+    if (this->m_Directory.empty() || !itksys::SystemTools::FileIsDirectory(this->m_Directory))
+    {
+      return;
+    }
+    std::random_device randomDevice;
+    const std::string  path = this->GetAccessIndexPath();
+    const std::string  temporaryPath = path + "." + std::to_string(randomDevice()) + ".tmp";
+    {
+      std::ofstream file(temporaryPath.c_str());
+      for (const auto & entry : index)
+      {
+        file << entry.first << '\t' << entry.second << '\n';
+      }
+      if (!file)
+      {
+        file.close();
+        itksys::SystemTools::RemoveFile(temporaryPath);
+        return;
+      }
+    }
+    if (!itksys::SystemTools::RenameFile(temporaryPath, path))
+    {
+      itksys::SystemTools::RemoveFile(temporaryPath);
+    }
+  }
+
+  /** Give key the next value of the access counter. */
+  void
+  RecordAccess(const std::string & key) const
+  {
+    AccessIndexType index = this->ReadAccessIndex();
+    uint64_t        latest = 0;
+    for (const auto & entry : index)
+    {
+      latest = std::max(latest, entry.second);
+    }
+    index[key] = latest + 1;
+    this->WriteAccessIndex(index);
+  }
+
+  std::vector<EntryDescription>
+  ListEntries() const
+  {
+    std::vector<EntryDescription> entries;
+    itksys::Directory             directory;
+    if (this->m_Directory.empty() || !directory.Load(this->m_Directory))
+    {
+      return entries;
+    }
+    // Entries missing from the index are the least recently used.
+    const AccessIndexType index = this->ReadAccessIndex();
+    for (unsigned long i = 0; i < directory.GetNumberOfFiles(); ++i)
+    {
+      const std::string name = directory.GetFile(i);
+      if (name.size() < 4 || name.compare(name.size() - 4, 4, ".bin") != 0)
+      {
+        continue;
+      }
+      const std::string                     key = name.substr(0, name.size() - 4);
+      const std::string                     path = this->m_Directory + "/" + name;
+      const AccessIndexType::const_iterator access = index.find(key);
+      entries.push_back(EntryDescription{ key,
+                                          path,
+                                          static_cast<SizeValueType>(itksys::SystemTools::FileLength(path)),
+                                          access != index.end() ? access->second : 0 });
+    }
+    return entries;
+  }
+
+  /** Remove the least recently used entries, except keptPath, until at most
+   * maximumSize bytes remain. */
+  void
+  Evict(SizeValueType maximumSize, const std::string & keptPath = std::string())
+  {
+    std::vector<EntryDescription> entries = this->ListEntries();
+    SizeValueType                 size = 0;
+    for (const EntryDescription & entry : entries)
+    {
+      size += entry.Size;
+    }
+    std::sort(entries.begin(), entries.end(), [](const EntryDescription & a, const EntryDescription & b) {
+      return a.LastAccess < b.LastAccess;
+    });
+    std::vector<std::string> removedKeys;
+    for (const EntryDescription & entry : entries)
+    {
+      if (size <= maximumSize)
+      {
+        break;
+      }
+      if (entry.Path == keptPath)
+      {
+        continue;
+      }
+      // Another process may have removed the entry already.
+      itksys::SystemTools::RemoveFile(entry.Path);
+      size -= entry.Size;
+      removedKeys.push_back(entry.Key);
+    }
+
+    if (!removedKeys.empty())
+    {
+      AccessIndexType index = this->ReadAccessIndex();
+      for (const std::string & key : removedKeys)
+      {
+        index.erase(key);
+      }
+      this->WriteAccessIndex(index);
+    }
+  }
+
+  std::string m_Directory;
+
+  SizeValueType m_MaximumSize{ SizeValueType{ 1 } << 30 };
+
+  mutable std::vector<ImageDigest> m_ImageDigests;
+  mutable std::mutex               m_ImageDigestsMutex;
+};
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,128 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateStridedView_h
+#define itkHigherOrderAccurateStridedView_h
+
+#include "itkFixedArray.h"
+#include "itkIndex.h"
+#include "itkSize.h"
+
+#include <type_traits>
+
+namespace itk
+{
+
+/** \class HigherOrderAccurateStridedView
+ *
+ * \brief Non-owning description of an N-dimensional array of values in
+ * memory the caller owns.
+ *
+ * A view is a pointer to its first value, the number of values along each
+ * axis and, for each axis, the distance in bytes between consecutive values.
+ * Strides may be negative and need not be multiples of one another, so a
+ * view can describe a cropped or subsampled part of a buffer, a NumPy slice,
+ * or one channel of an interleaved multi-component buffer.  Axis 0 is the
+ * fastest axis of an ITK image.
+ *
+ * \sa HigherOrderAccurateStridedViewGradientCalculator
+ *
+ * \ingroup HigherOrderAccurateGradient
+ */
+template <typename TValue, unsigned int VDimension>
+class HigherOrderAccurateStridedView
+{
+public:
+  static constexpr unsigned int Dimension = VDimension;
+
+  using ValueType = TValue;
+  using SizeType = Size<VDimension>;
+  using IndexType = Index<VDimension>;
+  using StrideType = FixedArray<OffsetValueType, VDimension>;
+
+  HigherOrderAccurateStridedView()
+  {
+    m_Size.Fill(0);
+    m_Strides.Fill(0);
+  }
+
+  HigherOrderAccurateStridedView(ValueType * buffer, const SizeType & size, const StrideType & strides)
+    : m_Buffer(buffer)
+    , m_Size(size)
+    , m_Strides(strides)
+  {}
+
+  /** View of a contiguous buffer, in the order of an ITK image. */
+  static HigherOrderAccurateStridedView
+  Contiguous(ValueType * buffer, const SizeType & size)
+  {
+    StrideType      strides;
+    OffsetValueType stride = sizeof(ValueType);
+    for (unsigned int i = 0; i < VDimension; ++i)
+    {
+      strides[i] = stride;
+      stride *= static_cast<OffsetValueType>(size[i]);
+    }
+    return HigherOrderAccurateStridedView(buffer, size, strides);
+  }
+
+  ValueType *
+  GetBuffer() const
+  {
+    return m_Buffer;
+  }
+
+  const SizeType &
+  GetSize() const
+  {
+    return m_Size;
+  }
+
+  const StrideType &
+  GetStrides() const
+  {
+    return m_Strides;
+  }
+
+  /** Distance in bytes from the first value to the value at index. */
+  OffsetValueType
+  ComputeByteOffset(const IndexType & index) const
+  {
+    OffsetValueType offset = 0;
+    for (unsigned int i = 0; i < VDimension; ++i)
+    {
+      offset += index[i] * m_Strides[i];
+    }
+    return offset;
+  }
+
+  ValueType &
+  GetValue(const IndexType & index) const
+  {
+    using BytePointer = typename std::conditional<std::is_const<ValueType>::value, const char *, char *>::type;
+    return *reinterpret_cast<ValueType *>(reinterpret_cast<BytePointer>(m_Buffer) + this->ComputeByteOffset(index));
+  }
+
+private:
+  ValueType * m_Buffer{ nullptr };
+  SizeType    m_Size;
+  StrideType  m_Strides;
+};
+
+} // end namespace itk
+
+#endif
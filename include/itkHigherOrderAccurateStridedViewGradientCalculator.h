@@ -0,0 +1,223 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateStridedViewGradientCalculator_h
+#define itkHigherOrderAccurateStridedViewGradientCalculator_h
+
+// The configuration header is generated by CMake; without it, as when the
+// headers are used on their own, the filters are header-only.
+#if defined(__has_include)
+#  if __has_include("itkHigherOrderAccurateGradientConfigure.h")
+#    include "itkHigherOrderAccurateGradientConfigure.h"
+#  endif
+#else
+#  include "itkHigherOrderAccurateGradientConfigure.h"
+#endif
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkMatrix.h"
+#include "itkMultiThreaderBase.h"
+#include "itkVector.h"
+#include "itkHigherOrderAccurateDerivativeOperator.h"
+#include "itkHigherOrderAccurateStridedView.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class HigherOrderAccurateStridedViewGradientCalculator
+ *
+ * \brief Compute higher order accurate gradients and derivatives of strided
+ * views of memory the caller owns.
+ *
+ * The input and the outputs are HigherOrderAccurateStridedView, so a cropped
+ * or subsampled part of a volume, a NumPy slice, or one channel of an
+ * interleaved buffer is processed where it lies, without first being copied
+ * into a contiguous Image.  Each gradient component is written to its own
+ * output view, which may interleave the components (channel-last), stack
+ * them (channel-first), or point to separate buffers.
+ *
+ * The views carry no geometry: the Spacing and Direction of the sampling
+ * grid are set on the calculator and default to unit spacing and the
+ * identity.  The gradients and first derivatives equal those of
+ * HigherOrderAccurateGradientImageFilter and
+ * HigherOrderAccurateDerivativeImageFilter on an image holding the same
+ * values, with the same zero flux Neumann boundary condition.  Derivatives
+ * of order n are scaled by the n-th power of the inverse spacing.
+ *
+ * \sa HigherOrderAccurateGradientImageFilter
+ * \sa HigherOrderAccurateDerivativeImageFilter
+ *
+ * \ingroup HigherOrderAccurateGradient
+ */
+template <typename TInputValueType, unsigned int VDimension, typename TOutputValueType = TInputValueType>
+class ITK_TEMPLATE_EXPORT HigherOrderAccurateStridedViewGradientCalculator : public Object
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(HigherOrderAccurateStridedViewGradientCalculator);
+
+  static constexpr unsigned int ImageDimension = VDimension;
+
+  /** Standard class type aliases. */
+  using Self = HigherOrderAccurateStridedViewGradientCalculator;
+  using Superclass = Object;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(HigherOrderAccurateStridedViewGradientCalculator, Object);
+
+  using InputValueType = TInputValueType;
+  using OutputValueType = TOutputValueType;
+  using InputViewType = HigherOrderAccurateStridedView<const InputValueType, ImageDimension>;
+  using OutputViewType = HigherOrderAccurateStridedView<OutputValueType, ImageDimension>;
+  using GradientViewType = FixedArray<OutputViewType, ImageDimension>;
+  using SizeType = typename InputViewType::SizeType;
+  using IndexType = typename InputViewType::IndexType;
+  using SpacingType = Vector<SpacePrecisionType, ImageDimension>;
+  using DirectionType = Matrix<SpacePrecisionType, ImageDimension, ImageDimension>;
+
+  /** Set/Get the spacing of the sampling grid along each axis. */
+  itkSetMacro(Spacing, SpacingType);
+  itkGetConstReferenceMacro(Spacing, SpacingType);
+
+  /** Set/Get the direction cosines of the sampling grid.  The gradient is
+   * rotated to physical space as with UseImageDirection. */
+  itkSetMacro(Direction, DirectionType);
+  itkGetConstReferenceMacro(Direction, DirectionType);
+
+  /** Set/Get the order of accuracy of the derivative operator.  For more
+   * information, see HigherOrderAccurateDerivativeOperator. */
+  itkSetMacro(OrderOfAccuracy, unsigned int);
+  itkGetConstMacro(OrderOfAccuracy, unsigned int);
+
+  /** Set/Get the number of work units the lines are distributed over. */
+  void
+  SetNumberOfWorkUnits(ThreadIdType numberOfWorkUnits);
+  ThreadIdType
+  GetNumberOfWorkUnits() const;
+
+  /** Write component i of the gradient of input to output[i].  The outputs
+   * must have the size of the input. */
+  void
+  ComputeGradient(const InputViewType & input, const GradientViewType & output) const;
+
+  /** Write the derivative of the given order along direction of input to
+   * output, which must have the size of the input. */
+  void
+  ComputeDerivative(const InputViewType &  input,
+                    unsigned int           direction,
+                    unsigned int           order,
+                    const OutputViewType & output) const;
+
+protected:
+  HigherOrderAccurateStridedViewGradientCalculator();
+  ~HigherOrderAccurateStridedViewGradientCalculator() override = default;
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  using OperatorType = HigherOrderAccurateDerivativeOperator<double, ImageDimension>;
+
+  /** Scaled coefficients of the derivative along direction, for the offsets
+   * -radius..radius. */
+  std::vector<double>
+  ComputeCoefficients(unsigned int direction, unsigned int order) const;
+
+  /** Add the derivative along axis of the line of input starting at
+   * lineStart to line. */
+  static void
+  AccumulateLine(const InputViewType &       input,
+                 const IndexType &           lineStart,
+                 unsigned int                axis,
+                 const std::vector<double> & coefficients,
+                 double *                    line);
+
+  /** Call lineFunction for the start of every line along axis 0, over the
+   * work units. */
+  template <typename TLineFunction>
+  void
+  ParallelizeLines(const SizeType & size, const TLineFunction & lineFunction) const;
+
+  static void
+  VerifySize(const InputViewType & input, const OutputViewType & output);
+
+  SpacingType m_Spacing;
+
+  DirectionType m_Direction;
+
+  unsigned int m_OrderOfAccuracy{ 2 };
+
+  MultiThreaderBase::Pointer m_MultiThreader;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkHigherOrderAccurateStridedViewGradientCalculator.hxx"
+#endif
+
+#endif
+
+/** Explicit instantiations */
+#if defined(HigherOrderAccurateGradient_EXPLICIT_INSTANTIATION)
+#  ifndef ITK_TEMPLATE_EXPLICIT_HigherOrderAccurateStridedViewGradientCalculator
+// The common instantiations are compiled once in the HigherOrderAccurateGradient
+// library.
+//
+// IMPORTANT: Since within the same compilation unit,
+//            ITK_TEMPLATE_EXPLICIT_<classname> defined and undefined states
+//            need to be considered. This code *MUST* be *OUTSIDE* the header
+//            guards.
+//
+#    include "HigherOrderAccurateGradientExport.h"
+#    if defined(HigherOrderAccurateGradient_EXPORTS)
+//   We are building this library
+#      define HigherOrderAccurateGradient_EXPORT_EXPLICIT ITK_FORWARD_EXPORT
+#    else
+//   We are using this library
+#      define HigherOrderAccurateGradient_EXPORT_EXPLICIT HigherOrderAccurateGradient_EXPORT
+#    endif
+namespace itk
+{
+
+ITK_GCC_PRAGMA_DIAG_PUSH()
+ITK_GCC_PRAGMA_DIAG(ignored "-Wattributes")
+
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateStridedViewGradientCalculator<float, 2, float>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateStridedViewGradientCalculator<double, 2, double>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateStridedViewGradientCalculator<float, 3, float>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateStridedViewGradientCalculator<double, 3, double>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateStridedViewGradientCalculator<float, 4, float>;
+extern template class HigherOrderAccurateGradient_EXPORT_EXPLICIT
+  HigherOrderAccurateStridedViewGradientCalculator<double, 4, double>;
+
+ITK_GCC_PRAGMA_DIAG_POP()
+
+} // end namespace itk
+#    undef HigherOrderAccurateGradient_EXPORT_EXPLICIT
+#  endif
+#endif
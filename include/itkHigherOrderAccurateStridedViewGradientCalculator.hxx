@@ -0,0 +1,308 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateStridedViewGradientCalculator_hxx
+#define itkHigherOrderAccurateStridedViewGradientCalculator_hxx
+#include "itkHigherOrderAccurateStridedViewGradientCalculator.h"
+
+#include "itkImageRegion.h"
+#include "itkHigherOrderAccurateDerivativeOperator.h"
+
+#include <algorithm>
+
+namespace itk
+{
+
+template <typename TInputValueType, unsigned int VDimension, typename TOutputValueType>
+HigherOrderAccurateStridedViewGradientCalculator<TInputValueType, VDimension, TOutputValueType>::
+  HigherOrderAccurateStridedViewGradientCalculator()
+  : m_MultiThreader(MultiThreaderBase::New())
+{
+  m_Spacing.Fill(1.0);
+  m_Direction.SetIdentity();
+}
+
+
+template <typename TInputValueType, unsigned int VDimension, typename TOutputValueType>
+void
+HigherOrderAccurateStridedViewGradientCalculator<TInputValueType, VDimension, TOutputValueType>::SetNumberOfWorkUnits(
+  ThreadIdType numberOfWorkUnits)
+{
+  if (numberOfWorkUnits != this->m_MultiThreader->GetNumberOfWorkUnits())
+  {
+    this->m_MultiThreader->SetNumberOfWorkUnits(numberOfWorkUnits);
+    this->Modified();
+  }
+}
+
+
+template <typename TInputValueType, unsigned int VDimension, typename TOutputValueType>
+ThreadIdType
+HigherOrderAccurateStridedViewGradientCalculator<TInputValueType, VDimension, TOutputValueType>::GetNumberOfWorkUnits()
+  const
+{
+  return this->m_MultiThreader->GetNumberOfWorkUnits();
+}
+
+
+template <typename TInputValueType, unsigned int VDimension, typename TOutputValueType>
+std::vector<double>
+HigherOrderAccurateStridedViewGradientCalculator<TInputValueType, VDimension, TOutputValueType>::ComputeCoefficients(
+  unsigned int direction,
+  unsigned int order) const
+{
+  if (direction >= ImageDimension)
+  {
+    itkExceptionMacro(<< "Direction " << direction << " is not smaller than the dimension " << ImageDimension);
+  }
+
+  return OperatorType::ComputeSpacedCoefficients(order, this->m_OrderOfAccuracy, this->m_Spacing[direction]);
+}
+
+
+template <typename TInputValueType, unsigned int VDimension, typename TOutputValueType>
+void
+HigherOrderAccurateStridedViewGradientCalculator<TInputValueType, VDimension, TOutputValueType>::AccumulateLine(
+  const InputViewType &       input,
+  const IndexType &           lineStart,
+  unsigned int                axis,
+  const std::vector<double> & coefficients,
+  double *                    line)
+{
+  const char *          center = reinterpret_cast<const char *>(input.GetBuffer()) + input.ComputeByteOffset(lineStart);
+  const OffsetValueType step = input.GetStrides()[0];
+  const OffsetValueType stride = input.GetStrides()[axis];
+  const auto            lineLength = static_cast<OffsetValueType>(input.GetSize()[0]);
+  const auto            last = static_cast<OffsetValueType>(input.GetSize()[axis]) - 1;
+  const auto            radius = static_cast<OffsetValueType>(coefficients.size() / 2);
+  const auto            value = [](const char * pointer) {
+    return static_cast<double>(*reinterpret_cast<const InputValueType *>(pointer));
+  };
+
+  // The positions of the line whose taps all lie in the view.
+  OffsetValueType interiorBegin = 0;
+  OffsetValueType interiorEnd = lineLength;
+  if (axis == 0)
+  {
+    interiorBegin = std::min(radius, lineLength);
+    interiorEnd = std::max(interiorBegin, lineLength - radius);
+  }
+  else if (lineStart[axis] < radius || lineStart[axis] + radius > last)
+  {
+    interiorEnd = 0;
+  }
+
+  for (OffsetValueType k = -radius; k <= radius; ++k)
+  {
+    const double weight = coefficients[k + radius];
+    const char * tap = center + k * stride;
+    for (OffsetValueType x = interiorBegin; x < interiorEnd; ++x)
+    {
+      line[x] += weight * value(tap + x * step);
+    }
+  }
+
+  // Zero flux Neumann boundary condition: clamp the taps to the view.
+  const auto accumulateClamped = [&](OffsetValueType begin, OffsetValueType end) {
+    for (OffsetValueType x = begin; x < end; ++x)
+    {
+      const OffsetValueType position = axis == 0 ? x : lineStart[axis];
+      OperatorType::AccumulateClampedTaps(
+        coefficients, position, 0, last, [&](double weight, OffsetValueType shift) {
+          line[x] += weight * value(center + x * step + shift * stride);
+        });
+    }
+  };
+  if (interiorBegin < interiorEnd)
+  {
+    accumulateClamped(0, interiorBegin);
+    accumulateClamped(interiorEnd, lineLength);
+  }
+  else
+  {
+    accumulateClamped(0, lineLength);
+  }
+}
+
+
+template <typename TInputValueType, unsigned int VDimension, typename TOutputValueType>
+template <typename TLineFunction>
+void
+HigherOrderAccurateStridedViewGradientCalculator<TInputValueType, VDimension, TOutputValueType>::ParallelizeLines(
+  const SizeType &      size,
+  const TLineFunction & lineFunction) const
+{
+  using RegionType = ImageRegion<ImageDimension>;
+
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    if (size[i] == 0)
+    {
+      return;
+    }
+  }
+
+  RegionType lineStartRegion;
+  lineStartRegion.SetSize(size);
+  lineStartRegion.SetSize(0, 1);
+  this->m_MultiThreader->template ParallelizeImageRegion<ImageDimension>(
+    lineStartRegion,
+    [&lineFunction](const RegionType & piece) {
+      IndexType       lineStart = piece.GetIndex();
+      const IndexType upper = piece.GetUpperIndex();
+      while (true)
+      {
+        lineFunction(lineStart);
+
+        unsigned int i = 1;
+        for (; i < ImageDimension; ++i)
+        {
+          if (lineStart[i] < upper[i])
+          {
+            ++lineStart[i];
+            break;
+          }
+          lineStart[i] = piece.GetIndex(i);
+        }
+        if (i == ImageDimension)
+        {
+          return;
+        }
+      }
+    },
+    nullptr);
+}
+
+
+template <typename TInputValueType, unsigned int VDimension, typename TOutputValueType>
+void
+HigherOrderAccurateStridedViewGradientCalculator<TInputValueType, VDimension, TOutputValueType>::VerifySize(
+  const InputViewType &  input,
+  const OutputViewType & output)
+{
+  if (input.GetBuffer() == nullptr || output.GetBuffer() == nullptr)
+  {
+    itkGenericExceptionMacro(<< "The input and output views must have a buffer.");
+  }
+  if (input.GetSize() != output.GetSize())
+  {
+    itkGenericExceptionMacro(<< "The output view size " << output.GetSize() << " differs from the input view size "
+                             << input.GetSize());
+  }
+}
+
+
+template <typename TInputValueType, unsigned int VDimension, typename TOutputValueType>
+void
+HigherOrderAccurateStridedViewGradientCalculator<TInputValueType, VDimension, TOutputValueType>::ComputeGradient(
+  const InputViewType &    input,
+  const GradientViewType & output) const
+{
+  std::vector<double> coefficients[ImageDimension];
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    VerifySize(input, output[i]);
+    coefficients[i] = this->ComputeCoefficients(i, 1);
+  }
+
+  bool identityDirection = true;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    for (unsigned int j = 0; j < ImageDimension; ++j)
+    {
+      identityDirection = identityDirection && this->m_Direction[i][j] == (i == j ? 1.0 : 0.0);
+    }
+  }
+  const DirectionType & direction = this->m_Direction;
+
+  const SizeValueType lineLength = input.GetSize()[0];
+  this->ParallelizeLines(input.GetSize(), [&](const IndexType & lineStart) {
+    std::vector<double> gradient(ImageDimension * lineLength, 0.0);
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      AccumulateLine(input, lineStart, i, coefficients[i], gradient.data() + i * lineLength);
+    }
+
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      char *                outputLine =
+        reinterpret_cast<char *>(output[i].GetBuffer()) + output[i].ComputeByteOffset(lineStart);
+      const OffsetValueType step = output[i].GetStrides()[0];
+      for (SizeValueType x = 0; x < lineLength; ++x)
+      {
+        double component = gradient[i * lineLength + x];
+        if (!identityDirection)
+        {
+          component = 0.0;
+          for (unsigned int k = 0; k < ImageDimension; ++k)
+          {
+            component += direction[i][k] * gradient[k * lineLength + x];
+          }
+        }
+        *reinterpret_cast<OutputValueType *>(outputLine + static_cast<OffsetValueType>(x) * step) =
+          static_cast<OutputValueType>(component);
+      }
+    }
+  });
+}
+
+
+template <typename TInputValueType, unsigned int VDimension, typename TOutputValueType>
+void
+HigherOrderAccurateStridedViewGradientCalculator<TInputValueType, VDimension, TOutputValueType>::ComputeDerivative(
+  const InputViewType &  input,
+  unsigned int           direction,
+  unsigned int           order,
+  const OutputViewType & output) const
+{
+  VerifySize(input, output);
+  const std::vector<double> coefficients = this->ComputeCoefficients(direction, order);
+
+  const SizeValueType lineLength = input.GetSize()[0];
+  this->ParallelizeLines(input.GetSize(), [&](const IndexType & lineStart) {
+    std::vector<double> derivative(lineLength, 0.0);
+    AccumulateLine(input, lineStart, direction, coefficients, derivative.data());
+
+    char *                outputLine =
+      reinterpret_cast<char *>(output.GetBuffer()) + output.ComputeByteOffset(lineStart);
+    const OffsetValueType step = output.GetStrides()[0];
+    for (SizeValueType x = 0; x < lineLength; ++x)
+    {
+      *reinterpret_cast<OutputValueType *>(outputLine + static_cast<OffsetValueType>(x) * step) =
+        static_cast<OutputValueType>(derivative[x]);
+    }
+  });
+}
+
+
+template <typename TInputValueType, unsigned int VDimension, typename TOutputValueType>
+void
+HigherOrderAccurateStridedViewGradientCalculator<TInputValueType, VDimension, TOutputValueType>::PrintSelf(
+  std::ostream & os,
+  Indent         indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Spacing: " << this->m_Spacing << std::endl;
+  os << indent << "Direction: " << this->m_Direction << std::endl;
+  os << indent << "OrderOfAccuracy: " << this->m_OrderOfAccuracy << std::endl;
+  os << indent << "NumberOfWorkUnits: " << this->GetNumberOfWorkUnits() << std::endl;
+}
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,187 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateSymmetricDemonsForceImageFilter_h
+#define itkHigherOrderAccurateSymmetricDemonsForceImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkVector.h"
+#include "itkHigherOrderAccurateDerivativeOperator.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class HigherOrderAccurateSymmetricDemonsForceImageFilter
+ *
+ * \brief Compute the symmetric forces demons update field with higher order
+ * accurate gradients of the fixed and the moving image.
+ *
+ * The inputs are the fixed image and the moving image warped onto the grid of
+ * the fixed image by the current displacement field.  For every pixel, the
+ * gradients of both images are computed with the
+ * HigherOrderAccurateDerivativeOperator and combined in the same pass into
+ * the update of SymmetricForcesDemonsRegistrationFunction:
+ *
+ * \f[
+ *   u = \frac{2 (F - M) (\nabla F + \nabla M)}
+ *            {|\nabla F + \nabla M|^2 + (F - M)^2 / K}
+ * \f]
+ *
+ * where K is the mean squared spacing of the fixed image.  No gradient image
+ * is stored: the derivatives of one scanline of each image are accumulated
+ * into line buffers and consumed immediately.
+ *
+ * The update is zero where |F - M| is below the IntensityDifferenceThreshold
+ * or where the denominator is below the DenominatorThreshold.
+ *
+ * \sa SymmetricForcesDemonsRegistrationFunction
+ * \sa HigherOrderAccurateGradientImageFilter
+ *
+ * \ingroup HigherOrderAccurateGradient
+ */
+template <typename TFixedImage,
+          typename TMovingImage = TFixedImage,
+          typename TDisplacementField = Image<Vector<float, TFixedImage::ImageDimension>, TFixedImage::ImageDimension>>
+class HigherOrderAccurateSymmetricDemonsForceImageFilter : public ImageToImageFilter<TFixedImage, TDisplacementField>
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(HigherOrderAccurateSymmetricDemonsForceImageFilter);
+
+  /** Extract dimension from input image. */
+  static constexpr unsigned int ImageDimension = TFixedImage::ImageDimension;
+
+  /** Standard class type alias. */
+  using Self = HigherOrderAccurateSymmetricDemonsForceImageFilter;
+  using Superclass = ImageToImageFilter<TFixedImage, TDisplacementField>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(HigherOrderAccurateSymmetricDemonsForceImageFilter, ImageToImageFilter);
+
+  /** Image type alias support. */
+  using FixedImageType = TFixedImage;
+  using MovingImageType = TMovingImage;
+  using DisplacementFieldType = TDisplacementField;
+  using OutputImageType = TDisplacementField;
+  using OutputImageRegionType = typename OutputImageType::RegionType;
+  using DisplacementType = typename DisplacementFieldType::PixelType;
+
+  /** Set/Get the fixed image. */
+  itkSetInputMacro(FixedImage, FixedImageType);
+  itkGetInputMacro(FixedImage, FixedImageType);
+
+  /** Set/Get the moving image, warped onto the grid of the fixed image. */
+  itkSetInputMacro(MovingImage, MovingImageType);
+  itkGetInputMacro(MovingImage, MovingImageType);
+
+  /** Set/Get whether or not the filter will use the spacing of the input
+      image in its calculations */
+  itkSetMacro(UseImageSpacing, bool);
+  itkGetConstMacro(UseImageSpacing, bool);
+  itkBooleanMacro(UseImageSpacing);
+
+  /** Set/Get whether the gradients are computed with respect to the physical
+   * coordinate system (On) or the image grid (Off).  The default value of this
+   * flag is On. */
+  itkSetMacro(UseImageDirection, bool);
+  itkGetConstMacro(UseImageDirection, bool);
+  itkBooleanMacro(UseImageDirection);
+
+  /** Set/Get the order of accuracy of the derivative operator.  For more
+   * information, see HigherOrderAccurateDerivativeOperator. */
+  itkSetMacro(OrderOfAccuracy, unsigned int);
+  itkGetConstMacro(OrderOfAccuracy, unsigned int);
+
+  /** Set/Get the intensity difference below which the update is zero.
+   * Defaults to 0.001. */
+  itkSetMacro(IntensityDifferenceThreshold, double);
+  itkGetConstMacro(IntensityDifferenceThreshold, double);
+
+  /** Set/Get the denominator below which the update is zero.  Defaults to
+   * 1e-9. */
+  itkSetMacro(DenominatorThreshold, double);
+  itkGetConstMacro(DenominatorThreshold, double);
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  /** Begin concept checking */
+  itkConceptMacro(FixedConvertibleToDoubleCheck, (Concept::Convertible<typename FixedImageType::PixelType, double>));
+  itkConceptMacro(MovingConvertibleToDoubleCheck, (Concept::Convertible<typename MovingImageType::PixelType, double>));
+  /** End concept checking */
+#endif
+
+protected:
+  HigherOrderAccurateSymmetricDemonsForceImageFilter();
+  ~HigherOrderAccurateSymmetricDemonsForceImageFilter() override = default;
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** The input requested regions are padded by the operator radius.
+   *
+   * \sa ImageToImageFilter::GenerateInputRequestedRegion() */
+  void
+  GenerateInputRequestedRegion() override;
+
+  /** Build the scaled derivative coefficients and the normalizer. */
+  void
+  BeforeThreadedGenerateData() override;
+
+  void
+  DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread) override;
+
+private:
+  using IndexType = typename FixedImageType::IndexType;
+  using RegionType = typename FixedImageType::RegionType;
+  using OperatorType = HigherOrderAccurateDerivativeOperator<double, ImageDimension>;
+
+  /** Accumulate the derivatives with respect to the grid along a scanline. */
+  template <typename TImage>
+  void
+  ComputeLineDerivatives(const TImage *        image,
+                         const IndexType &     lineStart,
+                         SizeValueType         lineLength,
+                         bool                  interior,
+                         std::vector<double> * derivatives) const;
+
+  bool m_UseImageSpacing{ true };
+
+  bool m_UseImageDirection{ true };
+
+  unsigned int m_OrderOfAccuracy{ 2 };
+
+  double m_IntensityDifferenceThreshold{ 0.001 };
+
+  double m_DenominatorThreshold{ 1e-9 };
+
+  double m_Normalizer{ 1.0 };
+
+  /** Derivative coefficients along each axis, for the offsets -radius..radius. */
+  std::vector<double> m_Coefficients[ImageDimension];
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkHigherOrderAccurateSymmetricDemonsForceImageFilter.hxx"
+#endif
+
+#endif
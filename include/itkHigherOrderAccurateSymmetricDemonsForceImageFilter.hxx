@@ -0,0 +1,320 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateSymmetricDemonsForceImageFilter_hxx
+#define itkHigherOrderAccurateSymmetricDemonsForceImageFilter_hxx
+#include "itkHigherOrderAccurateSymmetricDemonsForceImageFilter.h"
+
+#include "itkImageRegionConstIteratorWithOnlyIndex.h"
+#include "itkHigherOrderAccurateDerivativeOperator.h"
+#include "itkNeighborhoodAlgorithm.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace itk
+{
+
+template <typename TFixedImage, typename TMovingImage, typename TDisplacementField>
+HigherOrderAccurateSymmetricDemonsForceImageFilter<TFixedImage, TMovingImage, TDisplacementField>::
+  HigherOrderAccurateSymmetricDemonsForceImageFilter()
+{
+  this->SetPrimaryInputName("FixedImage");
+  this->AddRequiredInputName("MovingImage", 1);
+}
+
+
+template <typename TFixedImage, typename TMovingImage, typename TDisplacementField>
+void
+HigherOrderAccurateSymmetricDemonsForceImageFilter<TFixedImage, TMovingImage, TDisplacementField>::
+  GenerateInputRequestedRegion()
+{
+  // call the superclass' implementation of this method, which sets the
+  // requested region of both inputs to the output requested region
+  Superclass::GenerateInputRequestedRegion();
+
+  auto * fixedPtr = const_cast<FixedImageType *>(this->GetFixedImage());
+  auto * movingPtr = const_cast<MovingImageType *>(this->GetMovingImage());
+  if (!fixedPtr || !movingPtr)
+  {
+    return;
+  }
+
+  // Build an operator so that we can determine the kernel size
+  HigherOrderAccurateDerivativeOperator<double, ImageDimension> oper;
+  oper.SetDirection(0);
+  oper.SetOrder(1);
+  oper.SetOrderOfAccuracy(this->m_OrderOfAccuracy);
+  oper.CreateDirectional();
+  unsigned long radius = oper.GetRadius()[0];
+
+  // pad the requested regions by the operator radius and crop them at the
+  // largest possible regions
+  RegionType fixedRequestedRegion = fixedPtr->GetRequestedRegion();
+  fixedRequestedRegion.PadByRadius(radius);
+  typename MovingImageType::RegionType movingRequestedRegion = movingPtr->GetRequestedRegion();
+  movingRequestedRegion.PadByRadius(radius);
+
+  if (fixedRequestedRegion.Crop(fixedPtr->GetLargestPossibleRegion()) &&
+      movingRequestedRegion.Crop(movingPtr->GetLargestPossibleRegion()))
+  {
+    fixedPtr->SetRequestedRegion(fixedRequestedRegion);
+    movingPtr->SetRequestedRegion(movingRequestedRegion);
+    return;
+  }
+  else
+  {
+    // Couldn't crop the region (requested region is outside the largest
+    // possible region).  Throw an exception.
+
+    // store what we tried to request (prior to trying to crop)
+    fixedPtr->SetRequestedRegion(fixedRequestedRegion);
+
+    // build an exception
+    InvalidRequestedRegionError e(__FILE__, __LINE__);
+    e.SetLocation(ITK_LOCATION);
+    e.SetDescription("Requested region is (at least partially) outside the largest possible region.");
+    e.SetDataObject(fixedPtr);
+    throw e;
+  }
+}
+
+
+template <typename TFixedImage, typename TMovingImage, typename TDisplacementField>
+void
+HigherOrderAccurateSymmetricDemonsForceImageFilter<TFixedImage, TMovingImage, TDisplacementField>::
+  BeforeThreadedGenerateData()
+{
+  const FixedImageType *  fixedImage = this->GetFixedImage();
+  const MovingImageType * movingImage = this->GetMovingImage();
+  if (fixedImage->GetBufferedRegion() != movingImage->GetBufferedRegion())
+  {
+    itkExceptionMacro(<< "The moving image must be warped onto the grid of the fixed image.");
+  }
+
+  // The normalizer is the mean squared spacing, as in
+  // SymmetricForcesDemonsRegistrationFunction.
+  this->m_Normalizer = 0.0;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    this->m_Normalizer += fixedImage->GetSpacing()[i] * fixedImage->GetSpacing()[i];
+  }
+  this->m_Normalizer /= static_cast<double>(ImageDimension);
+
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    this->m_Coefficients[i] = OperatorType::ComputeSpacedCoefficients(
+      1, this->m_OrderOfAccuracy, this->m_UseImageSpacing ? fixedImage->GetSpacing()[i] : 1.0);
+  }
+}
+
+
+template <typename TFixedImage, typename TMovingImage, typename TDisplacementField>
+template <typename TImage>
+void
+HigherOrderAccurateSymmetricDemonsForceImageFilter<TFixedImage, TMovingImage, TDisplacementField>::
+  ComputeLineDerivatives(const TImage *        image,
+                         const IndexType &     lineStart,
+                         SizeValueType         lineLength,
+                         bool                  interior,
+                         std::vector<double> * derivatives) const
+{
+  const typename TImage::PixelType * buffer = image->GetBufferPointer();
+  const OffsetValueType *            offsetTable = image->GetOffsetTable();
+  const RegionType &                 bufferedRegion = image->GetBufferedRegion();
+  const auto                         radius = static_cast<OffsetValueType>(this->m_Coefficients[0].size() / 2);
+
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    std::fill(derivatives[i].begin(), derivatives[i].begin() + lineLength, 0.0);
+  }
+
+  if (interior)
+  {
+    // All taps are in the buffer, and the pixels under each tap form one
+    // contiguous run.
+    const typename TImage::PixelType * center = buffer + image->ComputeOffset(lineStart);
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      double * derivative = derivatives[i].data();
+      for (OffsetValueType k = -radius; k <= radius; ++k)
+      {
+        if (k == 0)
+        {
+          continue;
+        }
+        const double                       weight = this->m_Coefficients[i][k + radius];
+        const typename TImage::PixelType * tap = center + k * offsetTable[i];
+        for (SizeValueType x = 0; x < lineLength; ++x)
+        {
+          derivative[x] += weight * static_cast<double>(tap[x]);
+        }
+      }
+    }
+    return;
+  }
+
+  // Zero flux Neumann boundary condition: clamp the taps to the buffer.
+  IndexType index = lineStart;
+  for (SizeValueType x = 0; x < lineLength; ++x, ++index[0])
+  {
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      const OffsetValueType first = bufferedRegion.GetIndex(i);
+      const OffsetValueType last = first + static_cast<OffsetValueType>(bufferedRegion.GetSize(i)) - 1;
+      IndexType             tapIndex = index;
+      double                sum = 0.0;
+      OperatorType::AccumulateClampedTaps(
+        this->m_Coefficients[i], index[i], first, last, [&](double weight, OffsetValueType shift) {
+          tapIndex[i] = index[i] + shift;
+          sum += weight * static_cast<double>(buffer[image->ComputeOffset(tapIndex)]);
+        });
+      derivatives[i][x] = sum;
+    }
+  }
+}
+
+
+template <typename TFixedImage, typename TMovingImage, typename TDisplacementField>
+void
+HigherOrderAccurateSymmetricDemonsForceImageFilter<TFixedImage, TMovingImage, TDisplacementField>::
+  DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread)
+{
+  const FixedImageType *  fixedImage = this->GetFixedImage();
+  const MovingImageType * movingImage = this->GetMovingImage();
+  OutputImageType *       outputImage = this->GetOutput();
+
+  const auto radius = static_cast<SizeValueType>(this->m_Coefficients[0].size() / 2);
+  Size<ImageDimension> radiusSize;
+  radiusSize.Fill(radius);
+
+  // Find the data-set boundary "faces".
+  typename NeighborhoodAlgorithm::ImageBoundaryFacesCalculator<FixedImageType>::FaceListType faceList;
+  NeighborhoodAlgorithm::ImageBoundaryFacesCalculator<FixedImageType>                        bC;
+  faceList = bC(fixedImage, outputRegionForThread, radiusSize);
+
+  const RegionType &                             bufferedRegion = fixedImage->GetBufferedRegion();
+  const typename FixedImageType::DirectionType & direction = fixedImage->GetDirection();
+  const typename FixedImageType::PixelType *     fixedBuffer = fixedImage->GetBufferPointer();
+  const typename MovingImageType::PixelType *    movingBuffer = movingImage->GetBufferPointer();
+  const double                                   threshold = this->m_IntensityDifferenceThreshold;
+  const SizeValueType                            maximumLineLength = outputRegionForThread.GetSize(0);
+  std::vector<double>                            fixedDerivatives[ImageDimension];
+  std::vector<double>                            movingDerivatives[ImageDimension];
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    fixedDerivatives[i].resize(maximumLineLength);
+    movingDerivatives[i].resize(maximumLineLength);
+  }
+
+  for (const auto & face : faceList)
+  {
+    if (face.GetNumberOfPixels() == 0)
+    {
+      continue;
+    }
+
+    // On the non-boundary face every tap of the stencil is in the buffer.
+    RegionType paddedFace = face;
+    paddedFace.PadByRadius(radiusSize);
+    const bool interiorFace = bufferedRegion.IsInside(paddedFace);
+
+    const SizeValueType lineLength = face.GetSize(0);
+
+    OutputImageRegionType lineStartRegion = face;
+    lineStartRegion.SetSize(0, 1);
+
+    for (ImageRegionConstIteratorWithOnlyIndex<OutputImageType> lineIt(outputImage, lineStartRegion);
+         !lineIt.IsAtEnd();
+         ++lineIt)
+    {
+      const IndexType lineStart = lineIt.GetIndex();
+      this->ComputeLineDerivatives(fixedImage, lineStart, lineLength, interiorFace, fixedDerivatives);
+      this->ComputeLineDerivatives(movingImage, lineStart, lineLength, interiorFace, movingDerivatives);
+
+      const OffsetValueType inputOffset = fixedImage->ComputeOffset(lineStart);
+      DisplacementType *    outputLine = outputImage->GetBufferPointer() + outputImage->ComputeOffset(lineStart);
+      for (SizeValueType x = 0; x < lineLength; ++x)
+      {
+        const double speedValue = static_cast<double>(fixedBuffer[inputOffset + x]) -
+                                  static_cast<double>(movingBuffer[inputOffset + x]);
+
+        double gridGradient[ImageDimension];
+        for (unsigned int i = 0; i < ImageDimension; ++i)
+        {
+          gridGradient[i] = fixedDerivatives[i][x] + movingDerivatives[i][x];
+        }
+
+        double gradient[ImageDimension];
+        double gradientSquaredMagnitude = 0.0;
+        for (unsigned int i = 0; i < ImageDimension; ++i)
+        {
+          if (this->m_UseImageDirection)
+          {
+            gradient[i] = 0.0;
+            for (unsigned int k = 0; k < ImageDimension; ++k)
+            {
+              gradient[i] += direction[i][k] * gridGradient[k];
+            }
+          }
+          else
+          {
+            gradient[i] = gridGradient[i];
+          }
+          gradientSquaredMagnitude += gradient[i] * gradient[i];
+        }
+
+        const double denominator = speedValue * speedValue / this->m_Normalizer + gradientSquaredMagnitude;
+
+        DisplacementType & update = outputLine[x];
+        if (std::abs(speedValue) < threshold || denominator < this->m_DenominatorThreshold)
+        {
+          for (unsigned int i = 0; i < ImageDimension; ++i)
+          {
+            update[i] = NumericTraits<typename DisplacementType::ValueType>::ZeroValue();
+          }
+          continue;
+        }
+
+        for (unsigned int i = 0; i < ImageDimension; ++i)
+        {
+          update[i] = static_cast<typename DisplacementType::ValueType>(2.0 * speedValue * gradient[i] / denominator);
+        }
+      }
+    }
+  }
+}
+
+
+template <typename TFixedImage, typename TMovingImage, typename TDisplacementField>
+void
+HigherOrderAccurateSymmetricDemonsForceImageFilter<TFixedImage, TMovingImage, TDisplacementField>::PrintSelf(
+  std::ostream & os,
+  Indent         indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "UseImageSpacing: " << (this->m_UseImageSpacing ? "On" : "Off") << std::endl;
+  os << indent << "UseImageDirection = " << (this->m_UseImageDirection ? "On" : "Off") << std::endl;
+  os << indent << "OrderOfAccuracy: " << this->m_OrderOfAccuracy << std::endl;
+  os << indent << "IntensityDifferenceThreshold: " << this->m_IntensityDifferenceThreshold << std::endl;
+  os << indent << "DenominatorThreshold: " << this->m_DenominatorThreshold << std::endl;
+}
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,184 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateTotalVariationImageFilter_h
+#define itkHigherOrderAccurateTotalVariationImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkHigherOrderAccurateDerivativeOperator.h"
+#include "itkHigherOrderAccurateLineDerivative.h"
+
+namespace itk
+{
+
+/** \class HigherOrderAccurateTotalVariationImageFilter
+ *
+ * \brief Total variation denoising with the Chambolle-Pock primal-dual
+ * algorithm on the higher order accurate gradient.
+ *
+ * The output minimizes the Rudin-Osher-Fatemi energy
+ *
+ * \f[
+ *   \sum_x |G u|(x) + \frac{\lambda}{2} \sum_x (u(x) - f(x))^2
+ * \f]
+ *
+ * where f is the input, \f$\lambda\f$ is the Lambda parameter and G is the
+ * gradient computed with the HigherOrderAccurateDerivativeOperator, with zero
+ * flux Neumann boundary conditions.  The divergence used by the solver is
+ * the exact negative adjoint of G, boundary included, so the iterations
+ * converge for the step sizes \f$\tau = \sigma = 0.99 / L\f$ where L is an
+ * upper bound of the norm of G.
+ *
+ * Every iteration makes two multithreaded sweeps over the image.  The first
+ * computes the gradient of the extrapolated primal variable and applies the
+ * dual ascent step and the projection onto the unit ball in the same pass.
+ * The second computes the divergence of the dual variable and applies the
+ * primal proximal step and the extrapolation.  No intermediate gradient or
+ * divergence image is stored.  The dual variable is kept as one single
+ * precision array per component.
+ *
+ * \sa HigherOrderAccurateGradientImageFilter
+ * \sa HigherOrderAccurateDerivativeOperator
+ *
+ * \ingroup HigherOrderAccurateGradient
+ */
+template <typename TInputImage, typename TOperatorValueType = float, typename TOutputValueType = float>
+class HigherOrderAccurateTotalVariationImageFilter
+  : public ImageToImageFilter<TInputImage, Image<TOutputValueType, TInputImage::ImageDimension>>
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(HigherOrderAccurateTotalVariationImageFilter);
+
+  /** Extract dimension from input image. */
+  static constexpr unsigned int ImageDimension = TInputImage::ImageDimension;
+
+  /** Standard class type alias. */
+  using Self = HigherOrderAccurateTotalVariationImageFilter;
+
+  /** Convenient type alias for simplifying declarations. */
+  using InputImageType = TInputImage;
+  using InputImagePointer = typename InputImageType::Pointer;
+  using OutputImageType = Image<TOutputValueType, ImageDimension>;
+  using OutputImagePointer = typename OutputImageType::Pointer;
+
+  /** Standard class type alias. */
+  using Superclass = ImageToImageFilter<InputImageType, OutputImageType>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(HigherOrderAccurateTotalVariationImageFilter, ImageToImageFilter);
+
+  /** Image type alias support. */
+  using InputPixelType = typename InputImageType::PixelType;
+  using OperatorValueType = TOperatorValueType;
+  using OutputValueType = TOutputValueType;
+  using OutputImageRegionType = typename OutputImageType::RegionType;
+  using LineDerivativeType = HigherOrderAccurateLineDerivative<ImageDimension>;
+
+  /** Set/Get whether or not the filter will use the spacing of the input
+      image in its calculations */
+  itkSetMacro(UseImageSpacing, bool);
+  itkGetConstMacro(UseImageSpacing, bool);
+  itkBooleanMacro(UseImageSpacing);
+
+  /** Set/Get the order of accuracy of the derivative operator.  For more
+   * information, see HigherOrderAccurateDerivativeOperator. */
+  itkSetMacro(OrderOfAccuracy, unsigned int);
+  itkGetConstMacro(OrderOfAccuracy, unsigned int);
+
+  /** Set/Get the weight of the data term.  Smaller values remove more
+   * variation.  Defaults to 1. */
+  itkSetMacro(Lambda, double);
+  itkGetConstMacro(Lambda, double);
+
+  /** Set/Get the number of primal-dual iterations.  Defaults to 100. */
+  itkSetMacro(NumberOfIterations, unsigned int);
+  itkGetConstMacro(NumberOfIterations, unsigned int);
+
+  /** Get the gradient G of the last update, whose negative adjoint is the
+   * divergence used by the solver. */
+  itkGetConstReferenceMacro(LineDerivative, LineDerivativeType);
+
+  /** Get the component along axis of the dual variable of the last update,
+   * laid out as the input buffer.  Its magnitude is at most one at every
+   * pixel. */
+  const std::vector<float> &
+  GetDual(unsigned int axis) const
+  {
+    return this->m_Dual[axis];
+  }
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  /** Begin concept checking */
+  itkConceptMacro(InputConvertibleToDoubleCheck, (Concept::Convertible<InputPixelType, double>));
+  itkConceptMacro(OutputHasNumericTraitsCheck, (Concept::HasNumericTraits<OutputValueType>));
+  /** End concept checking */
+#endif
+
+protected:
+  HigherOrderAccurateTotalVariationImageFilter() = default;
+  ~HigherOrderAccurateTotalVariationImageFilter() override = default;
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** The iterations propagate information across the whole image, so the
+   * whole input is requested.
+   *
+   * \sa ImageToImageFilter::GenerateInputRequestedRegion() */
+  void
+  GenerateInputRequestedRegion() override;
+
+  /** The whole output is produced. */
+  void
+  EnlargeOutputRequestedRegion(DataObject * output) override;
+
+  /** Run the iterations, each of which is made of two multithreaded
+   * sweeps. */
+  void
+  GenerateData() override;
+
+private:
+  using IndexType = typename InputImageType::IndexType;
+  using RegionType = typename InputImageType::RegionType;
+  using OperatorType = HigherOrderAccurateDerivativeOperator<OperatorValueType, ImageDimension>;
+
+  bool m_UseImageSpacing{ true };
+
+  unsigned int m_OrderOfAccuracy{ 2 };
+
+  double m_Lambda{ 1.0 };
+
+  unsigned int m_NumberOfIterations{ 100 };
+
+  /** Derivative along each axis, and its adjoint, on the input buffer. */
+  LineDerivativeType m_LineDerivative;
+
+  /** Components of the dual variable, in single precision. */
+  std::vector<float> m_Dual[ImageDimension];
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkHigherOrderAccurateTotalVariationImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,221 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateTotalVariationImageFilter_hxx
+#define itkHigherOrderAccurateTotalVariationImageFilter_hxx
+#include "itkHigherOrderAccurateTotalVariationImageFilter.h"
+
+#include "itkImageRegionConstIteratorWithOnlyIndex.h"
+#include "itkHigherOrderAccurateDerivativeOperator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace itk
+{
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateTotalVariationImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  GenerateInputRequestedRegion()
+{
+  // call the superclass' implementation of this method
+  Superclass::GenerateInputRequestedRegion();
+
+  InputImagePointer inputPtr = const_cast<InputImageType *>(this->GetInput());
+  if (inputPtr)
+  {
+    inputPtr->SetRequestedRegionToLargestPossibleRegion();
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateTotalVariationImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  EnlargeOutputRequestedRegion(DataObject * output)
+{
+  Superclass::EnlargeOutputRequestedRegion(output);
+  output->SetRequestedRegionToLargestPossibleRegion();
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateTotalVariationImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::GenerateData()
+{
+  this->AllocateOutputs();
+
+  const InputImageType * input = this->GetInput();
+  OutputImageType *      output = this->GetOutput();
+  const RegionType       region = input->GetBufferedRegion();
+
+  if (this->m_Lambda <= 0.0)
+  {
+    itkExceptionMacro(<< "Lambda must be positive.");
+  }
+
+  // The squared norm of the gradient is bounded by the sum over the axes of
+  // the products of the largest row and column sums of the absolute values
+  // of the one dimensional operators, boundary rows included.
+  double squaredNormBound = 0.0;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    const std::vector<double> coefficients = OperatorType::ComputeSpacedCoefficients(
+      1, this->m_OrderOfAccuracy, this->m_UseImageSpacing ? input->GetSpacing()[i] : 1.0);
+
+    const auto          radius = static_cast<OffsetValueType>(coefficients.size() / 2);
+    const auto          length = static_cast<OffsetValueType>(region.GetSize(i));
+    double              rowSum = 0.0;
+    std::vector<double> columnSums(length, 0.0);
+    for (OffsetValueType k = -radius; k <= radius; ++k)
+    {
+      rowSum += std::abs(coefficients[k + radius]);
+      for (OffsetValueType x = 0; x < length; ++x)
+      {
+        columnSums[std::min(std::max(x + k, OffsetValueType{ 0 }), length - 1)] += std::abs(coefficients[k + radius]);
+      }
+    }
+    squaredNormBound += rowSum * *std::max_element(columnSums.begin(), columnSums.end());
+    this->m_LineDerivative.SetCoefficients(i, coefficients);
+  }
+  this->m_LineDerivative.SetBufferedRegion(region);
+  const double stepSize = 0.99 / std::sqrt(squaredNormBound);
+  const double lambdaStep = this->m_Lambda * stepSize;
+
+  // The primal variable, its extrapolation and the components of the dual
+  // variable are laid out as the input buffer.
+  const SizeValueType    numberOfPixels = region.GetNumberOfPixels();
+  const InputPixelType * inputBuffer = input->GetBufferPointer();
+  std::vector<double>    primal(numberOfPixels);
+  for (SizeValueType n = 0; n < numberOfPixels; ++n)
+  {
+    primal[n] = static_cast<double>(inputBuffer[n]);
+  }
+  std::vector<double> extrapolated = primal;
+  for (auto & component : this->m_Dual)
+  {
+    component.assign(numberOfPixels, 0.0f);
+  }
+
+  this->GetMultiThreader()->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+
+  for (unsigned int iteration = 0; iteration < this->m_NumberOfIterations; ++iteration)
+  {
+    // Dual ascent on the gradient of the extrapolation, then projection onto
+    // the unit ball.
+    this->GetMultiThreader()->template ParallelizeImageRegion<ImageDimension>(
+      region,
+      [this, input, stepSize, &extrapolated](const RegionType & piece) {
+        const SizeValueType lineLength = piece.GetSize(0);
+        std::vector<double> gradient(ImageDimension * lineLength);
+
+        RegionType lineStartRegion = piece;
+        lineStartRegion.SetSize(0, 1);
+        for (ImageRegionConstIteratorWithOnlyIndex<InputImageType> lineIt(input, lineStartRegion); !lineIt.IsAtEnd();
+             ++lineIt)
+        {
+          const IndexType lineStart = lineIt.GetIndex();
+          const auto      lineOffset = static_cast<SizeValueType>(input->ComputeOffset(lineStart));
+          std::fill(gradient.begin(), gradient.end(), 0.0);
+          for (unsigned int i = 0; i < ImageDimension; ++i)
+          {
+            this->m_LineDerivative.AccumulateDerivative(
+              extrapolated.data(), i, lineStart, lineLength, gradient.data() + i * lineLength);
+          }
+
+          for (SizeValueType x = 0; x < lineLength; ++x)
+          {
+            double squaredMagnitude = 0.0;
+            for (unsigned int i = 0; i < ImageDimension; ++i)
+            {
+              double & ascent = gradient[i * lineLength + x];
+              ascent = this->m_Dual[i][lineOffset + x] + stepSize * ascent;
+              squaredMagnitude += ascent * ascent;
+            }
+            const double scale = 1.0 / std::max(1.0, std::sqrt(squaredMagnitude));
+            for (unsigned int i = 0; i < ImageDimension; ++i)
+            {
+              this->m_Dual[i][lineOffset + x] = static_cast<float>(scale * gradient[i * lineLength + x]);
+            }
+          }
+        }
+      },
+      nullptr);
+
+    // Proximal step of the data term on the divergence of the dual variable,
+    // then extrapolation.
+    this->GetMultiThreader()->template ParallelizeImageRegion<ImageDimension>(
+      region,
+      [this, input, inputBuffer, stepSize, lambdaStep, &primal, &extrapolated](const RegionType & piece) {
+        const SizeValueType lineLength = piece.GetSize(0);
+        std::vector<double> adjoint(lineLength);
+
+        RegionType lineStartRegion = piece;
+        lineStartRegion.SetSize(0, 1);
+        for (ImageRegionConstIteratorWithOnlyIndex<InputImageType> lineIt(input, lineStartRegion); !lineIt.IsAtEnd();
+             ++lineIt)
+        {
+          const IndexType lineStart = lineIt.GetIndex();
+          const auto      lineOffset = static_cast<SizeValueType>(input->ComputeOffset(lineStart));
+          std::fill(adjoint.begin(), adjoint.end(), 0.0);
+          for (unsigned int i = 0; i < ImageDimension; ++i)
+          {
+            this->m_LineDerivative.AccumulateAdjoint(this->m_Dual[i].data(), i, lineStart, lineLength, adjoint.data());
+          }
+
+          for (SizeValueType x = 0; x < lineLength; ++x)
+          {
+            const SizeValueType n = lineOffset + x;
+            const double        previous = primal[n];
+            const double        data = static_cast<double>(inputBuffer[n]);
+            const double        updated = (previous - stepSize * adjoint[x] + lambdaStep * data) / (1.0 + lambdaStep);
+            primal[n] = updated;
+            extrapolated[n] = 2.0 * updated - previous;
+          }
+        }
+      },
+      nullptr);
+
+    this->UpdateProgress(static_cast<float>(iteration + 1) / this->m_NumberOfIterations);
+  }
+
+  OutputValueType * outputBuffer = output->GetBufferPointer();
+  for (SizeValueType n = 0; n < numberOfPixels; ++n)
+  {
+    outputBuffer[n] = static_cast<OutputValueType>(primal[n]);
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateTotalVariationImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::PrintSelf(
+  std::ostream & os,
+  Indent         indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "UseImageSpacing: " << (this->m_UseImageSpacing ? "On" : "Off") << std::endl;
+  os << indent << "OrderOfAccuracy: " << this->m_OrderOfAccuracy << std::endl;
+  os << indent << "Lambda: " << this->m_Lambda << std::endl;
+  os << indent << "NumberOfIterations: " << this->m_NumberOfIterations << std::endl;
+}
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,175 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateVectorGradientImageFilter_h
+#define itkHigherOrderAccurateVectorGradientImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkVectorImage.h"
+
+namespace itk
+{
+
+/** \class HigherOrderAccurateVectorGradientImageFilter
+ *
+ * \brief Calculate the gradient of every channel of a multi-component image
+ * with a higher order accurate central-difference derivative kernel.
+ *
+ * The input may be a VectorImage, an Image of RGBPixel, Vector or any other
+ * pixel type whose components are stored contiguously, or a scalar Image.
+ * All channels are differentiated in a single traversal of the input.
+ *
+ * By default the output is a VectorImage with ImageDimension times
+ * NumberOfComponentsPerPixel components.  The gradient of channel c occupies
+ * components c * ImageDimension through c * ImageDimension + ImageDimension - 1.
+ *
+ * When UseDiZenzoGradient is enabled, the channel gradients are instead
+ * combined into the Di Zenzo color gradient and the output has ImageDimension
+ * components.  The Di Zenzo gradient points along the principal eigenvector of
+ * the structure tensor \f$ \sum_c \nabla I_c \nabla I_c^T \f$ and its magnitude
+ * is the square root of the largest eigenvalue.  The sign of the eigenvector is
+ * chosen so that it agrees with the sum of the channel gradients.
+ *
+ * Di Zenzo, S. "A note on the gradient of a multi-image." Computer Vision,
+ * Graphics, and Image Processing.  vol 33.  p. 116-125.  1986.
+ *
+ * Interior scanlines are processed as one contiguous run of
+ * pixels times channels per stencil tap, so the inner loop vectorizes
+ * regardless of the number of channels.
+ *
+ * \sa HigherOrderAccurateGradientImageFilter
+ * \sa HigherOrderAccurateDerivativeOperator
+ *
+ * \ingroup GradientFilters
+ * \ingroup HigherOrderAccurateGradient
+ */
+template <typename TInputImage, typename TOperatorValueType = float, typename TOutputValueType = float>
+class HigherOrderAccurateVectorGradientImageFilter
+  : public ImageToImageFilter<TInputImage, VectorImage<TOutputValueType, TInputImage::ImageDimension>>
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(HigherOrderAccurateVectorGradientImageFilter);
+
+  /** Extract dimension from input image. */
+  static constexpr unsigned int ImageDimension = TInputImage::ImageDimension;
+
+  /** Standard class type alias. */
+  using Self = HigherOrderAccurateVectorGradientImageFilter;
+
+  /** Convenient type alias for simplifying declarations. */
+  using InputImageType = TInputImage;
+  using InputImagePointer = typename InputImageType::Pointer;
+  using OutputImageType = VectorImage<TOutputValueType, ImageDimension>;
+  using OutputImagePointer = typename OutputImageType::Pointer;
+
+  /** Standard class type alias. */
+  using Superclass = ImageToImageFilter<InputImageType, OutputImageType>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(HigherOrderAccurateVectorGradientImageFilter, ImageToImageFilter);
+
+  /** Image type alias support. */
+  using InputPixelType = typename InputImageType::PixelType;
+  using InputComponentType = typename NumericTraits<InputPixelType>::ValueType;
+  using OperatorValueType = TOperatorValueType;
+  using OutputValueType = TOutputValueType;
+  using OutputPixelType = typename OutputImageType::PixelType;
+  using OutputImageRegionType = typename OutputImageType::RegionType;
+
+  /** Set/Get whether or not the filter will use the spacing of the input
+      image in its calculations */
+  itkSetMacro(UseImageSpacing, bool);
+  itkGetConstMacro(UseImageSpacing, bool);
+  itkBooleanMacro(UseImageSpacing);
+
+  /** Set/Get whether the derivatives are computed with respect to the
+   * physical coordinate system (On) or the image grid (Off).  The default
+   * value of this flag is On. */
+  itkSetMacro(UseImageDirection, bool);
+  itkGetConstMacro(UseImageDirection, bool);
+  itkBooleanMacro(UseImageDirection);
+
+  /** Set/Get whether to output the combined Di Zenzo color gradient instead of
+   * the per-channel gradients.  The default value of this flag is Off. */
+  itkSetMacro(UseDiZenzoGradient, bool);
+  itkGetConstMacro(UseDiZenzoGradient, bool);
+  itkBooleanMacro(UseDiZenzoGradient);
+
+  /** Set/Get the order of accuracy of the derivative operator.  For more
+   * information, see HigherOrderAccurateDerivativeOperator. */
+  itkSetMacro(OrderOfAccuracy, unsigned int);
+  itkGetConstMacro(OrderOfAccuracy, unsigned int);
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  /** Begin concept checking */
+  itkConceptMacro(InputConvertibleToOutputCheck, (Concept::Convertible<InputComponentType, OutputValueType>));
+  itkConceptMacro(OutputHasNumericTraitsCheck, (Concept::HasNumericTraits<OutputValueType>));
+  /** End concept checking */
+#endif
+
+protected:
+  HigherOrderAccurateVectorGradientImageFilter() = default;
+  ~HigherOrderAccurateVectorGradientImageFilter() override = default;
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** The number of output components depends on the number of input
+   * components and on UseDiZenzoGradient. */
+  void
+  GenerateOutputInformation() override;
+
+  /** The input requested region is padded by the operator radius.
+   *
+   * \sa ImageToImageFilter::GenerateInputRequestedRegion() */
+  void
+  GenerateInputRequestedRegion() override;
+
+  void
+  DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread) override;
+
+private:
+  using DirectionType = typename InputImageType::DirectionType;
+
+  /** Write the accumulated derivatives of a run of pixels to the output. */
+  void
+  WriteLine(const std::vector<OutputValueType> * derivatives,
+            SizeValueType                        numberOfPixels,
+            unsigned int                         numberOfChannels,
+            const DirectionType &                direction,
+            OutputValueType *                    outputLine) const;
+
+  bool m_UseImageSpacing{ true };
+
+  bool m_UseImageDirection{ true };
+
+  bool m_UseDiZenzoGradient{ false };
+
+  unsigned int m_OrderOfAccuracy{ 2 };
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkHigherOrderAccurateVectorGradientImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,363 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateVectorGradientImageFilter_hxx
+#define itkHigherOrderAccurateVectorGradientImageFilter_hxx
+#include "itkHigherOrderAccurateVectorGradientImageFilter.h"
+
+#include "itkImageRegionConstIteratorWithOnlyIndex.h"
+#include "itkHigherOrderAccurateDerivativeOperator.h"
+#include "itkNeighborhoodAlgorithm.h"
+#include "itkSymmetricSecondRankTensor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace itk
+{
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateVectorGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  GenerateOutputInformation()
+{
+  Superclass::GenerateOutputInformation();
+
+  OutputImageType *      outputPtr = this->GetOutput();
+  const InputImageType * inputPtr = this->GetInput();
+
+  if (!inputPtr || !outputPtr)
+  {
+    return;
+  }
+
+  if (this->m_UseDiZenzoGradient)
+  {
+    outputPtr->SetNumberOfComponentsPerPixel(ImageDimension);
+  }
+  else
+  {
+    outputPtr->SetNumberOfComponentsPerPixel(ImageDimension * inputPtr->GetNumberOfComponentsPerPixel());
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateVectorGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  GenerateInputRequestedRegion()
+{
+  // call the superclass' implementation of this method
+  Superclass::GenerateInputRequestedRegion();
+
+  // get pointers to the input and output
+  InputImagePointer  inputPtr = const_cast<InputImageType *>(this->GetInput());
+  OutputImagePointer outputPtr = this->GetOutput();
+
+  if (!inputPtr || !outputPtr)
+  {
+    return;
+  }
+
+  // Build an operator so that we can determine the kernel size
+  HigherOrderAccurateDerivativeOperator<OperatorValueType, ImageDimension> oper;
+  oper.SetDirection(0);
+  oper.SetOrder(1);
+  oper.SetOrderOfAccuracy(this->m_OrderOfAccuracy);
+  oper.CreateDirectional();
+  unsigned long radius = oper.GetRadius()[0];
+
+  // get a copy of the input requested region (should equal the output
+  // requested region)
+  typename TInputImage::RegionType inputRequestedRegion;
+  inputRequestedRegion = inputPtr->GetRequestedRegion();
+
+  // pad the input requested region by the operator radius
+  inputRequestedRegion.PadByRadius(radius);
+
+  // crop the input requested region at the input's largest possible region
+  if (inputRequestedRegion.Crop(inputPtr->GetLargestPossibleRegion()))
+  {
+    inputPtr->SetRequestedRegion(inputRequestedRegion);
+    return;
+  }
+  else
+  {
+    // Couldn't crop the region (requested region is outside the largest
+    // possible region).  Throw an exception.
+
+    // store what we tried to request (prior to trying to crop)
+    inputPtr->SetRequestedRegion(inputRequestedRegion);
+
+    // build an exception
+    InvalidRequestedRegionError e(__FILE__, __LINE__);
+    e.SetLocation(ITK_LOCATION);
+    e.SetDescription("Requested region is (at least partially) outside the largest possible region.");
+    e.SetDataObject(inputPtr);
+    throw e;
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateVectorGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::
+  DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread)
+{
+  using IndexType = typename InputImageType::IndexType;
+  using RegionType = typename InputImageType::RegionType;
+
+  OutputImageType *      outputImage = this->GetOutput();
+  const InputImageType * inputImage = this->GetInput();
+
+  const unsigned int numberOfChannels = inputImage->GetNumberOfComponentsPerPixel();
+  const unsigned int numberOfOutputComponents = outputImage->GetNumberOfComponentsPerPixel();
+
+  // Set up operators
+  using OperatorType = HigherOrderAccurateDerivativeOperator<OperatorValueType, ImageDimension>;
+  std::vector<double> coefficients[ImageDimension];
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    coefficients[i] = OperatorType::ComputeSpacedCoefficients(
+      1, this->m_OrderOfAccuracy, this->m_UseImageSpacing ? inputImage->GetSpacing()[i] : 1.0);
+  }
+
+  const auto radius = static_cast<OffsetValueType>(coefficients[0].size() / 2);
+
+  Size<ImageDimension> radiusSize;
+  radiusSize.Fill(radius);
+
+  // Find the data-set boundary "faces".
+  typename NeighborhoodAlgorithm::ImageBoundaryFacesCalculator<InputImageType>::FaceListType faceList;
+  NeighborhoodAlgorithm::ImageBoundaryFacesCalculator<InputImageType>                        bC;
+  faceList = bC(inputImage, outputRegionForThread, radiusSize);
+
+  const auto *            inputBuffer = reinterpret_cast<const InputComponentType *>(inputImage->GetBufferPointer());
+  const OffsetValueType * offsetTable = inputImage->GetOffsetTable();
+  const RegionType &      bufferedRegion = inputImage->GetBufferedRegion();
+  OutputValueType *       outputBuffer = outputImage->GetBufferPointer();
+  const DirectionType &   direction = inputImage->GetDirection();
+
+  // The derivatives along each axis for one scanline, stored pixel by pixel
+  // with the channels of a pixel contiguous, like the input.
+  const SizeValueType          maximumLineLength = outputRegionForThread.GetSize(0);
+  std::vector<OutputValueType> derivatives[ImageDimension];
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    derivatives[i].resize(maximumLineLength * numberOfChannels);
+  }
+
+  for (const auto & face : faceList)
+  {
+    if (face.GetNumberOfPixels() == 0)
+    {
+      continue;
+    }
+
+    // On the non-boundary face every tap of the stencil is in the buffer.
+    RegionType paddedFace = face;
+    paddedFace.PadByRadius(radiusSize);
+    const bool interiorFace = bufferedRegion.IsInside(paddedFace);
+
+    const SizeValueType lineLength = face.GetSize(0);
+    const SizeValueType runLength = lineLength * numberOfChannels;
+
+    OutputImageRegionType lineStartRegion = face;
+    lineStartRegion.SetSize(0, 1);
+
+    for (ImageRegionConstIteratorWithOnlyIndex<OutputImageType> lineIt(outputImage, lineStartRegion);
+         !lineIt.IsAtEnd();
+         ++lineIt)
+    {
+      const IndexType lineStart = lineIt.GetIndex();
+
+      for (unsigned int i = 0; i < ImageDimension; ++i)
+      {
+        std::fill(
+          derivatives[i].begin(), derivatives[i].begin() + runLength, NumericTraits<OutputValueType>::ZeroValue());
+      }
+
+      if (interiorFace)
+      {
+        // All taps are in the buffer, and the pixels and channels under each
+        // tap form one contiguous run.
+        const InputComponentType * center = inputBuffer + inputImage->ComputeOffset(lineStart) * numberOfChannels;
+        for (unsigned int i = 0; i < ImageDimension; ++i)
+        {
+          OutputValueType * derivative = derivatives[i].data();
+          for (OffsetValueType k = -radius; k <= radius; ++k)
+          {
+            if (k == 0)
+            {
+              continue;
+            }
+            const auto                 weight = static_cast<OutputValueType>(coefficients[i][k + radius]);
+            const InputComponentType * tap = center + k * offsetTable[i] * numberOfChannels;
+            for (SizeValueType j = 0; j < runLength; ++j)
+            {
+              derivative[j] += weight * static_cast<OutputValueType>(tap[j]);
+            }
+          }
+        }
+      }
+      else
+      {
+        // Zero flux Neumann boundary condition: clamp the taps to the buffer.
+        IndexType index = lineStart;
+        for (SizeValueType x = 0; x < lineLength; ++x, ++index[0])
+        {
+          for (unsigned int i = 0; i < ImageDimension; ++i)
+          {
+            const OffsetValueType first = bufferedRegion.GetIndex(i);
+            const OffsetValueType last = first + static_cast<OffsetValueType>(bufferedRegion.GetSize(i)) - 1;
+            OutputValueType *     derivative = derivatives[i].data() + x * numberOfChannels;
+            IndexType             tapIndex = index;
+            OperatorType::AccumulateClampedTaps(
+              coefficients[i], index[i], first, last, [&](double weight, OffsetValueType shift) {
+                tapIndex[i] = index[i] + shift;
+                const InputComponentType * tap = inputBuffer + inputImage->ComputeOffset(tapIndex) * numberOfChannels;
+                for (unsigned int c = 0; c < numberOfChannels; ++c)
+                {
+                  derivative[c] += static_cast<OutputValueType>(weight) * static_cast<OutputValueType>(tap[c]);
+                }
+              });
+          }
+        }
+      }
+
+      this->WriteLine(derivatives,
+                      lineLength,
+                      numberOfChannels,
+                      direction,
+                      outputBuffer + outputImage->ComputeOffset(lineStart) * numberOfOutputComponents);
+    }
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateVectorGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::WriteLine(
+  const std::vector<OutputValueType> * derivatives,
+  SizeValueType                        numberOfPixels,
+  unsigned int                         numberOfChannels,
+  const DirectionType &                direction,
+  OutputValueType *                    outputLine) const
+{
+  if (!this->m_UseDiZenzoGradient)
+  {
+    const unsigned int numberOfOutputComponents = ImageDimension * numberOfChannels;
+    for (SizeValueType x = 0; x < numberOfPixels; ++x)
+    {
+      OutputValueType * outputPixel = outputLine + x * numberOfOutputComponents;
+      for (unsigned int c = 0; c < numberOfChannels; ++c)
+      {
+        const SizeValueType j = x * numberOfChannels + c;
+        for (unsigned int i = 0; i < ImageDimension; ++i)
+        {
+          if (this->m_UseImageDirection)
+          {
+            double sum = 0.0;
+            for (unsigned int k = 0; k < ImageDimension; ++k)
+            {
+              sum += direction[i][k] * derivatives[k][j];
+            }
+            outputPixel[c * ImageDimension + i] = static_cast<OutputValueType>(sum);
+          }
+          else
+          {
+            outputPixel[c * ImageDimension + i] = derivatives[i][j];
+          }
+        }
+      }
+    }
+    return;
+  }
+
+  using TensorType = SymmetricSecondRankTensor<double, ImageDimension>;
+  typename TensorType::EigenValuesArrayType   eigenValues;
+  typename TensorType::EigenVectorsMatrixType eigenVectors;
+
+  for (SizeValueType x = 0; x < numberOfPixels; ++x)
+  {
+    TensorType                         tensor;
+    FixedArray<double, ImageDimension> gradientSum;
+    tensor.Fill(0.0);
+    gradientSum.Fill(0.0);
+    for (unsigned int c = 0; c < numberOfChannels; ++c)
+    {
+      const SizeValueType j = x * numberOfChannels + c;
+      for (unsigned int i = 0; i < ImageDimension; ++i)
+      {
+        gradientSum[i] += derivatives[i][j];
+        for (unsigned int k = i; k < ImageDimension; ++k)
+        {
+          tensor(i, k) += static_cast<double>(derivatives[i][j]) * derivatives[k][j];
+        }
+      }
+    }
+
+    // The eigenvalues are sorted in ascending order and the eigenvectors
+    // are the rows of the matrix.
+    tensor.ComputeEigenAnalysis(eigenValues, eigenVectors);
+    const double magnitude = std::sqrt(std::max(eigenValues[ImageDimension - 1], 0.0));
+
+    double agreement = 0.0;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      agreement += eigenVectors[ImageDimension - 1][i] * gradientSum[i];
+    }
+    const double scale = agreement < 0.0 ? -magnitude : magnitude;
+
+    OutputValueType * outputPixel = outputLine + x * ImageDimension;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      if (this->m_UseImageDirection)
+      {
+        double sum = 0.0;
+        for (unsigned int k = 0; k < ImageDimension; ++k)
+        {
+          sum += direction[i][k] * eigenVectors[ImageDimension - 1][k];
+        }
+        outputPixel[i] = static_cast<OutputValueType>(scale * sum);
+      }
+      else
+      {
+        outputPixel[i] = static_cast<OutputValueType>(scale * eigenVectors[ImageDimension - 1][i]);
+      }
+    }
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType>
+void
+HigherOrderAccurateVectorGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType>::PrintSelf(
+  std::ostream & os,
+  Indent         indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "UseImageSpacing: " << (this->m_UseImageSpacing ? "On" : "Off") << std::endl;
+  os << indent << "UseImageDirection = " << (this->m_UseImageDirection ? "On" : "Off") << std::endl;
+  os << indent << "UseDiZenzoGradient: " << (this->m_UseDiZenzoGradient ? "On" : "Off") << std::endl;
+  os << indent << "OrderOfAccuracy: " << this->m_OrderOfAccuracy << std::endl;
+}
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,228 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateWarpedGradientImageFilter_h
+#define itkHigherOrderAccurateWarpedGradientImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkCovariantVector.h"
+#include "itkDataObjectDecorator.h"
+#include "itkTransform.h"
+#include "itkHigherOrderAccurateDerivativeOperator.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class HigherOrderAccurateWarpedGradientImageFilter
+ *
+ * \brief Sample the higher order accurate gradient of a moving image at the
+ * positions given by a transform, without resampling the moving image.
+ *
+ * For every output pixel at physical point x, the output is the gradient of
+ * the input (moving) image at T(x), where T is the Transform.  The gradient is
+ * computed on the moving grid with the HigherOrderAccurateDerivativeOperator
+ * and linearly interpolated at the continuous index of T(x).  Points that map
+ * outside of the moving image are set to zero.
+ *
+ * The moving gradient is only evaluated where it is needed.  Each work unit
+ * computes the gradient in tiles of TileSize pixels on demand and keeps up to
+ * MaximumNumberOfCachedTiles of them, evicting the least recently used one, so
+ * neither the warped image nor the full moving gradient image is stored.
+ *
+ * When UseTransformJacobian is enabled, the output is the gradient of the
+ * warped image, moving o T, by the chain rule, J_T(x)^T (grad M)(T(x)).
+ * A displacement field can be used through a DisplacementFieldTransform.
+ *
+ * The output grid is the one of the ReferenceImage, when it is set, and the one
+ * of the input image otherwise.
+ *
+ * \sa HigherOrderAccurateGradientImageFilter
+ * \sa ResampleImageFilter
+ *
+ * \ingroup GradientFilters
+ * \ingroup HigherOrderAccurateGradient
+ */
+template <typename TInputImage,
+          typename TOperatorValueType = float,
+          typename TOutputValueType = float,
+          typename TTransformPrecisionType = double>
+class HigherOrderAccurateWarpedGradientImageFilter
+  : public ImageToImageFilter<
+      TInputImage,
+      Image<CovariantVector<TOutputValueType, TInputImage::ImageDimension>, TInputImage::ImageDimension>>
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(HigherOrderAccurateWarpedGradientImageFilter);
+
+  /** Extract dimension from input image. */
+  static constexpr unsigned int ImageDimension = TInputImage::ImageDimension;
+
+  /** Standard class type alias. */
+  using Self = HigherOrderAccurateWarpedGradientImageFilter;
+
+  /** Convenient type alias for simplifying declarations. */
+  using InputImageType = TInputImage;
+  using InputImagePointer = typename InputImageType::Pointer;
+  using OutputImageType = Image<CovariantVector<TOutputValueType, ImageDimension>, ImageDimension>;
+  using OutputImagePointer = typename OutputImageType::Pointer;
+
+  /** Standard class type alias. */
+  using Superclass = ImageToImageFilter<InputImageType, OutputImageType>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(HigherOrderAccurateWarpedGradientImageFilter, ImageToImageFilter);
+
+  /** Image type alias support. */
+  using InputPixelType = typename InputImageType::PixelType;
+  using OperatorValueType = TOperatorValueType;
+  using OutputValueType = TOutputValueType;
+  using OutputPixelType = CovariantVector<OutputValueType, ImageDimension>;
+  using OutputImageRegionType = typename OutputImageType::RegionType;
+  using SizeType = typename InputImageType::SizeType;
+
+  /** Transform type alias. */
+  using TransformPrecisionType = TTransformPrecisionType;
+  using TransformType = Transform<TransformPrecisionType, ImageDimension, ImageDimension>;
+  using DecoratedTransformType = DataObjectDecorator<TransformType>;
+
+  /** Image type defining the output grid. */
+  using ReferenceImageBaseType = ImageBase<ImageDimension>;
+
+  /** Set/Get the transform that maps output points to points of the input
+   * image.  Defaults to the identity. */
+  itkSetGetDecoratedObjectInputMacro(Transform, TransformType);
+
+  /** Set/Get the image defining the output grid. */
+  itkSetInputMacro(ReferenceImage, ReferenceImageBaseType);
+  itkGetInputMacro(ReferenceImage, ReferenceImageBaseType);
+
+  /** Set/Get whether or not the filter will use the spacing of the input
+      image in its calculations */
+  itkSetMacro(UseImageSpacing, bool);
+  itkGetConstMacro(UseImageSpacing, bool);
+  itkBooleanMacro(UseImageSpacing);
+
+  /** Set/Get whether the derivatives are computed with respect to the
+   * physical coordinate system (On) or the image grid (Off).  The default
+   * value of this flag is On. */
+  itkSetMacro(UseImageDirection, bool);
+  itkGetConstMacro(UseImageDirection, bool);
+  itkBooleanMacro(UseImageDirection);
+
+  /** Set/Get whether the sampled gradient is multiplied by the transposed
+   * Jacobian of the transform, which yields the gradient of the warped image.
+   * The default value of this flag is Off. */
+  itkSetMacro(UseTransformJacobian, bool);
+  itkGetConstMacro(UseTransformJacobian, bool);
+  itkBooleanMacro(UseTransformJacobian);
+
+  /** Set/Get the order of accuracy of the derivative operator.  For more
+   * information, see HigherOrderAccurateDerivativeOperator. */
+  itkSetMacro(OrderOfAccuracy, unsigned int);
+  itkGetConstMacro(OrderOfAccuracy, unsigned int);
+
+  /** Set/Get the size of the tiles in which the gradient of the input is
+   * computed.  Defaults to 16 pixels along each axis. */
+  itkSetMacro(TileSize, SizeType);
+  itkGetConstReferenceMacro(TileSize, SizeType);
+
+  /** Set/Get the number of gradient tiles kept by each work unit. */
+  itkSetMacro(MaximumNumberOfCachedTiles, SizeValueType);
+  itkGetConstMacro(MaximumNumberOfCachedTiles, SizeValueType);
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  /** Begin concept checking */
+  itkConceptMacro(InputConvertibleToDoubleCheck, (Concept::Convertible<InputPixelType, double>));
+  itkConceptMacro(OutputHasNumericTraitsCheck, (Concept::HasNumericTraits<OutputValueType>));
+  /** End concept checking */
+#endif
+
+protected:
+  HigherOrderAccurateWarpedGradientImageFilter();
+  ~HigherOrderAccurateWarpedGradientImageFilter() override = default;
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** The output grid is taken from the ReferenceImage when it is set. */
+  void
+  GenerateOutputInformation() override;
+
+  /** The warped positions are not known in advance, so the whole input is
+   * requested. */
+  void
+  GenerateInputRequestedRegion() override;
+
+  /** The input and the reference image do not need to occupy the same
+   * physical space. */
+  void
+  VerifyInputInformation() ITKv5_CONST override
+  {}
+
+  /** Build the scaled derivative coefficients. */
+  void
+  BeforeThreadedGenerateData() override;
+
+  void
+  DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread) override;
+
+private:
+  using IndexType = typename InputImageType::IndexType;
+  using OperatorType = HigherOrderAccurateDerivativeOperator<OperatorValueType, ImageDimension>;
+
+  /** Gradient of the input, with respect to the grid, in a block of pixels. */
+  struct GradientTile
+  {
+    IndexType                    m_Index;
+    SizeType                     m_Size;
+    std::vector<OutputValueType> m_Gradient;
+    SizeValueType                m_LastUse{ 0 };
+  };
+
+  /** Compute the gradient of the input over the given tile. */
+  void
+  ComputeGradientTile(GradientTile & tile) const;
+
+  bool m_UseImageSpacing{ true };
+
+  bool m_UseImageDirection{ true };
+
+  bool m_UseTransformJacobian{ false };
+
+  unsigned int m_OrderOfAccuracy{ 2 };
+
+  SizeType m_TileSize;
+
+  SizeValueType m_MaximumNumberOfCachedTiles{ 64 };
+
+  /** Derivative coefficients along each axis, for the offsets -radius..radius. */
+  std::vector<double> m_Coefficients[ImageDimension];
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkHigherOrderAccurateWarpedGradientImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,359 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkHigherOrderAccurateWarpedGradientImageFilter_hxx
+#define itkHigherOrderAccurateWarpedGradientImageFilter_hxx
+#include "itkHigherOrderAccurateWarpedGradientImageFilter.h"
+
+#include "itkContinuousIndex.h"
+#include "itkIdentityTransform.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkHigherOrderAccurateDerivativeOperator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <utility>
+
+namespace itk
+{
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType, typename TTransformPrecisionType>
+HigherOrderAccurateWarpedGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType, TTransformPrecisionType>::
+  HigherOrderAccurateWarpedGradientImageFilter()
+{
+  // #1 "ReferenceImage" optional
+  this->AddOptionalInputName("ReferenceImage", 1);
+
+  // "Transform" required ( not numbered)
+  this->AddRequiredInputName("Transform");
+  this->SetTransform(IdentityTransform<TransformPrecisionType, ImageDimension>::New());
+
+  this->m_TileSize.Fill(16);
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType, typename TTransformPrecisionType>
+void
+HigherOrderAccurateWarpedGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType, TTransformPrecisionType>::
+  GenerateOutputInformation()
+{
+  // call the superclass' implementation of this method
+  Superclass::GenerateOutputInformation();
+
+  OutputImageType *              outputPtr = this->GetOutput();
+  const ReferenceImageBaseType * referenceImage = this->GetReferenceImage();
+  if (!outputPtr || !referenceImage)
+  {
+    return;
+  }
+
+  outputPtr->SetLargestPossibleRegion(referenceImage->GetLargestPossibleRegion());
+  outputPtr->SetSpacing(referenceImage->GetSpacing());
+  outputPtr->SetOrigin(referenceImage->GetOrigin());
+  outputPtr->SetDirection(referenceImage->GetDirection());
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType, typename TTransformPrecisionType>
+void
+HigherOrderAccurateWarpedGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType, TTransformPrecisionType>::
+  GenerateInputRequestedRegion()
+{
+  if (!this->GetInput())
+  {
+    return;
+  }
+
+  // The region of the input that the transform maps to is not known without
+  // transforming every output point, so the entire input is requested.
+  InputImagePointer inputPtr = const_cast<InputImageType *>(this->GetInput());
+  inputPtr->SetRequestedRegionToLargestPossibleRegion();
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType, typename TTransformPrecisionType>
+void
+HigherOrderAccurateWarpedGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType, TTransformPrecisionType>::
+  BeforeThreadedGenerateData()
+{
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    if (this->m_TileSize[i] == 0)
+    {
+      itkExceptionMacro(<< "TileSize cannot be zero.");
+    }
+  }
+
+  const InputImageType * inputImage = this->GetInput();
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    this->m_Coefficients[i] = OperatorType::ComputeSpacedCoefficients(
+      1, this->m_OrderOfAccuracy, this->m_UseImageSpacing ? inputImage->GetSpacing()[i] : 1.0);
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType, typename TTransformPrecisionType>
+void
+HigherOrderAccurateWarpedGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType, TTransformPrecisionType>::
+  ComputeGradientTile(GradientTile & tile) const
+{
+  const InputImageType *                      inputImage = this->GetInput();
+  const typename InputImageType::RegionType & bufferedRegion = inputImage->GetBufferedRegion();
+  const InputPixelType *                      buffer = inputImage->GetBufferPointer();
+  const OffsetValueType *                     offsetTable = inputImage->GetOffsetTable();
+
+  const SizeValueType numberOfPixels = tile.m_Size.CalculateProductOfElements();
+  tile.m_Gradient.resize(numberOfPixels * ImageDimension);
+
+  IndexType index = tile.m_Index;
+  for (SizeValueType n = 0; n < numberOfPixels; ++n)
+  {
+    const OffsetValueType pixelOffset = inputImage->ComputeOffset(index);
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      // Taps outside of the buffer are clamped to it, as with the
+      // ZeroFluxNeumannBoundaryCondition.
+      const IndexValueType first = bufferedRegion.GetIndex(i);
+      const IndexValueType last = first + static_cast<IndexValueType>(bufferedRegion.GetSize(i)) - 1;
+      double               sum = 0.0;
+      OperatorType::AccumulateClampedTaps(
+        this->m_Coefficients[i], index[i], first, last, [&](double weight, OffsetValueType shift) {
+          sum += weight * static_cast<double>(buffer[pixelOffset + shift * offsetTable[i]]);
+        });
+      tile.m_Gradient[n * ImageDimension + i] = static_cast<OutputValueType>(sum);
+    }
+
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      if (++index[i] < tile.m_Index[i] + static_cast<IndexValueType>(tile.m_Size[i]))
+      {
+        break;
+      }
+      index[i] = tile.m_Index[i];
+    }
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType, typename TTransformPrecisionType>
+void
+HigherOrderAccurateWarpedGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType, TTransformPrecisionType>::
+  DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread)
+{
+  const InputImageType * inputImage = this->GetInput();
+  OutputImageType *      outputImage = this->GetOutput();
+  const TransformType *  transform = this->GetTransform();
+
+  const typename InputImageType::RegionType & bufferedRegion = inputImage->GetBufferedRegion();
+  const IndexType &                           start = bufferedRegion.GetIndex();
+  const SizeType &                            size = bufferedRegion.GetSize();
+
+  // Tiles are numbered with the first axis varying fastest.
+  SizeValueType tileStride[ImageDimension];
+  SizeValueType numberOfTiles = 1;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    tileStride[i] = numberOfTiles;
+    numberOfTiles *= (size[i] + this->m_TileSize[i] - 1) / this->m_TileSize[i];
+  }
+
+  std::unordered_map<SizeValueType, GradientTile> cache;
+  const SizeValueType  maximumNumberOfCachedTiles = std::max(this->m_MaximumNumberOfCachedTiles, SizeValueType{ 1 });
+  GradientTile *       lastTile = nullptr;
+  SizeValueType        lastTileId = numberOfTiles;
+  SizeValueType        useCount = 0;
+
+  // Return the grid gradient at a pixel of the input, computing its tile if
+  // it is not cached.
+  const auto gridGradient = [&](const IndexType & index) -> const OutputValueType * {
+    SizeValueType tileId = 0;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      tileId += tileStride[i] * (static_cast<SizeValueType>(index[i] - start[i]) / this->m_TileSize[i]);
+    }
+    if (tileId != lastTileId)
+    {
+      auto found = cache.find(tileId);
+      if (found == cache.end())
+      {
+        std::vector<OutputValueType> buffer;
+        if (cache.size() >= maximumNumberOfCachedTiles)
+        {
+          // Evict the least recently used tile and reuse its buffer.  The scan
+          // is cheap next to the computation of the new tile.
+          const auto leastRecentlyUsed =
+            std::min_element(cache.begin(), cache.end(), [](const auto & a, const auto & b) {
+              return a.second.m_LastUse < b.second.m_LastUse;
+            });
+          buffer = std::move(leastRecentlyUsed->second.m_Gradient);
+          cache.erase(leastRecentlyUsed);
+        }
+        GradientTile & tile = cache[tileId];
+        tile.m_Gradient = std::move(buffer);
+        for (unsigned int i = 0; i < ImageDimension; ++i)
+        {
+          const SizeValueType tileIndex = static_cast<SizeValueType>(index[i] - start[i]) / this->m_TileSize[i];
+          tile.m_Index[i] = start[i] + static_cast<IndexValueType>(tileIndex * this->m_TileSize[i]);
+          tile.m_Size[i] =
+            std::min(this->m_TileSize[i], static_cast<SizeValueType>(start[i] + size[i] - tile.m_Index[i]));
+        }
+        this->ComputeGradientTile(tile);
+        lastTile = &tile;
+      }
+      else
+      {
+        lastTile = &found->second;
+      }
+      // Only a change of tile counts as a use, which is enough to order them.
+      lastTile->m_LastUse = ++useCount;
+      lastTileId = tileId;
+    }
+
+    SizeValueType localOffset = 0;
+    SizeValueType localStride = 1;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      localOffset += localStride * static_cast<SizeValueType>(index[i] - lastTile->m_Index[i]);
+      localStride *= lastTile->m_Size[i];
+    }
+    return &lastTile->m_Gradient[localOffset * ImageDimension];
+  };
+
+  OutputPixelType zero;
+  zero.Fill(NumericTraits<OutputValueType>::ZeroValue());
+
+  using PointType = typename TransformType::InputPointType;
+  using VectorType = CovariantVector<double, ImageDimension>;
+
+  for (ImageRegionIteratorWithIndex<OutputImageType> it(outputImage, outputRegionForThread); !it.IsAtEnd(); ++it)
+  {
+    PointType point;
+    outputImage->TransformIndexToPhysicalPoint(it.GetIndex(), point);
+    const typename TransformType::OutputPointType mappedPoint = transform->TransformPoint(point);
+
+    ContinuousIndex<double, ImageDimension> continuousIndex;
+    inputImage->TransformPhysicalPointToContinuousIndex(mappedPoint, continuousIndex);
+
+    // Linear interpolation of the grid gradient, with the same extent of the
+    // buffer as LinearInterpolateImageFunction.
+    bool      inside = true;
+    IndexType baseIndex;
+    IndexType lastIndex;
+    double    fraction[ImageDimension];
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      const double first = static_cast<double>(start[i]);
+      const double last = first + static_cast<double>(size[i]) - 1.0;
+      if (!(continuousIndex[i] >= first - 0.5 && continuousIndex[i] < last + 0.5))
+      {
+        inside = false;
+        break;
+      }
+      const double clamped = std::min(std::max(continuousIndex[i], first), last);
+      baseIndex[i] = static_cast<IndexValueType>(std::floor(clamped));
+      lastIndex[i] = std::min(baseIndex[i] + 1, static_cast<IndexValueType>(last));
+      fraction[i] = clamped - static_cast<double>(baseIndex[i]);
+    }
+    if (!inside)
+    {
+      it.Set(zero);
+      continue;
+    }
+
+    VectorType gradient;
+    gradient.Fill(0.0);
+    for (unsigned int corner = 0; corner < (1u << ImageDimension); ++corner)
+    {
+      double    weight = 1.0;
+      IndexType cornerIndex;
+      for (unsigned int i = 0; i < ImageDimension; ++i)
+      {
+        if (corner & (1u << i))
+        {
+          cornerIndex[i] = lastIndex[i];
+          weight *= fraction[i];
+        }
+        else
+        {
+          cornerIndex[i] = baseIndex[i];
+          weight *= 1.0 - fraction[i];
+        }
+      }
+      if (weight == 0.0)
+      {
+        continue;
+      }
+      const OutputValueType * cornerGradient = gridGradient(cornerIndex);
+      for (unsigned int i = 0; i < ImageDimension; ++i)
+      {
+        gradient[i] += weight * cornerGradient[i];
+      }
+    }
+
+    if (this->m_UseImageDirection)
+    {
+      const VectorType localGradient = gradient;
+      inputImage->TransformLocalVectorToPhysicalVector(localGradient, gradient);
+    }
+
+    OutputPixelType output;
+    if (this->m_UseTransformJacobian)
+    {
+      typename TransformType::JacobianPositionType jacobian;
+      transform->ComputeJacobianWithRespectToPosition(point, jacobian);
+      for (unsigned int i = 0; i < ImageDimension; ++i)
+      {
+        double sum = 0.0;
+        for (unsigned int j = 0; j < ImageDimension; ++j)
+        {
+          sum += jacobian(j, i) * gradient[j];
+        }
+        output[i] = static_cast<OutputValueType>(sum);
+      }
+    }
+    else
+    {
+      for (unsigned int i = 0; i < ImageDimension; ++i)
+      {
+        output[i] = static_cast<OutputValueType>(gradient[i]);
+      }
+    }
+    it.Set(output);
+  }
+}
+
+
+template <typename TInputImage, typename TOperatorValueType, typename TOutputValueType, typename TTransformPrecisionType>
+void
+HigherOrderAccurateWarpedGradientImageFilter<TInputImage, TOperatorValueType, TOutputValueType, TTransformPrecisionType>::
+  PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "UseImageSpacing: " << (this->m_UseImageSpacing ? "On" : "Off") << std::endl;
+  os << indent << "UseImageDirection = " << (this->m_UseImageDirection ? "On" : "Off") << std::endl;
+  os << indent << "UseTransformJacobian: " << (this->m_UseTransformJacobian ? "On" : "Off") << std::endl;
+  os << indent << "OrderOfAccuracy: " << this->m_OrderOfAccuracy << std::endl;
+  os << indent << "TileSize: " << this->m_TileSize << std::endl;
+  os << indent << "MaximumNumberOfCachedTiles: " << this->m_MaximumNumberOfCachedTiles << std::endl;
+}
+
+} // end namespace itk
+
+#endif
@@ -7,14 +7,26 @@ http://www.insight-journal.org/browse/publication/775
 http://hdl.handle.net/10380/3231
 ")
 
+# The module only has a library, to be built shared with ITK, when the
+# common template instantiations are compiled; it is header-only otherwise.
+set(_HigherOrderAccurateGradient_ENABLE_SHARED "")
+if(HigherOrderAccurateGradient_EXPLICIT_INSTANTIATION)
+  set(_HigherOrderAccurateGradient_ENABLE_SHARED ENABLE_SHARED)
+endif()
+
 itk_module(HigherOrderAccurateGradient
+  ${_HigherOrderAccurateGradient_ENABLE_SHARED}
   DEPENDS
     ITKCommon
     ITKImageGradient
     ITKImageIntensity
     ITKImageFeature
+    ITKImageFunction
+    ITKTransform
+    ITKFFT
   TEST_DEPENDS
     ITKTestKernel
+    ITKMetricsv4
   EXCLUDE_FROM_DEFAULT
   DESCRIPTION
     "${DOCUMENTATION}"
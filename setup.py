@@ -47,6 +47,8 @@ setup(
     license='Apache',
     keywords='ITK Higher-order Derivative Gradient',
     url=r'https://github.com/InsightSoftwareConsortium/ITKHigherOrderAccurateGradient',
+    # ITK 5.2 is supported, but only ITK 5.3 and later release the global
+    # interpreter lock in the wrapped calls; see README.rst.
     install_requires=[
         r'itk>=v5.2.0.post2'
     ]
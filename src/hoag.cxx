@@ -0,0 +1,371 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "hoag.h"
+
+#include "itkHigherOrderAccurateStridedViewGradientCalculator.h"
+
+#include <exception>
+#include <string>
+
+namespace
+{
+
+thread_local std::string lastError;
+
+hoag_status
+Fail(hoag_status status, const std::string & message)
+{
+  lastError = message;
+  return status;
+}
+
+
+template <typename TValue, unsigned int VDimension>
+using CalculatorType = itk::HigherOrderAccurateStridedViewGradientCalculator<TValue, VDimension, TValue>;
+
+
+/** Set up the calculator and the input view shared by the gradient and the
+ * derivative.  Returns an empty string, or the error. */
+template <typename TValue, unsigned int VDimension>
+std::string
+Configure(CalculatorType<TValue, VDimension> *                          calculator,
+          const TValue *                                               input,
+          const size_t                                                 dims[],
+          const double                                                 spacing[],
+          int                                                          accuracy,
+          const hoag_options &                                         options,
+          typename CalculatorType<TValue, VDimension>::InputViewType & view)
+{
+  using InputViewType = typename CalculatorType<TValue, VDimension>::InputViewType;
+
+  if (input == nullptr || dims == nullptr)
+  {
+    return "The input and the dimensions must not be NULL.";
+  }
+  if (accuracy < 1)
+  {
+    return "The accuracy must be at least 1.";
+  }
+
+  typename InputViewType::SizeType size;
+  for (unsigned int i = 0; i < VDimension; ++i)
+  {
+    size[i] = static_cast<itk::SizeValueType>(dims[i]);
+  }
+  if (options.input_strides)
+  {
+    typename InputViewType::StrideType strides;
+    for (unsigned int i = 0; i < VDimension; ++i)
+    {
+      strides[i] = static_cast<itk::OffsetValueType>(options.input_strides[i]);
+    }
+    view = InputViewType(input, size, strides);
+  }
+  else
+  {
+    view = InputViewType::Contiguous(input, size);
+  }
+
+  if (spacing)
+  {
+    typename CalculatorType<TValue, VDimension>::SpacingType calculatorSpacing;
+    for (unsigned int i = 0; i < VDimension; ++i)
+    {
+      calculatorSpacing[i] = spacing[i];
+    }
+    calculator->SetSpacing(calculatorSpacing);
+  }
+  calculator->SetOrderOfAccuracy(static_cast<unsigned int>(accuracy));
+  if (options.number_of_work_units > 0)
+  {
+    calculator->SetNumberOfWorkUnits(options.number_of_work_units);
+  }
+  return std::string();
+}
+
+
+template <typename TValue, unsigned int VDimension>
+hoag_status
+Gradient(const TValue *       input,
+         const size_t         dims[],
+         const double         spacing[],
+         const double         direction[],
+         int                  accuracy,
+         TValue *             output,
+         const hoag_options * options)
+{
+  using Calculator = CalculatorType<TValue, VDimension>;
+  using OutputViewType = typename Calculator::OutputViewType;
+
+  hoag_options defaultOptions;
+  hoag_options_init(&defaultOptions);
+  const hoag_options & usedOptions = options ? *options : defaultOptions;
+
+  try
+  {
+    typename Calculator::Pointer       calculator = Calculator::New();
+    typename Calculator::InputViewType view;
+    const std::string                  error =
+      Configure<TValue, VDimension>(calculator, input, dims, spacing, accuracy, usedOptions, view);
+    if (!error.empty())
+    {
+      return Fail(HOAG_ERROR_INVALID_ARGUMENT, error);
+    }
+    if (output == nullptr)
+    {
+      return Fail(HOAG_ERROR_INVALID_ARGUMENT, "The output must not be NULL.");
+    }
+
+    if (direction)
+    {
+      typename Calculator::DirectionType calculatorDirection;
+      for (unsigned int i = 0; i < VDimension; ++i)
+      {
+        for (unsigned int j = 0; j < VDimension; ++j)
+        {
+          calculatorDirection[i][j] = direction[i * VDimension + j];
+        }
+      }
+      calculator->SetDirection(calculatorDirection);
+    }
+
+    // Component planes one after the other, or the components of a sample
+    // next to each other.
+    const typename OutputViewType::SizeType & size = view.GetSize();
+    typename Calculator::GradientViewType     outputViews;
+    for (unsigned int c = 0; c < VDimension; ++c)
+    {
+      if (usedOptions.channel_first)
+      {
+        outputViews[c] = OutputViewType::Contiguous(output + c * size.CalculateProductOfElements(), size);
+      }
+      else
+      {
+        typename OutputViewType::StrideType strides;
+        strides[0] = VDimension * sizeof(TValue);
+        for (unsigned int i = 1; i < VDimension; ++i)
+        {
+          strides[i] = strides[i - 1] * static_cast<itk::OffsetValueType>(size[i - 1]);
+        }
+        outputViews[c] = OutputViewType(output + c, size, strides);
+      }
+    }
+
+    calculator->ComputeGradient(view, outputViews);
+  }
+  catch (const std::exception & exception)
+  {
+    return Fail(HOAG_ERROR_COMPUTATION, exception.what());
+  }
+  catch (...)
+  {
+    // No exception may cross the C interface.
+    return Fail(HOAG_ERROR_COMPUTATION, "Unknown error.");
+  }
+  return HOAG_SUCCESS;
+}
+
+
+template <typename TValue, unsigned int VDimension>
+hoag_status
+Derivative(const TValue *       input,
+           const size_t         dims[],
+           const double         spacing[],
+           unsigned int         axis,
+           unsigned int         order,
+           int                  accuracy,
+           TValue *             output,
+           const hoag_options * options)
+{
+  using Calculator = CalculatorType<TValue, VDimension>;
+  using OutputViewType = typename Calculator::OutputViewType;
+
+  hoag_options defaultOptions;
+  hoag_options_init(&defaultOptions);
+  const hoag_options & usedOptions = options ? *options : defaultOptions;
+
+  try
+  {
+    typename Calculator::Pointer       calculator = Calculator::New();
+    typename Calculator::InputViewType view;
+    const std::string                  error =
+      Configure<TValue, VDimension>(calculator, input, dims, spacing, accuracy, usedOptions, view);
+    if (!error.empty())
+    {
+      return Fail(HOAG_ERROR_INVALID_ARGUMENT, error);
+    }
+    if (output == nullptr)
+    {
+      return Fail(HOAG_ERROR_INVALID_ARGUMENT, "The output must not be NULL.");
+    }
+    if (axis >= VDimension)
+    {
+      return Fail(HOAG_ERROR_INVALID_ARGUMENT, "The axis must be smaller than the dimension.");
+    }
+    if (order < 1 || order > 2)
+    {
+      return Fail(HOAG_ERROR_INVALID_ARGUMENT, "The order must be 1 or 2.");
+    }
+
+    calculator->ComputeDerivative(view, axis, order, OutputViewType::Contiguous(output, view.GetSize()));
+  }
+  catch (const std::exception & exception)
+  {
+    return Fail(HOAG_ERROR_COMPUTATION, exception.what());
+  }
+  catch (...)
+  {
+    // No exception may cross the C interface.
+    return Fail(HOAG_ERROR_COMPUTATION, "Unknown error.");
+  }
+  return HOAG_SUCCESS;
+}
+
+} // end anonymous namespace
+
+
+extern "C"
+{
+
+  void
+  hoag_options_init(hoag_options * options)
+  {
+    if (options)
+    {
+      options->number_of_work_units = 0;
+      options->channel_first = 0;
+      options->input_strides = nullptr;
+    }
+  }
+
+
+  const char *
+  hoag_last_error(void)
+  {
+    return lastError.c_str();
+  }
+
+
+  hoag_status
+  hoag_gradient_f32_2d(const float *        input,
+                       const size_t         dims[2],
+                       const double         spacing[2],
+                       const double         direction[4],
+                       int                  accuracy,
+                       float *              output,
+                       const hoag_options * options)
+  {
+    return Gradient<float, 2>(input, dims, spacing, direction, accuracy, output, options);
+  }
+
+
+  hoag_status
+  hoag_gradient_f32_3d(const float *        input,
+                       const size_t         dims[3],
+                       const double         spacing[3],
+                       const double         direction[9],
+                       int                  accuracy,
+                       float *              output,
+                       const hoag_options * options)
+  {
+    return Gradient<float, 3>(input, dims, spacing, direction, accuracy, output, options);
+  }
+
+
+  hoag_status
+  hoag_gradient_f64_2d(const double *       input,
+                       const size_t         dims[2],
+                       const double         spacing[2],
+                       const double         direction[4],
+                       int                  accuracy,
+                       double *             output,
+                       const hoag_options * options)
+  {
+    return Gradient<double, 2>(input, dims, spacing, direction, accuracy, output, options);
+  }
+
+
+  hoag_status
+  hoag_gradient_f64_3d(const double *       input,
+                       const size_t         dims[3],
+                       const double         spacing[3],
+                       const double         direction[9],
+                       int                  accuracy,
+                       double *             output,
+                       const hoag_options * options)
+  {
+    return Gradient<double, 3>(input, dims, spacing, direction, accuracy, output, options);
+  }
+
+
+  hoag_status
+  hoag_derivative_f32_2d(const float *        input,
+                         const size_t         dims[2],
+                         const double         spacing[2],
+                         unsigned int         axis,
+                         unsigned int         order,
+                         int                  accuracy,
+                         float *              output,
+                         const hoag_options * options)
+  {
+    return Derivative<float, 2>(input, dims, spacing, axis, order, accuracy, output, options);
+  }
+
+
+  hoag_status
+  hoag_derivative_f32_3d(const float *        input,
+                         const size_t         dims[3],
+                         const double         spacing[3],
+                         unsigned int         axis,
+                         unsigned int         order,
+                         int                  accuracy,
+                         float *              output,
+                         const hoag_options * options)
+  {
+    return Derivative<float, 3>(input, dims, spacing, axis, order, accuracy, output, options);
+  }
+
+
+  hoag_status
+  hoag_derivative_f64_2d(const double *       input,
+                         const size_t         dims[2],
+                         const double         spacing[2],
+                         unsigned int         axis,
+                         unsigned int         order,
+                         int                  accuracy,
+                         double *             output,
+                         const hoag_options * options)
+  {
+    return Derivative<double, 2>(input, dims, spacing, axis, order, accuracy, output, options);
+  }
+
+
+  hoag_status
+  hoag_derivative_f64_3d(const double *       input,
+                         const size_t         dims[3],
+                         const double         spacing[3],
+                         unsigned int         axis,
+                         unsigned int         order,
+                         int                  accuracy,
+                         double *             output,
+                         const hoag_options * options)
+  {
+    return Derivative<double, 3>(input, dims, spacing, axis, order, accuracy, output, options);
+  }
+
+} // extern "C"
@@ -0,0 +1,113 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkHigherOrderAccurateAnisotropicDiffusionImageFilter.h"
+
+#include <cmath>
+
+int
+itkHigherOrderAccurateAnisotropicDiffusionImageFilterTest(int, char *[])
+{
+  constexpr unsigned int Dimension = 2;
+  using ImageType = itk::Image<float, Dimension>;
+  using OutputImageType = itk::Image<double, Dimension>;
+  using FilterType = itk::HigherOrderAccurateAnisotropicDiffusionImageFilter<ImageType, double, double>;
+
+  ImageType::SizeType size;
+  size[0] = 45;
+  size[1] = 38;
+  ImageType::SpacingType spacing;
+  spacing[0] = 1.0;
+  spacing[1] = 1.5;
+
+  // A step edge with a smooth ripple on top.
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(size);
+  image->SetSpacing(spacing);
+  image->Allocate();
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion()); !it.IsAtEnd(); ++it)
+  {
+    const double x = it.GetIndex()[0];
+    const double y = it.GetIndex()[1];
+    it.Set(static_cast<float>((x > 20 ? 10.0 : 0.0) + std::sin(0.7 * x) * std::cos(0.5 * y)));
+  }
+
+  FilterType::SizeType tileSize;
+  tileSize[0] = 7;
+  tileSize[1] = 9;
+
+  // Sweep the whole image for every iteration, then advance small tiles by
+  // three iterations at a time, with a shorter last block.
+  FilterType::Pointer reference = FilterType::New();
+  reference->SetInput(image);
+  reference->SetNumberOfIterations(8);
+  reference->SetTimeStep(0.05);
+  reference->SetConductanceParameter(2.0);
+  reference->SetOrderOfAccuracy(2);
+  reference->SetTimeStepsPerBlock(1);
+
+  FilterType::Pointer blocked = FilterType::New();
+  blocked->SetInput(image);
+  blocked->SetNumberOfIterations(8);
+  blocked->SetTimeStep(0.05);
+  blocked->SetConductanceParameter(2.0);
+  blocked->SetOrderOfAccuracy(2);
+  blocked->SetTimeStepsPerBlock(3);
+  blocked->SetTileSize(tileSize);
+  blocked->SetNumberOfWorkUnits(3);
+
+  try
+  {
+    reference->Update();
+    blocked->Update();
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << "Exception caught!" << std::endl;
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  double maximumChange = 0.0;
+  for (itk::ImageRegionConstIteratorWithIndex<OutputImageType> it(reference->GetOutput(),
+                                                                  reference->GetOutput()->GetLargestPossibleRegion());
+       !it.IsAtEnd();
+       ++it)
+  {
+    const double expected = it.Get();
+    const double actual = blocked->GetOutput()->GetPixel(it.GetIndex());
+    if (std::abs(actual - expected) > 1e-10 * (1.0 + std::abs(expected)))
+    {
+      std::cerr << "Temporal blocking changed the result at " << it.GetIndex() << ": " << actual << " versus "
+                << expected << std::endl;
+      return EXIT_FAILURE;
+    }
+    maximumChange = std::max(maximumChange, std::abs(expected - image->GetPixel(it.GetIndex())));
+  }
+
+  if (maximumChange < 0.01)
+  {
+    std::cerr << "The diffusion did not change the image." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  blocked->Print(std::cout);
+
+  return EXIT_SUCCESS;
+}
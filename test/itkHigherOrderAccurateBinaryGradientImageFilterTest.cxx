@@ -0,0 +1,140 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkCastImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkHigherOrderAccurateBinaryGradientImageFilter.h"
+#include "itkHigherOrderAccurateGradientImageFilter.h"
+
+#include <cmath>
+
+int
+itkHigherOrderAccurateBinaryGradientImageFilterTest(int, char *[])
+{
+  constexpr unsigned int Dimension = 3;
+  using MaskImageType = itk::Image<unsigned char, Dimension>;
+  using RealImageType = itk::Image<float, Dimension>;
+
+  // The scanlines are longer than one packed word so that the shifts across
+  // word boundaries are exercised.
+  MaskImageType::SizeType size;
+  size[0] = 150;
+  size[1] = 21;
+  size[2] = 17;
+  MaskImageType::SpacingType spacing;
+  spacing[0] = 0.5;
+  spacing[1] = 1.0;
+  spacing[2] = 2.0;
+
+  MaskImageType::Pointer mask = MaskImageType::New();
+  mask->SetRegions(size);
+  mask->SetSpacing(spacing);
+  mask->Allocate();
+
+  for (itk::ImageRegionIteratorWithIndex<MaskImageType> it(mask, mask->GetLargestPossibleRegion()); !it.IsAtEnd();
+       ++it)
+  {
+    const MaskImageType::IndexType index = it.GetIndex();
+    const double                   x = (index[0] - 70.0) / 60.0;
+    const double                   y = (index[1] - 10.0) / 8.0;
+    const double                   z = (index[2] - 9.0) / 6.0;
+    it.Set(x * x + y * y + z * z < 1.0 ? 1 : 0);
+  }
+
+  using FilterType = itk::HigherOrderAccurateBinaryGradientImageFilter<MaskImageType, float, float>;
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(mask);
+  filter->SetForegroundValue(1);
+
+  using CastFilterType = itk::CastImageFilter<MaskImageType, RealImageType>;
+  CastFilterType::Pointer cast = CastFilterType::New();
+  cast->SetInput(mask);
+
+  using ReferenceFilterType = itk::HigherOrderAccurateGradientImageFilter<RealImageType, float, float>;
+  ReferenceFilterType::Pointer reference = ReferenceFilterType::New();
+  reference->SetInput(cast->GetOutput());
+
+  constexpr double tolerance = 1e-5;
+
+  try
+  {
+    for (unsigned int accuracy = 1; accuracy < 6; ++accuracy)
+    {
+      filter->SetOrderOfAccuracy(accuracy);
+      filter->NormalizeGradientOff();
+      filter->Update();
+      FilterType::OutputImageType::ConstPointer output = filter->GetOutput();
+
+      reference->SetOrderOfAccuracy(accuracy);
+      reference->Update();
+      ReferenceFilterType::OutputImageType::ConstPointer expected = reference->GetOutput();
+
+      itk::ImageRegionConstIteratorWithIndex<FilterType::OutputImageType> it(output,
+                                                                             output->GetLargestPossibleRegion());
+      for (; !it.IsAtEnd(); ++it)
+      {
+        const FilterType::OutputPixelType          actual = it.Get();
+        const ReferenceFilterType::OutputPixelType referenceValue = expected->GetPixel(it.GetIndex());
+        for (unsigned int i = 0; i < Dimension; ++i)
+        {
+          if (std::abs(actual[i] - referenceValue[i]) > tolerance)
+          {
+            std::cerr << "Gradient mismatch at " << it.GetIndex() << " for accuracy " << accuracy << ": " << actual
+                      << " versus " << referenceValue << std::endl;
+            return EXIT_FAILURE;
+          }
+        }
+      }
+
+      // The normals are unit vectors on the boundary band and zero elsewhere.
+      filter->NormalizeGradientOn();
+      filter->Update();
+      for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+      {
+        const double norm = it.Get().GetNorm();
+        const double expectedNorm = expected->GetPixel(it.GetIndex()).GetNorm() > tolerance ? 1.0 : 0.0;
+        if (std::abs(norm - expectedNorm) > 1e-4)
+        {
+          std::cerr << "Unexpected normal " << it.Get() << " at " << it.GetIndex() << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+    }
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << "Exception caught!" << std::endl;
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  filter->SetOrderOfAccuracy(FilterType::MaximumOrderOfAccuracy + 1);
+  try
+  {
+    filter->Update();
+    std::cerr << "Expected an exception for an unsupported OrderOfAccuracy." << std::endl;
+    return EXIT_FAILURE;
+  }
+  catch (itk::ExceptionObject &)
+  {
+  }
+
+  filter->Print(std::cout);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,131 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkHigherOrderAccurateBrickedGradientCalculator.h"
+#include "itkHigherOrderAccurateGradientImageFilter.h"
+
+#include <cmath>
+#include <vector>
+
+int
+itkHigherOrderAccurateBrickedGradientCalculatorTest(int, char *[])
+{
+  constexpr unsigned int Dimension = 3;
+  using ImageType = itk::Image<float, Dimension>;
+  using CalculatorType = itk::HigherOrderAccurateBrickedGradientCalculator<float, Dimension, float>;
+  using LayoutType = CalculatorType::LayoutType;
+  using GradientImageType = itk::Image<CalculatorType::OutputPixelType, Dimension>;
+  using FilterType = itk::HigherOrderAccurateGradientImageFilter<ImageType, float, float>;
+
+  // A size that is not a multiple of the brick sizes, so the bricks along
+  // the upper boundaries are padded.
+  ImageType::SizeType size;
+  size[0] = 21;
+  size[1] = 13;
+  size[2] = 10;
+  ImageType::SpacingType spacing;
+  spacing[0] = 0.8;
+  spacing[1] = 1.2;
+  spacing[2] = 2.5;
+  ImageType::DirectionType direction;
+  direction.SetIdentity();
+  direction(1, 1) = 0.6;
+  direction(1, 2) = -0.8;
+  direction(2, 1) = 0.8;
+  direction(2, 2) = 0.6;
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(size);
+  image->SetSpacing(spacing);
+  image->SetDirection(direction);
+  image->Allocate();
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion()); !it.IsAtEnd(); ++it)
+  {
+    const ImageType::IndexType index = it.GetIndex();
+    it.Set(static_cast<float>(std::sin(0.3 * index[0]) * std::cos(0.4 * index[1]) + 0.02 * index[2] * index[2]));
+  }
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(image);
+  filter->SetOrderOfAccuracy(3);
+
+  CalculatorType::Pointer calculator = CalculatorType::New();
+  calculator->SetSpacing(spacing);
+  calculator->SetDirection(direction);
+  calculator->SetOrderOfAccuracy(3);
+  calculator->SetNumberOfWorkUnits(3);
+
+  GradientImageType::Pointer gradient = GradientImageType::New();
+  gradient->SetRegions(size);
+  gradient->Allocate();
+
+  // Raster bricks, Morton bricks, and the whole volume in Z order.
+  const LayoutType layouts[] = { LayoutType(size, 8, LayoutType::VoxelOrderEnum::Raster),
+                                 LayoutType(size, 4, LayoutType::VoxelOrderEnum::Morton),
+                                 LayoutType(size, 32, LayoutType::VoxelOrderEnum::Morton) };
+  try
+  {
+    filter->Update();
+    for (const LayoutType & layout : layouts)
+    {
+      std::vector<float>                           bricked(layout.GetBufferSize());
+      std::vector<CalculatorType::OutputPixelType> brickedGradient(layout.GetBufferSize());
+      layout.CopyFromImage(image.GetPointer(), bricked.data());
+      calculator->ComputeGradient(layout, bricked.data(), brickedGradient.data());
+      layout.CopyToImage(brickedGradient.data(), gradient.GetPointer());
+
+      for (itk::ImageRegionConstIteratorWithIndex<GradientImageType> it(gradient, gradient->GetLargestPossibleRegion());
+           !it.IsAtEnd();
+           ++it)
+      {
+        const FilterType::OutputPixelType expected = filter->GetOutput()->GetPixel(it.GetIndex());
+        for (unsigned int i = 0; i < Dimension; ++i)
+        {
+          if (std::abs(it.Get()[i] - expected[i]) > 1e-5)
+          {
+            std::cerr << "Gradient component " << i << " at " << it.GetIndex() << " is " << it.Get()[i]
+                      << " instead of " << expected[i] << " with bricks of " << layout.GetBrickSize() << " in "
+                      << layout.GetVoxelOrder() << std::endl;
+            return EXIT_FAILURE;
+          }
+        }
+      }
+    }
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << "Exception caught!" << std::endl;
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // The brick size must be a power of two.
+  try
+  {
+    const LayoutType layout(size, 6);
+    std::cerr << "Expected an exception for a brick size of " << layout.GetBrickSize() << std::endl;
+    return EXIT_FAILURE;
+  }
+  catch (itk::ExceptionObject &)
+  {
+  }
+
+  calculator->Print(std::cout);
+
+  return EXIT_SUCCESS;
+}
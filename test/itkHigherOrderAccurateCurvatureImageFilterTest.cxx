@@ -0,0 +1,132 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkHigherOrderAccurateCurvatureImageFilter.h"
+
+#include <cmath>
+
+int
+itkHigherOrderAccurateCurvatureImageFilterTest(int, char *[])
+{
+  constexpr unsigned int Dimension = 3;
+  using ImageType = itk::Image<double, Dimension>;
+  using FilterType = itk::HigherOrderAccurateCurvatureImageFilter<ImageType, double, double>;
+
+  ImageType::SizeType size;
+  size.Fill(32);
+  ImageType::SpacingType spacing;
+  spacing[0] = 0.8;
+  spacing[1] = 1.0;
+  spacing[2] = 1.2;
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(size);
+  image->SetSpacing(spacing);
+  image->Allocate();
+
+  // The distance to a point has spheres as iso-surfaces, with mean curvature
+  // 2 / r and Gaussian curvature 1 / r^2.
+  ImageType::PointType center;
+  center[0] = 12.4;
+  center[1] = 15.5;
+  center[2] = 18.6;
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion()); !it.IsAtEnd(); ++it)
+  {
+    ImageType::PointType point;
+    image->TransformIndexToPhysicalPoint(it.GetIndex(), point);
+    it.Set(point.EuclideanDistanceTo(center));
+  }
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(image);
+  filter->SetOrderOfAccuracy(3);
+  filter->ComputeGaussianCurvatureOn();
+
+  try
+  {
+    filter->Update();
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << "Exception caught!" << std::endl;
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const ImageType * meanCurvature = filter->GetMeanCurvatureOutput();
+  const ImageType * gaussianCurvature = filter->GetGaussianCurvatureOutput();
+  unsigned int      numberOfCheckedPixels = 0;
+  for (itk::ImageRegionConstIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion()); !it.IsAtEnd();
+       ++it)
+  {
+    const double radius = it.Get();
+    bool         interior = true;
+    for (unsigned int i = 0; i < Dimension; ++i)
+    {
+      interior = interior && it.GetIndex()[i] >= 3 && it.GetIndex()[i] < 29;
+    }
+    if (!interior || radius < 6.0 || radius > 10.0)
+    {
+      continue;
+    }
+    ++numberOfCheckedPixels;
+
+    const double expectedMean = 2.0 / radius;
+    const double expectedGaussian = 1.0 / (radius * radius);
+    if (std::abs(meanCurvature->GetPixel(it.GetIndex()) - expectedMean) > 0.01 * expectedMean)
+    {
+      std::cerr << "Mean curvature mismatch at " << it.GetIndex() << ": " << meanCurvature->GetPixel(it.GetIndex())
+                << " versus " << expectedMean << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (std::abs(gaussianCurvature->GetPixel(it.GetIndex()) - expectedGaussian) > 0.01 * expectedGaussian)
+    {
+      std::cerr << "Gaussian curvature mismatch at " << it.GetIndex() << ": "
+                << gaussianCurvature->GetPixel(it.GetIndex()) << " versus " << expectedGaussian << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if (numberOfCheckedPixels == 0)
+  {
+    std::cerr << "No pixel was checked." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Disabling an output leaves it unallocated.
+  filter->ComputeGaussianCurvatureOff();
+  try
+  {
+    filter->Update();
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << "Exception caught!" << std::endl;
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (filter->GetGaussianCurvatureOutput()->GetBufferPointer() != nullptr)
+  {
+    std::cerr << "The Gaussian curvature output should not be allocated." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  filter->Print(std::cout);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,119 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkHigherOrderAccurateFeatureBankImageFilter.h"
+
+#include <cmath>
+
+int
+itkHigherOrderAccurateFeatureBankImageFilterTest(int, char *[])
+{
+  constexpr unsigned int Dimension = 2;
+  using ImageType = itk::Image<double, Dimension>;
+  using FilterType = itk::HigherOrderAccurateFeatureBankImageFilter<ImageType, double, float>;
+  using FeatureEnum = FilterType::FeatureEnum;
+
+  ImageType::SizeType size;
+  size.Fill(32);
+
+  // The central differences are exact for a quadratic.
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(size);
+  image->Allocate();
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion()); !it.IsAtEnd(); ++it)
+  {
+    const double x = it.GetIndex()[0];
+    const double y = it.GetIndex()[1];
+    it.Set(x * x + 3.0 * x * y - y * y + 0.5 * x);
+  }
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(image);
+  filter->SetOrderOfAccuracy(2);
+  filter->AddFeature(FeatureEnum::Gradient);
+  filter->AddFeature(FeatureEnum::GradientMagnitude, 2);
+  filter->AddFeature(FeatureEnum::Hessian, 2);
+  filter->AddFeature(FeatureEnum::Laplacian);
+  filter->AddFeature(FeatureEnum::HessianEigenvalues);
+
+  try
+  {
+    filter->Update();
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << "Exception caught!" << std::endl;
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const FilterType::OutputImageType * output = filter->GetOutput();
+  if (output->GetNumberOfComponentsPerPixel() != 9)
+  {
+    std::cerr << "Expected 9 components, got " << output->GetNumberOfComponentsPerPixel() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Away from the border, the features match the analytic derivatives at
+  // every dilation.
+  ImageType::RegionType interior = image->GetLargestPossibleRegion();
+  interior.ShrinkByRadius(5);
+  const double eigenvalue = std::sqrt(13.0);
+  for (itk::ImageRegionConstIteratorWithIndex<ImageType> it(image, interior); !it.IsAtEnd(); ++it)
+  {
+    const double x = it.GetIndex()[0];
+    const double y = it.GetIndex()[1];
+    const double gx = 2.0 * x + 3.0 * y + 0.5;
+    const double gy = 3.0 * x - 2.0 * y;
+    const double expected[9] = { gx, gy, std::sqrt(gx * gx + gy * gy), 2.0, 3.0, -2.0, 0.0, -eigenvalue, eigenvalue };
+
+    const FilterType::OutputImageType::PixelType pixel = output->GetPixel(it.GetIndex());
+    for (unsigned int c = 0; c < 9; ++c)
+    {
+      if (std::abs(pixel[c] - expected[c]) > 1e-3 * (1.0 + std::abs(expected[c])))
+      {
+        std::cerr << "Component " << c << " at " << it.GetIndex() << " is " << pixel[c] << ", expected "
+                  << expected[c] << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  filter->ClearFeatures();
+  filter->AddFeature(FeatureEnum::Laplacian, 3);
+  try
+  {
+    filter->Update();
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << "Exception caught!" << std::endl;
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (filter->GetOutput()->GetNumberOfComponentsPerPixel() != 1)
+  {
+    std::cerr << "Expected 1 component after clearing the features." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  filter->Print(std::cout);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,218 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkHigherOrderAccurateDerivativeImageFilter.h"
+#include "itkHigherOrderAccurateGradientImageFilter.h"
+#include "hoag.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+int
+itkHigherOrderAccurateGradientCAPITest(int, char *[])
+{
+  constexpr unsigned int Dimension = 3;
+  using ImageType = itk::Image<float, Dimension>;
+  using FilterType = itk::HigherOrderAccurateGradientImageFilter<ImageType, float, float>;
+  using DerivativeFilterType = itk::HigherOrderAccurateDerivativeImageFilter<ImageType, ImageType>;
+  using DoubleImageType = itk::Image<double, Dimension>;
+  using DoubleFilterType = itk::HigherOrderAccurateGradientImageFilter<DoubleImageType, double, double>;
+  using DoubleDerivativeFilterType = itk::HigherOrderAccurateDerivativeImageFilter<DoubleImageType, DoubleImageType>;
+
+  const size_t  dims[Dimension] = { 13, 10, 8 };
+  const double  spacing[Dimension] = { 0.9, 1.1, 2.0 };
+  const double  direction[Dimension * Dimension] = { 0.6, -0.8, 0.0, 0.8, 0.6, 0.0, 0.0, 0.0, 1.0 };
+  const size_t  numberOfPixels = dims[0] * dims[1] * dims[2];
+  constexpr int accuracy = 2;
+
+  ImageType::Pointer       image = ImageType::New();
+  ImageType::SizeType      size;
+  ImageType::SpacingType   imageSpacing;
+  ImageType::DirectionType imageDirection;
+  for (unsigned int i = 0; i < Dimension; ++i)
+  {
+    size[i] = dims[i];
+    imageSpacing[i] = spacing[i];
+    for (unsigned int j = 0; j < Dimension; ++j)
+    {
+      imageDirection(i, j) = direction[i * Dimension + j];
+    }
+  }
+  image->SetRegions(size);
+  image->SetSpacing(imageSpacing);
+  image->SetDirection(imageDirection);
+  image->Allocate();
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion()); !it.IsAtEnd(); ++it)
+  {
+    const ImageType::IndexType index = it.GetIndex();
+    it.Set(static_cast<float>(std::sin(0.4 * index[0]) * std::cos(0.3 * index[1]) + 0.05 * index[2] * index[2]));
+  }
+
+  // The same values in double precision, interleaved with another channel,
+  // for the strided double precision entry points.
+  DoubleImageType::Pointer doubleImage = DoubleImageType::New();
+  doubleImage->SetRegions(size);
+  doubleImage->SetSpacing(imageSpacing);
+  doubleImage->SetDirection(imageDirection);
+  doubleImage->Allocate();
+  std::vector<double> interleaved(2 * numberOfPixels, -1.0);
+  for (size_t n = 0; n < numberOfPixels; ++n)
+  {
+    doubleImage->GetBufferPointer()[n] = image->GetBufferPointer()[n];
+    interleaved[2 * n + 1] = image->GetBufferPointer()[n];
+  }
+  const ptrdiff_t interleavedStrides[Dimension] = { 2 * sizeof(double),
+                                                    static_cast<ptrdiff_t>(2 * sizeof(double) * dims[0]),
+                                                    static_cast<ptrdiff_t>(2 * sizeof(double) * dims[0] * dims[1]) };
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(image);
+  filter->SetOrderOfAccuracy(accuracy);
+  DerivativeFilterType::Pointer derivativeFilter = DerivativeFilterType::New();
+  derivativeFilter->SetInput(image);
+  derivativeFilter->SetOrder(2);
+  derivativeFilter->SetDirection(0);
+  derivativeFilter->SetOrderOfAccuracy(accuracy);
+  DoubleFilterType::Pointer doubleFilter = DoubleFilterType::New();
+  doubleFilter->SetInput(doubleImage);
+  doubleFilter->SetOrderOfAccuracy(accuracy);
+  DoubleDerivativeFilterType::Pointer doubleDerivativeFilter = DoubleDerivativeFilterType::New();
+  doubleDerivativeFilter->SetInput(doubleImage);
+  doubleDerivativeFilter->SetOrder(1);
+  doubleDerivativeFilter->SetDirection(2);
+  doubleDerivativeFilter->SetOrderOfAccuracy(accuracy);
+  try
+  {
+    filter->Update();
+    derivativeFilter->Update();
+    doubleFilter->Update();
+    doubleDerivativeFilter->Update();
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << "Exception caught!" << std::endl;
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const float *      input = image->GetBufferPointer();
+  std::vector<float> channelLast(Dimension * numberOfPixels);
+  std::vector<float> channelFirst(Dimension * numberOfPixels);
+  hoag_options       options;
+  hoag_options_init(&options);
+  options.number_of_work_units = 2;
+  if (hoag_gradient_f32_3d(input, dims, spacing, direction, accuracy, channelLast.data(), &options) != HOAG_SUCCESS)
+  {
+    std::cerr << "Channel-last gradient failed: " << hoag_last_error() << std::endl;
+    return EXIT_FAILURE;
+  }
+  options.channel_first = 1;
+  if (hoag_gradient_f32_3d(input, dims, spacing, direction, accuracy, channelFirst.data(), &options) != HOAG_SUCCESS)
+  {
+    std::cerr << "Channel-first gradient failed: " << hoag_last_error() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const FilterType::OutputPixelType * expected = filter->GetOutput()->GetBufferPointer();
+  for (size_t n = 0; n < numberOfPixels; ++n)
+  {
+    for (unsigned int i = 0; i < Dimension; ++i)
+    {
+      if (std::abs(channelLast[n * Dimension + i] - expected[n][i]) > 1e-5f ||
+          std::abs(channelFirst[i * numberOfPixels + n] - expected[n][i]) > 1e-5f)
+      {
+        std::cerr << "Gradient component " << i << " of pixel " << n << ": " << channelLast[n * Dimension + i]
+                  << " and " << channelFirst[i * numberOfPixels + n] << " instead of " << expected[n][i] << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  // Second derivative along x of the contiguous float input.
+  std::vector<float> derivative(numberOfPixels);
+  if (hoag_derivative_f32_3d(input, dims, spacing, 0, 2, accuracy, derivative.data(), nullptr) != HOAG_SUCCESS)
+  {
+    std::cerr << "Derivative failed: " << hoag_last_error() << std::endl;
+    return EXIT_FAILURE;
+  }
+  const float * expectedDerivative = derivativeFilter->GetOutput()->GetBufferPointer();
+  for (size_t n = 0; n < numberOfPixels; ++n)
+  {
+    if (std::abs(derivative[n] - expectedDerivative[n]) > 1e-4f)
+    {
+      std::cerr << "Derivative of pixel " << n << " is " << derivative[n] << " instead of " << expectedDerivative[n]
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Gradient and first derivative along z of the strided double input.
+  std::vector<double> doubleGradient(Dimension * numberOfPixels);
+  std::vector<double> doubleDerivative(numberOfPixels);
+  hoag_options        stridedOptions;
+  hoag_options_init(&stridedOptions);
+  stridedOptions.input_strides = interleavedStrides;
+  const double * stridedInput = interleaved.data() + 1;
+  if (hoag_gradient_f64_3d(stridedInput, dims, spacing, direction, accuracy, doubleGradient.data(), &stridedOptions) !=
+        HOAG_SUCCESS ||
+      hoag_derivative_f64_3d(stridedInput, dims, spacing, 2, 1, accuracy, doubleDerivative.data(), &stridedOptions) !=
+        HOAG_SUCCESS)
+  {
+    std::cerr << "Strided double precision computation failed: " << hoag_last_error() << std::endl;
+    return EXIT_FAILURE;
+  }
+  const DoubleFilterType::OutputPixelType * expectedDouble = doubleFilter->GetOutput()->GetBufferPointer();
+  const double * expectedDoubleDerivative = doubleDerivativeFilter->GetOutput()->GetBufferPointer();
+  for (size_t n = 0; n < numberOfPixels; ++n)
+  {
+    for (unsigned int i = 0; i < Dimension; ++i)
+    {
+      if (std::abs(doubleGradient[n * Dimension + i] - expectedDouble[n][i]) > 1e-9)
+      {
+        std::cerr << "Strided gradient component " << i << " of pixel " << n << " is "
+                  << doubleGradient[n * Dimension + i] << " instead of " << expectedDouble[n][i] << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+    if (std::abs(doubleDerivative[n] - expectedDoubleDerivative[n]) > 1e-8)
+    {
+      std::cerr << "Strided derivative of pixel " << n << " is " << doubleDerivative[n] << " instead of "
+                << expectedDoubleDerivative[n] << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Invalid arguments are reported, not thrown.
+  if (hoag_derivative_f32_3d(input, dims, spacing, 3, 1, accuracy, channelLast.data(), nullptr) !=
+        HOAG_ERROR_INVALID_ARGUMENT ||
+      std::strlen(hoag_last_error()) == 0)
+  {
+    std::cerr << "Expected an error for an axis out of range." << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (hoag_gradient_f32_3d(nullptr, dims, spacing, direction, accuracy, channelLast.data(), nullptr) !=
+      HOAG_ERROR_INVALID_ARGUMENT)
+  {
+    std::cerr << "Expected an error for a NULL input." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,227 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkHigherOrderAccurateGradientImageFilter.h"
+
+#include <cmath>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+
+template <typename TImage>
+bool
+ImagesAreClose(const TImage * image, const TImage * reference, const char * description)
+{
+  itk::ImageRegionConstIteratorWithIndex<TImage> it(image, reference->GetLargestPossibleRegion());
+  for (; !it.IsAtEnd(); ++it)
+  {
+    for (unsigned int i = 0; i < TImage::ImageDimension; ++i)
+    {
+      if (std::abs(it.Get()[i] - reference->GetPixel(it.GetIndex())[i]) > 1e-5)
+      {
+        std::cerr << description << ": component " << i << " at " << it.GetIndex() << " is " << it.Get()[i]
+                  << " instead of " << reference->GetPixel(it.GetIndex())[i] << std::endl;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+
+std::vector<std::string>
+ReadLines(const std::string & fileName)
+{
+  std::vector<std::string> lines;
+  std::ifstream            file(fileName.c_str());
+  std::string              line;
+  while (std::getline(file, line))
+  {
+    lines.push_back(line);
+  }
+  return lines;
+}
+
+} // end anonymous namespace
+
+int
+itkHigherOrderAccurateGradientImageFilterAutotuneTest(int argc, char * argv[])
+{
+  if (argc < 2)
+  {
+    std::cerr << "Usage: " << argv[0];
+    std::cerr << " profileFile ";
+    std::cerr << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  constexpr unsigned int Dimension = 3;
+  using ImageType = itk::Image<float, Dimension>;
+  using FilterType = itk::HigherOrderAccurateGradientImageFilter<ImageType, float, float>;
+  using AutotunerType = itk::HigherOrderAccurateAutotuner;
+
+  ImageType::SizeType size;
+  size[0] = 29;
+  size[1] = 17;
+  size[2] = 11;
+  ImageType::SpacingType spacing;
+  spacing[0] = 0.9;
+  spacing[1] = 1.1;
+  spacing[2] = 2.0;
+  ImageType::DirectionType direction;
+  direction.SetIdentity();
+  direction(0, 0) = 0.6;
+  direction(0, 1) = -0.8;
+  direction(1, 0) = 0.8;
+  direction(1, 1) = 0.6;
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(size);
+  image->SetSpacing(spacing);
+  image->SetDirection(direction);
+  image->Allocate();
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion()); !it.IsAtEnd(); ++it)
+  {
+    const ImageType::IndexType index = it.GetIndex();
+    it.Set(static_cast<float>(std::sin(0.4 * index[0]) * std::cos(0.3 * index[1]) + 0.05 * index[2] * index[2]));
+  }
+
+  FilterType::Pointer reference = FilterType::New();
+  reference->SetInput(image);
+  reference->SetOrderOfAccuracy(3);
+
+  // Every kernel variant and tiling computes the same gradient.
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(image);
+  filter->SetOrderOfAccuracy(3);
+  try
+  {
+    reference->Update();
+    for (const FilterType::KernelVariantEnum kernelVariant :
+         { FilterType::KernelVariantEnum::Neighborhood, FilterType::KernelVariantEnum::Scanline })
+    {
+      for (const FilterType::TilingEnum tiling : { FilterType::TilingEnum::Slabs, FilterType::TilingEnum::Blocks })
+      {
+        for (const unsigned int numberOfWorkUnits : { 1u, 5u })
+        {
+          filter->SetKernelVariant(kernelVariant);
+          filter->SetTiling(tiling);
+          filter->SetNumberOfWorkUnits(numberOfWorkUnits);
+          filter->Update();
+          if (!ImagesAreClose(filter->GetOutput(), reference->GetOutput(), "Configured gradient"))
+          {
+            std::cerr << "with " << kernelVariant << ", " << tiling << " and " << numberOfWorkUnits << " work units"
+                      << std::endl;
+            return EXIT_FAILURE;
+          }
+        }
+      }
+    }
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << "Exception caught!" << std::endl;
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // The first run of a workload records its fastest configuration.
+  AutotunerType::Pointer autotuner = AutotunerType::New();
+  autotuner->SetProfileFileName(argv[1]);
+  autotuner->SetNumberOfTrials(1);
+  autotuner->Clear();
+
+  FilterType::Pointer tuned = FilterType::New();
+  tuned->SetInput(image);
+  tuned->SetOrderOfAccuracy(3);
+  tuned->SetAutotuner(autotuner);
+  try
+  {
+    tuned->Update();
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << "Exception caught!" << std::endl;
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (!ImagesAreClose(tuned->GetOutput(), reference->GetOutput(), "Autotuned gradient"))
+  {
+    return EXIT_FAILURE;
+  }
+
+  std::vector<std::string> profile = ReadLines(argv[1]);
+  if (profile.size() != 1 || profile[0].find(AutotunerType::GetProcessorDescription()) != 0)
+  {
+    std::cerr << "Expected one profile entry for this processor, got " << profile.size() << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string key = profile[0].substr(0, profile[0].find('\t'));
+
+  // Later runs of the workload use the recorded configuration without
+  // measuring again.
+  autotuner->Record(key, "Scanline Blocks 3");
+  FilterType::Pointer profiled = FilterType::New();
+  profiled->SetInput(image);
+  profiled->SetOrderOfAccuracy(3);
+  profiled->SetAutotuner(autotuner);
+  try
+  {
+    profiled->Update();
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << "Exception caught!" << std::endl;
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (!ImagesAreClose(profiled->GetOutput(), reference->GetOutput(), "Profiled gradient"))
+  {
+    return EXIT_FAILURE;
+  }
+  std::string configuration;
+  if (!autotuner->Lookup(key, configuration) || configuration != "Scanline Blocks 3" || ReadLines(argv[1]).size() != 1)
+  {
+    std::cerr << "The recorded configuration was replaced: " << configuration << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Another order of accuracy is another workload.
+  profiled->SetOrderOfAccuracy(2);
+  try
+  {
+    profiled->Update();
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << "Exception caught!" << std::endl;
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (ReadLines(argv[1]).size() != 2)
+  {
+    std::cerr << "Expected a second profile entry." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  profiled->Print(std::cout);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,168 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkHigherOrderAccurateGradientImageFilter.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+
+template <typename TImage>
+bool
+ImagesAreIdentical(const TImage * image, const TImage * reference)
+{
+  return image->GetBufferedRegion() == reference->GetBufferedRegion() &&
+         std::memcmp(image->GetBufferPointer(),
+                     reference->GetBufferPointer(),
+                     reference->GetBufferedRegion().GetNumberOfPixels() * sizeof(typename TImage::PixelType)) == 0;
+}
+
+
+template <typename TImage>
+bool
+ImagesAreClose(const TImage * image, const TImage * reference)
+{
+  itk::ImageRegionConstIteratorWithIndex<TImage> it(image, reference->GetLargestPossibleRegion());
+  for (; !it.IsAtEnd(); ++it)
+  {
+    for (unsigned int i = 0; i < TImage::ImageDimension; ++i)
+    {
+      if (std::abs(it.Get()[i] - reference->GetPixel(it.GetIndex())[i]) > 1e-5)
+      {
+        std::cerr << "Component " << i << " at " << it.GetIndex() << " is " << it.Get()[i] << " instead of "
+                  << reference->GetPixel(it.GetIndex())[i] << std::endl;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+} // end anonymous namespace
+
+int
+itkHigherOrderAccurateGradientImageFilterReproducibleTest(int, char *[])
+{
+  constexpr unsigned int Dimension = 3;
+  using ImageType = itk::Image<float, Dimension>;
+  using FilterType = itk::HigherOrderAccurateGradientImageFilter<ImageType, float, float>;
+
+  ImageType::SizeType size;
+  size[0] = 37;
+  size[1] = 19;
+  size[2] = 13;
+  ImageType::SpacingType spacing;
+  spacing[0] = 0.7;
+  spacing[1] = 1.3;
+  spacing[2] = 2.1;
+  ImageType::DirectionType direction;
+  direction.SetIdentity();
+  direction(0, 0) = 0.6;
+  direction(0, 2) = -0.8;
+  direction(2, 0) = 0.8;
+  direction(2, 2) = 0.6;
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(size);
+  image->SetSpacing(spacing);
+  image->SetDirection(direction);
+  image->Allocate();
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion()); !it.IsAtEnd(); ++it)
+  {
+    const ImageType::IndexType index = it.GetIndex();
+    it.Set(static_cast<float>(std::exp(-0.01 * index[0] * index[1]) * std::sin(0.7 * index[2]) + 1e-3 * index[0]));
+  }
+
+  FilterType::Pointer reference = FilterType::New();
+  reference->SetInput(image);
+  reference->SetOrderOfAccuracy(4);
+  reference->SetComputeGradientVariance(true);
+  reference->SetNoiseSigma(0.3);
+  reference->ReproducibleOn();
+  reference->SetNumberOfWorkUnits(1);
+
+  // The default mode computes the same gradient up to rounding.
+  FilterType::Pointer contracted = FilterType::New();
+  contracted->SetInput(image);
+  contracted->SetOrderOfAccuracy(4);
+  try
+  {
+    reference->Update();
+    contracted->Update();
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << "Exception caught!" << std::endl;
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (!ImagesAreClose(contracted->GetOutput(), reference->GetOutput()))
+  {
+    std::cerr << "The reproducible gradient differs from the default one." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Every kernel variant, tiling and number of work units computes the same
+  // bits, with and without the variance.
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(image);
+  filter->SetOrderOfAccuracy(4);
+  filter->SetNoiseSigma(0.3);
+  filter->ReproducibleOn();
+  for (const bool computeGradientVariance : { true, false })
+  {
+    for (const FilterType::KernelVariantEnum kernelVariant :
+         { FilterType::KernelVariantEnum::Neighborhood, FilterType::KernelVariantEnum::Scanline })
+    {
+      for (const FilterType::TilingEnum tiling : { FilterType::TilingEnum::Slabs, FilterType::TilingEnum::Blocks })
+      {
+        for (const unsigned int numberOfWorkUnits : { 1u, 2u, 3u, 7u, 16u })
+        {
+          filter->SetComputeGradientVariance(computeGradientVariance);
+          filter->SetKernelVariant(kernelVariant);
+          filter->SetTiling(tiling);
+          filter->SetNumberOfWorkUnits(numberOfWorkUnits);
+          try
+          {
+            filter->Update();
+          }
+          catch (itk::ExceptionObject & ex)
+          {
+            std::cerr << "Exception caught!" << std::endl;
+            std::cerr << ex << std::endl;
+            return EXIT_FAILURE;
+          }
+          if (!ImagesAreIdentical(filter->GetOutput(), reference->GetOutput()) ||
+              (computeGradientVariance &&
+               !ImagesAreIdentical(filter->GetGradientVarianceOutput(), reference->GetGradientVarianceOutput())))
+          {
+            std::cerr << "The output differs from the reference with " << kernelVariant << ", " << tiling << " and "
+                      << numberOfWorkUnits << " work units, variance " << computeGradientVariance << std::endl;
+            return EXIT_FAILURE;
+          }
+        }
+      }
+    }
+  }
+
+  filter->Print(std::cout);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,118 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkShiftScaleImageFilter.h"
+#include "itkStreamingImageFilter.h"
+
+#include "itkHigherOrderAccurateGradientImageFilter.h"
+
+#include <cmath>
+
+int
+itkHigherOrderAccurateGradientImageFilterStreamingTest(int, char *[])
+{
+  constexpr unsigned int Dimension = 2;
+  using ImageType = itk::Image<float, Dimension>;
+  using ShiftScaleType = itk::ShiftScaleImageFilter<ImageType, ImageType>;
+  using FilterType = itk::HigherOrderAccurateGradientImageFilter<ImageType, double, double>;
+  using StreamingType = itk::StreamingImageFilter<FilterType::OutputImageType, FilterType::OutputImageType>;
+
+  ImageType::SizeType size;
+  size[0] = 24;
+  size[1] = 40;
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(size);
+  image->Allocate();
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion()); !it.IsAtEnd(); ++it)
+  {
+    const double x = it.GetIndex()[0];
+    const double y = it.GetIndex()[1];
+    it.Set(static_cast<float>(std::sin(0.4 * x) + std::cos(0.25 * y) * x));
+  }
+
+  FilterType::Pointer reference = FilterType::New();
+  reference->SetInput(image);
+  reference->SetOrderOfAccuracy(3);
+
+  // Count the pixels produced upstream of the streamed filter.
+  ShiftScaleType::Pointer shiftScale = ShiftScaleType::New();
+  shiftScale->SetInput(image);
+  itk::SizeValueType producedPixels = 0;
+  shiftScale->AddObserver(itk::EndEvent(), [&](const itk::EventObject &) {
+    producedPixels += shiftScale->GetOutput()->GetBufferedRegion().GetNumberOfPixels();
+  });
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(shiftScale->GetOutput());
+  filter->SetOrderOfAccuracy(3);
+
+  StreamingType::Pointer streamer = StreamingType::New();
+  streamer->SetInput(filter->GetOutput());
+  streamer->SetNumberOfStreamDivisions(4);
+
+  try
+  {
+    reference->Update();
+
+    // Without reuse, the slabs shared by consecutive pieces are produced twice.
+    streamer->Update();
+    if (producedPixels <= image->GetLargestPossibleRegion().GetNumberOfPixels())
+    {
+      std::cerr << "Expected the shared slabs to be produced again, " << producedPixels << " pixels were produced."
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    filter->ReuseStreamingHaloOn();
+    producedPixels = 0;
+    streamer->Update();
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << "Exception caught!" << std::endl;
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (producedPixels != image->GetLargestPossibleRegion().GetNumberOfPixels())
+  {
+    std::cerr << "Expected every pixel to be produced once, " << producedPixels << " pixels were produced."
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  for (itk::ImageRegionConstIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion()); !it.IsAtEnd();
+       ++it)
+  {
+    const FilterType::OutputPixelType expected = reference->GetOutput()->GetPixel(it.GetIndex());
+    const FilterType::OutputPixelType streamed = streamer->GetOutput()->GetPixel(it.GetIndex());
+    for (unsigned int i = 0; i < Dimension; ++i)
+    {
+      if (std::abs(streamed[i] - expected[i]) > 1e-9)
+      {
+        std::cerr << "At " << it.GetIndex() << ", the streamed gradient is " << streamed << " instead of " << expected
+                  << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  filter->Print(std::cout);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,174 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkHigherOrderAccurateGradientImageFilter.h"
+
+#include <cmath>
+
+int
+itkHigherOrderAccurateGradientImageFilterVarianceTest(int, char *[])
+{
+  constexpr unsigned int Dimension = 2;
+  using ImageType = itk::Image<float, Dimension>;
+  using FilterType = itk::HigherOrderAccurateGradientImageFilter<ImageType, float, float>;
+
+  ImageType::SizeType size;
+  size[0] = 20;
+  size[1] = 15;
+  ImageType::SpacingType spacing;
+  spacing[0] = 0.5;
+  spacing[1] = 2.0;
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(size);
+  image->SetSpacing(spacing);
+  image->Allocate();
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion()); !it.IsAtEnd(); ++it)
+  {
+    it.Set(static_cast<float>(it.GetIndex()[0] * it.GetIndex()[1]));
+  }
+
+  constexpr double sigma = 0.3;
+  FilterType::VarianceImageType::Pointer varianceImage = FilterType::VarianceImageType::New();
+  varianceImage->SetRegions(size);
+  varianceImage->SetSpacing(spacing);
+  varianceImage->Allocate();
+  varianceImage->FillBuffer(static_cast<float>(sigma * sigma));
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(image);
+  filter->SetOrderOfAccuracy(2);
+  filter->ComputeGradientVarianceOn();
+  filter->SetNoiseSigma(sigma);
+
+  FilterType::Pointer imageFilter = FilterType::New();
+  imageFilter->SetInput(image);
+  imageFilter->SetOrderOfAccuracy(2);
+  imageFilter->ComputeGradientVarianceOn();
+  imageFilter->SetVarianceImage(varianceImage);
+
+  constexpr double tolerance = 1e-5;
+
+  try
+  {
+    filter->Update();
+    imageFilter->Update();
+    const FilterType::OutputImageType * variance = filter->GetGradientVarianceOutput();
+    const FilterType::OutputImageType * imageVariance = imageFilter->GetGradientVarianceOutput();
+
+    // The coefficients of the fourth order kernel are 1/12, -2/3, 0, 2/3,
+    // -1/12.  At the first pixel, the two negative taps are replicated onto
+    // the same pixel and are merged before squaring.
+    const double interiorSum = 2.0 * (1.0 / 144.0 + 64.0 / 144.0);
+    const double borderSum = 49.0 / 144.0 + 64.0 / 144.0 + 1.0 / 144.0;
+
+    ImageType::IndexType interiorIndex;
+    interiorIndex[0] = 10;
+    interiorIndex[1] = 7;
+    ImageType::IndexType borderIndex;
+    borderIndex[0] = 0;
+    borderIndex[1] = 7;
+
+    for (unsigned int i = 0; i < Dimension; ++i)
+    {
+      const double expected = sigma * sigma * interiorSum / (spacing[i] * spacing[i]);
+      if (std::abs(variance->GetPixel(interiorIndex)[i] - expected) > tolerance)
+      {
+        std::cerr << "Unexpected interior variance " << variance->GetPixel(interiorIndex) << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+    const double expectedBorder = sigma * sigma * borderSum / (spacing[0] * spacing[0]);
+    if (std::abs(variance->GetPixel(borderIndex)[0] - expectedBorder) > tolerance)
+    {
+      std::cerr << "Unexpected border variance " << variance->GetPixel(borderIndex) << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    // A constant variance image is equivalent to the scalar noise sigma.
+    for (itk::ImageRegionConstIteratorWithIndex<FilterType::OutputImageType> it(variance,
+                                                                               variance->GetLargestPossibleRegion());
+         !it.IsAtEnd();
+         ++it)
+    {
+      for (unsigned int i = 0; i < Dimension; ++i)
+      {
+        if (std::abs(it.Get()[i] - imageVariance->GetPixel(it.GetIndex())[i]) > tolerance)
+        {
+          std::cerr << "Variance image mismatch at " << it.GetIndex() << ": " << it.Get() << " versus "
+                    << imageVariance->GetPixel(it.GetIndex()) << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+    }
+
+    // A quarter turn of the image direction swaps the component variances.
+    ImageType::DirectionType direction;
+    direction.Fill(0.0);
+    direction[0][1] = -1.0;
+    direction[1][0] = 1.0;
+    image->SetDirection(direction);
+    filter->Update();
+    const FilterType::OutputPixelType rotated = filter->GetGradientVarianceOutput()->GetPixel(interiorIndex);
+    for (unsigned int i = 0; i < Dimension; ++i)
+    {
+      const double expected = sigma * sigma * interiorSum / (spacing[1 - i] * spacing[1 - i]);
+      if (std::abs(rotated[i] - expected) > tolerance)
+      {
+        std::cerr << "Unexpected rotated variance " << rotated << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+
+    // At a corner, the taps of both components are clamped onto the corner
+    // pixel, whose merged coefficients correlate the components.  Rotated by
+    // an eighth of a turn, the covariance moves variance from the first
+    // physical component to the second.
+    const double halfSqrt2 = 0.5 * std::sqrt(2.0);
+    direction[0][0] = halfSqrt2;
+    direction[0][1] = -halfSqrt2;
+    direction[1][0] = halfSqrt2;
+    direction[1][1] = halfSqrt2;
+    image->SetDirection(direction);
+    filter->Update();
+    ImageType::IndexType cornerIndex;
+    cornerIndex.Fill(0);
+    const FilterType::OutputPixelType corner = filter->GetGradientVarianceOutput()->GetPixel(cornerIndex);
+    const double                      cornerMean =
+      0.5 * sigma * sigma * borderSum * (1.0 / (spacing[0] * spacing[0]) + 1.0 / (spacing[1] * spacing[1]));
+    const double                      cornerCovariance = sigma * sigma * (49.0 / 144.0) / (spacing[0] * spacing[1]);
+    if (std::abs(corner[0] - (cornerMean - cornerCovariance)) > tolerance ||
+        std::abs(corner[1] - (cornerMean + cornerCovariance)) > tolerance)
+    {
+      std::cerr << "Unexpected corner variance " << corner << " instead of [" << cornerMean - cornerCovariance << ", "
+                << cornerMean + cornerCovariance << "]" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << "Exception caught!" << std::endl;
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  filter->Print(std::cout);
+
+  return EXIT_SUCCESS;
+}
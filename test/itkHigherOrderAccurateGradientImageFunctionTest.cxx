@@ -0,0 +1,145 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMeanSquaresImageToImageMetricv4.h"
+#include "itkTranslationTransform.h"
+
+#include "itkHigherOrderAccurateGradientImageFilter.h"
+#include "itkHigherOrderAccurateGradientImageFunction.h"
+#include "itkHigherOrderAccurateMetricv4GradientSource.h"
+
+#include <cmath>
+
+int
+itkHigherOrderAccurateGradientImageFunctionTest(int, char *[])
+{
+  constexpr unsigned int Dimension = 2;
+  using ImageType = itk::Image<float, Dimension>;
+
+  ImageType::SizeType size;
+  size[0] = 32;
+  size[1] = 27;
+  ImageType::SpacingType spacing;
+  spacing[0] = 0.8;
+  spacing[1] = 1.2;
+
+  ImageType::Pointer fixed = ImageType::New();
+  fixed->SetRegions(size);
+  fixed->SetSpacing(spacing);
+  fixed->Allocate();
+  ImageType::Pointer moving = ImageType::New();
+  moving->SetRegions(size);
+  moving->SetSpacing(spacing);
+  moving->Allocate();
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(fixed, fixed->GetLargestPossibleRegion()); !it.IsAtEnd(); ++it)
+  {
+    const double x = it.GetIndex()[0] - 16.0;
+    const double y = it.GetIndex()[1] - 13.0;
+    it.Set(static_cast<float>(100.0 * std::exp(-(x * x + y * y) / 40.0)));
+    moving->SetPixel(it.GetIndex(), static_cast<float>(100.0 * std::exp(-((x - 1.5) * (x - 1.5) + y * y) / 40.0)));
+  }
+
+  using FunctionType = itk::HigherOrderAccurateGradientImageFunction<ImageType, double>;
+  FunctionType::Pointer function = FunctionType::New();
+  function->SetOrderOfAccuracy(3);
+  function->SetInputImage(moving);
+
+  using FilterType = itk::HigherOrderAccurateGradientImageFilter<ImageType, double, double>;
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(moving);
+  filter->SetOrderOfAccuracy(3);
+
+  using MetricType = itk::MeanSquaresImageToImageMetricv4<ImageType, ImageType>;
+  using TransformType = itk::TranslationTransform<double, Dimension>;
+  using GradientSourceType = itk::HigherOrderAccurateMetricv4GradientSource<MetricType>;
+
+  try
+  {
+    // The function agrees with the filter on the grid.
+    filter->Update();
+    const FilterType::OutputImageType * gradient = filter->GetOutput();
+    for (itk::ImageRegionConstIteratorWithIndex<FilterType::OutputImageType> it(
+           gradient, gradient->GetLargestPossibleRegion());
+         !it.IsAtEnd();
+         ++it)
+    {
+      const FunctionType::OutputType value = function->EvaluateAtIndex(it.GetIndex());
+      for (unsigned int i = 0; i < Dimension; ++i)
+      {
+        if (std::abs(value[i] - it.Get()[i]) > 1e-8 * (1.0 + std::abs(it.Get()[i])))
+        {
+          std::cerr << "Gradient mismatch at " << it.GetIndex() << ": " << value << " versus " << it.Get()
+                    << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+    }
+
+    // The precomputed and the on the fly gradient sources give the same
+    // metric derivative.
+    MetricType::DerivativeType derivatives[2];
+    for (unsigned int mode = 0; mode < 2; ++mode)
+    {
+      TransformType::Pointer        transform = TransformType::New();
+      TransformType::ParametersType parameters(Dimension);
+      parameters[0] = 0.4;
+      parameters[1] = -0.3;
+      transform->SetParameters(parameters);
+
+      MetricType::Pointer metric = MetricType::New();
+      metric->SetFixedImage(fixed);
+      metric->SetMovingImage(moving);
+      metric->SetMovingTransform(transform);
+
+      GradientSourceType::Pointer gradientSource = GradientSourceType::New();
+      gradientSource->SetOrderOfAccuracy(3);
+      gradientSource->SetMemoryBudget(mode == 0 ? itk::NumericTraits<itk::SizeValueType>::max() : 0);
+      gradientSource->ConfigureMetric(metric);
+      if (gradientSource->GetPrecomputeMovingImageGradient() != (mode == 0) ||
+          metric->GetUseMovingImageGradientFilter() != (mode == 0))
+      {
+        std::cerr << "Unexpected gradient mode for memory budget " << gradientSource->GetMemoryBudget() << std::endl;
+        return EXIT_FAILURE;
+      }
+
+      metric->Initialize();
+      MetricType::MeasureType value;
+      metric->GetValueAndDerivative(value, derivatives[mode]);
+      gradientSource->Print(std::cout);
+    }
+
+    for (unsigned int i = 0; i < derivatives[0].Size(); ++i)
+    {
+      if (std::abs(derivatives[0][i] - derivatives[1][i]) > 1e-6 * (1.0 + std::abs(derivatives[0][i])))
+      {
+        std::cerr << "Metric derivative mismatch: " << derivatives[0] << " versus " << derivatives[1] << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << "Exception caught!" << std::endl;
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  function->Print(std::cout);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,323 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkDerivativeImageFilter.h"
+#include "itkGradientRecursiveGaussianImageFilter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTimeProbe.h"
+
+#include "itkHigherOrderAccurateDerivativeImageFilter.h"
+#include "itkHigherOrderAccurateGradientImageFilter.h"
+#include "itkHigherOrderAccurateStridedViewGradientCalculator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Accuracy and throughput of the derivative along x of analytic fields, for
+// every order of accuracy of the higher order accurate kernels and for the
+// ITK derivative filters.  For each field, the configurations that no other
+// configuration beats on both error and time form the Pareto frontier.
+//
+// Usage: itkHigherOrderAccurateGradientParetoBenchmark report.csv [size] [repetitions]
+
+namespace
+{
+
+constexpr unsigned int Dimension = 2;
+using ImageType = itk::Image<double, Dimension>;
+
+struct Field
+{
+  std::string                           Name;
+  std::function<double(double, double)> Value;
+  std::function<double(double, double)> DerivativeX;
+};
+
+struct Method
+{
+  std::string                                         Name;
+  unsigned int                                        OrderOfAccuracy;
+  std::function<void(const ImageType *)>              Run;
+  std::function<double(const ImageType::IndexType &)> Result;
+};
+
+struct Measurement
+{
+  std::string  Field;
+  std::string  Method;
+  unsigned int OrderOfAccuracy;
+  double       RMSError;
+  double       MaximumError;
+  double       Seconds;
+  bool         Pareto;
+};
+
+} // end anonymous namespace
+
+int
+itkHigherOrderAccurateGradientParetoBenchmark(int argc, char * argv[])
+{
+  if (argc < 2)
+  {
+    std::cerr << "Usage: " << argv[0];
+    std::cerr << " report.csv [size] [repetitions]";
+    std::cerr << std::endl;
+    return EXIT_FAILURE;
+  }
+  const itk::SizeValueType imageSize = argc > 2 ? std::stoul(argv[2]) : 256;
+  const unsigned int       repetitions = argc > 3 ? std::stoul(argv[3]) : 5;
+
+  // Coordinates in pixels from the center of the image.
+  const double center = 0.5 * (imageSize - 1);
+  const double scale = 1.0 / imageSize;
+
+  std::vector<Field> fields;
+  fields.push_back(Field{ "polynomial",
+                          [=](double x, double y) { return std::pow(x * scale, 3) - 2.0 * x * y * scale * scale; },
+                          [=](double x, double y) {
+                            return 3.0 * x * x * scale * scale * scale - 2.0 * y * scale * scale;
+                          } });
+  for (double wavenumber : { 0.25, 0.5, 1.0, 2.0 })
+  {
+    fields.push_back(Field{ "sinusoid_k" + std::to_string(wavenumber).substr(0, 4),
+                            [=](double x, double y) { return std::sin(wavenumber * x + 0.3 * y); },
+                            [=](double x, double y) { return wavenumber * std::cos(wavenumber * x + 0.3 * y); } });
+  }
+  const double sigma = 0.1 * imageSize;
+  fields.push_back(Field{ "gaussian",
+                          [=](double x, double y) { return std::exp(-(x * x + y * y) / (2.0 * sigma * sigma)); },
+                          [=](double x, double y) {
+                            return -x / (sigma * sigma) * std::exp(-(x * x + y * y) / (2.0 * sigma * sigma));
+                          } });
+
+  // The methods, which all compute the derivative along x of the same input.
+  std::vector<Method> methods;
+  for (unsigned int accuracy = 1; accuracy <= 5; ++accuracy)
+  {
+    using FilterType = itk::HigherOrderAccurateDerivativeImageFilter<ImageType, ImageType>;
+    FilterType::Pointer filter = FilterType::New();
+    filter->SetOrder(1);
+    filter->SetDirection(0);
+    filter->SetOrderOfAccuracy(accuracy);
+    methods.push_back(Method{ "HigherOrderAccurateDerivativeImageFilter",
+                              accuracy,
+                              [=](const ImageType * image) {
+                                filter->SetInput(image);
+                                filter->Modified();
+                                filter->Update();
+                              },
+                              [=](const ImageType::IndexType & index) {
+                                return filter->GetOutput()->GetPixel(index);
+                              } });
+  }
+  for (unsigned int accuracy = 1; accuracy <= 5; ++accuracy)
+  {
+    using FilterType = itk::HigherOrderAccurateGradientImageFilter<ImageType, double, double>;
+    FilterType::Pointer filter = FilterType::New();
+    filter->SetOrderOfAccuracy(accuracy);
+    methods.push_back(Method{ "HigherOrderAccurateGradientImageFilter",
+                              accuracy,
+                              [=](const ImageType * image) {
+                                filter->SetInput(image);
+                                filter->Modified();
+                                filter->Update();
+                              },
+                              [=](const ImageType::IndexType & index) {
+                                return filter->GetOutput()->GetPixel(index)[0];
+                              } });
+  }
+  for (unsigned int accuracy = 1; accuracy <= 5; ++accuracy)
+  {
+    using CalculatorType = itk::HigherOrderAccurateStridedViewGradientCalculator<double, Dimension, double>;
+    CalculatorType::Pointer calculator = CalculatorType::New();
+    calculator->SetOrderOfAccuracy(accuracy);
+    auto derivative = std::make_shared<std::vector<double>>(imageSize * imageSize);
+    methods.push_back(Method{ "HigherOrderAccurateStridedViewGradientCalculator",
+                              accuracy,
+                              [=](const ImageType * image) {
+                                const CalculatorType::SizeType size = image->GetBufferedRegion().GetSize();
+                                calculator->ComputeDerivative(
+                                  CalculatorType::InputViewType::Contiguous(image->GetBufferPointer(), size),
+                                  0,
+                                  1,
+                                  CalculatorType::OutputViewType::Contiguous(derivative->data(), size));
+                              },
+                              [=](const ImageType::IndexType & index) {
+                                return (*derivative)[index[0] + imageSize * index[1]];
+                              } });
+  }
+  {
+    using FilterType = itk::DerivativeImageFilter<ImageType, ImageType>;
+    FilterType::Pointer filter = FilterType::New();
+    filter->SetOrder(1);
+    filter->SetDirection(0);
+    methods.push_back(Method{ "DerivativeImageFilter",
+                              0,
+                              [=](const ImageType * image) {
+                                filter->SetInput(image);
+                                filter->Modified();
+                                filter->Update();
+                              },
+                              [=](const ImageType::IndexType & index) {
+                                return filter->GetOutput()->GetPixel(index);
+                              } });
+  }
+  {
+    using GradientImageType = itk::Image<itk::CovariantVector<double, Dimension>, Dimension>;
+    using FilterType = itk::GradientRecursiveGaussianImageFilter<ImageType, GradientImageType>;
+    FilterType::Pointer filter = FilterType::New();
+    filter->SetSigma(1.0);
+    methods.push_back(Method{ "GradientRecursiveGaussianImageFilter",
+                              0,
+                              [=](const ImageType * image) {
+                                filter->SetInput(image);
+                                filter->Modified();
+                                filter->Update();
+                              },
+                              [=](const ImageType::IndexType & index) {
+                                return filter->GetOutput()->GetPixel(index)[0];
+                              } });
+  }
+
+  // The error is measured away from the border, where the kernels differ in
+  // their boundary condition rather than in their accuracy.
+  const itk::IndexValueType margin = 8;
+  ImageType::RegionType     interior;
+  interior.SetIndex({ { margin, margin } });
+  interior.SetSize({ { imageSize - 2 * margin, imageSize - 2 * margin } });
+
+  std::vector<Measurement> measurements;
+  try
+  {
+    for (const Field & field : fields)
+    {
+      ImageType::Pointer image = ImageType::New();
+      image->SetRegions(ImageType::SizeType{ { imageSize, imageSize } });
+      image->Allocate();
+      for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion()); !it.IsAtEnd();
+           ++it)
+      {
+        it.Set(field.Value(it.GetIndex()[0] - center, it.GetIndex()[1] - center));
+      }
+
+      for (const Method & method : methods)
+      {
+        // The fastest of the repetitions, after a first run that warms the
+        // caches and allocates the output.
+        method.Run(image);
+        double seconds = itk::NumericTraits<double>::max();
+        for (unsigned int r = 0; r < repetitions; ++r)
+        {
+          itk::TimeProbe probe;
+          probe.Start();
+          method.Run(image);
+          probe.Stop();
+          seconds = std::min(seconds, probe.GetTotal());
+        }
+
+        double sumOfSquares = 0.0;
+        double maximumError = 0.0;
+        double maximumValue = 0.0;
+        for (itk::ImageRegionConstIteratorWithIndex<ImageType> it(image, interior); !it.IsAtEnd(); ++it)
+        {
+          const double expected = field.DerivativeX(it.GetIndex()[0] - center, it.GetIndex()[1] - center);
+          const double error = std::abs(method.Result(it.GetIndex()) - expected);
+          sumOfSquares += error * error;
+          maximumError = std::max(maximumError, error);
+          maximumValue = std::max(maximumValue, std::abs(expected));
+        }
+        const double rmsError = std::sqrt(sumOfSquares / interior.GetNumberOfPixels());
+        measurements.push_back(Measurement{ field.Name,
+                                             method.Name,
+                                             method.OrderOfAccuracy,
+                                             rmsError / maximumValue,
+                                             maximumError / maximumValue,
+                                             seconds,
+                                             false });
+      }
+    }
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << "Exception caught!" << std::endl;
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  for (Measurement & candidate : measurements)
+  {
+    candidate.Pareto = std::none_of(measurements.begin(), measurements.end(), [&](const Measurement & other) {
+      return other.Field == candidate.Field && other.RMSError <= candidate.RMSError &&
+             other.Seconds <= candidate.Seconds &&
+             (other.RMSError < candidate.RMSError || other.Seconds < candidate.Seconds);
+    });
+  }
+
+  std::ofstream report(argv[1]);
+  report << "field,method,order_of_accuracy,relative_rms_error,relative_max_error,seconds,megapixels_per_second,pareto"
+         << std::endl;
+  const double megapixels = imageSize * imageSize * 1e-6;
+  for (const Measurement & measurement : measurements)
+  {
+    report << measurement.Field << ',' << measurement.Method << ',' << measurement.OrderOfAccuracy << ','
+           << measurement.RMSError << ',' << measurement.MaximumError << ',' << measurement.Seconds << ','
+           << megapixels / measurement.Seconds << ',' << measurement.Pareto << std::endl;
+    if (measurement.Pareto)
+    {
+      std::cout << measurement.Field << ": " << measurement.Method;
+      if (measurement.OrderOfAccuracy > 0)
+      {
+        std::cout << " accuracy " << measurement.OrderOfAccuracy;
+      }
+      std::cout << ", relative RMS error " << measurement.RMSError << ", " << megapixels / measurement.Seconds
+                << " Mpixel/s" << std::endl;
+    }
+  }
+
+  // Sanity of the measurements: on a smooth field, raising the order of
+  // accuracy lowers the error, and the kernel variants agree.
+  auto find = [&](const std::string & field, const std::string & method, unsigned int accuracy) {
+    return *std::find_if(measurements.begin(), measurements.end(), [&](const Measurement & measurement) {
+      return measurement.Field == field && measurement.Method == method && measurement.OrderOfAccuracy == accuracy;
+    });
+  };
+  for (unsigned int accuracy = 2; accuracy <= 5; ++accuracy)
+  {
+    const Measurement & higher = find("sinusoid_k0.25", "HigherOrderAccurateDerivativeImageFilter", accuracy);
+    const Measurement & lower = find("sinusoid_k0.25", "HigherOrderAccurateDerivativeImageFilter", accuracy - 1);
+    if (!(higher.RMSError < lower.RMSError))
+    {
+      std::cerr << "The error of accuracy " << accuracy << " is not lower than the error of accuracy " << accuracy - 1
+                << ": " << higher.RMSError << " versus " << lower.RMSError << std::endl;
+      return EXIT_FAILURE;
+    }
+    const Measurement & scanline = find("sinusoid_k0.25", "HigherOrderAccurateStridedViewGradientCalculator", accuracy);
+    if (std::abs(scanline.RMSError - higher.RMSError) > 1e-9)
+    {
+      std::cerr << "The kernel variants disagree at accuracy " << accuracy << ": " << scanline.RMSError << " versus "
+                << higher.RMSError << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
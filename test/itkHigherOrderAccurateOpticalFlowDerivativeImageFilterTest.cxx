@@ -0,0 +1,177 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkHigherOrderAccurateGradientImageFilter.h"
+#include "itkHigherOrderAccurateOpticalFlowDerivativeImageFilter.h"
+
+#include <cmath>
+
+int
+itkHigherOrderAccurateOpticalFlowDerivativeImageFilterTest(int, char *[])
+{
+  constexpr unsigned int Dimension = 2;
+  constexpr unsigned int NumberOfFrames = 3;
+  using ImageType = itk::Image<float, Dimension>;
+  using FilterType = itk::HigherOrderAccurateOpticalFlowDerivativeImageFilter<ImageType, float, float>;
+  using GradientFilterType = itk::HigherOrderAccurateGradientImageFilter<ImageType, double, double>;
+
+  ImageType::SizeType size;
+  size[0] = 181;
+  size[1] = 157;
+  ImageType::SpacingType spacing;
+  spacing[0] = 0.5;
+  spacing[1] = 1.0;
+
+  // Every pixel varies linearly in time, so the temporal derivative is the
+  // slope and the mean frame is the middle frame.
+  ImageType::Pointer frames[NumberOfFrames];
+  for (unsigned int t = 0; t < NumberOfFrames; ++t)
+  {
+    frames[t] = ImageType::New();
+    frames[t]->SetRegions(size);
+    frames[t]->SetSpacing(spacing);
+    frames[t]->Allocate();
+    for (itk::ImageRegionIteratorWithIndex<ImageType> it(frames[t], frames[t]->GetLargestPossibleRegion());
+         !it.IsAtEnd();
+         ++it)
+    {
+      const double x = it.GetIndex()[0];
+      const double y = it.GetIndex()[1];
+      it.Set(static_cast<float>(std::sin(0.3 * x) * std::cos(0.2 * y) + t * (0.1 * x - 0.05 * y)));
+    }
+  }
+
+  FilterType::Pointer filter = FilterType::New();
+  for (unsigned int t = 0; t < NumberOfFrames; ++t)
+  {
+    filter->SetInput(t, frames[t]);
+  }
+  filter->SetOrderOfAccuracy(3);
+
+  GradientFilterType::Pointer gradientFilter = GradientFilterType::New();
+  gradientFilter->SetInput(frames[1]);
+  gradientFilter->SetOrderOfAccuracy(3);
+
+  FilterType::SizeType windowRadius;
+  windowRadius[0] = 2;
+  windowRadius[1] = 1;
+
+  try
+  {
+    filter->Update();
+    gradientFilter->Update();
+    FilterType::OutputImageType::Pointer derivatives = filter->GetOutput();
+    derivatives->DisconnectPipeline();
+    if (derivatives->GetNumberOfComponentsPerPixel() != Dimension + 1)
+    {
+      std::cerr << "Unexpected number of components " << derivatives->GetNumberOfComponentsPerPixel() << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    for (itk::ImageRegionConstIteratorWithIndex<ImageType> it(frames[0], frames[0]->GetLargestPossibleRegion());
+         !it.IsAtEnd();
+         ++it)
+    {
+      const ImageType::IndexType                   index = it.GetIndex();
+      const FilterType::OutputImageType::PixelType value = derivatives->GetPixel(index);
+      const GradientFilterType::OutputPixelType    gradient = gradientFilter->GetOutput()->GetPixel(index);
+      const double                                 temporal = 0.1 * index[0] - 0.05 * index[1];
+      for (unsigned int i = 0; i < Dimension; ++i)
+      {
+        if (std::abs(value[i] - gradient[i]) > 1e-4)
+        {
+          std::cerr << "Spatial derivative mismatch at " << index << ": " << value << " versus " << gradient
+                    << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+      if (std::abs(value[Dimension] - temporal) > 1e-4)
+      {
+        std::cerr << "Temporal derivative mismatch at " << index << ": " << value << " versus " << temporal
+                  << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+
+    // The windowed moments are the box sums of the products of the
+    // derivatives, with the window clipped at the image boundary.
+    // With one work unit, the fields of the whole image exceed the cache and
+    // it is processed in several tiles.
+    filter->ComputeLucasKanadeMomentsOn();
+    filter->SetWindowRadius(windowRadius);
+    filter->SetNumberOfWorkUnits(1);
+    filter->Update();
+    const FilterType::OutputImageType * moments = filter->GetOutput();
+    const unsigned int                  numberOfComponents = Dimension + 1 + Dimension * (Dimension + 1) / 2 + Dimension;
+    if (moments->GetNumberOfComponentsPerPixel() != numberOfComponents)
+    {
+      std::cerr << "Unexpected number of components " << moments->GetNumberOfComponentsPerPixel() << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    const ImageType::RegionType largestRegion = frames[0]->GetLargestPossibleRegion();
+    for (itk::ImageRegionConstIteratorWithIndex<ImageType> it(frames[0], largestRegion); !it.IsAtEnd(); ++it)
+    {
+      ImageType::RegionType window;
+      window.SetIndex(it.GetIndex());
+      window.SetSize({ { 1, 1 } });
+      window.PadByRadius(windowRadius);
+      window.Crop(largestRegion);
+
+      double expected[Dimension * (Dimension + 1) / 2 + Dimension] = {};
+      for (itk::ImageRegionConstIteratorWithIndex<ImageType> wit(frames[0], window); !wit.IsAtEnd(); ++wit)
+      {
+        const FilterType::OutputImageType::PixelType value = derivatives->GetPixel(wit.GetIndex());
+        unsigned int                                 m = 0;
+        for (unsigned int i = 0; i < Dimension; ++i)
+        {
+          for (unsigned int j = i; j < Dimension; ++j)
+          {
+            expected[m++] += value[i] * value[j];
+          }
+        }
+        for (unsigned int i = 0; i < Dimension; ++i)
+        {
+          expected[m++] += value[i] * value[Dimension];
+        }
+      }
+
+      const FilterType::OutputImageType::PixelType value = moments->GetPixel(it.GetIndex());
+      for (unsigned int m = 0; m < Dimension * (Dimension + 1) / 2 + Dimension; ++m)
+      {
+        if (std::abs(value[Dimension + 1 + m] - expected[m]) > 1e-3 * (1.0 + std::abs(expected[m])))
+        {
+          std::cerr << "Moment " << m << " mismatch at " << it.GetIndex() << ": " << value[Dimension + 1 + m]
+                    << " versus " << expected[m] << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+    }
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << "Exception caught!" << std::endl;
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  filter->Print(std::cout);
+
+  return EXIT_SUCCESS;
+}
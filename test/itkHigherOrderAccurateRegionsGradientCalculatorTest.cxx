@@ -0,0 +1,132 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkHigherOrderAccurateGradientImageFilter.h"
+#include "itkHigherOrderAccurateRegionsGradientCalculator.h"
+
+#include <cmath>
+
+int
+itkHigherOrderAccurateRegionsGradientCalculatorTest(int, char *[])
+{
+  constexpr unsigned int Dimension = 2;
+  using ImageType = itk::Image<float, Dimension>;
+  using CalculatorType = itk::HigherOrderAccurateRegionsGradientCalculator<ImageType, double>;
+  using FilterType = itk::HigherOrderAccurateGradientImageFilter<ImageType, double, double>;
+
+  ImageType::SizeType size;
+  size[0] = 32;
+  size[1] = 27;
+  ImageType::SpacingType spacing;
+  spacing[0] = 0.8;
+  spacing[1] = 1.2;
+  ImageType::DirectionType direction;
+  direction(0, 0) = 0.6;
+  direction(0, 1) = -0.8;
+  direction(1, 0) = 0.8;
+  direction(1, 1) = 0.6;
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(size);
+  image->SetSpacing(spacing);
+  image->SetDirection(direction);
+  image->Allocate();
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion()); !it.IsAtEnd(); ++it)
+  {
+    const double x = it.GetIndex()[0] - 16.0;
+    const double y = it.GetIndex()[1] - 13.0;
+    it.Set(static_cast<float>(100.0 * std::exp(-(x * x + y * y) / 40.0)));
+  }
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(image);
+  filter->SetOrderOfAccuracy(3);
+  try
+  {
+    filter->Update();
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << "Exception caught!" << std::endl;
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // The halos of the first three regions overlap, the last one is apart.
+  CalculatorType::RegionListType regions(4);
+  regions[0].SetIndex({ { 2, 2 } });
+  regions[0].SetSize({ { 5, 4 } });
+  regions[1].SetIndex({ { 8, 5 } });
+  regions[1].SetSize({ { 4, 4 } });
+  regions[2].SetIndex({ { 0, 0 } });
+  regions[2].SetSize({ { 3, 3 } });
+  regions[3].SetIndex({ { 25, 20 } });
+  regions[3].SetSize({ { 5, 7 } });
+
+  CalculatorType::Pointer calculator = CalculatorType::New();
+  calculator->SetImage(image);
+  calculator->SetOrderOfAccuracy(3);
+  calculator->SetNumberOfWorkUnits(3);
+  try
+  {
+    calculator->Compute(regions);
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << "Exception caught!" << std::endl;
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (calculator->GetHaloRegions().size() != 2)
+  {
+    std::cerr << "Expected 2 halo regions, got " << calculator->GetHaloRegions().size() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const std::vector<double> &             gradients = calculator->GetPackedGradients();
+  const std::vector<itk::SizeValueType> & offsets = calculator->GetRegionOffsets();
+  for (unsigned int k = 0; k < regions.size(); ++k)
+  {
+    const double * regionGradient = gradients.data() + offsets[k];
+    for (itk::ImageRegionConstIteratorWithIndex<ImageType> it(image, regions[k]); !it.IsAtEnd();
+         ++it, regionGradient += Dimension)
+    {
+      const FilterType::OutputPixelType expected = filter->GetOutput()->GetPixel(it.GetIndex());
+      for (unsigned int i = 0; i < Dimension; ++i)
+      {
+        if (std::abs(regionGradient[i] - expected[i]) > 1e-6)
+        {
+          std::cerr << "Region " << k << " at " << it.GetIndex() << ": " << regionGradient[i] << " versus "
+                    << expected[i] << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+    }
+    if (regionGradient != gradients.data() + offsets[k + 1])
+    {
+      std::cerr << "Unexpected size of the gradient of region " << k << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  calculator->Print(std::cout);
+
+  return EXIT_SUCCESS;
+}
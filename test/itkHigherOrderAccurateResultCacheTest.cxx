@@ -0,0 +1,198 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkHigherOrderAccurateDerivativeImageFilter.h"
+#include "itkHigherOrderAccurateGradientImageFilter.h"
+#include "itkHigherOrderAccurateResultCache.h"
+
+#include <cmath>
+
+int
+itkHigherOrderAccurateResultCacheTest(int argc, char * argv[])
+{
+  if (argc < 2)
+  {
+    std::cerr << "Usage: " << argv[0] << " cacheDirectory" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  constexpr unsigned int Dimension = 2;
+  using ImageType = itk::Image<float, Dimension>;
+  using FilterType = itk::HigherOrderAccurateGradientImageFilter<ImageType, double, double>;
+  using DerivativeFilterType = itk::HigherOrderAccurateDerivativeImageFilter<ImageType, ImageType>;
+  using CacheType = itk::HigherOrderAccurateResultCache;
+
+  ImageType::SizeType size;
+  size.Fill(16);
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(size);
+  image->Allocate();
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion()); !it.IsAtEnd(); ++it)
+  {
+    const double x = it.GetIndex()[0];
+    const double y = it.GetIndex()[1];
+    it.Set(static_cast<float>(std::sin(0.3 * x) * std::cos(0.2 * y)));
+  }
+  // One gradient entry holds 16 x 16 pixels of two doubles.
+  constexpr itk::SizeValueType entrySize = 16 * 16 * 2 * sizeof(double);
+
+  CacheType::Pointer cache = CacheType::New();
+  cache->SetDirectory(argv[1]);
+  cache->Clear();
+
+  try
+  {
+    FilterType::Pointer computing = FilterType::New();
+    computing->SetInput(image);
+    computing->SetOrderOfAccuracy(3);
+    computing->SetResultCache(cache);
+    computing->Update();
+    if (cache->GetSize() != entrySize)
+    {
+      std::cerr << "Expected one entry after the first run, the cache holds " << cache->GetSize() << " bytes."
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    // The same input and parameters are read back, without a new entry.
+    FilterType::Pointer loading = FilterType::New();
+    loading->SetInput(image);
+    loading->SetOrderOfAccuracy(3);
+    loading->SetResultCache(cache);
+    loading->Update();
+    if (cache->GetSize() != entrySize)
+    {
+      std::cerr << "The second run did not reuse the entry." << std::endl;
+      return EXIT_FAILURE;
+    }
+    for (itk::ImageRegionConstIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion()); !it.IsAtEnd();
+         ++it)
+    {
+      const FilterType::OutputPixelType expected = computing->GetOutput()->GetPixel(it.GetIndex());
+      const FilterType::OutputPixelType loaded = loading->GetOutput()->GetPixel(it.GetIndex());
+      if (expected != loaded)
+      {
+        std::cerr << "Loaded " << loaded << " instead of " << expected << " at " << it.GetIndex() << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+
+    // Any change of the parameters or of the input is a new entry.
+    loading->SetOrderOfAccuracy(2);
+    loading->Update();
+    if (cache->GetSize() != 2 * entrySize)
+    {
+      std::cerr << "Changing the order of accuracy did not add an entry." << std::endl;
+      return EXIT_FAILURE;
+    }
+    image->SetPixel({ { 3, 4 } }, 10.0f);
+    image->Modified();
+    loading->Update();
+    if (cache->GetSize() != 3 * entrySize)
+    {
+      std::cerr << "Changing the input did not add an entry." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    // The derivative filter shares the cache.
+    DerivativeFilterType::Pointer derivative = DerivativeFilterType::New();
+    derivative->SetInput(image);
+    derivative->SetDirection(1);
+    derivative->SetResultCache(cache);
+    derivative->Update();
+    DerivativeFilterType::Pointer loadingDerivative = DerivativeFilterType::New();
+    loadingDerivative->SetInput(image);
+    loadingDerivative->SetDirection(1);
+    loadingDerivative->SetResultCache(cache);
+    loadingDerivative->Update();
+    const itk::SizeValueType derivativeEntrySize = 16 * 16 * sizeof(float);
+    if (cache->GetSize() != 3 * entrySize + derivativeEntrySize)
+    {
+      std::cerr << "Expected a single derivative entry, the cache holds " << cache->GetSize() << " bytes." << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (loadingDerivative->GetOutput()->GetPixel({ { 3, 4 } }) != derivative->GetOutput()->GetPixel({ { 3, 4 } }))
+    {
+      std::cerr << "The loaded derivative differs from the computed one." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    // Storing beyond the maximum size evicts the least recently used entries.
+    cache->SetMaximumSize(2 * entrySize);
+    computing->SetOrderOfAccuracy(4);
+    computing->Update();
+    if (cache->GetSize() > 2 * entrySize)
+    {
+      std::cerr << "The cache holds " << cache->GetSize() << " bytes, more than its maximum size." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    // The least recently loaded or stored entries are evicted first, also
+    // within the same second.
+    constexpr itk::SizeValueType imageEntrySize = 16 * 16 * sizeof(float);
+    cache->Clear();
+    cache->SetMaximumSize(2 * imageEntrySize);
+    cache->Store("first", image.GetPointer());
+    cache->Store("second", image.GetPointer());
+    if (!cache->Load("first", image.GetPointer()))
+    {
+      std::cerr << "Could not load the first entry." << std::endl;
+      return EXIT_FAILURE;
+    }
+    cache->Store("third", image.GetPointer());
+    if (!cache->Contains("first") || cache->Contains("second") || !cache->Contains("third"))
+    {
+      std::cerr << "The second entry was not the one evicted." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    // The digest of an image is only recomputed once the image is modified.
+    const std::string digest = cache->ComputeImageDigest(image.GetPointer());
+    image->GetBufferPointer()[0] += 1.0f;
+    if (cache->ComputeImageDigest(image.GetPointer()) != digest)
+    {
+      std::cerr << "The digest was recomputed for an unmodified image." << std::endl;
+      return EXIT_FAILURE;
+    }
+    image->Modified();
+    if (cache->ComputeImageDigest(image.GetPointer()) == digest)
+    {
+      std::cerr << "The digest was not recomputed for a modified image." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    cache->Print(std::cout);
+    computing->Print(std::cout);
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << "Exception caught!" << std::endl;
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  cache->Clear();
+  if (cache->GetSize() != 0)
+  {
+    std::cerr << "Clear() left " << cache->GetSize() << " bytes." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
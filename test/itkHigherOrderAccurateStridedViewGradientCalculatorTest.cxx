@@ -0,0 +1,173 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkHigherOrderAccurateDerivativeImageFilter.h"
+#include "itkHigherOrderAccurateGradientImageFilter.h"
+#include "itkHigherOrderAccurateStridedViewGradientCalculator.h"
+
+#include <cmath>
+#include <vector>
+
+int
+itkHigherOrderAccurateStridedViewGradientCalculatorTest(int, char *[])
+{
+  constexpr unsigned int Dimension = 3;
+  using ImageType = itk::Image<float, Dimension>;
+  using CalculatorType = itk::HigherOrderAccurateStridedViewGradientCalculator<float, Dimension, double>;
+  using FilterType = itk::HigherOrderAccurateGradientImageFilter<ImageType, double, double>;
+  using DerivativeFilterType = itk::HigherOrderAccurateDerivativeImageFilter<ImageType, ImageType>;
+
+  // A buffer of 2 interleaved channels over 11 x 9 x 7 pixels.
+  constexpr unsigned int                    channels = 2;
+  const itk::OffsetValueType                bufferSize[Dimension] = { 11, 9, 7 };
+  std::vector<float>                        buffer(channels * 11 * 9 * 7);
+  CalculatorType::InputViewType::StrideType bufferStrides;
+  bufferStrides[0] = channels * sizeof(float);
+  bufferStrides[1] = bufferStrides[0] * bufferSize[0];
+  bufferStrides[2] = bufferStrides[1] * bufferSize[1];
+  for (itk::OffsetValueType z = 0; z < bufferSize[2]; ++z)
+  {
+    for (itk::OffsetValueType y = 0; y < bufferSize[1]; ++y)
+    {
+      for (itk::OffsetValueType x = 0; x < bufferSize[0]; ++x)
+      {
+        const itk::OffsetValueType pixel = x + bufferSize[0] * (y + bufferSize[1] * z);
+        buffer[channels * pixel] = -1.0f;
+        buffer[channels * pixel + 1] = static_cast<float>(std::sin(0.3 * x) * std::cos(0.2 * y) + 0.1 * z * z);
+      }
+    }
+  }
+
+  // The view reads channel 1 of every other pixel along x, rows 1 to 8, and
+  // the slices in reverse order.
+  CalculatorType::SizeType viewSize;
+  viewSize[0] = 6;
+  viewSize[1] = 8;
+  viewSize[2] = 7;
+  CalculatorType::InputViewType::StrideType viewStrides;
+  viewStrides[0] = 2 * bufferStrides[0];
+  viewStrides[1] = bufferStrides[1];
+  viewStrides[2] = -bufferStrides[2];
+  const float * viewBase = buffer.data() + 1 + channels * (bufferSize[0] * (1 + bufferSize[1] * 6));
+  const CalculatorType::InputViewType view(viewBase, viewSize, viewStrides);
+
+  // The same values in a contiguous image, for the reference filters.
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(viewSize);
+  CalculatorType::SpacingType spacing;
+  spacing[0] = 1.0;
+  spacing[1] = 0.7;
+  spacing[2] = 1.3;
+  CalculatorType::DirectionType direction;
+  direction.SetIdentity();
+  direction(0, 0) = 0.6;
+  direction(0, 1) = -0.8;
+  direction(1, 0) = 0.8;
+  direction(1, 1) = 0.6;
+  image->SetSpacing(spacing);
+  image->SetDirection(direction);
+  image->Allocate();
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion()); !it.IsAtEnd(); ++it)
+  {
+    it.Set(view.GetValue(it.GetIndex()));
+  }
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(image);
+  filter->SetOrderOfAccuracy(3);
+  DerivativeFilterType::Pointer derivativeFilter = DerivativeFilterType::New();
+  derivativeFilter->SetInput(image);
+  derivativeFilter->SetOrder(1);
+  derivativeFilter->SetDirection(2);
+  derivativeFilter->SetOrderOfAccuracy(3);
+
+  // Channel-first gradient, and a derivative along the reversed axis written
+  // with a padded row stride.
+  const itk::SizeValueType         numberOfPixels = viewSize[0] * viewSize[1] * viewSize[2];
+  std::vector<double>              gradient(Dimension * numberOfPixels);
+  CalculatorType::GradientViewType gradientViews;
+  for (unsigned int i = 0; i < Dimension; ++i)
+  {
+    gradientViews[i] = CalculatorType::OutputViewType::Contiguous(gradient.data() + i * numberOfPixels, viewSize);
+  }
+  std::vector<double>                        derivative((viewSize[0] + 3) * viewSize[1] * viewSize[2]);
+  CalculatorType::OutputViewType::StrideType derivativeStrides;
+  derivativeStrides[0] = sizeof(double);
+  derivativeStrides[1] = (viewSize[0] + 3) * sizeof(double);
+  derivativeStrides[2] = derivativeStrides[1] * viewSize[1];
+  const CalculatorType::OutputViewType derivativeView(derivative.data(), viewSize, derivativeStrides);
+
+  CalculatorType::Pointer calculator = CalculatorType::New();
+  calculator->SetSpacing(spacing);
+  calculator->SetDirection(direction);
+  calculator->SetOrderOfAccuracy(3);
+  calculator->SetNumberOfWorkUnits(3);
+  try
+  {
+    filter->Update();
+    derivativeFilter->Update();
+    calculator->ComputeGradient(view, gradientViews);
+    calculator->ComputeDerivative(view, 2, 1, derivativeView);
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << "Exception caught!" << std::endl;
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  for (itk::ImageRegionConstIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion()); !it.IsAtEnd();
+       ++it)
+  {
+    const FilterType::OutputPixelType expected = filter->GetOutput()->GetPixel(it.GetIndex());
+    for (unsigned int i = 0; i < Dimension; ++i)
+    {
+      if (std::abs(gradientViews[i].GetValue(it.GetIndex()) - expected[i]) > 1e-9)
+      {
+        std::cerr << "Gradient component " << i << " at " << it.GetIndex() << " is "
+                  << gradientViews[i].GetValue(it.GetIndex()) << " instead of " << expected[i] << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+    const double expectedDerivative = derivativeFilter->GetOutput()->GetPixel(it.GetIndex());
+    if (std::abs(derivativeView.GetValue(it.GetIndex()) - expectedDerivative) > 1e-4)
+    {
+      std::cerr << "Derivative at " << it.GetIndex() << " is " << derivativeView.GetValue(it.GetIndex())
+                << " instead of " << expectedDerivative << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // The output must have the size of the input.
+  CalculatorType::SizeType wrongSize = viewSize;
+  wrongSize[2] = 3;
+  try
+  {
+    calculator->ComputeDerivative(view, 0, 1, CalculatorType::OutputViewType::Contiguous(derivative.data(), wrongSize));
+    std::cerr << "Expected an exception for an output of another size." << std::endl;
+    return EXIT_FAILURE;
+  }
+  catch (itk::ExceptionObject &)
+  {
+  }
+
+  calculator->Print(std::cout);
+
+  return EXIT_SUCCESS;
+}
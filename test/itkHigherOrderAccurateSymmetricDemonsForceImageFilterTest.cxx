@@ -0,0 +1,132 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkHigherOrderAccurateGradientImageFilter.h"
+#include "itkHigherOrderAccurateSymmetricDemonsForceImageFilter.h"
+
+#include <cmath>
+
+int
+itkHigherOrderAccurateSymmetricDemonsForceImageFilterTest(int, char *[])
+{
+  constexpr unsigned int Dimension = 2;
+  using ImageType = itk::Image<float, Dimension>;
+  using FilterType = itk::HigherOrderAccurateSymmetricDemonsForceImageFilter<ImageType>;
+  using GradientFilterType = itk::HigherOrderAccurateGradientImageFilter<ImageType, double, double>;
+
+  ImageType::SizeType size;
+  size[0] = 41;
+  size[1] = 33;
+  ImageType::SpacingType spacing;
+  spacing[0] = 0.7;
+  spacing[1] = 1.3;
+
+  ImageType::Pointer fixed = ImageType::New();
+  fixed->SetRegions(size);
+  fixed->SetSpacing(spacing);
+  fixed->Allocate();
+  ImageType::Pointer moving = ImageType::New();
+  moving->SetRegions(size);
+  moving->SetSpacing(spacing);
+  moving->Allocate();
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(fixed, fixed->GetLargestPossibleRegion()); !it.IsAtEnd(); ++it)
+  {
+    const double x = it.GetIndex()[0] - 20.0;
+    const double y = it.GetIndex()[1] - 16.0;
+    it.Set(static_cast<float>(100.0 * std::exp(-(x * x + y * y) / 60.0)));
+    moving->SetPixel(it.GetIndex(),
+                     static_cast<float>(100.0 * std::exp(-((x - 2.0) * (x - 2.0) + (y + 1.0) * (y + 1.0)) / 60.0)));
+  }
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetFixedImage(fixed);
+  filter->SetMovingImage(moving);
+  filter->SetOrderOfAccuracy(3);
+
+  GradientFilterType::Pointer fixedGradient = GradientFilterType::New();
+  fixedGradient->SetInput(fixed);
+  fixedGradient->SetOrderOfAccuracy(3);
+  GradientFilterType::Pointer movingGradient = GradientFilterType::New();
+  movingGradient->SetInput(moving);
+  movingGradient->SetOrderOfAccuracy(3);
+
+  const double normalizer = (spacing[0] * spacing[0] + spacing[1] * spacing[1]) / Dimension;
+
+  try
+  {
+    filter->Update();
+    fixedGradient->Update();
+    movingGradient->Update();
+
+    // The fused update matches the symmetric forces formula applied to the
+    // separately computed gradients.
+    const FilterType::OutputImageType * update = filter->GetOutput();
+    for (itk::ImageRegionConstIteratorWithIndex<FilterType::OutputImageType> it(update,
+                                                                               update->GetLargestPossibleRegion());
+         !it.IsAtEnd();
+         ++it)
+    {
+      const ImageType::IndexType                index = it.GetIndex();
+      const double                              speedValue = fixed->GetPixel(index) - moving->GetPixel(index);
+      const GradientFilterType::OutputPixelType gradient =
+        fixedGradient->GetOutput()->GetPixel(index) + movingGradient->GetOutput()->GetPixel(index);
+      const double denominator = speedValue * speedValue / normalizer + gradient.GetSquaredNorm();
+
+      for (unsigned int i = 0; i < Dimension; ++i)
+      {
+        double expected = 0.0;
+        if (std::abs(speedValue) >= filter->GetIntensityDifferenceThreshold() &&
+            denominator >= filter->GetDenominatorThreshold())
+        {
+          expected = 2.0 * speedValue * gradient[i] / denominator;
+        }
+        if (std::abs(it.Get()[i] - expected) > 1e-4 * (1.0 + std::abs(expected)))
+        {
+          std::cerr << "Update mismatch at " << index << ": " << it.Get() << " versus " << expected << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+    }
+
+    // Identical images give a zero update.
+    filter->SetMovingImage(fixed);
+    filter->Update();
+    for (itk::ImageRegionConstIteratorWithIndex<FilterType::OutputImageType> it(
+           filter->GetOutput(), filter->GetOutput()->GetLargestPossibleRegion());
+         !it.IsAtEnd();
+         ++it)
+    {
+      if (it.Get().GetNorm() != 0.0)
+      {
+        std::cerr << "Non-zero update " << it.Get() << " at " << it.GetIndex() << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << "Exception caught!" << std::endl;
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  filter->Print(std::cout);
+
+  return EXIT_SUCCESS;
+}
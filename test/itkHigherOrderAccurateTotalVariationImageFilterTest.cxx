@@ -0,0 +1,213 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkHigherOrderAccurateTotalVariationImageFilter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+int
+itkHigherOrderAccurateTotalVariationImageFilterTest(int, char *[])
+{
+  constexpr unsigned int Dimension = 2;
+  using ImageType = itk::Image<float, Dimension>;
+  using FilterType = itk::HigherOrderAccurateTotalVariationImageFilter<ImageType, double, float>;
+
+  ImageType::SizeType size;
+  size[0] = 48;
+  size[1] = 40;
+
+  ImageType::Pointer clean = ImageType::New();
+  clean->SetRegions(size);
+  clean->Allocate();
+  ImageType::Pointer noisy = ImageType::New();
+  noisy->SetRegions(size);
+  noisy->Allocate();
+
+  // A bright square corrupted by uniform noise.
+  std::mt19937 generator(12345);
+  double       noisySquaredError = 0.0;
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(clean, clean->GetLargestPossibleRegion()); !it.IsAtEnd(); ++it)
+  {
+    const ImageType::IndexType index = it.GetIndex();
+    const bool                 inside = index[0] >= 12 && index[0] < 36 && index[1] >= 10 && index[1] < 30;
+    const double               value = inside ? 10.0 : 0.0;
+    const double               noise = 4.0 * (static_cast<double>(generator()) / 4294967296.0 - 0.5);
+    it.Set(static_cast<float>(value));
+    noisy->SetPixel(index, static_cast<float>(value + noise));
+    noisySquaredError += noise * noise;
+  }
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(noisy);
+  filter->SetLambda(1.0);
+  filter->SetNumberOfIterations(200);
+
+  try
+  {
+    filter->Update();
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << "Exception caught!" << std::endl;
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  double denoisedSquaredError = 0.0;
+  for (itk::ImageRegionConstIteratorWithIndex<ImageType> it(clean, clean->GetLargestPossibleRegion()); !it.IsAtEnd();
+       ++it)
+  {
+    const double difference = filter->GetOutput()->GetPixel(it.GetIndex()) - it.Get();
+    denoisedSquaredError += difference * difference;
+  }
+  std::cout << "Squared error: noisy " << noisySquaredError << ", denoised " << denoisedSquaredError << std::endl;
+  if (denoisedSquaredError > 0.25 * noisySquaredError)
+  {
+    std::cerr << "The total variation denoising did not reduce the error enough." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // The projection keeps the dual variable within the unit ball.
+  const itk::SizeValueType numberOfPixels = noisy->GetBufferedRegion().GetNumberOfPixels();
+  for (itk::SizeValueType n = 0; n < numberOfPixels; ++n)
+  {
+    double squaredMagnitude = 0.0;
+    for (unsigned int i = 0; i < Dimension; ++i)
+    {
+      squaredMagnitude += static_cast<double>(filter->GetDual(i)[n]) * filter->GetDual(i)[n];
+    }
+    if (squaredMagnitude > 1.0 + 1e-6)
+    {
+      std::cerr << "Dual variable outside of the unit ball at offset " << n << ": " << std::sqrt(squaredMagnitude)
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // A dominant data term leaves the input unchanged.
+  filter->SetLambda(1e4);
+  try
+  {
+    filter->Update();
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << "Exception caught!" << std::endl;
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+  for (itk::ImageRegionConstIteratorWithIndex<ImageType> it(noisy, noisy->GetLargestPossibleRegion()); !it.IsAtEnd();
+       ++it)
+  {
+    if (std::abs(filter->GetOutput()->GetPixel(it.GetIndex()) - it.Get()) > 0.01)
+    {
+      std::cerr << "Unexpected change at " << it.GetIndex() << ": " << filter->GetOutput()->GetPixel(it.GetIndex())
+                << " versus " << it.Get() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // The divergence is the negative adjoint of the gradient, border included,
+  // so <G u, p> + <u, div p> vanishes for any u and p.  On this small image,
+  // an operator of radius three puts most of the pixels near the border.
+  ImageType::SizeType smallSize;
+  smallSize[0] = 11;
+  smallSize[1] = 7;
+  ImageType::SpacingType smallSpacing;
+  smallSpacing[0] = 0.5;
+  smallSpacing[1] = 2.0;
+  ImageType::Pointer small = ImageType::New();
+  small->SetRegions(smallSize);
+  small->SetSpacing(smallSpacing);
+  small->Allocate();
+
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  const itk::SizeValueType               numberOfSmallPixels = small->GetBufferedRegion().GetNumberOfPixels();
+  std::vector<double>                    field(numberOfSmallPixels);
+  std::vector<double>                    components[Dimension];
+  for (itk::SizeValueType n = 0; n < numberOfSmallPixels; ++n)
+  {
+    field[n] = uniform(generator);
+    small->GetBufferPointer()[n] = static_cast<float>(field[n]);
+  }
+  for (auto & component : components)
+  {
+    component.resize(numberOfSmallPixels);
+    for (double & value : component)
+    {
+      value = uniform(generator);
+    }
+  }
+
+  FilterType::Pointer adjointFilter = FilterType::New();
+  adjointFilter->SetInput(small);
+  adjointFilter->SetOrderOfAccuracy(3);
+  adjointFilter->SetNumberOfIterations(1);
+  try
+  {
+    adjointFilter->Update();
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << "Exception caught!" << std::endl;
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+  const FilterType::LineDerivativeType & derivative = adjointFilter->GetLineDerivative();
+
+  const itk::SizeValueType lineLength = smallSize[0];
+  std::vector<double>      line(lineLength);
+  std::vector<double>      adjoint(numberOfSmallPixels, 0.0);
+  double                   gradientProduct = 0.0;
+  ImageType::RegionType    lineStartRegion = small->GetBufferedRegion();
+  lineStartRegion.SetSize(0, 1);
+  for (itk::ImageRegionConstIteratorWithIndex<ImageType> lineIt(small, lineStartRegion); !lineIt.IsAtEnd(); ++lineIt)
+  {
+    const ImageType::IndexType lineStart = lineIt.GetIndex();
+    const auto                 lineOffset = static_cast<itk::SizeValueType>(small->ComputeOffset(lineStart));
+    for (unsigned int i = 0; i < Dimension; ++i)
+    {
+      std::fill(line.begin(), line.end(), 0.0);
+      derivative.AccumulateDerivative(field.data(), i, lineStart, lineLength, line.data());
+      for (itk::SizeValueType x = 0; x < lineLength; ++x)
+      {
+        gradientProduct += line[x] * components[i][lineOffset + x];
+      }
+      derivative.AccumulateAdjoint(components[i].data(), i, lineStart, lineLength, adjoint.data() + lineOffset);
+    }
+  }
+  double divergenceProduct = 0.0;
+  for (itk::SizeValueType n = 0; n < numberOfSmallPixels; ++n)
+  {
+    divergenceProduct -= field[n] * adjoint[n];
+  }
+  std::cout << "<G u, p> = " << gradientProduct << ", <u, div p> = " << divergenceProduct << std::endl;
+  if (std::abs(gradientProduct + divergenceProduct) > 1e-12 * (1.0 + std::abs(gradientProduct)))
+  {
+    std::cerr << "The divergence is not the negative adjoint of the gradient." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  filter->Print(std::cout);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,186 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkRGBPixel.h"
+#include "itkVectorIndexSelectionCastImageFilter.h"
+
+#include "itkHigherOrderAccurateGradientImageFilter.h"
+#include "itkHigherOrderAccurateVectorGradientImageFilter.h"
+
+#include <cmath>
+
+int
+itkHigherOrderAccurateVectorGradientImageFilterTest(int, char *[])
+{
+  constexpr unsigned int Dimension = 2;
+  constexpr unsigned int NumberOfChannels = 3;
+  using PixelType = float;
+  using ImageType = itk::Image<PixelType, Dimension>;
+  using VectorImageType = itk::VectorImage<PixelType, Dimension>;
+
+  ImageType::SizeType size;
+  size[0] = 37;
+  size[1] = 23;
+  ImageType::SpacingType spacing;
+  spacing[0] = 0.5;
+  spacing[1] = 1.5;
+
+  VectorImageType::Pointer vectorImage = VectorImageType::New();
+  vectorImage->SetRegions(size);
+  vectorImage->SetSpacing(spacing);
+  vectorImage->SetNumberOfComponentsPerPixel(NumberOfChannels);
+  vectorImage->Allocate();
+
+  using RGBImageType = itk::Image<itk::RGBPixel<unsigned char>, Dimension>;
+  RGBImageType::Pointer rgbImage = RGBImageType::New();
+  rgbImage->SetRegions(size);
+  rgbImage->SetSpacing(spacing);
+  rgbImage->Allocate();
+
+  ImageType::Pointer grayImage = ImageType::New();
+  grayImage->SetRegions(size);
+  grayImage->SetSpacing(spacing);
+  grayImage->Allocate();
+
+  itk::VariableLengthVector<PixelType> vectorPixel(NumberOfChannels);
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(grayImage, grayImage->GetLargestPossibleRegion()); !it.IsAtEnd();
+       ++it)
+  {
+    const ImageType::IndexType index = it.GetIndex();
+    const double               x = index[0];
+    const double               y = index[1];
+    for (unsigned int c = 0; c < NumberOfChannels; ++c)
+    {
+      vectorPixel[c] = static_cast<PixelType>((c + 1) * x * x * 0.01 - (c + 2) * y + std::sin(0.3 * c * x));
+    }
+    vectorImage->SetPixel(index, vectorPixel);
+
+    const auto gray = static_cast<unsigned char>((3 * index[0] + 5 * index[1]) % 256);
+    it.Set(gray);
+    itk::RGBPixel<unsigned char> rgb;
+    rgb.Fill(gray);
+    rgbImage->SetPixel(index, rgb);
+  }
+
+  using FilterType = itk::HigherOrderAccurateVectorGradientImageFilter<VectorImageType, float, float>;
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(vectorImage);
+
+  using ScalarFilterType = itk::HigherOrderAccurateGradientImageFilter<ImageType, float, float>;
+  ScalarFilterType::Pointer scalarFilter = ScalarFilterType::New();
+
+  using SelectionFilterType = itk::VectorIndexSelectionCastImageFilter<VectorImageType, ImageType>;
+  SelectionFilterType::Pointer selectionFilter = SelectionFilterType::New();
+  selectionFilter->SetInput(vectorImage);
+  scalarFilter->SetInput(selectionFilter->GetOutput());
+
+  constexpr double tolerance = 1e-4;
+
+  try
+  {
+    // Every channel gradient must match the scalar filter applied to the
+    // extracted channel, including at the image boundary.
+    for (unsigned int accuracy = 1; accuracy < 5; ++accuracy)
+    {
+      filter->SetOrderOfAccuracy(accuracy);
+      filter->Update();
+      VectorImageType::ConstPointer output = filter->GetOutput();
+      if (output->GetNumberOfComponentsPerPixel() != Dimension * NumberOfChannels)
+      {
+        std::cerr << "Unexpected number of output components: " << output->GetNumberOfComponentsPerPixel()
+                  << std::endl;
+        return EXIT_FAILURE;
+      }
+
+      scalarFilter->SetOrderOfAccuracy(accuracy);
+      for (unsigned int c = 0; c < NumberOfChannels; ++c)
+      {
+        selectionFilter->SetIndex(c);
+        scalarFilter->Update();
+        ScalarFilterType::OutputImageType::ConstPointer expected = scalarFilter->GetOutput();
+
+        for (itk::ImageRegionConstIteratorWithIndex<ScalarFilterType::OutputImageType> it(
+               expected, expected->GetLargestPossibleRegion());
+             !it.IsAtEnd();
+             ++it)
+        {
+          const VectorImageType::PixelType actual = output->GetPixel(it.GetIndex());
+          for (unsigned int i = 0; i < Dimension; ++i)
+          {
+            const double difference = actual[c * Dimension + i] - it.Get()[i];
+            if (std::abs(difference) > tolerance * (1.0 + std::abs(it.Get()[i])))
+            {
+              std::cerr << "Channel " << c << " gradient mismatch at " << it.GetIndex() << " for accuracy "
+                        << accuracy << ": " << actual << " versus " << it.Get() << std::endl;
+              return EXIT_FAILURE;
+            }
+          }
+        }
+      }
+    }
+
+    // With identical channels, the Di Zenzo gradient is the channel gradient
+    // scaled by the square root of the number of channels.
+    using RGBFilterType = itk::HigherOrderAccurateVectorGradientImageFilter<RGBImageType, float, float>;
+    RGBFilterType::Pointer rgbFilter = RGBFilterType::New();
+    rgbFilter->SetInput(rgbImage);
+    rgbFilter->UseDiZenzoGradientOn();
+    rgbFilter->SetOrderOfAccuracy(3);
+    rgbFilter->Update();
+    RGBFilterType::OutputImageType::ConstPointer diZenzo = rgbFilter->GetOutput();
+    if (diZenzo->GetNumberOfComponentsPerPixel() != Dimension)
+    {
+      std::cerr << "Unexpected number of Di Zenzo components: " << diZenzo->GetNumberOfComponentsPerPixel()
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    scalarFilter->SetInput(grayImage);
+    scalarFilter->SetOrderOfAccuracy(3);
+    scalarFilter->Update();
+    ScalarFilterType::OutputImageType::ConstPointer expected = scalarFilter->GetOutput();
+
+    for (itk::ImageRegionConstIteratorWithIndex<ScalarFilterType::OutputImageType> it(
+           expected, expected->GetLargestPossibleRegion());
+         !it.IsAtEnd();
+         ++it)
+    {
+      const RGBFilterType::OutputImageType::PixelType actual = diZenzo->GetPixel(it.GetIndex());
+      for (unsigned int i = 0; i < Dimension; ++i)
+      {
+        const double reference = std::sqrt(static_cast<double>(NumberOfChannels)) * it.Get()[i];
+        if (std::abs(actual[i] - reference) > tolerance * (1.0 + std::abs(reference)))
+        {
+          std::cerr << "Di Zenzo gradient mismatch at " << it.GetIndex() << ": " << actual << " versus "
+                    << it.Get() << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+    }
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << "Exception caught!" << std::endl;
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  filter->Print(std::cout);
+
+  return EXIT_SUCCESS;
+}
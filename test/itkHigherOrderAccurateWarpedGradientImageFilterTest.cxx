@@ -0,0 +1,229 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkAffineTransform.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTranslationTransform.h"
+
+#include "itkHigherOrderAccurateGradientImageFilter.h"
+#include "itkHigherOrderAccurateWarpedGradientImageFilter.h"
+
+#include <cmath>
+
+int
+itkHigherOrderAccurateWarpedGradientImageFilterTest(int, char *[])
+{
+  constexpr unsigned int Dimension = 2;
+  using ImageType = itk::Image<float, Dimension>;
+  using FilterType = itk::HigherOrderAccurateWarpedGradientImageFilter<ImageType, float, float>;
+  using GradientFilterType = itk::HigherOrderAccurateGradientImageFilter<ImageType, float, float>;
+  using GradientImageType = GradientFilterType::OutputImageType;
+  using PointType = ImageType::PointType;
+
+  ImageType::SizeType size;
+  size[0] = 30;
+  size[1] = 25;
+  ImageType::SpacingType spacing;
+  spacing[0] = 1.0;
+  spacing[1] = 0.5;
+
+  ImageType::Pointer moving = ImageType::New();
+  moving->SetRegions(size);
+  moving->SetSpacing(spacing);
+  moving->Allocate();
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(moving, moving->GetLargestPossibleRegion()); !it.IsAtEnd();
+       ++it)
+  {
+    const double x = it.GetIndex()[0];
+    const double y = it.GetIndex()[1];
+    it.Set(static_cast<float>(std::sin(0.2 * x) + 0.05 * x * y));
+  }
+
+  GradientFilterType::Pointer gradientFilter = GradientFilterType::New();
+  gradientFilter->SetInput(moving);
+  gradientFilter->SetOrderOfAccuracy(3);
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(moving);
+  filter->SetOrderOfAccuracy(3);
+
+  // Reference: the gradient image, linearly interpolated at a point.
+  const auto interpolateGradient = [&](const PointType & point, GradientImageType::PixelType & value) -> bool {
+    const GradientImageType * gradient = gradientFilter->GetOutput();
+    itk::ContinuousIndex<double, Dimension> continuousIndex;
+    gradient->TransformPhysicalPointToContinuousIndex(point, continuousIndex);
+    ImageType::IndexType base;
+    double               fraction[Dimension];
+    for (unsigned int i = 0; i < Dimension; ++i)
+    {
+      const double last = size[i] - 1.0;
+      if (continuousIndex[i] < -0.5 || continuousIndex[i] >= last + 0.5)
+      {
+        return false;
+      }
+      const double clamped = std::min(std::max(continuousIndex[i], 0.0), last);
+      base[i] = static_cast<itk::IndexValueType>(std::floor(clamped));
+      fraction[i] = clamped - base[i];
+    }
+    value.Fill(0.0f);
+    for (unsigned int corner = 0; corner < 4; ++corner)
+    {
+      ImageType::IndexType index = base;
+      double               weight = 1.0;
+      for (unsigned int i = 0; i < Dimension; ++i)
+      {
+        if (corner & (1u << i))
+        {
+          index[i] = std::min(index[i] + 1, static_cast<itk::IndexValueType>(size[i] - 1));
+          weight *= fraction[i];
+        }
+        else
+        {
+          weight *= 1.0 - fraction[i];
+        }
+      }
+      for (unsigned int i = 0; i < Dimension; ++i)
+      {
+        value[i] += static_cast<float>(weight * gradient->GetPixel(index)[i]);
+      }
+    }
+    return true;
+  };
+
+  const auto compare = [&](const itk::Transform<double, Dimension, Dimension> * transform,
+                           const itk::Matrix<double, Dimension, Dimension> * jacobian) -> bool {
+    const FilterType::OutputImageType * output = filter->GetOutput();
+    for (itk::ImageRegionConstIteratorWithIndex<FilterType::OutputImageType> it(output,
+                                                                               output->GetLargestPossibleRegion());
+         !it.IsAtEnd();
+         ++it)
+    {
+      PointType point;
+      output->TransformIndexToPhysicalPoint(it.GetIndex(), point);
+      GradientImageType::PixelType expected;
+      if (!interpolateGradient(transform->TransformPoint(point), expected))
+      {
+        expected.Fill(0.0f);
+      }
+      else if (jacobian)
+      {
+        const GradientImageType::PixelType sampled = expected;
+        for (unsigned int i = 0; i < Dimension; ++i)
+        {
+          expected[i] = static_cast<float>((*jacobian)[0][i] * sampled[0] + (*jacobian)[1][i] * sampled[1]);
+        }
+      }
+      for (unsigned int i = 0; i < Dimension; ++i)
+      {
+        if (std::abs(it.Get()[i] - expected[i]) > 1e-4 * (1.0 + std::abs(expected[i])))
+        {
+          std::cerr << "Warped gradient mismatch at " << it.GetIndex() << ": " << it.Get() << " versus " << expected
+                    << std::endl;
+          return false;
+        }
+      }
+    }
+    return true;
+  };
+
+  try
+  {
+    gradientFilter->Update();
+
+    // A translation by whole pixels samples the gradient on the grid.
+    using TranslationType = itk::TranslationTransform<double, Dimension>;
+    TranslationType::Pointer          translation = TranslationType::New();
+    TranslationType::OutputVectorType shift;
+    shift[0] = 2.0;
+    shift[1] = 1.5;
+    translation->Translate(shift);
+    filter->SetTransform(translation);
+    filter->Update();
+    if (!compare(translation, nullptr))
+    {
+      return EXIT_FAILURE;
+    }
+
+    // A sub-pixel translation interpolates between grid gradients.
+    shift[0] = 0.3;
+    shift[1] = 0.35;
+    translation->SetOffset(shift);
+    filter->Update();
+    if (!compare(translation, nullptr))
+    {
+      return EXIT_FAILURE;
+    }
+
+    // An affine transform on another grid, with the chain rule applied and
+    // with small tiles so that the cache is evicted.
+    using AffineType = itk::AffineTransform<double, Dimension>;
+    AffineType::Pointer          affine = AffineType::New();
+    AffineType::MatrixType       matrix;
+    AffineType::OutputVectorType offset;
+    matrix[0][0] = 1.1;
+    matrix[0][1] = 0.2;
+    matrix[1][0] = -0.1;
+    matrix[1][1] = 0.9;
+    offset[0] = 1.2;
+    offset[1] = -0.4;
+    affine->SetMatrix(matrix);
+    affine->SetOffset(offset);
+
+    ImageType::Pointer  reference = ImageType::New();
+    ImageType::SizeType referenceSize;
+    referenceSize[0] = 12;
+    referenceSize[1] = 10;
+    reference->SetRegions(referenceSize);
+    ImageType::SpacingType referenceSpacing;
+    referenceSpacing[0] = 2.0;
+    referenceSpacing[1] = 1.0;
+    reference->SetSpacing(referenceSpacing);
+    PointType referenceOrigin;
+    referenceOrigin[0] = 1.0;
+    referenceOrigin[1] = 1.0;
+    reference->SetOrigin(referenceOrigin);
+
+    FilterType::SizeType tileSize;
+    tileSize[0] = 5;
+    tileSize[1] = 4;
+    filter->SetTileSize(tileSize);
+    filter->SetMaximumNumberOfCachedTiles(2);
+    filter->SetTransform(affine);
+    filter->SetReferenceImage(reference);
+    filter->UseTransformJacobianOn();
+    filter->Update();
+    if (filter->GetOutput()->GetLargestPossibleRegion().GetSize() != referenceSize)
+    {
+      std::cerr << "The output grid does not match the reference image." << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (!compare(affine, &matrix))
+    {
+      return EXIT_FAILURE;
+    }
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << "Exception caught!" << std::endl;
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  filter->Print(std::cout);
+
+  return EXIT_SUCCESS;
+}
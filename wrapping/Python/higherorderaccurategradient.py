@@ -0,0 +1,150 @@
+"""Functional NumPy interface to the higher order accurate derivative filters.
+
+The input array is wrapped in an ITK image without a copy when it is a
+C-contiguous array of a type the filters are wrapped for (float32, and
+float64, uint8, int16 or uint16 when ITK wraps them), and the result is
+returned as a NumPy view of the filter output buffer.  Axes, spacing and gradient components
+follow the NumPy axis order, as with ``numpy.gradient``::
+
+  import numpy as np
+  from itk.higherorderaccurategradient import higher_order_accurate_gradient
+
+  volume = np.random.rand(64, 128, 128).astype(np.float32)
+  gradient = higher_order_accurate_gradient(volume, spacing=(2.0, 0.5, 0.5), order_of_accuracy=3)
+  # gradient.shape == (64, 128, 128, 3), gradient[..., 0] is the derivative along axis 0
+
+With ITK 5.3 and later, the wrapped calls run without holding the global
+interpreter lock, so several gradients can be computed concurrently from
+Python threads.
+"""
+
+import itk
+import numpy as np
+
+__all__ = [
+    'higher_order_accurate_gradient',
+    'higher_order_accurate_derivative',
+]
+
+
+# ITK pixel types of the NumPy types the filters may be wrapped for.  Which
+# are wrapped depends on the WRAP_ITK_* options of the ITK build, so arrays
+# of a type without a wrapped filter are converted to float32.
+_PIXEL_TYPE_NAMES = {
+    np.dtype(np.float32): 'F',
+    np.dtype(np.float64): 'D',
+    np.dtype(np.uint8): 'UC',
+    np.dtype(np.int16): 'SS',
+    np.dtype(np.uint16): 'US',
+}
+
+
+def _wrapped_filter(array, instantiate):
+    """Find a wrapped filter for the array.
+
+    :param array: Input array.
+    :param instantiate: Function of the input and output ITK pixel types that
+        returns the filter class, or raises when it is not wrapped.
+    :return: The array, converted to float32 when no filter is wrapped for
+        its type, and the filter class.  The output is float64 for float64
+        input when it is wrapped, and float32 otherwise.
+    """
+    input_name = _PIXEL_TYPE_NAMES.get(array.dtype)
+    if input_name is not None:
+        output_names = ('D', 'F') if input_name == 'D' else ('F',)
+        for output_name in output_names:
+            try:
+                return array, instantiate(getattr(itk, input_name), getattr(itk, output_name))
+            except (KeyError, TypeError):
+                pass
+    return array.astype(np.float32), instantiate(itk.F, itk.F)
+
+
+def _image_view(array, spacing):
+    array = np.ascontiguousarray(array)
+    image = itk.image_view_from_array(array)
+    if spacing is not None:
+        spacing = np.broadcast_to(np.asarray(spacing, dtype=np.float64), (array.ndim,))
+        image.SetSpacing([float(s) for s in spacing[::-1]])
+    return array, image
+
+
+def _run(process_object, number_of_work_units):
+    if number_of_work_units is not None:
+        process_object.SetNumberOfWorkUnits(number_of_work_units)
+    process_object.Update()
+    output = process_object.GetOutput()
+    # The input image only views the caller's array, which may not outlive
+    # the output.
+    output.DisconnectPipeline()
+    return itk.array_view_from_image(output)
+
+
+def higher_order_accurate_gradient(array, spacing=None, order_of_accuracy=2, channel_axis=-1,
+                                   number_of_work_units=None):
+    """Gradient of an array of one of the wrapped image dimensions.
+
+    :param array: Scalar array.  Arrays of a type the filters are wrapped
+        for (float32, and float64, uint8, int16 or uint16 when ITK wraps
+        them) are used without a copy when C-contiguous, other types are
+        converted to float32.  The result is float64 for float64 input when
+        it is wrapped, and float32 otherwise.
+    :param spacing: Sample spacing along each axis, or a scalar for all axes.
+        Defaults to 1.
+    :param order_of_accuracy: Order of accuracy of the derivative operator,
+        see HigherOrderAccurateDerivativeOperator.
+    :param channel_axis: Position of the gradient components in the result,
+        -1 for channel-last or 0 for channel-first.  Both are views of the
+        same buffer, which is stored channel-last.
+    :param number_of_work_units: Number of work units of the filter, or None
+        for the ITK default.
+    :return: Array with one more axis than the input, holding the
+        derivatives along axis 0, 1, ... of the input.
+    """
+    if channel_axis not in (0, -1):
+        raise ValueError('channel_axis must be 0 or -1, got {}'.format(channel_axis))
+    array = np.asarray(array)
+    array, filter_type = _wrapped_filter(
+        array,
+        lambda input_type, output_type: itk.HigherOrderAccurateGradientImageFilter[
+            itk.Image[input_type, array.ndim], output_type, output_type])
+    array, image = _image_view(array, spacing)
+    gradient_filter = filter_type.New()
+    gradient_filter.SetInput(image)
+    gradient_filter.SetOrderOfAccuracy(order_of_accuracy)
+    gradient = _run(gradient_filter, number_of_work_units)
+
+    # ITK orders the components x, y, z, the reverse of the NumPy axes.
+    gradient = gradient[..., ::-1]
+    return np.moveaxis(gradient, -1, channel_axis)
+
+
+def higher_order_accurate_derivative(array, axis, order=1, spacing=None, order_of_accuracy=2,
+                                     number_of_work_units=None):
+    """Derivative of an array of one of the wrapped image dimensions along one axis.
+
+    :param array: Scalar array, used as in higher_order_accurate_gradient.
+    :param axis: NumPy axis of the derivative.
+    :param order: Order of the derivative, 1 or 2.
+    :param spacing: Sample spacing along each axis, or a scalar for all axes.
+        Defaults to 1.
+    :param order_of_accuracy: Order of accuracy of the derivative operator.
+    :param number_of_work_units: Number of work units of the filter, or None
+        for the ITK default.
+    :return: Array of the shape of the input.
+    """
+    array = np.asarray(array)
+    if not -array.ndim <= axis < array.ndim:
+        raise ValueError('axis {} is out of bounds for an array of dimension {}'.format(axis, array.ndim))
+    axis %= array.ndim
+    array, filter_type = _wrapped_filter(
+        array,
+        lambda input_type, output_type: itk.HigherOrderAccurateDerivativeImageFilter[
+            itk.Image[input_type, array.ndim], itk.Image[output_type, array.ndim]])
+    array, image = _image_view(array, spacing)
+    derivative_filter = filter_type.New()
+    derivative_filter.SetInput(image)
+    derivative_filter.SetDirection(array.ndim - 1 - axis)
+    derivative_filter.SetOrder(order)
+    derivative_filter.SetOrderOfAccuracy(order_of_accuracy)
+    return _run(derivative_filter, number_of_work_units)
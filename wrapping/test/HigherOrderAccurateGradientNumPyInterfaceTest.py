@@ -0,0 +1,78 @@
+#==========================================================================
+#
+#   Copyright NumFOCUS
+#
+#   Licensed under the Apache License, Version 2.0 (the "License");
+#   you may not use this file except in compliance with the License.
+#   You may obtain a copy of the License at
+#
+#          http://www.apache.org/licenses/LICENSE-2.0.txt
+#
+#   Unless required by applicable law or agreed to in writing, software
+#   distributed under the License is distributed on an "AS IS" BASIS,
+#   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#   See the License for the specific language governing permissions and
+#   limitations under the License.
+#
+#==========================================================================*/
+
+# Compare the NumPy interface with the ITK filters it wraps, and check that
+# the components and the spacing follow the NumPy axis order.
+
+import itk
+import numpy as np
+
+from itk.higherorderaccurategradient import higher_order_accurate_derivative, higher_order_accurate_gradient
+
+order_of_accuracy = 3
+spacing = (2.0, 0.5, 0.25)
+shape = (7, 11, 13)
+
+z, y, x = np.meshgrid(*[np.arange(n) for n in shape], indexing='ij')
+array = (np.sin(0.4 * x) * np.cos(0.3 * y) + 0.05 * z * z).astype(np.float32)
+
+# Reference from the filters, with the spacing and the components in ITK
+# order.
+image = itk.image_from_array(array)
+image.SetSpacing(spacing[::-1])
+gradient_filter = itk.HigherOrderAccurateGradientImageFilter[type(image), itk.F, itk.F].New()
+gradient_filter.SetInput(image)
+gradient_filter.SetOrderOfAccuracy(order_of_accuracy)
+gradient_filter.Update()
+reference = itk.array_from_image(gradient_filter.GetOutput())
+
+gradient = higher_order_accurate_gradient(array, spacing=spacing, order_of_accuracy=order_of_accuracy)
+assert gradient.shape == shape + (3,), gradient.shape
+for axis in range(3):
+    np.testing.assert_allclose(gradient[..., axis], reference[..., 2 - axis], rtol=1e-5, atol=1e-5)
+
+channel_first = higher_order_accurate_gradient(array, spacing=spacing, order_of_accuracy=order_of_accuracy,
+                                               channel_axis=0)
+assert channel_first.shape == (3,) + shape, channel_first.shape
+np.testing.assert_array_equal(channel_first, np.moveaxis(gradient, -1, 0))
+
+for axis in range(3):
+    derivative_filter = itk.HigherOrderAccurateDerivativeImageFilter[type(image), type(image)].New()
+    derivative_filter.SetInput(image)
+    derivative_filter.SetDirection(2 - axis)
+    derivative_filter.SetOrder(1)
+    derivative_filter.SetOrderOfAccuracy(order_of_accuracy)
+    derivative_filter.Update()
+    derivative = higher_order_accurate_derivative(array, axis, spacing=spacing, order_of_accuracy=order_of_accuracy)
+    np.testing.assert_allclose(derivative, itk.array_from_image(derivative_filter.GetOutput()), rtol=1e-5,
+                               atol=1e-5)
+
+# The derivatives of a ramp, away from the boundary, are its slopes along
+# the NumPy axes divided by the spacing of each axis.
+slopes = (1.0, -2.0, 3.0)
+ramp = (slopes[0] * z + slopes[1] * y + slopes[2] * x).astype(np.float64)
+interior = (slice(3, -3),) * 3
+ramp_gradient = higher_order_accurate_gradient(ramp, spacing=spacing)
+for axis in range(3):
+    np.testing.assert_allclose(ramp_gradient[interior + (axis,)], slopes[axis] / spacing[axis], rtol=1e-6)
+    np.testing.assert_allclose(higher_order_accurate_derivative(ramp, axis, spacing=spacing)[interior],
+                               slopes[axis] / spacing[axis], rtol=1e-6)
+
+# Integer arrays are processed whether or not ITK wraps their type.
+integer_gradient = higher_order_accurate_gradient(ramp.astype(np.int16), spacing=spacing)
+np.testing.assert_allclose(integer_gradient[interior], ramp_gradient[interior], rtol=1e-5)